@@ -0,0 +1,128 @@
+/*
+Copyright 2019 Association for the promotion of open - source insurance software and for the establishment of open interface standards in the insurance industry
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http ://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef CP_DEPENDENCYGRAPH_H
+#define CP_DEPENDENCYGRAPH_H 1
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace CalculusPrime {
+
+//! \brief The static dependencies between the formulas of a tariff, see IRatingEngine::analyzeDependencies.
+//! The nodes are the formula functions and the rating formulas (each sorted by name) followed by the rating outputs in calculation order.
+//! The references of a formula are taken from its compiled form, so every variable, formula and function it may use is reported,
+//! regardless of the branches taken by a calculation.
+class DependencyGraph
+{
+public:
+    enum class NodeType {
+        /** a rating formula which is evaluated when its variable is referenced */
+        RATING_FORMULA,
+        /** a rating formula which defines a function, e.g. Quote(anzahl) */
+        FORMULA_FUNCTION,
+        /** a rating output */
+        RATING_OUTPUT
+    };
+
+    //! \brief a formula and its references
+    struct Node
+    {
+        NodeType type;
+        //! \brief the name of the rating formula (the function header of formula functions) or the variable name of the rating output
+        std::string name;
+        //! \brief the instance id of a rating output
+        std::string instanceId;
+        //! \brief false if the formula does not compile, its references are unknown then
+        bool compiled;
+        //! \brief the referenced variables which are neither rating formulas nor rating outputs (i.e. the input variables), sorted
+        std::vector<std::string> variables;
+        //! \brief the names of the called functions which are no formula functions (i.e. the IFunctions), sorted
+        std::vector<std::string> functions;
+        //! \brief the indices of the referenced rating formulas, formula functions and rating outputs, sorted
+        std::vector<std::size_t> dependencies;
+        //! \brief true if the value does not depend on the instance id, i.e. neither the formula nor the formulas it references
+        //! call IFunctions (which may read the instance id), read rating outputs with instance id or read rating outputs which are calculated
+        //! after the formula is first read. Such a rating formula is calculated once for all instance ids of a calculation,
+        //! unless one of the variables it reads is an input parameter with instance values.
+        bool instanceInvariant;
+    };
+
+    //! \brief the value returned if a node is not found
+    static const std::size_t NO_NODE = static_cast<std::size_t>(-1);
+
+    DependencyGraph();
+
+    //! \brief constructor, computes the cycles and the levels of the rating outputs
+    //! \param nodes_ the nodes, the rating outputs must follow all other nodes in calculation order
+    explicit DependencyGraph(const std::vector<Node>& nodes_);
+
+    //! \brief returns all nodes
+    const std::vector<Node>& getNodes() const
+    {
+        return m_nodes;
+    }
+
+    //! \brief returns the index of the rating formula, formula function (by its name or header) or the first rating output with the name (case insensitive)
+    //! \return the index or NO_NODE
+    std::size_t findNode(const std::string& name_) const;
+
+    //! \brief returns the cycles between the formulas, every cycle is a list of node indices.
+    //! A calculation which evaluates a formula of a cycle does not terminate.
+    //! Formula functions which only call each other are no cycle, they are recursive functions.
+    const std::vector<std::vector<std::size_t>>& getCycles() const
+    {
+        return m_cycles;
+    }
+
+    bool hasCycles() const
+    {
+        return !m_cycles.empty();
+    }
+
+    //! \brief returns the levels of the rating outputs. Level 0 are the rating outputs which do not depend on other rating outputs,
+    //! every other rating output is one level above the highest rating output it depends on.
+    //! A rating output is above the rating outputs before it which it references, directly or through formulas.
+    //! It is also above the rating outputs before it which reference it through formulas, which read a variable it overwrites
+    //! or which have the same variable name and instance id. So the rating outputs of one level may be calculated in any order.
+    const std::vector<std::vector<std::size_t>>& getOutputLevels() const
+    {
+        return m_outputLevels;
+    }
+
+    //! \brief returns the rating outputs in topological order (level by level, in calculation order within a level)
+    const std::vector<std::size_t>& getOutputOrder() const
+    {
+        return m_outputOrder;
+    }
+
+private:
+    void findCycles();
+
+    void computeOutputLevels();
+
+    std::vector<Node> m_nodes;
+    //! \brief the node indices by lower case name
+    std::unordered_map<std::string, std::size_t> m_nodeIndices;
+    std::vector<std::vector<std::size_t>> m_cycles;
+    std::vector<std::vector<std::size_t>> m_outputLevels;
+    std::vector<std::size_t> m_outputOrder;
+};
+
+} // namespace CalculusPrime
+
+#endif // #ifndef CP_DEPENDENCYGRAPH_H
@@ -0,0 +1,103 @@
+/*
+Copyright 2019 Association for the promotion of open - source insurance software and for the establishment of open interface standards in the insurance industry
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http ://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef CP_FUNCTIONCACHINGPOLICY_H
+#define CP_FUNCTIONCACHINGPOLICY_H 1
+
+#include <chrono>
+#include <string>
+
+namespace CalculusPrime {
+
+//! \brief Declares how the rating engine caches the results of a business function (see IFunction::getCachingPolicy).
+//! A function with a caching scope declares that its result only depends on its arguments and, if a validity date variable
+//! is set, on the value of that variable. The rating engine then builds the cache key from the function id and the arguments,
+//! looks up the result before it executes the function and stores the result afterwards. Errors are not cached.
+class FunctionCachingPolicy
+{
+public:
+    //! \brief where the results are cached
+    enum class Scope {
+        /** the results are not cached, the function is executed for every call */
+        NONE,
+        /** the results are cached for the current calculation */
+        CALCULATION,
+        /** the results are cached in the function result cache (see IFunctionResultCache) with the insurance rate key of the tariff */
+        TARIFF
+    };
+
+    FunctionCachingPolicy()
+        : m_scope(Scope::NONE)
+        , m_timeToLive(0)
+    {
+    }
+
+    //! \brief returns where the results are cached
+    Scope getScope() const
+    {
+        return m_scope;
+    }
+
+    //! \brief set where the results are cached
+    FunctionCachingPolicy& setScope(Scope scope_)
+    {
+        m_scope = scope_;
+        return *this;
+    }
+
+    //! \brief returns the name of the variable which holds the validity date, empty if the result does not depend on a date
+    const std::string& getValidityDateVariable() const
+    {
+        return m_validityDateVariable;
+    }
+
+    //! \brief set the name of the variable which holds the validity date in ISO format (e.g. the tariff date).
+    //! The result is cached for the date of the call (see IFunctionResultCache::putFunctionResultWithValidityDate).
+    FunctionCachingPolicy& setValidityDateVariable(const std::string& validityDateVariable_)
+    {
+        m_validityDateVariable = validityDateVariable_;
+        return *this;
+    }
+
+    //! \brief returns how long a result in the function result cache is used, zero if it is used until the cache is cleared
+    std::chrono::seconds getTimeToLive() const
+    {
+        return m_timeToLive;
+    }
+
+    //! \brief set how long a result in the function result cache is used after it was stored, an expired result is replaced
+    //! by the next call. The results are cached with their expiry time (see IFunctionResultCache::putFunctionResultWithExpiry),
+    //! caches which do not implement it do not cache them. By default results are used until the cache is cleared.
+    FunctionCachingPolicy& setTimeToLive(std::chrono::seconds timeToLive_)
+    {
+        m_timeToLive = timeToLive_;
+        return *this;
+    }
+
+    //! \brief returns if the result only depends on the arguments, i.e. the results are cached, without validity date and time to live
+    bool isPure() const
+    {
+        return m_scope != Scope::NONE && m_validityDateVariable.empty() && m_timeToLive.count() == 0;
+    }
+
+private:
+    Scope m_scope;
+    std::string m_validityDateVariable;
+    std::chrono::seconds m_timeToLive;
+};
+
+} // namespace CalculusPrime
+
+#endif // #ifndef CP_FUNCTIONCACHINGPOLICY_H
@@ -18,6 +18,7 @@ limitations under the License.
 
 #include <memory>
 #include <vector>
+#include <calculusprime/FunctionCachingPolicy.h>
 #include <calculusprime/Value.h>
 
 namespace CalculusPrime {
@@ -40,10 +41,18 @@ public:
 
     //! \brief execute the function with the specified input parameters and return the result value
     //! \param params_ the input parameters for the function
-    //! \param parsingContext_ the IParsingContext object
+    //! \param parsingContext_ the IParsingContext object, it is only valid during the call
     //! \return the calculated value
     virtual Value execute(const std::vector<Value>& params_, const std::shared_ptr<IParsingContext>& parsingContext_) = 0;
 
+    //! \brief returns how the rating engine caches the results of the function. By default the results are not cached,
+    //! functions which cache their results themselves keep this default.
+    //! \return the policy, it must not change while the function is used by a rating engine
+    virtual const FunctionCachingPolicy& getCachingPolicy() const
+    {
+        static const FunctionCachingPolicy notCached;
+        return notCached;
+    }
 };
 
 } // namespace CalculusPrime
@@ -0,0 +1,68 @@
+/*
+Copyright 2019 Association for the promotion of open - source insurance software and for the establishment of open interface standards in the insurance industry
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http ://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef CP_IPREPAREDTARIFF_H
+#define CP_IPREPAREDTARIFF_H 1
+
+#include <string>
+#include <vector>
+#include <calculusprime/DependencyGraph.h>
+#include <calculusprime/IRatingEngine.h>
+
+namespace CalculusPrime {
+
+//! \brief A tariff prepared by IRatingEngine::prepare.
+//! The rating formulas and rating outputs are resolved once, every calculation only takes the input values.
+//! A prepared tariff does not change during calculations, so it may be used by several threads concurrently.
+class IPreparedTariff
+{
+public:
+    virtual ~IPreparedTariff()
+    {
+    }
+
+    //! \brief returns the insurance rate key of the tariff
+    virtual const std::string& getInsuranceRateKey() const = 0;
+
+    //! \brief returns the rating outputs of the tariff, sorted by their sort order
+    virtual const std::vector<RatingOutput>& getRatingOutput() const = 0;
+
+    //! \brief Calculates the results from the given input parameters
+    //! \param input_ key-value mapping. Values may be String or Double or InstanceVariables
+    //! \return the calculated values as a map the variable names as keys and the appropriate values as string or double or instance variables
+    //! \throws RatingEngineException
+    virtual IRatingEngine::Map_t calculate(const IRatingEngine::Map_t& input_) const = 0;
+
+    //! \brief Calculates the results for many input parameter sets.
+    //! With more than one thread (see RatingEngineOptions::setNumberOfThreads) the inputs are calculated concurrently,
+    //! the rating outputs of each input are calculated one after another then. With columnar evaluation
+    //! (see RatingEngineOptions::setColumnarEvaluation) the numeric rating outputs are calculated for all inputs at once.
+    //! \param inputs_ the input parameters of every calculation
+    //! \return the results in the order of the inputs, a failed calculation does not cancel the others
+    virtual std::vector<IRatingEngine::BatchResult> calculateBatch(const std::vector<IRatingEngine::Map_t>& inputs_) const = 0;
+
+    //! \brief Checks statically which formulas may calculate different results with short circuit evaluation
+    //! (see RatingEngineOptions::setShortCircuitEvaluation), e.g. because the right operand of And or Or calls a function
+    //! which may fail, directly or through the rating formulas it reads. Formulas which do not compile are not reported.
+    //! \return the names of the rating formulas and the variable names of the rating outputs, sorted
+    virtual std::vector<std::string> checkShortCircuitEvaluation() const = 0;
+
+    //! \brief returns the static dependencies between the rating formulas and the rating outputs of the tariff
+    virtual const DependencyGraph& getDependencyGraph() const = 0;
+};
+
+} // namespace CalculusPrime
+
+#endif // #ifndef CP_IPREPAREDTARIFF_H
@@ -16,14 +16,19 @@ limitations under the License.
 #ifndef CP_IRATINGENGINE_H
 #define CP_IRATINGENGINE_H 1
 
+#include <exception>
+#include <memory>
 #include <unordered_map>
 #include <string>
 #include <vector>
 #include <boost/variant.hpp>
+#include <calculusprime/DependencyGraph.h>
 #include <calculusprime/RatingOutput.h>
 
 namespace CalculusPrime {
 
+class IPreparedTariff;
+
 //! \brief The rating engine interface
 class IRatingEngine
 {
@@ -45,6 +50,15 @@ public:
     //! \brief Rating formulas map. Key ist the name of the formula, value the formula
     typedef std::unordered_map<std::string, std::string> RatingFormulaMap_t;
 
+    //! \brief the result of one calculation of a batch
+    struct BatchResult
+    {
+        //! \brief the calculated values, empty if the calculation failed
+        Map_t output;
+        //! \brief the exception of a failed calculation (e.g. a RatingEngineException), empty if the calculation succeeded
+        std::exception_ptr error;
+    };
+
     virtual ~IRatingEngine()
     {
     }
@@ -57,6 +71,39 @@ public:
     //! \return the calculated values as a map the variable names as keys and the appropriate values as string or double or instance variables
     //! \throws RatingEngineException
     virtual Map_t calculate(const std::string& insuranceRateKey_, const Map_t& input_, const RatingFormulaMap_t& ratingFormulas_, const std::vector<RatingOutput>& ratingOutput_) = 0;
+
+    //! \brief Prepares a tariff for repeated calculations with different input parameters
+    //! \param insuranceRateKey_ the insurance rate key
+    //! \param ratingFormulas_ the rating formulas
+    //! \param ratingOutput_ the output variables to calculate. They are calculated by their sort order
+    //! \return the prepared tariff, it uses the functions and caches of this rating engine
+    //! \throws RatingEngineException, the default implementation does not support prepared tariffs
+    virtual std::unique_ptr<IPreparedTariff> prepare(const std::string& insuranceRateKey_, const RatingFormulaMap_t& ratingFormulas_, const std::vector<RatingOutput>& ratingOutput_);
+
+    //! \brief Calculates the results for many input parameter sets with the same tariff, the tariff is prepared once.
+    //! With more than one thread (see RatingEngineOptions::setNumberOfThreads) the inputs are calculated concurrently.
+    //! \param insuranceRateKey_ the insurance rate key
+    //! \param inputs_ the input parameters of every calculation
+    //! \param ratingFormulas_ the rating formulas
+    //! \param ratingOutput_ the output variables to calculate
+    //! \return the results in the order of the inputs, a failed calculation does not cancel the others.
+    //! The default implementation calls calculate for one input after the other.
+    virtual std::vector<BatchResult> calculateBatch(const std::string& insuranceRateKey_, const std::vector<Map_t>& inputs_, const RatingFormulaMap_t& ratingFormulas_, const std::vector<RatingOutput>& ratingOutput_);
+
+    //! \brief Analyzes the static dependencies between the rating formulas, formula functions and rating outputs without calculating them.
+    //! The graph reports the referenced variables, formulas and functions of every formula, the cycles between the formulas
+    //! and the topological order and levels of the rating outputs.
+    //! \param insuranceRateKey_ the insurance rate key
+    //! \param ratingFormulas_ the rating formulas
+    //! \param ratingOutput_ the output variables
+    //! \return the dependency graph
+    //! \throws RatingEngineException, the default implementation does not support the analysis
+    virtual DependencyGraph analyzeDependencies(const std::string& insuranceRateKey_, const RatingFormulaMap_t& ratingFormulas_, const std::vector<RatingOutput>& ratingOutput_);
+
+    //! \brief Drops the tariffs which the calls with formulas keep prepared for the insurance rate key (see RatingEngineOptions::setMaxPreparedTariffs),
+    //! e.g. when its caches are evicted from DefaultCacheFactory. The default implementation keeps no prepared tariffs.
+    //! \param insuranceRateKey_ the insurance rate key
+    virtual void evictPreparedTariffs(const std::string& insuranceRateKey_);
 };
 
 } // namespace CalculusPrime
@@ -19,6 +19,7 @@ limitations under the License.
 #include <memory>
 #include <vector>
 #include <boost/noncopyable.hpp>
+#include <calculusprime/RatingEngineOptions.h>
 
 namespace CalculusPrime {
 
@@ -38,6 +39,14 @@ public:
     //! \param parseTreeCache_ the parse-tree cache to use (may not be null)
     //! \return a new IRatingeEngine instance
     static std::unique_ptr<IRatingEngine> createRatingEngine(const std::vector<std::shared_ptr<IFunction>>& functions_, const std::shared_ptr<IFunctionResultCache>& functionResultCache_, const std::shared_ptr<IParseTreeCache>& parseTreeCache_);
+
+    //! \brief the factory function
+    //! \param functions_ functions the list of business functions the should be supported
+    //! \param functionResultCache_ the function result cache to use (may not be null)
+    //! \param parseTreeCache_ the parse-tree cache to use (may not be null)
+    //! \param options_ the options of the rating engine (e.g. the evaluation backend)
+    //! \return a new IRatingeEngine instance
+    static std::unique_ptr<IRatingEngine> createRatingEngine(const std::vector<std::shared_ptr<IFunction>>& functions_, const std::shared_ptr<IFunctionResultCache>& functionResultCache_, const std::shared_ptr<IParseTreeCache>& parseTreeCache_, const RatingEngineOptions& options_);
 };
 
 } // namespace CalculusPrime
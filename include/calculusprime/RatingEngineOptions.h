@@ -0,0 +1,154 @@
+/*
+Copyright 2019 Association for the promotion of open - source insurance software and for the establishment of open interface standards in the insurance industry
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http ://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef CP_RATINGENGINEOPTIONS_H
+#define CP_RATINGENGINEOPTIONS_H 1
+
+#include <cstddef>
+
+namespace CalculusPrime {
+
+//! \brief The backends for evaluating the compiled formulas
+enum class EvaluationBackend {
+    /** evaluates the compiled expression tree recursively */
+    TREE,
+    /** executes the formulas as register based bytecode */
+    BYTECODE
+};
+
+//! \brief Options of a rating engine instance
+class RatingEngineOptions
+{
+public:
+    RatingEngineOptions()
+        : m_evaluationBackend(EvaluationBackend::TREE)
+        , m_shortCircuitEvaluation(false)
+        , m_numberOfThreads(1)
+        , m_columnarEvaluation(false)
+        , m_sharedFunctionMemoization(false)
+        , m_maxPreparedTariffs(16)
+    {
+    }
+
+    //! \brief returns the evaluation backend
+    EvaluationBackend getEvaluationBackend() const
+    {
+        return m_evaluationBackend;
+    }
+
+    //! \brief set the evaluation backend
+    RatingEngineOptions& setEvaluationBackend(EvaluationBackend evaluationBackend_)
+    {
+        m_evaluationBackend = evaluationBackend_;
+        return *this;
+    }
+
+    //! \brief returns if And and Or are evaluated with short circuit semantics
+    bool isShortCircuitEvaluation() const
+    {
+        return m_shortCircuitEvaluation;
+    }
+
+    //! \brief set if And and Or are evaluated with short circuit semantics.
+    //! The right operand is not evaluated if the left operand already decides the result (false for And, true for Or),
+    //! so it does not call functions and does not report errors. By default both operands are evaluated.
+    //! IPreparedTariff::checkShortCircuitEvaluation reports the formulas whose results may differ.
+    RatingEngineOptions& setShortCircuitEvaluation(bool shortCircuitEvaluation_)
+    {
+        m_shortCircuitEvaluation = shortCircuitEvaluation_;
+        return *this;
+    }
+
+    //! \brief returns the number of threads which calculate the rating outputs of one calculation
+    std::size_t getNumberOfThreads() const
+    {
+        return m_numberOfThreads;
+    }
+
+    //! \brief set the number of threads which calculate the rating outputs of one calculation.
+    //! With more than one thread, rating outputs which do not depend on each other (see DependencyGraph::getOutputLevels)
+    //! are calculated concurrently, the sort order is only kept between dependent rating outputs. The business functions
+    //! must be thread safe then, the function result cache is synchronized by the rating engine unless it is a ConcurrentFunctionResultCache
+    //! or a TwoLevelFunctionResultCache. By default (1) the rating outputs are calculated one after another on the calling thread.
+    RatingEngineOptions& setNumberOfThreads(std::size_t numberOfThreads_)
+    {
+        m_numberOfThreads = numberOfThreads_;
+        return *this;
+    }
+
+    //! \brief returns if numeric rating outputs are evaluated column by column
+    bool isColumnarEvaluation() const
+    {
+        return m_columnarEvaluation;
+    }
+
+    //! \brief set if IPreparedTariff::calculateBatch evaluates numeric rating outputs column by column.
+    //! Rating outputs which only consist of numbers, arithmetic operators, comparisons, And, Or, Not, Max, Min, Rnd, Ceil, Floor, Exp,
+    //! If/Else and Return and which only read number input parameters are evaluated for all inputs of the batch at once with vectorized loops.
+    //! Inputs for which such an output fails or whose parameters are not numbers are calculated as before, so the results do not change.
+    //! Consecutive rating outputs with the same variable name and formula for different instances, which read no rating formulas,
+    //! are evaluated for all their instances at once by every calculation. By default every rating output is calculated separately.
+    RatingEngineOptions& setColumnarEvaluation(bool columnarEvaluation_)
+    {
+        m_columnarEvaluation = columnarEvaluation_;
+        return *this;
+    }
+
+    //! \brief returns if the results of pure formula functions are memoized across the calculations of a prepared tariff
+    bool isSharedFunctionMemoization() const
+    {
+        return m_sharedFunctionMemoization;
+    }
+
+    //! \brief set if the results of pure formula functions are memoized across the calculations of a prepared tariff.
+    //! A formula function is pure if its implementation only reads its arguments and only calls built-in functions, other
+    //! pure formula functions and business functions which are declared pure (see FunctionCachingPolicy::isPure). The results of pure functions are always memoized per calculation by their arguments, with this
+    //! option every tariff prepared by the rating engine also keeps up to Function::MAX_SHARED_RESULTS results per function
+    //! for all its calculations. By default the results are discarded after each calculation.
+    RatingEngineOptions& setSharedFunctionMemoization(bool sharedFunctionMemoization_)
+    {
+        m_sharedFunctionMemoization = sharedFunctionMemoization_;
+        return *this;
+    }
+
+    //! \brief returns how many tariffs the calls with formulas keep prepared
+    std::size_t getMaxPreparedTariffs() const
+    {
+        return m_maxPreparedTariffs;
+    }
+
+    //! \brief set how many tariffs the calls with formulas (IRatingEngine::calculate, calculateBatch and analyzeDependencies) keep prepared.
+    //! A tariff is identified by its insurance rate key, formulas and rating outputs, a call with the same ones reuses it.
+    //! Every prepared tariff keeps a copy of its formulas and rating outputs and their compiled formulas until it is dropped,
+    //! the least recently used tariff is dropped for another one (see also IRatingEngine::evictPreparedTariffs).
+    //! With 0 the tariff is prepared by every call. By default 16 tariffs are kept.
+    RatingEngineOptions& setMaxPreparedTariffs(std::size_t maxPreparedTariffs_)
+    {
+        m_maxPreparedTariffs = maxPreparedTariffs_;
+        return *this;
+    }
+
+private:
+    EvaluationBackend m_evaluationBackend;
+    bool m_shortCircuitEvaluation;
+    std::size_t m_numberOfThreads;
+    bool m_columnarEvaluation;
+    bool m_sharedFunctionMemoization;
+    std::size_t m_maxPreparedTariffs;
+};
+
+} // namespace CalculusPrime
+
+#endif // #ifndef CP_RATINGENGINEOPTIONS_H
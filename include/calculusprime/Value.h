@@ -16,16 +16,22 @@ limitations under the License.
 #ifndef CP_VALUE_H
 #define CP_VALUE_H 1
 
+#include <atomic>
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
 #include <iosfwd>
-#include <boost/optional.hpp>
+#include <string>
 #include <boost/throw_exception.hpp>
+#include <boost/utility/string_view.hpp>
 #include <boost/variant.hpp>
 #include <calculusprime/internal/require.h>
 
 namespace CalculusPrime {
 
 //! \brief Generic value class for passing Double/String/Boolean values to/from the rating engine
+//! The value is a tagged union of 16 bytes, strings are immutable and reference counted,
+//! so copying a value never allocates.
 class Value
 {
 public:
@@ -33,161 +39,241 @@ public:
     typedef boost::variant<std::string, double, bool> Variant_t;
 
     Value()
+        : m_type(Type::VOID_TYPE)
     {
+        m_data.number = 0.0;
     }
 
-    explicit Value(const Variant_t& value_)
-        : m_value(value_)
-    {
-    }
+    explicit Value(const Variant_t& value_);
 
     explicit Value(const char* value_)
-        : m_value(std::string(value_))
+        : m_type(Type::STRING)
     {
+        m_data.string = createString(value_);
     }
 
     explicit Value(bool value_)
-        : m_value(value_)
+        : m_type(Type::BOOL)
     {
+        m_data.number = 0.0;
+        m_data.boolean = value_;
     }
 
     explicit Value(double value_)
-        : m_value(value_)
+        : m_type(Type::DOUBLE)
     {
+        m_data.number = value_;
     }
 
     explicit Value(const std::string& value_)
-        : m_value(value_)
+        : m_type(Type::STRING)
+    {
+        m_data.string = createString(value_);
+    }
+
+    explicit Value(boost::string_view value_)
+        : m_type(Type::STRING)
     {
+        m_data.string = createString(value_);
     }
 
     explicit Value(int value_)
-        : m_value(double(value_))
+        : m_type(Type::DOUBLE)
+    {
+        m_data.number = double(value_);
+    }
+
+    Value(const Value& value_)
+        : m_data(value_.m_data)
+        , m_type(value_.m_type)
+    {
+        addRef();
+    }
+
+    Value(Value&& value_) noexcept
+        : m_data(value_.m_data)
+        , m_type(value_.m_type)
     {
+        value_.m_type = Type::VOID_TYPE;
     }
 
     ~Value()
     {
+        release();
+    }
+
+    Value& operator=(const Value& value_)
+    {
+        if (this != &value_) {
+            value_.addRef();
+            release();
+            m_data = value_.m_data;
+            m_type = value_.m_type;
+        }
+        return *this;
+    }
+
+    Value& operator=(Value&& value_) noexcept
+    {
+        if (this != &value_) {
+            release();
+            m_data = value_.m_data;
+            m_type = value_.m_type;
+            value_.m_type = Type::VOID_TYPE;
+        }
+        return *this;
     }
 
     //! \return if the stored value is void
     bool isVoid() const
     {
-        return !m_value;
+        return m_type == Type::VOID_TYPE;
     }
 
     //! \return if the stored value is bool
     bool isBool() const
     {
-        CP_REQUIRE(m_value);
-        const bool* b = boost::get<bool>(&(*m_value));
-        return b != nullptr;
+        CP_REQUIRE(!isVoid());
+        return m_type == Type::BOOL;
     }
 
     //! \return if the stored value as bool
     bool asBool() const
     {
-        CP_REQUIRE(m_value);
-        const bool* b = boost::get<bool>(&(*m_value));
-        CP_REQUIRE(b != nullptr);
-        return *b;
+        CP_REQUIRE(m_type == Type::BOOL);
+        return m_data.boolean;
     }
 
     //! \return if the stored value is string
     bool isString() const
     {
-        CP_REQUIRE(m_value);
-        const std::string* s = boost::get<std::string>(&(*m_value));
-        return s != nullptr;
+        CP_REQUIRE(!isVoid());
+        return m_type == Type::STRING;
     }
 
     //! \return if the stored value as string
     std::string asString() const
     {
-        CP_REQUIRE(m_value);
-        const std::string* s = boost::get<std::string>(&(*m_value));
-        CP_REQUIRE(s != nullptr);
-        return *s;
+        const boost::string_view str = asStringView();
+        return std::string(str.data(), str.size());
+    }
+
+    //! \return the stored string without copying it, the view is valid as long as this value is not changed or destroyed
+    boost::string_view asStringView() const
+    {
+        CP_REQUIRE(m_type == Type::STRING);
+        return m_data.string != nullptr ? boost::string_view(m_data.string->data(), m_data.string->size) : boost::string_view();
     }
 
     //! \return if the stored value is double
     bool isDouble() const
     {
-        CP_REQUIRE(m_value);
-        const double* d = boost::get<double>(&(*m_value));
-        return d != nullptr;
+        CP_REQUIRE(!isVoid());
+        return m_type == Type::DOUBLE;
     }
 
     //! \return if the stored value as double
     double asDouble() const
     {
-        CP_REQUIRE(m_value);
-        const double* d = boost::get<double>(&(*m_value));
-        CP_REQUIRE(d != nullptr);
-        return *d;
+        CP_REQUIRE(m_type == Type::DOUBLE);
+        return m_data.number;
     }
 
     //! \brief Apply the specified visitor_ to the stored value. if the stored value is void, nothing is executed
     template <typename Visitor>
     void applyVisitor(const Visitor& visitor_) const
     {
-        if (m_value) {
-            boost::apply_visitor(visitor_, *m_value);
+        switch (m_type) {
+        case Type::STRING:
+            visitor_(asString());
+            break;
+        case Type::DOUBLE:
+            visitor_(m_data.number);
+            break;
+        case Type::BOOL:
+            visitor_(m_data.boolean);
+            break;
+        default:
+            break;
         }
     }
 
     //! \brief writes the specified value to the stream
     //! \param os_ the output stream
     //! \param value_ the value
-    friend std::ostream& operator<< (std::ostream& os_, const Value& value_)
+    friend std::ostream& operator<< (std::ostream& os_, const Value& value_);
+
+    //! \brief less than operator for two values (may not have void values)
+    //! Values of different types are ordered by their type: string < double < bool
+    friend bool operator <(const Value& lhs_, const Value& rhs_);
+
+    //! \brief equals operator for two values. if one of the values is void, false is returned
+    friend bool operator ==(const Value& lhs_, const Value& rhs_)
     {
-        if (value_.isVoid()) {
-            os_ << "VOID";
-        }
-        else if (value_.isBool()) {
-            os_ << std::boolalpha << value_.asBool();
-        }
-        else if (value_.isDouble()) {
-            // this is a hack to remove .0 from double to String conversion
-            double d = value_.asDouble();
-            long l = (long)d;
-            if (d == l) {
-                os_ << l;
-            }
-            else {
-                os_ << d;
-            }
+        if (lhs_.isVoid() || rhs_.isVoid() || lhs_.m_type != rhs_.m_type) {
+            return false;
         }
-        else if (value_.isString()) {
-            os_ << '\'' << value_.asString() << '\'';
+        switch (lhs_.m_type) {
+        case Type::DOUBLE:
+            return std::abs(lhs_.m_data.number - rhs_.m_data.number) < 0.00000000001;
+        case Type::BOOL:
+            return lhs_.m_data.boolean == rhs_.m_data.boolean;
+        default:
+            return lhs_.m_data.string == rhs_.m_data.string || lhs_.asStringView() == rhs_.asStringView();
         }
-        return os_;
     }
 
-    //! \brief less than operator for two values (may not have void values)
-    friend bool operator <(const Value& lhs_, const Value& rhs_)
+private:
+    //! \brief the type tag, the order is the order of Variant_t
+    enum class Type : std::uint8_t {
+        STRING,
+        DOUBLE,
+        BOOL,
+        VOID_TYPE
+    };
+
+    //! \brief an immutable, reference counted string, the characters follow the header
+    struct StringData
     {
-        if (!lhs_.m_value || !rhs_.m_value) {
-            BOOST_THROW_EXCEPTION(std::runtime_error("operator < not applicable for empty values"));
+        std::atomic<std::size_t> refCount;
+        std::size_t size;
+
+        const char* data() const
+        {
+            return reinterpret_cast<const char*>(this + 1);
         }
-        return *(lhs_.m_value) < *(rhs_.m_value);
-    }
+    };
 
-    //! \brief equals operator for two values. if one of the values is void, false is returned
-    friend bool operator ==(const Value& lhs_, const Value& rhs_)
+    union Data
     {
-        if (!lhs_.m_value || !rhs_.m_value) {
-            return false;
+        double number;
+        bool boolean;
+        //! nullptr for the empty string
+        StringData* string;
+    };
+
+    //! \brief returns the shared string data for the characters, nullptr for an empty string
+    static StringData* createString(boost::string_view value_);
+
+    //! \brief free the string data
+    static void destroyString(StringData* string_);
+
+    void addRef() const
+    {
+        if (m_type == Type::STRING && m_data.string != nullptr) {
+            m_data.string->refCount.fetch_add(1, std::memory_order_relaxed);
         }
-        if (lhs_.isDouble() && rhs_.isDouble()) {
-            double diff = std::abs(lhs_.asDouble() - rhs_.asDouble());
-            return diff < 0.00000000001;
+    }
+
+    void release()
+    {
+        if (m_type == Type::STRING && m_data.string != nullptr && m_data.string->refCount.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            destroyString(m_data.string);
         }
-        return *(lhs_.m_value) == *(rhs_.m_value);
     }
 
-private:
-    boost::optional<Variant_t> m_value;
+    Data m_data;
+    Type m_type;
 };
 
 } // namespace CalculusPrime
@@ -0,0 +1,104 @@
+/*
+Copyright 2019 Association for the promotion of open - source insurance software and for the establishment of open interface standards in the insurance industry
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http ://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef CP_BOUNDEDFUNCTIONRESULTCACHE_H
+#define CP_BOUNDEDFUNCTIONRESULTCACHE_H 1
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <calculusprime/cache/IFunctionResultCache.h>
+
+namespace CalculusPrime {
+
+//! \brief The policies by which BoundedFunctionResultCache evicts results
+enum class EvictionPolicy {
+    /** evicts the least recently used result */
+    LRU,
+    /** W-TinyLFU: new results enter a small LRU window (1% of the bytes), the results which leave the window only replace the least
+        recently used result of the main area if they were requested more often. The main area is a segmented LRU, results requested
+        again are protected (80% of the main area). Request frequencies are estimated by a count-min sketch which ages periodically. */
+    W_TINY_LFU
+};
+
+//! \brief A function result cache with a maximum size in bytes. The bytes of every result are accounted, including its cache key,
+//! the strings of its values and its validity periods, so the memory of a long running service is bounded. Results are
+//! separated by insurance rate key and every insurance rate key may have a quota, its own results are evicted if it exceeds the quota.
+//! Results with validity dates are evicted with all validity periods of their cache key, results with an expiry time when they are read
+//! after their expiry time. The cache is not synchronized, reading a result updates its recency and frequency.
+class BoundedFunctionResultCache : public IFunctionResultCache
+{
+public:
+    //! \brief the counters of the cache
+    struct Statistics
+    {
+        std::uint64_t hits;
+        std::uint64_t misses;
+        std::uint64_t insertions;
+        //! the number of evicted results, including the results which were not admitted by W-TinyLFU
+        std::uint64_t evictions;
+        std::uint64_t evictedBytes;
+        //! the number of results which were evicted because their insurance rate key exceeded its quota
+        std::uint64_t quotaEvictions;
+        //! the number of new results which W-TinyLFU did not admit to the main area
+        std::uint64_t rejections;
+    };
+
+    //! \param maxBytes_ the maximum number of bytes of all results
+    BoundedFunctionResultCache(std::size_t maxBytes_, EvictionPolicy evictionPolicy_ = EvictionPolicy::LRU);
+
+    virtual ~BoundedFunctionResultCache();
+
+    virtual void putFunctionResult(const std::string& insuranceRateKey_, const std::string& cacheKey_, const Value& result_) override;
+
+    virtual void putFunctionResultWithValidityDate(const std::string& insuranceRateKey_, const std::string& cacheKey_, const std::string& validFrom_,
+                                                   const std::string& validTo_, const Value& result_) override;
+
+    virtual boost::optional<Value> getFunctionResult(const std::string& insuranceRateKey_, const std::string& cacheKey_) const override;
+
+    virtual boost::optional<Value> getFunctionResultWithValidityDate(const std::string& insuranceRateKey_, const std::string& date_, const std::string& cacheKey_) const override;
+
+    virtual void putFunctionResultWithExpiry(const std::string& insuranceRateKey_, const std::string& cacheKey_, std::chrono::system_clock::time_point expiry_,
+                                             const Value& result_) override;
+
+    virtual boost::optional<Value> getFunctionResultWithExpiry(const std::string& insuranceRateKey_, std::chrono::system_clock::time_point now_,
+                                                               const std::string& cacheKey_) const override;
+
+    //! \brief set the maximum number of bytes of the results of the insurance rate key, 0 removes the quota.
+    //! Results are evicted if the insurance rate key already exceeds the quota.
+    void setQuota(const std::string& insuranceRateKey_, std::size_t maxBytes_);
+
+    //! \brief returns the number of bytes of all results
+    std::size_t getBytes() const;
+
+    //! \brief returns the number of bytes of the results of the insurance rate key
+    std::size_t getBytes(const std::string& insuranceRateKey_) const;
+
+    //! \brief returns the number of cached results, the results with validity dates of a cache key count once
+    std::size_t getNumberOfResults() const;
+
+    //! \brief returns the counters
+    Statistics getStatistics() const;
+
+private:
+    class Store;
+
+    const std::unique_ptr<Store> m_store;
+};
+
+} // namespace CalculusPrime
+
+#endif // #ifndef CP_BOUNDEDFUNCTIONRESULTCACHE_H
@@ -0,0 +1,73 @@
+/*
+Copyright 2019 Association for the promotion of open - source insurance software and for the establishment of open interface standards in the insurance industry
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http ://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef CP_CONCURRENTFUNCTIONRESULTCACHE_H
+#define CP_CONCURRENTFUNCTIONRESULTCACHE_H 1
+
+#include <cstddef>
+#include <memory>
+#include <calculusprime/cache/IFunctionResultCache.h>
+
+namespace CalculusPrime {
+
+//! \brief A function result cache which may be shared by many threads, e.g. by all worker threads of a rating service.
+//! The results are distributed over shards by the hash of their cache key, every shard keeps two copies of its results
+//! (left-right concurrency control): readers never lock or wait, they only announce themselves in a counter of the shard.
+//! A writer updates the copy which is not read, switches the readers to it, waits until the readers of the other copy are done
+//! and updates that copy as well. Only writers of the same shard are serialized, the memory of the results is needed twice.
+//! Like DefaultFunctionResultCache it does not separate insurance rate keys.
+class ConcurrentFunctionResultCache : public IFunctionResultCache
+{
+public:
+    //! \param numberOfShards_ the number of shards, rounded up to a power of two
+    explicit ConcurrentFunctionResultCache(std::size_t numberOfShards_ = DEFAULT_NUMBER_OF_SHARDS);
+
+    virtual ~ConcurrentFunctionResultCache();
+
+    virtual void putFunctionResult(const std::string& insuranceRateKey_, const std::string& cacheKey_, const Value& result_) override;
+
+    virtual void putFunctionResultWithValidityDate(const std::string& insuranceRateKey_, const std::string& cacheKey_, const std::string& validFrom_,
+                                                   const std::string& validTo_, const Value& result_) override;
+
+    virtual boost::optional<Value> getFunctionResult(const std::string& insuranceRateKey_, const std::string& cacheKey_) const override;
+
+    virtual boost::optional<Value> getFunctionResultWithValidityDate(const std::string& insuranceRateKey_, const std::string& date_, const std::string& cacheKey_) const override;
+
+    virtual void putFunctionResultWithExpiry(const std::string& insuranceRateKey_, const std::string& cacheKey_, std::chrono::system_clock::time_point expiry_,
+                                             const Value& result_) override;
+
+    virtual boost::optional<Value> getFunctionResultWithExpiry(const std::string& insuranceRateKey_, std::chrono::system_clock::time_point now_,
+                                                               const std::string& cacheKey_) const override;
+
+    //! \brief returns the number of shards
+    std::size_t getNumberOfShards() const
+    {
+        return m_shardMask + 1;
+    }
+
+    static const std::size_t DEFAULT_NUMBER_OF_SHARDS = 64;
+
+private:
+    class Shard;
+
+    Shard& getShard(const std::string& cacheKey_) const;
+
+    std::size_t m_shardMask;
+    const std::unique_ptr<Shard[]> m_shards;
+};
+
+} // namespace CalculusPrime
+
+#endif // #ifndef CP_CONCURRENTFUNCTIONRESULTCACHE_H
@@ -16,40 +16,56 @@ limitations under the License.
 #ifndef CP_DEFAULTCACHEFACTORY_H
 #define CP_DEFAULTCACHEFACTORY_H 1
 
+#include <chrono>
+#include <cstddef>
 #include <memory>
 #include <string>
-#include <unordered_map>
 
 namespace CalculusPrime {
 
 class IFunctionResultCache;
 class IParseTreeCache;
-class DefaultFunctionResultCache;
-class DefaultParseTreeCache;
 
 
-//! \brief The default cache factory returns one cache instance per insurance rate key
+//! \brief The default cache factory returns one cache instance per insurance rate key.
+//! The factory is thread-safe, the insurance rate keys are distributed over shards with their own lock, so requests for
+//! different tariffs rarely wait for each other. The caches are reference counted: a prepared tariff or rating engine keeps
+//! its caches even if the factory removes them, and the factory only evicts caches which nobody else references.
 class DefaultCacheFactory
 {
 public:
-    //! \brief returns a function result cache instance for the given insurance rate key
+    //! \brief returns a function result cache instance for the given insurance rate key. All threads which calculate the
+    //! tariff share the instance, so it is a ConcurrentFunctionResultCache.
     static std::shared_ptr<IFunctionResultCache> getFunctionResultCache(const std::string& insuranceRateKey_);
 
     //! \brief returns a parse tree cache instance for the given insurance rate key
     static std::shared_ptr<IParseTreeCache> getParseTreeCache(const std::string& insuranceRateKey_);
 
-    //! \brief clear all caches
+    //! \brief remove the caches of the insurance rate key if nobody else references them
+    //! \return true if the caches were removed
+    static bool evict(const std::string& insuranceRateKey_);
+
+    //! \brief remove the caches of the insurance rate key, the next request returns new caches.
+    //! The holders of the removed caches keep using them until they release them.
+    static void invalidate(const std::string& insuranceRateKey_);
+
+    //! \brief remove the caches of the insurance rate keys which were not requested for the idle time and which nobody else references
+    //! \return the number of removed insurance rate keys
+    static std::size_t expire(std::chrono::steady_clock::duration maxIdleTime_);
+
+    //! \brief returns the number of insurance rate keys with caches
+    static std::size_t getNumberOfInsuranceRateKeys();
+
+    //! \brief clear all caches, the holders of the caches keep using them until they release them
     static void clear();
 
 private:
     DefaultCacheFactory();
     ~DefaultCacheFactory();
 
-    typedef std::unordered_map<std::string, std::shared_ptr<DefaultFunctionResultCache>> FunctionResultCaches_t;
-    typedef std::unordered_map<std::string, std::shared_ptr<DefaultParseTreeCache>> ParseTreeCaches_t;
+    class Registry;
 
-    static FunctionResultCaches_t m_functionResultCaches;
-    static ParseTreeCaches_t m_parseTreeCaches;
+    static Registry& getRegistry();
 };
 
 } // namespace CalculusPrime
@@ -16,16 +16,19 @@ limitations under the License.
 #ifndef CP_DEFAULTFUNCTIONRESULTCACHE_H
 #define CP_DEFAULTFUNCTIONRESULTCACHE_H 1
 
-#include <set>
+#include <chrono>
 #include <unordered_map>
-#include <tuple>
 #include <calculusprime/Value.h>
 #include <calculusprime/cache/IFunctionResultCache.h>
+#include <calculusprime/cache/ValidityPeriods.h>
 
 namespace CalculusPrime {
 
 //! \brief The default function result cache implementation using std::unordered_map and no synchronization. It doesn't cache per insurance rate and therefore is not
-//! suited as a single global instance
+//! suited as a single global instance. Validity dates are stored as day numbers (see ValidityPeriods), so a lookup by date takes logarithmic time
+//! in the number of validity periods of the cache key. Dates which are not in ISO format (yyyy-mm-dd) are compared as strings.
+//! The result of an equal validity period is replaced, so a cache key keeps one result per period.
+//! Results with an expiry time are kept until they are replaced, an expired result is not found anymore.
 class DefaultFunctionResultCache : public IFunctionResultCache
 {
 public:
@@ -40,18 +43,26 @@ public:
 
     virtual boost::optional<Value> getFunctionResultWithValidityDate(const std::string& insuranceRateKey_, const std::string& date_, const std::string& cacheKey_) const override;
 
+    virtual void putFunctionResultWithExpiry(const std::string& insuranceRateKey_, const std::string& cacheKey_, std::chrono::system_clock::time_point expiry_,
+                                             const Value& result_) override;
+
+    virtual boost::optional<Value> getFunctionResultWithExpiry(const std::string& insuranceRateKey_, std::chrono::system_clock::time_point now_,
+                                                               const std::string& cacheKey_) const override;
+
 private:
     typedef std::unordered_map<std::string, Value> FunctionResultMap_t;
-    typedef std::tuple<Value, std::string, std::string> ValueWithValidity_t;
-    typedef std::unordered_map<std::string, std::set<ValueWithValidity_t>> FunctionResultWithValidityMap_t;
+    typedef std::unordered_map<std::string, ValidityPeriods> FunctionResultWithValidityMap_t;
 
-    static bool isValidFor(const ValueWithValidity_t& valueWithValidity_, const std::string& testDate_)
+    struct ExpiringResult
     {
-        return std::get<1>(valueWithValidity_) <= testDate_ && std::get<2>(valueWithValidity_) >= testDate_;
-    }
+        Value result;
+        std::chrono::system_clock::time_point expiry;
+    };
+    typedef std::unordered_map<std::string, ExpiringResult> FunctionResultWithExpiryMap_t;
 
     FunctionResultMap_t m_functionResults;
     FunctionResultWithValidityMap_t m_functionsResultsWithValidity;
+    FunctionResultWithExpiryMap_t m_functionResultsWithExpiry;
 };
 
 } // namespace CalculusPrime
@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef CP_IFUNCTIONRESULTCACHE_H
 #define CP_IFUNCTIONRESULTCACHE_H 1
 
+#include <chrono>
 #include <string>
 #include <boost/optional/optional.hpp>
 #include <calculusprime/Value.h>
@@ -23,6 +24,8 @@ limitations under the License.
 namespace CalculusPrime {
 
 //! \brief Interface for getting/putting function results from/to the caches
+//! Business functions either use it themselves or declare a caching policy (see FunctionCachingPolicy), then the rating engine
+//! looks up and stores their results.
 class IFunctionResultCache
 {
 public:
@@ -37,6 +40,7 @@ public:
     virtual void putFunctionResult(const std::string& insuranceRateKey_, const std::string& cacheKey_, const Value& result_) = 0;
 
     //! \brief cache a function result with a validity date in ISO format. This is used for functions with different results depending on the date (e.g. tarrif date)
+    //! The result of a period which was cached before with the same validFrom_ and validTo_ is replaced.
     //! \param insuranceRateKey_ the insurance rate key
     //! \param cacheKey_ the cache key
     //! \param validFrom_ valid from date
@@ -58,6 +62,28 @@ public:
     //! \return the cached value (if found) or an empty object
     virtual boost::optional<Value> getFunctionResultWithValidityDate(const std::string& insuranceRateKey_, const std::string& date_, const std::string& cacheKey_) const = 0;
 
+    //! \brief cache a function result which is only used until its expiry time. This is used for functions with a time to live
+    //! (see FunctionCachingPolicy::setTimeToLive). The default implementation does not cache the result.
+    //! \param insuranceRateKey_ the insurance rate key
+    //! \param cacheKey_ the cache key
+    //! \param expiry_ the time from which on the result is not used anymore
+    //! \param result_ the function result
+    virtual void putFunctionResultWithExpiry(const std::string& insuranceRateKey_, const std::string& cacheKey_, std::chrono::system_clock::time_point expiry_,
+                                             const Value& result_)
+    {
+    }
+
+    //! \brief get the cached function result which was put with an expiry time (see putFunctionResultWithExpiry) and has not expired yet.
+    //! The default implementation does not find any result.
+    //! \param insuranceRateKey_ the insurance rate key
+    //! \param now_ the current time
+    //! \param cacheKey_ the cache key
+    //! \return the cached value (if found and not expired at now_) or an empty object
+    virtual boost::optional<Value> getFunctionResultWithExpiry(const std::string& insuranceRateKey_, std::chrono::system_clock::time_point now_,
+                                                               const std::string& cacheKey_) const
+    {
+        return boost::none;
+    }
 };
 
 } // namespace CalculusPrime
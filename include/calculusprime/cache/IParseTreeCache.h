@@ -22,6 +22,7 @@ limitations under the License.
 namespace CalculusPrime {
 
 //! \brief Interface for getting/putting parse trees from/to the caches.
+//! The rating engine stores the compiled formula (CompiledFormula), the object is opaque to the cache.
 class IParseTreeCache
 {
 public:
@@ -0,0 +1,74 @@
+/*
+Copyright 2019 Association for the promotion of open - source insurance software and for the establishment of open interface standards in the insurance industry
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http ://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef CP_TWOLEVELFUNCTIONRESULTCACHE_H
+#define CP_TWOLEVELFUNCTIONRESULTCACHE_H 1
+
+#include <cstddef>
+#include <memory>
+#include <calculusprime/cache/IFunctionResultCache.h>
+
+namespace CalculusPrime {
+
+template <typename T>
+class ThreadLocalCache;
+
+//! \brief A function result cache in front of a cache shared by many threads. Every thread keeps the results it read or wrote
+//! in a small cache of its own (L1), so the most frequently used results are read without touching the memory of the shared cache (L2).
+//! Missing results are not kept in the L1. The results are expected not to change once cached: after the results of the shared cache
+//! were cleared or replaced, invalidate() must be called, then every thread drops its L1 on its next access.
+class TwoLevelFunctionResultCache : public IFunctionResultCache
+{
+public:
+    //! \param sharedCache_ the L2, must be thread safe (e.g. ConcurrentFunctionResultCache)
+    //! \param numberOfLocalResults_ the number of results in the L1 of every thread, rounded up to a power of two
+    explicit TwoLevelFunctionResultCache(const std::shared_ptr<IFunctionResultCache>& sharedCache_, std::size_t numberOfLocalResults_ = DEFAULT_NUMBER_OF_LOCAL_RESULTS);
+
+    virtual ~TwoLevelFunctionResultCache();
+
+    virtual void putFunctionResult(const std::string& insuranceRateKey_, const std::string& cacheKey_, const Value& result_) override;
+
+    virtual void putFunctionResultWithValidityDate(const std::string& insuranceRateKey_, const std::string& cacheKey_, const std::string& validFrom_,
+                                                   const std::string& validTo_, const Value& result_) override;
+
+    virtual boost::optional<Value> getFunctionResult(const std::string& insuranceRateKey_, const std::string& cacheKey_) const override;
+
+    virtual boost::optional<Value> getFunctionResultWithValidityDate(const std::string& insuranceRateKey_, const std::string& date_, const std::string& cacheKey_) const override;
+
+    virtual void putFunctionResultWithExpiry(const std::string& insuranceRateKey_, const std::string& cacheKey_, std::chrono::system_clock::time_point expiry_,
+                                             const Value& result_) override;
+
+    virtual boost::optional<Value> getFunctionResultWithExpiry(const std::string& insuranceRateKey_, std::chrono::system_clock::time_point now_,
+                                                               const std::string& cacheKey_) const override;
+
+    //! \brief drop the results of the L1 of all threads, call it after the shared cache was cleared
+    void invalidate();
+
+    //! \brief returns the shared cache
+    const std::shared_ptr<IFunctionResultCache>& getSharedCache() const
+    {
+        return m_sharedCache;
+    }
+
+    static const std::size_t DEFAULT_NUMBER_OF_LOCAL_RESULTS = 1024;
+
+private:
+    const std::shared_ptr<IFunctionResultCache> m_sharedCache;
+    const std::unique_ptr<ThreadLocalCache<Value>> m_localCache;
+};
+
+} // namespace CalculusPrime
+
+#endif // #ifndef CP_TWOLEVELFUNCTIONRESULTCACHE_H
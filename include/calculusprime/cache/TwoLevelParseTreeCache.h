@@ -0,0 +1,71 @@
+/*
+Copyright 2019 Association for the promotion of open - source insurance software and for the establishment of open interface standards in the insurance industry
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http ://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef CP_TWOLEVELPARSETREECACHE_H
+#define CP_TWOLEVELPARSETREECACHE_H 1
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <calculusprime/cache/IParseTreeCache.h>
+
+namespace CalculusPrime {
+
+template <typename T>
+class ThreadLocalCache;
+
+//! \brief A parse tree cache in front of a cache shared by many threads. Every thread keeps the parse trees it read or wrote
+//! in a small cache of its own (L1), only the other lookups lock the shared cache (L2), so any IParseTreeCache may be shared
+//! (e.g. DefaultParseTreeCache). After the parse trees of the shared cache were cleared or replaced, invalidate() must be called,
+//! then every thread drops its L1 on its next access.
+class TwoLevelParseTreeCache : public IParseTreeCache
+{
+public:
+    //! \param sharedCache_ the L2
+    //! \param numberOfLocalParseTrees_ the number of parse trees in the L1 of every thread, rounded up to a power of two
+    explicit TwoLevelParseTreeCache(const std::shared_ptr<IParseTreeCache>& sharedCache_, std::size_t numberOfLocalParseTrees_ = DEFAULT_NUMBER_OF_LOCAL_PARSE_TREES);
+
+    virtual ~TwoLevelParseTreeCache();
+
+    virtual void putParseTree(const std::string& insuranceRateKey_, const std::string& cacheKey_, const std::shared_ptr<void>& parseTree_) override;
+
+    virtual std::shared_ptr<void> getParseTree(const std::string& insuranceRateKey_, const std::string& cacheKey_) const override;
+
+    //! \brief drop the parse trees of the L1 of all threads, call it after the shared cache was cleared
+    void invalidate();
+
+    //! \brief returns the shared cache, it must only be used while holding the lock of getSharedCacheMutex()
+    const std::shared_ptr<IParseTreeCache>& getSharedCache() const
+    {
+        return m_sharedCache;
+    }
+
+    //! \brief returns the mutex which serializes the access to the shared cache
+    std::mutex& getSharedCacheMutex() const
+    {
+        return m_sharedCacheMutex;
+    }
+
+    static const std::size_t DEFAULT_NUMBER_OF_LOCAL_PARSE_TREES = 256;
+
+private:
+    const std::shared_ptr<IParseTreeCache> m_sharedCache;
+    mutable std::mutex m_sharedCacheMutex;
+    const std::unique_ptr<ThreadLocalCache<std::shared_ptr<void>>> m_localCache;
+};
+
+} // namespace CalculusPrime
+
+#endif // #ifndef CP_TWOLEVELPARSETREECACHE_H
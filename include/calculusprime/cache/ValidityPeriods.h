@@ -0,0 +1,92 @@
+/*
+Copyright 2019 Association for the promotion of open - source insurance software and for the establishment of open interface standards in the insurance industry
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http ://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef CP_VALIDITYPERIODS_H
+#define CP_VALIDITYPERIODS_H 1
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <boost/optional/optional.hpp>
+#include <calculusprime/Value.h>
+
+namespace CalculusPrime {
+
+//! \brief The results of a cache key with their validity periods as day numbers, sorted by their first day.
+//! The latest last day of all periods up to each period is kept as well, so a lookup finds the last period which starts
+//! before the date by binary search and only goes back while an earlier period may still contain the date.
+//! Periods and dates which are not in ISO format (yyyy-mm-dd) are compared as strings instead, by a linear search.
+class ValidityPeriods
+{
+public:
+    struct Period
+    {
+        std::int32_t validFrom;
+        std::int32_t validTo;
+        Value result;
+    };
+
+    //! \brief a period of which a date is not in ISO format
+    struct StringPeriod
+    {
+        std::string validFrom;
+        std::string validTo;
+        Value result;
+    };
+
+    ValidityPeriods();
+
+    ~ValidityPeriods();
+
+    //! \brief add the period, the result of an equal period is replaced instead
+    //! \return the replaced result, empty if the period was added
+    boost::optional<Value> insert(std::int32_t validFrom_, std::int32_t validTo_, const Value& result_);
+
+    //! \brief add the period as day numbers if both dates are in ISO format, otherwise as strings
+    //! \return the replaced result of an equal period, empty if the period was added
+    boost::optional<Value> insert(const std::string& validFrom_, const std::string& validTo_, const Value& result_);
+
+    //! \brief returns the result of the period which contains the day, of overlapping periods the one which starts last
+    boost::optional<Value> find(std::int32_t day_) const;
+
+    //! \brief returns the result of the period which contains the date. A date in ISO format is looked up by its day number
+    //! and only compared with the periods as strings if none contains it, any other date is compared with all periods as strings.
+    boost::optional<Value> find(const std::string& date_) const;
+
+    //! \brief returns the periods, sorted by their first day
+    const std::vector<Period>& getPeriods() const
+    {
+        return m_periods;
+    }
+
+    //! \brief returns the periods which are compared as strings, in the order they were added
+    const std::vector<StringPeriod>& getStringPeriods() const
+    {
+        return m_stringPeriods;
+    }
+
+    //! \brief returns the day number of a date in ISO format (yyyy-mm-dd), empty if it is not such a date
+    static boost::optional<std::int32_t> toDayNumber(const std::string& date_);
+
+private:
+    std::vector<Period> m_periods;
+    std::vector<StringPeriod> m_stringPeriods;
+    //! \brief the latest last day of the periods up to the same index
+    std::vector<std::int32_t> m_maxValidTo;
+};
+
+} // namespace CalculusPrime
+
+#endif // #ifndef CP_VALIDITYPERIODS_H
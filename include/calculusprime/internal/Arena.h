@@ -0,0 +1,147 @@
+/*
+Copyright 2019 Association for the promotion of open - source insurance software and for the establishment of open interface standards in the insurance industry
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http ://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef CP_ARENA_H
+#define CP_ARENA_H 1
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+namespace CalculusPrime {
+
+//! \brief A monotonic allocator for the temporary objects of one calculation.
+//! Memory is taken from chunks of growing size, the first chunk is part of the arena. Deallocation does nothing,
+//! all chunks are released at once when the arena is destroyed. The arena must outlive every object allocated from it
+//! and it must only be used by one thread at a time.
+class Arena
+{
+public:
+    Arena()
+        : m_next(m_initialChunk)
+        , m_end(m_initialChunk + INITIAL_CHUNK_SIZE)
+        , m_chunks(nullptr)
+        , m_nextChunkSize(2 * INITIAL_CHUNK_SIZE)
+    {
+    }
+
+    Arena(const Arena&) = delete;
+
+    Arena& operator=(const Arena&) = delete;
+
+    ~Arena();
+
+    //! \brief allocate size_ bytes with the alignment alignment_ (a power of two)
+    void* allocate(std::size_t size_, std::size_t alignment_)
+    {
+        char* const result = align(m_next, alignment_);
+        if (result > m_end || size_ > static_cast<std::size_t>(m_end - result)) {
+            return allocateChunk(size_, alignment_);
+        }
+        m_next = result + size_;
+        return result;
+    }
+
+private:
+    static const std::size_t INITIAL_CHUNK_SIZE = 2048;
+    static const std::size_t MAX_CHUNK_SIZE = 65536;
+
+    //! \brief the header of an allocated chunk, followed by the memory of the chunk
+    struct Chunk
+    {
+        Chunk* previous;
+    };
+
+    static char* align(char* pointer_, std::size_t alignment_)
+    {
+        const std::uintptr_t address = reinterpret_cast<std::uintptr_t>(pointer_);
+        return pointer_ + ((alignment_ - address % alignment_) % alignment_);
+    }
+
+    //! \brief allocate a new chunk and the memory from it
+    void* allocateChunk(std::size_t size_, std::size_t alignment_);
+
+    alignas(std::max_align_t) char m_initialChunk[INITIAL_CHUNK_SIZE];
+    char* m_next;
+    char* m_end;
+    //! \brief the allocated chunks, the last one first
+    Chunk* m_chunks;
+    std::size_t m_nextChunkSize;
+};
+
+//! \brief A standard allocator which allocates from an arena, or from the heap without an arena.
+//! Containers and shared pointers which are created with it must not outlive the arena.
+template <class T>
+class ArenaAllocator
+{
+public:
+    typedef T value_type;
+
+    ArenaAllocator() noexcept
+        : m_arena(nullptr)
+    {
+    }
+
+    //! \param arena_ the arena, nullptr for the heap
+    ArenaAllocator(Arena* arena_) noexcept
+        : m_arena(arena_)
+    {
+    }
+
+    template <class U>
+    ArenaAllocator(const ArenaAllocator<U>& other_) noexcept
+        : m_arena(other_.getArena())
+    {
+    }
+
+    T* allocate(std::size_t n_)
+    {
+        if (m_arena != nullptr) {
+            return static_cast<T*>(m_arena->allocate(n_ * sizeof(T), alignof(T)));
+        }
+        return static_cast<T*>(::operator new(n_ * sizeof(T)));
+    }
+
+    void deallocate(T* pointer_, std::size_t) noexcept
+    {
+        if (m_arena == nullptr) {
+            ::operator delete(pointer_);
+        }
+    }
+
+    Arena* getArena() const noexcept
+    {
+        return m_arena;
+    }
+
+private:
+    Arena* m_arena;
+};
+
+template <class T, class U>
+inline bool operator==(const ArenaAllocator<T>& lhs_, const ArenaAllocator<U>& rhs_) noexcept
+{
+    return lhs_.getArena() == rhs_.getArena();
+}
+
+template <class T, class U>
+inline bool operator!=(const ArenaAllocator<T>& lhs_, const ArenaAllocator<U>& rhs_) noexcept
+{
+    return lhs_.getArena() != rhs_.getArena();
+}
+
+} // namespace CalculusPrime
+
+#endif // #ifndef CP_ARENA_H
@@ -0,0 +1,53 @@
+/*
+Copyright 2019 Association for the promotion of open - source insurance software and for the establishment of open interface standards in the insurance industry
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http ://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef CP_FUNCTIONRESULTCACHING_H
+#define CP_FUNCTIONRESULTCACHING_H 1
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <calculusprime/Value.h>
+
+namespace CalculusPrime {
+
+class IFunction;
+class ParsingContext;
+
+//! \brief Caches the results of business functions as declared by their caching policy (see IFunction::getCachingPolicy).
+//! Results of the scope CALCULATION are kept in the function memo of the parsing context (see ParsingContext::getFunctionMemo),
+//! results of the scope TARIFF in the function result cache of the rating engine. The results of functions with a time to live
+//! are cached with their expiry time (see IFunctionResultCache::putFunctionResultWithExpiry).
+class FunctionResultCaching
+{
+public:
+    //! \brief returns the cached result of the function for the arguments, the function is executed and its result cached if there is none
+    //! \param functionId_ the id of the function (see FunctionIdBuilder)
+    static Value execute(IFunction& function_, const std::string& functionId_, const std::vector<Value>& arguments_, const std::shared_ptr<ParsingContext>& parsingContext_);
+
+    //! \brief returns the cache key of a function call: the function id followed by the type and the binary representation of every argument,
+    //! so it is neither ambiguous nor formatted
+    static std::string createKey(const std::string& functionId_, const std::vector<Value>& arguments_);
+
+private:
+    FunctionResultCaching();
+
+    ~FunctionResultCaching();
+};
+
+} // namespace CalculusPrime
+
+#endif // #ifndef CP_FUNCTIONRESULTCACHING_H
@@ -16,12 +16,19 @@ limitations under the License.
 #ifndef CP_PARSINGCONTEXT_H
 #define CP_PARSINGCONTEXT_H 1
 
+#include <atomic>
 #include <memory>
 #include <vector>
 #include <unordered_map>
+#include <boost/container/small_vector.hpp>
 #include <calculusprime/IParsingContext.h>
 #include <calculusprime/Logging.h>
+#include <calculusprime/RatingEngineOptions.h>
 #include <calculusprime/Value.h>
+#include <calculusprime/internal/Arena.h>
+#include <calculusprime/internal/compiler/ArgumentStack.h>
+#include <calculusprime/internal/parsing/FunctionMemo.h>
+#include <calculusprime/internal/compiler/SymbolTable.h>
 
 namespace CalculusPrime {
 class IFunction;
@@ -30,23 +37,70 @@ class IValueHolder;
 //! \brief The IParsingContext implementation for the rating engine
 class ParsingContext : public IParsingContext, public std::enable_shared_from_this<ParsingContext>
 {
-    typedef std::unordered_map<std::string, std::shared_ptr<IFunction>> FunctionMap_t;
-
 public:
+    //! \brief the functions by their function id (see FunctionIdBuilder)
+    typedef SymbolTable::FunctionMap_t FunctionMap_t;
+
     ParsingContext(const std::vector<std::shared_ptr<IFunction>>& functions_, const std::shared_ptr<IFunctionResultCache>& functionResultCache_, const std::shared_ptr<IParseTreeCache> parseTreeCache_,
                    const std::string& insuranceRateKey_, const log4cplus::Logger& logger_)
-        : m_functionResultCache(functionResultCache_)
+        : m_root(this)
+        , m_outer(nullptr)
+        , m_functionResultCache(functionResultCache_)
         , m_parseTreeCache(parseTreeCache_)
         , m_insuranceRateKey(insuranceRateKey_)
+        , m_functions(std::make_shared<FunctionMap_t>())
+        , m_arena(nullptr)
+        , m_bindsVariables(true)
+        , m_instanceScope(this)
+        , m_instanceOrdinal(0)
         , m_logger(logger_)
         , m_functionDurationsMicroSecs(0)
+        , m_evaluationBackend(EvaluationBackend::TREE)
+        , m_shortCircuitEvaluation(false)
+        , m_ownArgumentStack(new ArgumentStack())
+        , m_argumentStack(m_ownArgumentStack.get())
+        , m_ownFunctionMemo(new FunctionMemo())
+        , m_functionMemo(m_ownFunctionMemo.get())
     {
         for (const std::shared_ptr<IFunction>& function : functions_) {
             addFunction(function);
         }
     }
 
-    ParsingContext(const std::shared_ptr<ParsingContext>& parent_);
+    //! \brief constructor for a function map and a symbol table which were created in advance (e.g. by a prepared tariff).
+    //! The map is shared, it is copied when a function is added to this parsing context.
+    //! The variables of the symbol table are stored in slots, the symbol table may be empty.
+    ParsingContext(const std::shared_ptr<FunctionMap_t>& functions_, const std::shared_ptr<const SymbolTable>& symbolTable_, const std::shared_ptr<IFunctionResultCache>& functionResultCache_,
+                   const std::shared_ptr<IParseTreeCache> parseTreeCache_, const std::string& insuranceRateKey_, const log4cplus::Logger& logger_)
+        : m_root(this)
+        , m_outer(nullptr)
+        , m_functionResultCache(functionResultCache_)
+        , m_parseTreeCache(parseTreeCache_)
+        , m_insuranceRateKey(insuranceRateKey_)
+        , m_functions(functions_)
+        , m_symbolTable(symbolTable_)
+        , m_arena(nullptr)
+        , m_slots(symbolTable_ ? symbolTable_->getNumberOfSymbols() : 0)
+        , m_bindsVariables(true)
+        , m_instanceScope(this)
+        , m_instanceOrdinal(0)
+        , m_logger(logger_)
+        , m_functionDurationsMicroSecs(0)
+        , m_evaluationBackend(EvaluationBackend::TREE)
+        , m_shortCircuitEvaluation(false)
+        , m_ownArgumentStack(new ArgumentStack())
+        , m_argumentStack(m_ownArgumentStack.get())
+        , m_ownFunctionMemo(new FunctionMemo())
+        , m_functionMemo(m_ownFunctionMemo.get())
+    {
+    }
+
+    //! \brief constructor for a child scope, e.g. of a function call. Nothing is copied from the parent:
+    //! the scope only holds its own variables (e.g. the function arguments), all other variables are looked up
+    //! in the enclosing scopes, without their function arguments. The functions, the caches and the options are those of the root context.
+    //! \param shareArgumentStack_ false for a context which is used by another thread than the parent,
+    //! it neither shares the argument stack, the arena nor the function memo of the parent
+    ParsingContext(const std::shared_ptr<ParsingContext>& parent_, bool shareArgumentStack_ = true);
 
     virtual ~ParsingContext();
 
@@ -60,9 +114,24 @@ public:
 
     virtual const std::string& getInstanceId() const override;
 
+    //! \brief set an instance id which is not interned, its instance ordinal is 0
     void setInstanceId(const std::string& instanceId_)
+    {
+        setInstanceId(instanceId_, 0);
+    }
+
+    //! \brief set the instance id and its ordinal interned by the prepared tariff
+    void setInstanceId(const std::string& instanceId_, std::uint32_t instanceOrdinal_)
     {
         m_instanceId = instanceId_;
+        m_instanceScope = this;
+        m_instanceOrdinal = instanceOrdinal_;
+    }
+
+    //! \brief returns the ordinal of the instance id in the calculated variables (see CalculatedVariables)
+    std::uint32_t getInstanceOrdinal() const
+    {
+        return m_instanceOrdinal;
     }
 
     void setCurrentRatingoutputVariable(const std::string& currentRatingoutputVariable_)
@@ -73,65 +142,159 @@ public:
     //! \brief get the function implementation for the specified id. Returns an empty object if not found
     std::shared_ptr<IFunction> getFunction(const std::string& id_) const
     {
-        FunctionMap_t::const_iterator it = m_functions.find(id_);
-        return it != m_functions.end() ? it->second : std::shared_ptr<IFunction>();
+        const FunctionMap_t& functions = *m_root->m_functions;
+        FunctionMap_t::const_iterator it = functions.find(id_);
+        return it != functions.end() ? it->second : std::shared_ptr<IFunction>();
     }
 
     const log4cplus::Logger& getLogger() const
     {
-        return m_logger;
+        return m_root->m_logger;
+    }
+
+    //! \brief returns the argument buffers of the function calls, shared with the child contexts of the same thread
+    ArgumentStack& getArgumentStack()
+    {
+        return *m_argumentStack;
+    }
+
+    //! \brief returns the results of the pure formula functions of the calculation, shared with the child contexts of the same thread
+    FunctionMemo& getFunctionMemo()
+    {
+        return *m_functionMemo;
+    }
+
+    //! \brief returns the arena of the calculation, nullptr if the temporary objects are allocated from the heap
+    Arena* getArena() const
+    {
+        return m_arena;
+    }
+
+    //! \brief set the arena the temporary objects of the calculation are allocated from (see Arena),
+    //! it is shared with the child contexts which are used by the same thread
+    void setArena(Arena* arena_)
+    {
+        m_arena = arena_;
     }
 
-    //! \brief add a function to this parsing context
+    //! \brief returns the symbol table of the prepared tariff, may be empty
+    const std::shared_ptr<const SymbolTable>& getSymbolTable() const
+    {
+        return m_root->m_symbolTable;
+    }
+
+    //! \brief returns the backend the formulas are evaluated with
+    EvaluationBackend getEvaluationBackend() const
+    {
+        return m_root->m_evaluationBackend;
+    }
+
+    //! \brief set the backend of the root context
+    void setEvaluationBackend(EvaluationBackend evaluationBackend_)
+    {
+        m_root->m_evaluationBackend = evaluationBackend_;
+    }
+
+    //! \brief returns if And and Or are evaluated with short circuit semantics
+    bool isShortCircuitEvaluation() const
+    {
+        return m_root->m_shortCircuitEvaluation;
+    }
+
+    //! \brief set the short circuit semantics of the root context
+    void setShortCircuitEvaluation(bool shortCircuitEvaluation_)
+    {
+        m_root->m_shortCircuitEvaluation = shortCircuitEvaluation_;
+    }
+
+    //! \brief add a function to this parsing context, which must be a root context
     void addFunction(const std::shared_ptr<IFunction>& function_);
 
+    //! \brief add a function to the function map
+    static void addFunction(FunctionMap_t& functions_, const std::shared_ptr<IFunction>& function_);
+
     //! \brief add a variable and its holder class to this parsing context
     void assignParam(const std::string& variableName_, const std::shared_ptr<IValueHolder>& valueHolder_);
 
-    //! \brief add the calculated result for the variable to this parsing context
-    void addCalculatedVariable(const std::string& variableName_, const Value& value_);
+    //! \brief add a variable and its holder class to the slot of the symbol table
+    void assignParam(std::uint32_t slot_, const std::shared_ptr<IValueHolder>& valueHolder_);
 
     //! \brief return sum of the function durations
     uint64_t getFunctionDurationsMicroSecs() const
     {
-        return m_parent ? m_parent->getFunctionDurationsMicroSecs() : m_functionDurationsMicroSecs;
+        return m_root->m_functionDurationsMicroSecs.load();
     }
 
-    //! \brief add a function duration to the parent (if it exists) or th the own counter
+    //! \brief add a function duration to the counter of the root context
     void addFunctionDurationMicroSecs(uint64_t microSecs_)
     {
-        if (m_parent) {
-            m_parent->addFunctionDurationMicroSecs(microSecs_);
-        }
-        else {
-            m_functionDurationsMicroSecs += microSecs_;
-        }
+        m_root->m_functionDurationsMicroSecs += microSecs_;
     }
 
     //! \brief resolve the value for the specified variable
     Value resolve(const std::string& variable_);
 
+    //! \brief resolve the value for the variable stored in the slot of the symbol table
+    //! \param slot_ the slot of the variable
+    //! \param variable_ the variable name, only used for error messages
+    Value resolve(std::uint32_t slot_, const std::string& variable_);
+
 private:
-    typedef std::unordered_map<std::string, Value> ValueMap_t;
-    typedef std::unordered_map<std::string, std::shared_ptr<ValueMap_t>> CalculatedVariableMap_t;
-    typedef std::unordered_map<std::string, std::shared_ptr<IValueHolder>> ValueHolderMap_t;
+    typedef std::unordered_map<std::string, std::shared_ptr<IValueHolder>, std::hash<std::string>, std::equal_to<std::string>,
+                               ArenaAllocator<std::pair<const std::string, std::shared_ptr<IValueHolder>>>> ValueHolderMap_t;
+    typedef std::vector<std::shared_ptr<IValueHolder>> ValueHolderSlots_t;
+    //! \brief a variable of the symbol table which is bound in a child scope
+    typedef std::pair<std::uint32_t, std::shared_ptr<IValueHolder>> SlotBinding_t;
+    typedef boost::container::small_vector<SlotBinding_t, 4> SlotBindings_t;
 
-    const FunctionMap_t& getFunctions() const
-    {
-        return m_functions;
-    }
+    //! \brief returns the value holder of the slot in this scope, nullptr if the scope does not bind the variable
+    const std::shared_ptr<IValueHolder>* findSlot(std::uint32_t slot_) const;
+
+    //! \brief returns the value holder of the variable in this scope, nullptr if the scope does not bind the variable
+    const std::shared_ptr<IValueHolder>* findVariable(const std::string& lowerCaseName_) const;
+
+    //! \brief returns the value of the holder, throws if it has no value for the current instance
+    Value getValue(IValueHolder& valueHolder_, const std::string& variable_);
 
     const std::shared_ptr<ParsingContext> m_parent;
+    //! \brief holds the functions, the caches and the options of the calculation, this for a root context
+    ParsingContext* const m_root;
+    //! \brief the nearest enclosing scope which binds variables other than function arguments, nullptr for a root context
+    const ParsingContext* const m_outer;
+    // the members up to m_symbolTable are only set in a root context
     const std::shared_ptr<IFunctionResultCache> m_functionResultCache;
     const std::shared_ptr<IParseTreeCache> m_parseTreeCache;
     const std::string m_insuranceRateKey;
-    FunctionMap_t m_functions;
+    //! \brief shared with the child contexts, copied on write
+    std::shared_ptr<FunctionMap_t> m_functions;
+    const std::shared_ptr<const SymbolTable> m_symbolTable;
+    //! \brief may be nullptr, declared before the containers which allocate from it
+    Arena* m_arena;
+    //! \brief the value holders of the variables of the symbol table, only in a root context
+    ValueHolderSlots_t m_slots;
+    //! \brief the variables of the symbol table which are bound in a child scope
+    SlotBindings_t m_slotBindings;
+    //! \brief true if this scope binds variables other than function arguments
+    bool m_bindsVariables;
     std::string m_instanceId;
+    //! \brief the scope whose instance id is the instance id of this scope
+    const ParsingContext* m_instanceScope;
+    std::uint32_t m_instanceOrdinal;
     std::string m_currentRatingoutputVariable;
-    CalculatedVariableMap_t m_calculatedVariables;
+    //! \brief the value holders of the variables which are not in the symbol table and bound in this scope
     ValueHolderMap_t m_variables;
+    // the members up to m_shortCircuitEvaluation are only used in a root context
     log4cplus::Logger m_logger;
-    uint64_t m_functionDurationsMicroSecs;
+    //! \brief atomic, the rating outputs of a calculation may be calculated concurrently
+    std::atomic<uint64_t> m_functionDurationsMicroSecs;
+    EvaluationBackend m_evaluationBackend;
+    bool m_shortCircuitEvaluation;
+    //! \brief the argument stack of a root context or of a child context for another thread
+    const std::unique_ptr<ArgumentStack> m_ownArgumentStack;
+    ArgumentStack* const m_argumentStack;
+    //! \brief the function memo of a root context or of a child context for another thread
+    const std::unique_ptr<FunctionMemo> m_ownFunctionMemo;
+    FunctionMemo* const m_functionMemo;
 };
 
 } // namespace CalculusPrime
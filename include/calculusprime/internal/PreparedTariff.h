@@ -0,0 +1,179 @@
+/*
+Copyright 2019 Association for the promotion of open - source insurance software and for the establishment of open interface standards in the insurance industry
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http ://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef CP_PREPAREDTARIFF_H
+#define CP_PREPAREDTARIFF_H 1
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include <boost/optional.hpp>
+#include <calculusprime/IPreparedTariff.h>
+#include <calculusprime/Logging.h>
+#include <calculusprime/RatingEngineOptions.h>
+#include <calculusprime/internal/ParsingContext.h>
+
+namespace CalculusPrime {
+
+class CompiledFormula;
+class Function;
+class IFunctionResultCache;
+class IParseTreeCache;
+class ThreadPool;
+
+//! \brief The IPreparedTariff implementation.
+//! Formula functions are created and added to the function map, the lazily evaluated formulas
+//! and the rating outputs are sorted once. All formulas are compiled and bound to the symbol table of the tariff,
+//! so their variables are resolved by slot. With a thread pool, the independent rating outputs are calculated concurrently
+//! level by level (see DependencyGraph::getOutputLevels). With columnar evaluation, calculateBatch evaluates the numeric
+//! rating outputs which only read input parameters for all inputs at once (see ColumnarEvaluator), and every calculation
+//! evaluates the rating outputs of one variable for many instances at once. The results of pure formula functions are memoized.
+class PreparedTariff : public IPreparedTariff
+{
+public:
+    PreparedTariff(const ParsingContext::FunctionMap_t& functions_, const std::shared_ptr<IFunctionResultCache>& functionResultCache_, const std::shared_ptr<IParseTreeCache>& parseTreeCache_,
+                   const RatingEngineOptions& options_, const std::shared_ptr<ThreadPool>& threadPool_, const log4cplus::Logger& logger_,
+                   const std::string& insuranceRateKey_, const IRatingEngine::RatingFormulaMap_t& ratingFormulas_, const std::vector<RatingOutput>& ratingOutput_);
+
+    virtual ~PreparedTariff();
+
+    virtual const std::string& getInsuranceRateKey() const override
+    {
+        return m_insuranceRateKey;
+    }
+
+    virtual const std::vector<RatingOutput>& getRatingOutput() const override
+    {
+        return m_ratingOutput;
+    }
+
+    virtual IRatingEngine::Map_t calculate(const IRatingEngine::Map_t& input_) const override;
+
+    virtual std::vector<IRatingEngine::BatchResult> calculateBatch(const std::vector<IRatingEngine::Map_t>& inputs_) const override;
+
+    virtual std::vector<std::string> checkShortCircuitEvaluation() const override;
+
+    virtual const DependencyGraph& getDependencyGraph() const override
+    {
+        return m_dependencyGraph;
+    }
+
+private:
+    //! \brief a formula which is evaluated lazily when its variable is referenced
+    struct LazyFormula
+    {
+        std::string variableName;
+        std::string formula;
+        std::uint32_t slot;
+        //! the lower case names of the variables the formula reads directly or through other formulas
+        std::vector<std::string> inputNames;
+        //! see DependencyGraph::Node::instanceInvariant
+        bool instanceInvariant;
+    };
+
+    //! \brief a rating output which is evaluated column by column
+    struct ColumnarOutput
+    {
+        //! the index of the rating output
+        std::size_t output;
+        std::shared_ptr<CompiledFormula> compiledFormula;
+        //! the lower case names of the identifiers of the formula
+        std::vector<std::string> identifiers;
+    };
+
+    //! \brief consecutive rating outputs of different instances with the same variable name and formula, evaluated column by column
+    struct InstanceGroup
+    {
+        //! the index of the first rating output
+        std::size_t firstOutput;
+        std::size_t numberOfOutputs;
+        const SymbolTable::BoundFormula* boundFormula;
+    };
+
+    //! \brief the values of the rating outputs of one input which were evaluated column by column, indexed like m_ratingOutput
+    typedef std::vector<boost::optional<Value>> PrecalculatedValues_t;
+
+    //! \brief compile the formula and bind it to the symbol table
+    //! \param name_ the name of the rating formula or the variable name of the rating output
+    //! \param cacheKey_ the variable name or the function id
+    void bind(const std::shared_ptr<ParsingContext>& parsingContext_, const std::string& name_, const std::string& cacheKey_, const std::string& formula_);
+
+    //! \brief calculate the results from the input parameters
+    //! \param threadPool_ calculates independent rating outputs concurrently, may be nullptr
+    //! \param precalculated_ the values of the rating outputs evaluated column by column, may be nullptr (only without thread pool)
+    IRatingEngine::Map_t calculate(const IRatingEngine::Map_t& input_, ThreadPool* threadPool_, const PrecalculatedValues_t* precalculated_) const;
+
+    //! \brief evaluate the columnar rating outputs for the inputs [first_, last_)
+    void calculateColumnar(const std::vector<IRatingEngine::Map_t>& inputs_, std::size_t first_, std::size_t last_, std::vector<PrecalculatedValues_t>& precalculated_) const;
+
+    //! \brief evaluate the rating outputs of the instance group which are not precalculated, one lane per instance
+    //! \param values_ receives the values of the rating outputs of the group, empty for the lanes which must be calculated separately
+    void calculateInstanceGroup(const std::shared_ptr<ParsingContext>& parsingContext_, const InstanceGroup& group_, const PrecalculatedValues_t* precalculated_, PrecalculatedValues_t& values_) const;
+
+    //! \brief find the rating outputs which can be evaluated column by column
+    void findColumnarOutputs();
+
+    //! \brief find the instance groups
+    void findInstanceGroups();
+
+    //! \brief calculate the value of the rating output
+    //! \param output_ the index of the rating output
+    Value calculateOutput(const std::shared_ptr<ParsingContext>& parsingContext_, std::size_t output_) const;
+
+    //! \brief intern the instance ids and the variable names of the rating outputs
+    void internRatingOutputs();
+
+    //! \brief build the dependency graph from the bound formulas
+    void buildDependencyGraph(const std::vector<std::shared_ptr<Function>>& formulaFunctions_, const std::vector<std::string>& formulaFunctionNames_);
+
+    //! \brief mark the formula functions which only read their arguments and only call pure functions as pure (see Function::isPure)
+    void findPureFunctions(const std::vector<std::shared_ptr<Function>>& formulaFunctions_);
+
+    //! \brief find the instance invariant nodes and the input names of the lazily evaluated formulas
+    void analyzeInstanceInvariance(std::vector<DependencyGraph::Node>& nodes_);
+
+    const std::string m_insuranceRateKey;
+    //! \brief the business functions and the formula functions
+    const std::shared_ptr<ParsingContext::FunctionMap_t> m_functions;
+    const std::shared_ptr<SymbolTable> m_symbolTable;
+    const std::shared_ptr<IFunctionResultCache> m_functionResultCache;
+    const std::shared_ptr<IParseTreeCache> m_parseTreeCache;
+    const RatingEngineOptions m_options;
+    //! \brief calculates the rating outputs concurrently, may be nullptr
+    const std::shared_ptr<ThreadPool> m_threadPool;
+    const log4cplus::Logger m_logger;
+    std::vector<LazyFormula> m_lazyFormulas;
+    std::vector<RatingOutput> m_ratingOutput;
+    //! \brief the names of the bound formulas and their cache keys
+    std::vector<std::pair<std::string, std::string>> m_boundFormulas;
+    DependencyGraph m_dependencyGraph;
+    std::vector<ColumnarOutput> m_columnarOutputs;
+    //! \brief sorted by the first rating output
+    std::vector<InstanceGroup> m_instanceGroups;
+    //! \brief the slots of the calculated variables (see CalculatedVariables)
+    std::vector<std::uint32_t> m_calculatedSlots;
+    //! \brief the number of interned instance ids, including the empty instance id
+    std::size_t m_numberOfInstances;
+    //! \brief the calculated variable of every rating output, indexed like m_ratingOutput
+    std::vector<std::uint32_t> m_outputVariables;
+    //! \brief the instance ordinal of every rating output, indexed like m_ratingOutput
+    std::vector<std::uint32_t> m_outputInstances;
+};
+
+} // namespace CalculusPrime
+
+#endif // #ifndef CP_PREPAREDTARIFF_H
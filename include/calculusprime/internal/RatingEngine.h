@@ -16,9 +16,14 @@ limitations under the License.
 #ifndef CP_RATINGENGINE_H
 #define CP_RATINGENGINE_H 1
 
+#include <list>
+#include <mutex>
+#include <unordered_map>
 #include <vector>
 #include <calculusprime/IRatingEngine.h>
 #include <calculusprime/Logging.h>
+#include <calculusprime/RatingEngineOptions.h>
+#include <calculusprime/internal/ParsingContext.h>
 
 
 namespace CalculusPrime {
@@ -26,23 +31,59 @@ namespace CalculusPrime {
 class IFunction;
 class IFunctionResultCache;
 class IParseTreeCache;
+class PreparedTariff;
+class ThreadPool;
 
 
 class RatingEngine : public IRatingEngine
 {
 public:
 
-    RatingEngine(const std::vector<std::shared_ptr<IFunction>>& functions_, const std::shared_ptr<IFunctionResultCache>& functionResultCache_, const std::shared_ptr<IParseTreeCache>& parseTreeCache_);
+    RatingEngine(const std::vector<std::shared_ptr<IFunction>>& functions_, const std::shared_ptr<IFunctionResultCache>& functionResultCache_, const std::shared_ptr<IParseTreeCache>& parseTreeCache_,
+                 const RatingEngineOptions& options_ = RatingEngineOptions());
 
     virtual ~RatingEngine();
 
     virtual Map_t calculate(const std::string& insuranceRateKey_, const Map_t& input_, const RatingFormulaMap_t& ratingFormulas_, const std::vector<RatingOutput>& ratingOutput_) override;
 
+    virtual std::unique_ptr<IPreparedTariff> prepare(const std::string& insuranceRateKey_, const RatingFormulaMap_t& ratingFormulas_, const std::vector<RatingOutput>& ratingOutput_) override;
+
+    virtual std::vector<BatchResult> calculateBatch(const std::string& insuranceRateKey_, const std::vector<Map_t>& inputs_, const RatingFormulaMap_t& ratingFormulas_, const std::vector<RatingOutput>& ratingOutput_) override;
+
+    virtual DependencyGraph analyzeDependencies(const std::string& insuranceRateKey_, const RatingFormulaMap_t& ratingFormulas_, const std::vector<RatingOutput>& ratingOutput_) override;
+
+    virtual void evictPreparedTariffs(const std::string& insuranceRateKey_) override;
+
 private:
-    const std::vector<std::shared_ptr<IFunction>> m_functions;
+    //! \brief a prepared tariff of the calls with formulas, reused by the calls with the same insurance rate key, formulas and rating outputs
+    struct CachedTariff
+    {
+        std::string insuranceRateKey;
+        //! \brief the hash of the formulas and rating outputs, they are only compared if it is equal
+        std::size_t fingerprint;
+        RatingFormulaMap_t ratingFormulas;
+        std::vector<RatingOutput> ratingOutput;
+        std::shared_ptr<const PreparedTariff> preparedTariff;
+    };
+
+    typedef std::list<std::shared_ptr<const CachedTariff>> CachedTariffList_t;
+
+    //! \brief returns the cached prepared tariff with the same formulas, otherwise prepares and caches the tariff
+    std::shared_ptr<const PreparedTariff> getPreparedTariff(const std::string& insuranceRateKey_, const RatingFormulaMap_t& ratingFormulas_, const std::vector<RatingOutput>& ratingOutput_);
+
+    //! \brief the business functions by their function id
+    ParsingContext::FunctionMap_t m_functions;
     const std::shared_ptr<IFunctionResultCache> m_functionResultCache;
     const std::shared_ptr<IParseTreeCache> m_parseTreeCache;
+    const RatingEngineOptions m_options;
+    //! \brief the thread pool of the prepared tariffs if more than one thread calculates the rating outputs, otherwise nullptr
+    const std::shared_ptr<ThreadPool> m_threadPool;
     const log4cplus::Logger m_logger;
+    //! \brief guards m_cachedTariffs and m_cachedTariffsByKey, the formulas are compared and the tariffs prepared outside of it
+    std::mutex m_cachedTariffsMutex;
+    //! \brief up to RatingEngineOptions::getMaxPreparedTariffs tariffs, the most recently used first
+    CachedTariffList_t m_cachedTariffs;
+    std::unordered_multimap<std::string, CachedTariffList_t::iterator> m_cachedTariffsByKey;
 };
 
 } // namespace CalculusPrime
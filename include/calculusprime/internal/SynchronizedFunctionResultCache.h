@@ -0,0 +1,85 @@
+/*
+Copyright 2019 Association for the promotion of open - source insurance software and for the establishment of open interface standards in the insurance industry
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http ://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef CP_SYNCHRONIZEDFUNCTIONRESULTCACHE_H
+#define CP_SYNCHRONIZEDFUNCTIONRESULTCACHE_H 1
+
+#include <memory>
+#include <mutex>
+#include <calculusprime/cache/IFunctionResultCache.h>
+
+namespace CalculusPrime {
+
+//! \brief Serializes the access to a function result cache, so the business functions of concurrently calculated
+//! rating outputs can share a cache without synchronization (e.g. DefaultFunctionResultCache).
+class SynchronizedFunctionResultCache : public IFunctionResultCache
+{
+public:
+    explicit SynchronizedFunctionResultCache(const std::shared_ptr<IFunctionResultCache>& cache_)
+        : m_cache(cache_)
+    {
+    }
+
+    virtual ~SynchronizedFunctionResultCache()
+    {
+    }
+
+    virtual void putFunctionResult(const std::string& insuranceRateKey_, const std::string& cacheKey_, const Value& result_) override
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_cache->putFunctionResult(insuranceRateKey_, cacheKey_, result_);
+    }
+
+    virtual void putFunctionResultWithValidityDate(const std::string& insuranceRateKey_, const std::string& cacheKey_, const std::string& validFrom_,
+                                                   const std::string& validTo_, const Value& result_) override
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_cache->putFunctionResultWithValidityDate(insuranceRateKey_, cacheKey_, validFrom_, validTo_, result_);
+    }
+
+    virtual boost::optional<Value> getFunctionResult(const std::string& insuranceRateKey_, const std::string& cacheKey_) const override
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_cache->getFunctionResult(insuranceRateKey_, cacheKey_);
+    }
+
+    virtual boost::optional<Value> getFunctionResultWithValidityDate(const std::string& insuranceRateKey_, const std::string& date_, const std::string& cacheKey_) const override
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_cache->getFunctionResultWithValidityDate(insuranceRateKey_, date_, cacheKey_);
+    }
+
+    virtual void putFunctionResultWithExpiry(const std::string& insuranceRateKey_, const std::string& cacheKey_, std::chrono::system_clock::time_point expiry_,
+                                             const Value& result_) override
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_cache->putFunctionResultWithExpiry(insuranceRateKey_, cacheKey_, expiry_, result_);
+    }
+
+    virtual boost::optional<Value> getFunctionResultWithExpiry(const std::string& insuranceRateKey_, std::chrono::system_clock::time_point now_,
+                                                               const std::string& cacheKey_) const override
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_cache->getFunctionResultWithExpiry(insuranceRateKey_, now_, cacheKey_);
+    }
+
+private:
+    const std::shared_ptr<IFunctionResultCache> m_cache;
+    mutable std::mutex m_mutex;
+};
+
+} // namespace CalculusPrime
+
+#endif // #ifndef CP_SYNCHRONIZEDFUNCTIONRESULTCACHE_H
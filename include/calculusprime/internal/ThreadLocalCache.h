@@ -0,0 +1,198 @@
+/*
+Copyright 2019 Association for the promotion of open - source insurance software and for the establishment of open interface standards in the insurance industry
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http ://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef CP_THREADLOCALCACHE_H
+#define CP_THREADLOCALCACHE_H 1
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include <boost/functional/hash.hpp>
+
+namespace CalculusPrime {
+
+//! \brief A small direct-mapped cache of every thread, the first level of TwoLevelFunctionResultCache and TwoLevelParseTreeCache.
+//! Every thread only reads and writes its own slots, so lookups neither lock nor write memory which other threads read.
+//! The slots of a thread belong to the generation of the cache they were filled in, invalidate() starts a new generation
+//! and every thread drops its slots on its next access. A value read from the second level is only cached if the generation
+//! did not change since the lookup, so a value read before an invalidation is not cached after it. A thread keeps the slots
+//! of at most MAX_CACHES_PER_THREAD caches, the slots of the cache it used least recently are dropped for another one.
+//! The slots of a destroyed cache are dropped on the next access of the thread to any cache.
+template <typename T>
+class ThreadLocalCache
+{
+public:
+    //! \param numberOfSlots_ the number of slots of every thread, rounded up to a power of two
+    explicit ThreadLocalCache(std::size_t numberOfSlots_)
+        : m_id(std::make_shared<const std::uint64_t>(nextId()))
+        , m_mask(roundUp(numberOfSlots_) - 1)
+        , m_generation(0)
+    {
+    }
+
+    //! \brief returns the value of the current thread, nullptr if it is not cached. The pointer is valid until the next access of the thread.
+    //! \param date_ the date of a result with validity dates, empty otherwise
+    //! \param generation_ set to the generation of the lookup, which is passed to put for the value read from the second level
+    const T* find(const std::string& insuranceRateKey_, const std::string& cacheKey_, const std::string& date_, std::uint64_t& generation_) const
+    {
+        const std::size_t hash = getHash(cacheKey_, date_);
+        const Slots& slots = getSlots();
+        generation_ = slots.generation;
+        const Slot& slot = slots.slots[hash & m_mask];
+        if (slot.used && slot.hash == hash && slot.cacheKey == cacheKey_ && slot.date == date_ && slot.insuranceRateKey == insuranceRateKey_) {
+            return &slot.value;
+        }
+        return nullptr;
+    }
+
+    //! \brief cache the value for the current thread, it replaces the value in the same slot
+    //! \param generation_ the generation before the value was read or written, the value is not cached if it changed since
+    void put(const std::string& insuranceRateKey_, const std::string& cacheKey_, const std::string& date_, const T& value_, std::uint64_t generation_) const
+    {
+        Slots& slots = getSlots();
+        if (slots.generation != generation_) {
+            return;
+        }
+        const std::size_t hash = getHash(cacheKey_, date_);
+        Slot& slot = slots.slots[hash & m_mask];
+        slot.used = true;
+        slot.hash = hash;
+        slot.insuranceRateKey = insuranceRateKey_;
+        slot.cacheKey = cacheKey_;
+        slot.date = date_;
+        slot.value = value_;
+    }
+
+    //! \brief returns the current generation, see put
+    std::uint64_t getGeneration() const
+    {
+        return m_generation.load(std::memory_order_acquire);
+    }
+
+    //! \brief drop the values of all threads
+    void invalidate()
+    {
+        m_generation.fetch_add(1, std::memory_order_release);
+    }
+
+    static const std::size_t MAX_CACHES_PER_THREAD = 8;
+
+private:
+    struct Slot
+    {
+        Slot()
+            : used(false)
+            , hash(0)
+        {
+        }
+
+        bool used;
+        std::size_t hash;
+        std::string insuranceRateKey;
+        std::string cacheKey;
+        std::string date;
+        T value;
+    };
+
+    //! \brief the slots of a thread for one cache
+    struct Slots
+    {
+        Slots(const std::shared_ptr<const std::uint64_t>& owner_, std::size_t numberOfSlots_)
+            : owner(owner_)
+            , ownerId(*owner_)
+            , generation(0)
+            , slots(numberOfSlots_)
+        {
+        }
+
+        //! the id of the cache, expired when the cache is destroyed
+        const std::weak_ptr<const std::uint64_t> owner;
+        const std::uint64_t ownerId;
+        std::uint64_t generation;
+        std::vector<Slot> slots;
+    };
+
+    // the slots of the current thread, the most recently used cache first
+    Slots& getSlots() const
+    {
+        static thread_local std::vector<std::unique_ptr<Slots>> caches;
+        caches.erase(std::remove_if(caches.begin(), caches.end(), [](const std::unique_ptr<Slots>& slots_) { return slots_->owner.expired(); }), caches.end());
+        std::size_t i = 0;
+        while (i < caches.size() && caches[i]->ownerId != *m_id) {
+            ++i;
+        }
+        if (i == caches.size()) {
+            if (caches.size() < MAX_CACHES_PER_THREAD) {
+                caches.emplace_back();
+            }
+            else {
+                i = caches.size() - 1;
+            }
+            caches[i].reset(new Slots(m_id, m_mask + 1));
+        }
+        if (i != 0) {
+            std::rotate(caches.begin(), caches.begin() + i, caches.begin() + i + 1);
+        }
+        Slots& slots = *caches.front();
+        const std::uint64_t generation = m_generation.load(std::memory_order_acquire);
+        if (slots.generation != generation) {
+            for (Slot& slot : slots.slots) {
+                slot.used = false;
+                slot.value = T();
+            }
+            slots.generation = generation;
+        }
+        return slots;
+    }
+
+    static std::size_t getHash(const std::string& cacheKey_, const std::string& date_)
+    {
+        // the insurance rate key is only compared, a cache is rarely shared by many tariffs
+        std::size_t hash = std::hash<std::string>()(cacheKey_);
+        if (!date_.empty()) {
+            boost::hash_combine(hash, std::hash<std::string>()(date_));
+        }
+        return hash;
+    }
+
+    static std::size_t roundUp(std::size_t numberOfSlots_)
+    {
+        std::size_t result = 1;
+        while (result < numberOfSlots_) {
+            result *= 2;
+        }
+        return result;
+    }
+
+    // ids are not reused, so a new cache never finds the slots of a destroyed cache
+    static std::uint64_t nextId()
+    {
+        static std::atomic<std::uint64_t> id(0);
+        return ++id;
+    }
+
+    //! the slots of the threads only keep a weak pointer, so they know when the cache is destroyed
+    const std::shared_ptr<const std::uint64_t> m_id;
+    const std::size_t m_mask;
+    std::atomic<std::uint64_t> m_generation;
+};
+
+} // namespace CalculusPrime
+
+#endif // #ifndef CP_THREADLOCALCACHE_H
@@ -0,0 +1,91 @@
+/*
+Copyright 2019 Association for the promotion of open - source insurance software and for the establishment of open interface standards in the insurance industry
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http ://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef CP_THREADPOOL_H
+#define CP_THREADPOOL_H 1
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace CalculusPrime {
+
+//! \brief A fixed set of worker threads which run batches of independent tasks.
+//! The tasks of a batch are claimed one by one by the workers and the calling thread, so a thread which is done
+//! with a short task takes the next one. Several threads may run batches concurrently.
+class ThreadPool
+{
+public:
+    //! \brief the task of a batch, called with the index of the task
+    typedef std::function<void(std::size_t)> Task_t;
+
+    //! \param numberOfWorkers_ the number of worker threads, the thread calling run() is an additional worker
+    explicit ThreadPool(std::size_t numberOfWorkers_);
+
+    ThreadPool(const ThreadPool&) = delete;
+
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool();
+
+    //! \brief run the tasks 0 .. numberOfTasks_-1 and wait until all are done
+    //! \throws the exception of the failed task with the lowest index, after all tasks are done
+    void run(std::size_t numberOfTasks_, const Task_t& task_);
+
+private:
+    struct Batch
+    {
+        Batch(std::size_t numberOfTasks_, const Task_t& task_)
+            : task(task_)
+            , numberOfTasks(numberOfTasks_)
+            , nextTask(0)
+            , completedTasks(0)
+            , exceptions(numberOfTasks_)
+        {
+        }
+
+        const Task_t& task;
+        const std::size_t numberOfTasks;
+        std::atomic<std::size_t> nextTask;
+        std::atomic<std::size_t> completedTasks;
+        std::vector<std::exception_ptr> exceptions;
+    };
+
+    //! \brief run tasks of the batch until all are claimed
+    void runTasks(Batch& batch_);
+
+    void work();
+
+    std::vector<std::thread> m_workers;
+    std::mutex m_mutex;
+    //! \brief signals new batches to the workers
+    std::condition_variable m_batchAvailable;
+    //! \brief signals completed batches to the threads waiting in run()
+    std::condition_variable m_batchCompleted;
+    //! \brief the batches with unclaimed tasks
+    std::deque<std::shared_ptr<Batch>> m_batches;
+    bool m_stopped;
+};
+
+} // namespace CalculusPrime
+
+#endif // #ifndef CP_THREADPOOL_H
@@ -0,0 +1,95 @@
+/*
+Copyright 2019 Association for the promotion of open - source insurance software and for the establishment of open interface standards in the insurance industry
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http ://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef CP_ARGUMENTSTACK_H
+#define CP_ARGUMENTSTACK_H 1
+
+#include <cstddef>
+#include <deque>
+#include <vector>
+#include <calculusprime/Value.h>
+
+namespace CalculusPrime {
+
+//! \brief The argument buffers of the function calls of one calculation.
+//! Nested calls use one buffer per nesting depth, the buffers keep their capacity,
+//! so a function call does not allocate its argument vector.
+class ArgumentStack
+{
+public:
+    //! \brief the arguments of one function call, the buffer is returned to the stack on destruction
+    class Frame
+    {
+    public:
+        Frame(ArgumentStack& stack_, std::size_t numArguments_)
+            : m_stack(stack_)
+            , m_arguments(stack_.push(numArguments_))
+        {
+        }
+
+        ~Frame()
+        {
+            m_stack.pop();
+        }
+
+        std::vector<Value>& getArguments()
+        {
+            return m_arguments;
+        }
+
+    private:
+        Frame(const Frame&) = delete;
+        Frame& operator=(const Frame&) = delete;
+
+        ArgumentStack& m_stack;
+        std::vector<Value>& m_arguments;
+    };
+
+    ArgumentStack()
+        : m_depth(0)
+    {
+    }
+
+    ~ArgumentStack()
+    {
+    }
+
+private:
+    ArgumentStack(const ArgumentStack&) = delete;
+    ArgumentStack& operator=(const ArgumentStack&) = delete;
+
+    std::vector<Value>& push(std::size_t numArguments_)
+    {
+        if (m_depth == m_buffers.size()) {
+            m_buffers.emplace_back();
+        }
+        std::vector<Value>& arguments = m_buffers[m_depth++];
+        arguments.resize(numArguments_);
+        return arguments;
+    }
+
+    void pop()
+    {
+        --m_depth;
+    }
+
+    //! \brief a deque, the buffers of the outer calls must not move when the stack grows
+    std::deque<std::vector<Value>> m_buffers;
+    std::size_t m_depth;
+};
+
+} // namespace CalculusPrime
+
+#endif // #ifndef CP_ARGUMENTSTACK_H
@@ -0,0 +1,69 @@
+/*
+Copyright 2019 Association for the promotion of open - source insurance software and for the establishment of open interface standards in the insurance industry
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http ://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef CP_BYTECODECOMPILER_H
+#define CP_BYTECODECOMPILER_H 1
+
+#include <cstdint>
+#include <memory>
+#include <calculusprime/internal/compiler/BytecodeProgram.h>
+#include <calculusprime/internal/compiler/CompiledFormula.h>
+
+namespace CalculusPrime {
+
+//! \brief Generates the register based bytecode for a CompiledFormula.
+//! Registers are allocated like a stack, operands of calls and built-in functions occupy consecutive registers.
+class BytecodeCompiler
+{
+public:
+    //! \brief generate the bytecode for the compiled formula
+    static std::shared_ptr<const BytecodeProgram> compile(const CompiledFormula& compiledFormula_);
+
+    ~BytecodeCompiler()
+    {
+    }
+
+private:
+    BytecodeCompiler(const CompiledFormula& compiledFormula_, BytecodeProgram& program_)
+        : m_compiledFormula(compiledFormula_)
+        , m_program(program_)
+        , m_nextRegister(0)
+    {
+    }
+
+    void compileBlock(std::uint32_t node_);
+
+    //! \brief generate the code which stores the value of the expression in register dst_
+    void compileExpression(std::uint32_t node_, std::uint32_t dst_);
+
+    //! \brief compile the operands of the node into consecutive registers and return the first one.
+    //! The operand types of the built-in functions are checked in between (see Operations::checkOperand).
+    std::uint32_t compileOperands(std::uint32_t node_);
+
+    std::uint32_t allocateRegisters(std::uint32_t count_);
+
+    void releaseRegisters(std::uint32_t count_)
+    {
+        m_nextRegister -= count_;
+    }
+
+    const CompiledFormula& m_compiledFormula;
+    BytecodeProgram& m_program;
+    std::uint32_t m_nextRegister;
+};
+
+} // namespace CalculusPrime
+
+#endif // #ifndef CP_BYTECODECOMPILER_H
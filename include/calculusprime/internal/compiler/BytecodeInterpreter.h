@@ -0,0 +1,70 @@
+/*
+Copyright 2019 Association for the promotion of open - source insurance software and for the establishment of open interface standards in the insurance industry
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http ://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef CP_BYTECODEINTERPRETER_H
+#define CP_BYTECODEINTERPRETER_H 1
+
+#include <cstdint>
+#include <memory>
+#include <boost/optional.hpp>
+#include <calculusprime/Value.h>
+#include <calculusprime/internal/compiler/BytecodeProgram.h>
+#include <calculusprime/internal/compiler/CompiledFormula.h>
+#include <calculusprime/internal/compiler/SymbolTable.h>
+
+// computed goto is a GCC/Clang extension, all other compilers dispatch with a switch
+#if defined(__GNUC__) || defined(__clang__)
+#define CP_BYTECODE_COMPUTED_GOTO 1
+#endif
+
+namespace CalculusPrime {
+
+class ParsingContext;
+
+//! \brief Executes the bytecode of a CompiledFormula within a parsing context.
+//! Numbers are kept unboxed in the registers, Values are only created for strings, bools,
+//! function arguments and the result. If the formula is bound to a symbol table, variables are read
+//! by their slot and functions are called without lookup, otherwise both are resolved by their name.
+class BytecodeInterpreter
+{
+public:
+    BytecodeInterpreter(const std::shared_ptr<ParsingContext>& parsingContext_, const CompiledFormula& compiledFormula_, const SymbolTable::BoundFormula* boundFormula_ = nullptr)
+        : m_parsingContext(parsingContext_)
+        , m_compiledFormula(compiledFormula_)
+        , m_slots(boundFormula_ != nullptr ? boundFormula_->slots.data() : nullptr)
+        , m_functions(boundFormula_ != nullptr ? boundFormula_->functions.data() : nullptr)
+    {
+    }
+
+    ~BytecodeInterpreter()
+    {
+    }
+
+    //! \brief execute the bytecode of the formula
+    //! \return the result of the executed Return statement, empty if the formula did not return a result
+    boost::optional<Value> execute();
+
+private:
+    const std::shared_ptr<ParsingContext> m_parsingContext;
+    const CompiledFormula& m_compiledFormula;
+    //! \brief the slots of the identifiers, may be nullptr
+    const std::uint32_t* const m_slots;
+    //! \brief the functions of the call sites, may be nullptr
+    IFunction* const* const m_functions;
+};
+
+} // namespace CalculusPrime
+
+#endif // #ifndef CP_BYTECODEINTERPRETER_H
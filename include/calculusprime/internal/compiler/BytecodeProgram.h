@@ -0,0 +1,163 @@
+/*
+Copyright 2019 Association for the promotion of open - source insurance software and for the establishment of open interface standards in the insurance industry
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http ://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef CP_BYTECODEPROGRAM_H
+#define CP_BYTECODEPROGRAM_H 1
+
+#include <cstdint>
+#include <vector>
+
+namespace CalculusPrime {
+
+// The instructions of the bytecode VM. dst, a and b are register numbers unless stated otherwise,
+// node is the index of the CompiledFormula node the instruction was generated for.
+#define CP_BYTECODE_OPS(X) \
+    /* r[dst] = numbers[a] */ \
+    X(LOAD_NUMBER) \
+    /* r[dst] = constants[a] of the compiled formula (strings and bools) */ \
+    X(LOAD_CONSTANT) \
+    /* r[dst] = value of the variable identifiers[a] */ \
+    X(LOAD_VARIABLE) \
+    /* r[dst] = -r[a] */ \
+    X(NEGATE) \
+    /* r[dst] = r[a] <op> r[b] - unboxed for numbers, all other types are delegated to Operations */ \
+    X(ADD) \
+    X(SUBTRACT) \
+    X(MULTIPLY) \
+    X(DIVIDE) \
+    X(POWER) \
+    X(GT_EQ) \
+    X(LT_EQ) \
+    X(GT) \
+    X(LT) \
+    X(EQ) \
+    X(NOT_EQ) \
+    /* r[dst] = r[a] <op> r[b] - always delegated to Operations */ \
+    X(AND) \
+    X(OR) \
+    /* Operations::checkOperand(node, b, r[a]) */ \
+    X(CHECK_OPERAND) \
+    /* r[dst] = Operations::apply(node, r[a]...) */ \
+    X(APPLY) \
+    /* look up the function of call site a, reports an unknown function before the arguments are evaluated */ \
+    X(FIND_FUNCTION) \
+    /* r[dst] = function of call site b (r[a]...) */ \
+    X(CALL) \
+    /* pc = a */ \
+    X(JUMP) \
+    /* if (!r[a]) pc = b */ \
+    X(JUMP_IF_FALSE) \
+    /* with short circuit evaluation: if (r[a] is bool false) pc = b */ \
+    X(SHORT_CIRCUIT_AND) \
+    /* with short circuit evaluation: if (r[a] is bool true) pc = b */ \
+    X(SHORT_CIRCUIT_OR) \
+    /* return r[a] */ \
+    X(RETURN) \
+    /* Error(r[a]) */ \
+    X(ERROR_CALL) \
+    /* end of the formula without a result */ \
+    X(END)
+
+#define CP_BYTECODE_ENUM(op) op,
+
+enum class BytecodeOp : std::uint8_t {
+    CP_BYTECODE_OPS(CP_BYTECODE_ENUM)
+};
+
+#undef CP_BYTECODE_ENUM
+
+//! \brief The register based bytecode of a CompiledFormula
+class BytecodeProgram
+{
+public:
+    struct Instruction
+    {
+        BytecodeOp op;
+        std::uint32_t dst;
+        std::uint32_t a;
+        std::uint32_t b;
+        std::uint32_t node;
+    };
+
+    BytecodeProgram()
+        : m_numberOfRegisters(0)
+    {
+    }
+
+    ~BytecodeProgram()
+    {
+    }
+
+    const std::vector<Instruction>& getInstructions() const
+    {
+        return m_instructions;
+    }
+
+    const std::vector<double>& getNumbers() const
+    {
+        return m_numbers;
+    }
+
+    std::uint32_t getNumberOfRegisters() const
+    {
+        return m_numberOfRegisters;
+    }
+
+    //! \brief append an instruction and return its address
+    std::uint32_t addInstruction(BytecodeOp op_, std::uint32_t dst_, std::uint32_t a_, std::uint32_t b_, std::uint32_t node_)
+    {
+        Instruction instruction = { op_, dst_, a_, b_, node_ };
+        m_instructions.push_back(instruction);
+        return static_cast<std::uint32_t>(m_instructions.size() - 1);
+    }
+
+    //! \brief set the target address of the JUMP, JUMP_IF_FALSE or SHORT_CIRCUIT_* instruction
+    void setJumpTarget(std::uint32_t address_, std::uint32_t target_)
+    {
+        Instruction& instruction = m_instructions[address_];
+        if (instruction.op == BytecodeOp::JUMP) {
+            instruction.a = target_;
+        }
+        else {
+            instruction.b = target_;
+        }
+    }
+
+    //! \brief returns the address of the next instruction
+    std::uint32_t getNextAddress() const
+    {
+        return static_cast<std::uint32_t>(m_instructions.size());
+    }
+
+    std::uint32_t addNumber(double number_)
+    {
+        m_numbers.push_back(number_);
+        return static_cast<std::uint32_t>(m_numbers.size() - 1);
+    }
+
+    void setNumberOfRegisters(std::uint32_t numberOfRegisters_)
+    {
+        m_numberOfRegisters = numberOfRegisters_;
+    }
+
+private:
+    std::vector<Instruction> m_instructions;
+    std::vector<double> m_numbers;
+    std::uint32_t m_numberOfRegisters;
+};
+
+} // namespace CalculusPrime
+
+#endif // #ifndef CP_BYTECODEPROGRAM_H
@@ -0,0 +1,114 @@
+/*
+Copyright 2019 Association for the promotion of open - source insurance software and for the establishment of open interface standards in the insurance industry
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http ://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef CP_COLUMNAREVALUATOR_H
+#define CP_COLUMNAREVALUATOR_H 1
+
+#include <cstdint>
+#include <vector>
+#include <calculusprime/internal/compiler/CompiledFormula.h>
+
+namespace CalculusPrime {
+
+//! \brief Evaluates a numeric CompiledFormula for many lanes (e.g. the policies of a batch) at once.
+//! The values of every node are kept in columns of BLOCK_SIZE doubles, every operator is a loop over the columns
+//! which the compiler vectorizes for the target instruction set. If/else chains are executed with lane masks,
+//! bools are stored as 0.0 and 1.0. Only formulas which pass isColumnar() are evaluated, their variables are numbers.
+//! Lanes which fail (e.g. a division by zero) or do not return a result are not reported, they are marked to be evaluated
+//! by a scalar backend, which reports the error exactly like a single calculation.
+class ColumnarEvaluator
+{
+public:
+    //! \brief the number of lanes evaluated at once, the columns of a block stay in the cache
+    static const std::size_t BLOCK_SIZE = 256;
+
+    explicit ColumnarEvaluator(const CompiledFormula& compiledFormula_)
+        : m_compiledFormula(compiledFormula_)
+        , m_numberOfColumns(0)
+        , m_numberOfMasks(0)
+        , m_variables(nullptr)
+        , m_firstLane(0)
+        , m_numberOfLanes(0)
+        , m_results(nullptr)
+    {
+    }
+
+    ~ColumnarEvaluator()
+    {
+    }
+
+    //! \brief returns if the formula can be evaluated column by column. This is the case for formulas which only consist of
+    //! numbers, bools, variables used as numbers, arithmetic operators, comparisons, And, Or, Not, Max, Min, Rnd, Ceil, Floor and Exp,
+    //! If/Else, Return and Error. Formulas with strings or function calls are not.
+    static bool isColumnar(const CompiledFormula& compiledFormula_);
+
+    //! \brief evaluate the formula for all lanes
+    //! \param columns_ the values of the lanes for every identifier of the formula (see CompiledFormula::getIdentifier)
+    //! \param numberOfLanes_ the number of lanes
+    //! \param results_ receives the result of every lane which is not marked in fallback_
+    //! \param fallback_ one flag per lane, marked lanes are skipped. Lanes which must be evaluated by a scalar backend are marked.
+    void evaluate(const double* const* columns_, std::size_t numberOfLanes_, double* results_, std::uint8_t* fallback_);
+
+private:
+    //! \brief the static type of an expression
+    enum class Type : std::uint8_t {
+        INVALID,
+        NUMBER,
+        BOOL
+    };
+
+    static Type getType(const CompiledFormula& compiledFormula_, std::uint32_t index_);
+
+    static bool isColumnarBlock(const CompiledFormula& compiledFormula_, std::uint32_t index_);
+
+    //! \brief execute the block for the active lanes of the current block of lanes
+    void executeBlock(std::uint32_t index_, const std::uint8_t* active_);
+
+    //! \brief evaluate the expression into the column, the failed lanes are only marked if they are active
+    void evaluate(std::uint32_t index_, double* column_, const std::uint8_t* active_);
+
+    double* pushColumn();
+
+    void popColumn()
+    {
+        --m_numberOfColumns;
+    }
+
+    std::uint8_t* pushMask();
+
+    void popMask()
+    {
+        --m_numberOfMasks;
+    }
+
+    const CompiledFormula& m_compiledFormula;
+    //! \brief the temporary columns and lane masks, used as stacks
+    std::vector<std::vector<double>> m_columns;
+    std::vector<std::vector<std::uint8_t>> m_masks;
+    std::size_t m_numberOfColumns;
+    std::size_t m_numberOfMasks;
+    //! \brief the current block of lanes
+    const double* const* m_variables;
+    std::size_t m_firstLane;
+    std::size_t m_numberOfLanes;
+    double* m_results;
+    //! \brief the lanes which returned a result and the failed lanes of the current block
+    std::uint8_t m_returned[BLOCK_SIZE];
+    std::uint8_t m_failed[BLOCK_SIZE];
+};
+
+} // namespace CalculusPrime
+
+#endif // #ifndef CP_COLUMNAREVALUATOR_H
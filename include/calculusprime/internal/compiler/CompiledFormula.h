@@ -0,0 +1,238 @@
+/*
+Copyright 2019 Association for the promotion of open - source insurance software and for the establishment of open interface standards in the insurance industry
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http ://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef CP_COMPILEDFORMULA_H
+#define CP_COMPILEDFORMULA_H 1
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <calculusprime/Value.h>
+
+namespace CalculusPrime {
+
+class BytecodeProgram;
+
+//! \brief operation of a node of a compiled formula
+enum class OpCode : std::uint8_t {
+    // blocks
+    /** Return expression */
+    RETURN,
+    /** if/else if/else chain, operands are condition/block pairs followed by the optional else block */
+    IF,
+    /** Error(expression) */
+    ERROR_CALL,
+
+    // leafs
+    /** literal, data is the index of the constant */
+    CONSTANT,
+    /** variable reference, data is the index of the identifier */
+    IDENTIFIER,
+
+    // unary operators
+    NEGATE,
+    NOT,
+
+    // binary operators
+    POWER,
+    MULTIPLY,
+    DIVIDE,
+    ADD,
+    SUBTRACT,
+    GT_EQ,
+    LT_EQ,
+    GT,
+    LT,
+    EQ,
+    NOT_EQ,
+    AND,
+    OR,
+    MODULO,
+
+    // built-in functions
+    MAX,
+    MIN,
+    ROUND,
+    CEIL,
+    FLOOR,
+    EXP,
+    DAY,
+    MONTH,
+    YEAR,
+    SUBSTR,
+    ADD_DAYS,
+    GET_DIFF_DAYS,
+    PADDED_STRING,
+    DIFFERENCE_IN_MONTHS,
+
+    /** call of a business or formula function, data is the index of the call site */
+    CALL
+};
+
+//! \brief A formula lowered from its ANTLR parse tree into a flat array of nodes.
+//! Operands are stored as node indices in one contiguous array, children always precede their parents.
+//! Literals are decoded once at compile time. Instances are immutable after compilation and are stored in the IParseTreeCache,
+//! together with the bytecode generated from them.
+class CompiledFormula
+{
+public:
+    struct Node
+    {
+        OpCode opCode;
+        std::uint16_t numOperands;
+        //! index of the first operand in the operand array
+        std::uint32_t firstOperand;
+        //! opcode specific data (constant, identifier or call site index, else flag)
+        std::uint32_t data;
+    };
+
+    //! \brief location of a node in the formula text - only used for error messages
+    struct SourceRef
+    {
+        std::uint32_t line;
+        std::uint32_t startIndex;
+        std::uint32_t stopIndex;
+    };
+
+    //! \brief call of a business or formula function
+    struct CallSite
+    {
+        std::string functionName;
+        std::string functionId;
+    };
+
+    explicit CompiledFormula(const std::string& formula_)
+        : m_formula(formula_)
+        , m_root(0)
+    {
+    }
+
+    ~CompiledFormula()
+    {
+    }
+
+    //! \brief returns the formula text
+    const std::string& getFormula() const
+    {
+        return m_formula;
+    }
+
+    //! \brief returns the index of the root block
+    std::uint32_t getRoot() const
+    {
+        return m_root;
+    }
+
+    const Node& getNode(std::uint32_t index_) const
+    {
+        return m_nodes[index_];
+    }
+
+    std::size_t getNumberOfNodes() const
+    {
+        return m_nodes.size();
+    }
+
+    //! \brief returns the node index of the i-th operand of the specified node
+    std::uint32_t getOperand(const Node& node_, std::size_t i_) const
+    {
+        return m_operands[node_.firstOperand + i_];
+    }
+
+    const Value& getConstant(std::uint32_t index_) const
+    {
+        return m_constants[index_];
+    }
+
+    const std::string& getIdentifier(std::uint32_t index_) const
+    {
+        return m_identifiers[index_];
+    }
+
+    std::size_t getNumberOfIdentifiers() const
+    {
+        return m_identifiers.size();
+    }
+
+    const CallSite& getCallSite(std::uint32_t index_) const
+    {
+        return m_callSites[index_];
+    }
+
+    std::size_t getNumberOfCallSites() const
+    {
+        return m_callSites.size();
+    }
+
+    std::size_t getLine(std::uint32_t index_) const
+    {
+        return m_sources[index_].line;
+    }
+
+    std::size_t getPosition(std::uint32_t index_) const
+    {
+        return m_sources[index_].startIndex;
+    }
+
+    //! \brief returns the source text of the specified node
+    std::string getText(std::uint32_t index_) const;
+
+    //! \brief append a node, the operands must have been added before
+    std::uint32_t addNode(OpCode opCode_, const std::vector<std::uint32_t>& operands_, std::uint32_t data_, const SourceRef& source_);
+
+    std::uint32_t addConstant(const Value& value_);
+
+    std::uint32_t addIdentifier(const std::string& identifier_);
+
+    std::uint32_t addCallSite(const std::string& functionName_, std::size_t numberOfArgs_);
+
+    void setRoot(std::uint32_t root_)
+    {
+        m_root = root_;
+    }
+
+    //! \brief replace the node by a constant, the operands of the node are not referenced any more
+    void replaceByConstant(std::uint32_t index_, const Value& value_);
+
+    //! \brief replace the operands and the data of the node
+    void replaceOperands(std::uint32_t index_, const std::vector<std::uint32_t>& operands_, std::uint32_t data_);
+
+    //! \brief returns the bytecode of the formula (for the BYTECODE evaluation backend)
+    const std::shared_ptr<const BytecodeProgram>& getBytecode() const
+    {
+        return m_bytecode;
+    }
+
+    void setBytecode(const std::shared_ptr<const BytecodeProgram>& bytecode_)
+    {
+        m_bytecode = bytecode_;
+    }
+
+private:
+    const std::string m_formula;
+    std::vector<Node> m_nodes;
+    std::vector<std::uint32_t> m_operands;
+    std::vector<Value> m_constants;
+    std::vector<std::string> m_identifiers;
+    std::vector<CallSite> m_callSites;
+    std::vector<SourceRef> m_sources;
+    std::uint32_t m_root;
+    std::shared_ptr<const BytecodeProgram> m_bytecode;
+};
+
+} // namespace CalculusPrime
+
+#endif // #ifndef CP_COMPILEDFORMULA_H
@@ -0,0 +1,51 @@
+/*
+Copyright 2019 Association for the promotion of open - source insurance software and for the establishment of open interface standards in the insurance industry
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http ://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef CP_CONSTANTFOLDER_H
+#define CP_CONSTANTFOLDER_H 1
+
+#include <cstdint>
+#include <calculusprime/internal/compiler/CompiledFormula.h>
+
+namespace CalculusPrime {
+
+//! \brief Folds the constant subexpressions of a compiled formula.
+//! Operators and built-in functions with constant operands (e.g. 0.5 * 12 or rnd(100 / 3, 2)) are replaced by their result,
+//! conditions of if statements which are constant are resolved. Expressions which fail (e.g. 1 / 0) are not folded,
+//! so the error is still reported when the formula is evaluated. Function calls and variables are never folded.
+class ConstantFolder
+{
+public:
+    //! \brief fold the formula, must be called before the bytecode is generated
+    static void fold(CompiledFormula& compiledFormula_);
+
+private:
+    ConstantFolder();
+
+    ~ConstantFolder();
+
+    static bool isConstant(const CompiledFormula& compiledFormula_, std::uint32_t index_)
+    {
+        return compiledFormula_.getNode(index_).opCode == OpCode::CONSTANT;
+    }
+
+    static void foldExpression(CompiledFormula& compiledFormula_, std::uint32_t index_);
+
+    static void foldIf(CompiledFormula& compiledFormula_, std::uint32_t index_);
+};
+
+} // namespace CalculusPrime
+
+#endif // #ifndef CP_CONSTANTFOLDER_H
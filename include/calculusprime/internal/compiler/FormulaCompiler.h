@@ -13,25 +13,31 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License.
 */
-#ifndef CP_EVALVISITOR_H
-#define CP_EVALVISITOR_H 1
+#ifndef CP_FORMULACOMPILER_H
+#define CP_FORMULACOMPILER_H 1
 
+#include <cstdint>
 #include <memory>
+#include <vector>
 #include "RatingEngineBaseVisitor.h"
+#include <calculusprime/internal/compiler/CompiledFormula.h>
 
 namespace CalculusPrime {
 
-class ParsingContext;
-
-class EvalVisitor : public RatingEngineBaseVisitor
+//! \brief Lowers the ANTLR parse tree of a formula into a CompiledFormula.
+//! Every visit method returns the index of the emitted node as std::uint32_t.
+class FormulaCompiler : public RatingEngineBaseVisitor
 {
 public:
-    EvalVisitor(const std::shared_ptr<ParsingContext>& parsingContext_)
-        : m_parsingContext(parsingContext_)
-    {
-    }
+    //! \brief compile the parse tree
+    //! \param parseTree_ the parse tree, only accessed during compilation
+    //! \param formula_ the formula text the parse tree was created from
+    //! \return the compiled formula
+    static std::shared_ptr<CompiledFormula> compile(RatingEngineParser::ParseContext* parseTree_, const std::string& formula_);
 
-    virtual ~EvalVisitor();
+    virtual ~FormulaCompiler();
+
+    virtual antlrcpp::Any visitParse(RatingEngineParser::ParseContext* ctx) override;
 
     virtual antlrcpp::Any visitBlock(RatingEngineParser::BlockContext* ctx) override;
 
@@ -114,9 +120,23 @@ public:
     virtual antlrcpp::Any visitLtEqExpression(RatingEngineParser::LtEqExpressionContext* ctx) override;
 
 private:
-    const std::shared_ptr<ParsingContext> m_parsingContext;
+    explicit FormulaCompiler(const std::shared_ptr<CompiledFormula>& compiledFormula_)
+        : m_compiledFormula(compiledFormula_)
+    {
+    }
+
+    //! \brief compile the sub tree and return the index of its node
+    std::uint32_t compileNode(antlr4::tree::ParseTree* tree_);
+
+    //! \brief compile the expressions and return the indices of their nodes
+    std::vector<std::uint32_t> compileNodes(const std::vector<RatingEngineParser::ExpressionContext*>& expressions_);
+
+    //! \brief append a node, the operands must have been compiled before
+    std::uint32_t emit(OpCode opCode_, antlr4::ParserRuleContext* ctx_, const std::vector<std::uint32_t>& operands_, std::uint32_t data_ = 0);
+
+    const std::shared_ptr<CompiledFormula> m_compiledFormula;
 };
 
 } // namespace CalculusPrime
 
-#endif // #ifndef CP_EVALVISITOR_H
+#endif // #ifndef CP_FORMULACOMPILER_H
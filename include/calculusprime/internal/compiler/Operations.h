@@ -0,0 +1,81 @@
+/*
+Copyright 2019 Association for the promotion of open - source insurance software and for the establishment of open interface standards in the insurance industry
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http ://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef CP_OPERATIONS_H
+#define CP_OPERATIONS_H 1
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <calculusprime/Value.h>
+#include <calculusprime/internal/compiler/CompiledFormula.h>
+
+namespace CalculusPrime {
+
+class IFunction;
+class ParsingContext;
+
+//! \brief The semantics of the operators and built-in functions of the formula language.
+//! Shared by all evaluation backends, so they cannot diverge.
+class Operations
+{
+public:
+    //! \brief apply the operator or built-in function of the specified node
+    //! \param compiledFormula_ the compiled formula
+    //! \param node_ the index of the node, used for the operation and for error messages
+    //! \param operands_ the evaluated operands (node.numOperands values)
+    //! \return the result
+    static Value apply(const CompiledFormula& compiledFormula_, std::uint32_t node_, const Value* operands_);
+
+    //! \brief returns true if the built-in function checks the type of each operand before the next operand is evaluated (see checkOperand)
+    static bool hasOperandChecks(OpCode opCode_);
+
+    //! \brief check the type of an operand of a built-in function with more than one parameter.
+    //! The backends call this after each operand but the last, so a type error is reported before the following operands are evaluated.
+    //! \param compiledFormula_ the compiled formula
+    //! \param node_ the index of the node
+    //! \param operand_ the number of the operand
+    //! \param value_ the evaluated operand
+    static void checkOperand(const CompiledFormula& compiledFormula_, std::uint32_t node_, std::size_t operand_, const Value& value_);
+
+    //! \brief find the business or formula function of the specified CALL node.
+    //! The backends call this before the arguments are evaluated. Errors are not converted, the callers report them as EvalException.
+    //! \param parsingContext_ the parsing context the function is executed in
+    //! \param compiledFormula_ the compiled formula
+    //! \param node_ the index of the CALL node
+    //! \param function_ the function bound to the call site (see SymbolTable), if nullptr the function is looked up in the parsing context
+    //! \return the function, never nullptr
+    static IFunction* findFunction(const std::shared_ptr<ParsingContext>& parsingContext_, const CompiledFormula& compiledFormula_, std::uint32_t node_, IFunction* function_);
+
+    //! \brief call the business or formula function of the specified CALL node, its result is cached as declared by the function (see FunctionResultCaching).
+    //! Errors are not converted, the callers report them as EvalException.
+    //! \param parsingContext_ the parsing context the function is executed in
+    //! \param compiledFormula_ the compiled formula
+    //! \param node_ the index of the CALL node
+    //! \param function_ the function returned by findFunction
+    //! \param arguments_ the evaluated arguments
+    //! \return the function result
+    static Value callFunction(const std::shared_ptr<ParsingContext>& parsingContext_, const CompiledFormula& compiledFormula_, std::uint32_t node_, IFunction& function_, const std::vector<Value>& arguments_);
+
+private:
+    Operations();
+
+    ~Operations();
+};
+
+} // namespace CalculusPrime
+
+#endif // #ifndef CP_OPERATIONS_H
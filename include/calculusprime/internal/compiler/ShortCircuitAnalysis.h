@@ -0,0 +1,57 @@
+/*
+Copyright 2019 Association for the promotion of open - source insurance software and for the establishment of open interface standards in the insurance industry
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http ://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef CP_SHORTCIRCUITANALYSIS_H
+#define CP_SHORTCIRCUITANALYSIS_H 1
+
+#include <cstdint>
+#include <vector>
+#include <calculusprime/internal/compiler/CompiledFormula.h>
+#include <calculusprime/internal/compiler/SymbolTable.h>
+
+namespace CalculusPrime {
+
+//! \brief Checks statically if the result of a compiled formula may differ with short circuit evaluation of And and Or.
+//! With short circuit evaluation the right operand is skipped, so the results differ if the right operand
+//! would fail or has a side effect. This is assumed for right operands which call a function, contain an arithmetic
+//! operator or a built-in function (e.g. a division by zero) or are constants which are not bool.
+//! Variables are assumed to be defined and to have the types the operators expect, variables which are calculated lazily
+//! by a formula which may fail (e.g. a rating formula which calls a function) are passed as failing slots.
+class ShortCircuitAnalysis
+{
+public:
+    //! \brief returns if the result of the bound formula may differ with short circuit evaluation
+    //! \param failingSlots_ true for the slots of the variables whose evaluation may fail or call a function
+    static bool mayDiffer(const SymbolTable::BoundFormula& boundFormula_, const std::vector<bool>& failingSlots_);
+
+    //! \brief returns if evaluating the bound formula may fail or call a function
+    //! \param failingSlots_ true for the slots of the variables whose evaluation may fail or call a function
+    static bool mayFail(const SymbolTable::BoundFormula& boundFormula_, const std::vector<bool>& failingSlots_);
+
+private:
+    ShortCircuitAnalysis();
+
+    ~ShortCircuitAnalysis();
+
+    //! \brief returns if evaluating the expression may fail or call a function
+    static bool mayFail(const SymbolTable::BoundFormula& boundFormula_, std::uint32_t index_, const std::vector<bool>& failingSlots_);
+
+    //! \brief returns if the identifier names a variable whose evaluation may fail
+    static bool isFailing(const SymbolTable::BoundFormula& boundFormula_, std::uint32_t identifier_, const std::vector<bool>& failingSlots_);
+};
+
+} // namespace CalculusPrime
+
+#endif // #ifndef CP_SHORTCIRCUITANALYSIS_H
@@ -0,0 +1,99 @@
+/*
+Copyright 2019 Association for the promotion of open - source insurance software and for the establishment of open interface standards in the insurance industry
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http ://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef CP_SYMBOLTABLE_H
+#define CP_SYMBOLTABLE_H 1
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace CalculusPrime {
+
+class CompiledFormula;
+class IFunction;
+
+//! \brief The variables of a prepared tariff, mapped case-insensitively to dense slot indices.
+//! The compiled formulas of the tariff are bound to the table, every identifier of a bound formula
+//! is replaced by its slot, so variables are read from the slot array of the ParsingContext without hashing.
+//! The call sites of a bound formula are resolved to the functions of the tariff.
+//! The table is built when the tariff is prepared and is immutable afterwards.
+class SymbolTable
+{
+public:
+    //! \brief the functions by their function id (see FunctionIdBuilder)
+    typedef std::unordered_map<std::string, std::shared_ptr<IFunction>> FunctionMap_t;
+
+    //! \brief a compiled formula together with the slots of its identifiers and the functions of its call sites
+    struct BoundFormula
+    {
+        std::shared_ptr<CompiledFormula> compiledFormula;
+        //! the slot for every identifier index of the compiled formula
+        std::vector<std::uint32_t> slots;
+        //! the function for every call site index of the compiled formula, nullptr if the function is not defined.
+        //! The functions are owned by the function map of the tariff.
+        std::vector<IFunction*> functions;
+    };
+
+    static const std::uint32_t NO_SLOT = std::numeric_limits<std::uint32_t>::max();
+
+    SymbolTable()
+    {
+    }
+
+    ~SymbolTable()
+    {
+    }
+
+    //! \brief add the variable (if not yet known) and return its slot
+    std::uint32_t addSymbol(const std::string& variableName_);
+
+    //! \brief returns the slot of the variable or NO_SLOT
+    std::uint32_t findSymbol(const std::string& variableName_) const;
+
+    //! \brief returns the number of slots
+    std::size_t getNumberOfSymbols() const
+    {
+        return m_symbols.size();
+    }
+
+    //! \brief bind the compiled formula stored under the parse tree cache key, all its identifiers are added to the table
+    //! \param cacheKey_ the parse tree cache key of the formula
+    //! \param compiledFormula_ the compiled formula
+    //! \param functions_ the functions of the tariff, the call sites are resolved with them
+    const BoundFormula& bind(const std::string& cacheKey_, const std::shared_ptr<CompiledFormula>& compiledFormula_, const FunctionMap_t& functions_);
+
+    //! \brief returns the formula bound for the parse tree cache key or nullptr
+    const BoundFormula* findFormula(const std::string& cacheKey_) const
+    {
+        FormulaMap_t::const_iterator it = m_formulas.find(cacheKey_);
+        return it != m_formulas.end() ? &it->second : nullptr;
+    }
+
+private:
+    typedef std::unordered_map<std::string, std::uint32_t> SymbolMap_t;
+    typedef std::unordered_map<std::string, BoundFormula> FormulaMap_t;
+
+    //! \brief the slots by the lower case variable names
+    SymbolMap_t m_symbols;
+    FormulaMap_t m_formulas;
+};
+
+} // namespace CalculusPrime
+
+#endif // #ifndef CP_SYMBOLTABLE_H
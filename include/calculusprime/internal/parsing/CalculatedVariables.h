@@ -0,0 +1,92 @@
+/*
+Copyright 2019 Association for the promotion of open - source insurance software and for the establishment of open interface standards in the insurance industry
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http ://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef CP_CALCULATEDVARIABLES_H
+#define CP_CALCULATEDVARIABLES_H 1
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <calculusprime/internal/parsing/IValueHolder.h>
+
+namespace CalculusPrime {
+
+class ParsingContext;
+
+//! \brief The values of the rating outputs of one calculation.
+//! The values are stored in a table of calculated variables and instance ordinals, the instance ids are interned
+//! by the prepared tariff (see ParsingContext::getInstanceOrdinal). Ordinal 0 is the empty instance id and every instance id
+//! which is not interned, like ValueHolder a variable without a value for the instance falls back to ordinal 0.
+//! Reading and writing a value neither hashes nor allocates.
+class CalculatedVariables : public std::enable_shared_from_this<CalculatedVariables>
+{
+public:
+    CalculatedVariables(std::size_t numberOfVariables_, std::size_t numberOfInstances_);
+
+    ~CalculatedVariables();
+
+    //! \brief returns the value holder of the variable, it shares the ownership of this object
+    std::shared_ptr<IValueHolder> getValueHolder(std::size_t variable_)
+    {
+        return std::shared_ptr<IValueHolder>(shared_from_this(), &m_valueHolders[variable_]);
+    }
+
+    //! \brief returns the value of the variable for the instance, or its value for ordinal 0
+    const boost::optional<Value>& getValue(std::size_t variable_, std::uint32_t instanceOrdinal_) const
+    {
+        const boost::optional<Value>* values = &m_values[variable_ * m_numberOfInstances];
+        return values[instanceOrdinal_] ? values[instanceOrdinal_] : values[0];
+    }
+
+    void setValue(std::size_t variable_, std::uint32_t instanceOrdinal_, const Value& value_)
+    {
+        m_values[variable_ * m_numberOfInstances + instanceOrdinal_] = value_;
+    }
+
+private:
+    class CalculatedValueHolder : public IValueHolder
+    {
+    public:
+        CalculatedValueHolder(const CalculatedVariables& calculatedVariables_, std::size_t variable_)
+            : m_calculatedVariables(calculatedVariables_)
+            , m_variable(variable_)
+        {
+        }
+
+        virtual ~CalculatedValueHolder()
+        {
+        }
+
+        virtual boost::optional<Value> getValue(const std::shared_ptr<ParsingContext>& parsingContext_) override;
+
+        virtual bool isFunctionArgument() const override
+        {
+            return false;
+        }
+
+    private:
+        const CalculatedVariables& m_calculatedVariables;
+        const std::size_t m_variable;
+    };
+
+    const std::size_t m_numberOfInstances;
+    //! \brief the values of the variables, one row of m_numberOfInstances values per variable
+    std::vector<boost::optional<Value>> m_values;
+    std::vector<CalculatedValueHolder> m_valueHolders;
+};
+
+} // namespace CalculusPrime
+
+#endif // #ifndef CP_CALCULATEDVARIABLES_H
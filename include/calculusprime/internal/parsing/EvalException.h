@@ -17,21 +17,22 @@ limitations under the License.
 #define CP_EVALEXCEPTION_H 1
 
 #include <exception>
+#include <cstdint>
 #include <sstream>
-#include <ParserRuleContext.h>
+#include <calculusprime/internal/compiler/CompiledFormula.h>
 
 namespace CalculusPrime {
 
 class EvalException : public std::runtime_error
 {
 public:
-    EvalException(antlr4::ParserRuleContext* ctx_)
-        : std::runtime_error(std::string("Illegal expression: " + ctx_->getText()))
+    EvalException(const CompiledFormula& compiledFormula_, std::uint32_t node_)
+        : std::runtime_error(std::string("Illegal expression: " + compiledFormula_.getText(node_)))
     {
     }
 
-    EvalException(const std::string& msg_, antlr4::ParserRuleContext* ctx_)
-        : std::runtime_error(makeMsg(msg_, ctx_))
+    EvalException(const std::string& msg_, const CompiledFormula& compiledFormula_, std::uint32_t node_)
+        : std::runtime_error(makeMsg(msg_, compiledFormula_, node_))
     {
     }
 
@@ -40,10 +41,10 @@ public:
     }
 
 private:
-    static std::string makeMsg(const std::string& msg_, antlr4::ParserRuleContext* ctx_)
+    static std::string makeMsg(const std::string& msg_, const CompiledFormula& compiledFormula_, std::uint32_t node_)
     {
         std::ostringstream msg;
-        msg << msg_ << ", line:" << ctx_->getStart()->getLine() << ", position:" << ctx_->getStart()->getStartIndex();
+        msg << msg_ << ", line:" << compiledFormula_.getLine(node_) << ", position:" << compiledFormula_.getPosition(node_);
         return msg.str();
 
     }
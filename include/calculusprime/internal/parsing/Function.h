@@ -16,12 +16,17 @@ limitations under the License.
 #ifndef CP_FUNCTION_H
 #define CP_FUNCTION_H 1
 
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
+#include <boost/optional.hpp>
 #include <calculusprime/IFunction.h>
 
 namespace CalculusPrime {
 
+class FunctionMemo;
+
 class Function : public IFunction
 {
 public:
@@ -41,11 +46,53 @@ public:
 
     virtual Value execute(const std::vector<Value>& params_, const std::shared_ptr<IParsingContext>& parsingContext_) override;
 
+    //! \brief returns the id of the function, also used as the parse tree cache key of the implementation
+    const std::string& getFunctionId() const
+    {
+        return m_functionId;
+    }
+
+    const std::string& getImplementation() const
+    {
+        return m_implementation;
+    }
+
+    //! \brief returns the names of the arguments
+    const std::vector<std::string>& getArguments() const
+    {
+        return m_arguments;
+    }
+
+    //! \brief returns if the result of the function only depends on its arguments, i.e. its implementation only reads its arguments
+    //! and only calls built-in functions, pure formula functions and business functions which are declared pure. The results of a pure function are memoized per calculation
+    //! (see ParsingContext::getFunctionMemo).
+    bool isPure() const
+    {
+        return m_pure;
+    }
+
+    //! \brief set if the function is pure, the prepared tariff analyzes the implementation (see PreparedTariff)
+    //! \param shareResults_ true if the results are memoized across calculations as well
+    void setPure(bool pure_, bool shareResults_);
+
+    //! \brief the maximum number of results which are memoized across calculations, further results are only memoized per calculation
+    static const std::size_t MAX_SHARED_RESULTS = 4096;
+
 private:
+    //! \brief returns the result which is memoized across calculations
+    boost::optional<Value> findSharedResult(const std::vector<Value>& params_);
+
+    //! \brief memoize the result across calculations
+    void shareResult(const std::vector<Value>& params_, const Value& result_);
+
     const std::string m_implementation;
     std::string m_name;
     std::string m_functionId;
     std::vector<std::string> m_arguments;
+    bool m_pure;
+    //! \brief the results which are memoized across calculations, nullptr if they are not shared
+    std::unique_ptr<FunctionMemo> m_sharedResults;
+    std::mutex m_sharedResultsMutex;
 };
 
 } // namespace CalculusPrime
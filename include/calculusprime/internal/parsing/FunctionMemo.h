@@ -0,0 +1,68 @@
+/*
+Copyright 2019 Association for the promotion of open - source insurance software and for the establishment of open interface standards in the insurance industry
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http ://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef CP_FUNCTIONMEMO_H
+#define CP_FUNCTIONMEMO_H 1
+
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+#include <calculusprime/Value.h>
+
+namespace CalculusPrime {
+
+class IFunction;
+
+//! \brief The results of pure formula functions (see Function::isPure) by their arguments.
+//! Arguments are compared exactly, i.e. without the tolerance of operator== of Value, so a result is only
+//! reused for the very same arguments. Looking up a result does not allocate. The memo is not synchronized.
+class FunctionMemo
+{
+public:
+    FunctionMemo();
+
+    ~FunctionMemo();
+
+    //! \brief returns the result of the function for the arguments, nullptr if it is not memoized
+    const Value* find(const IFunction* function_, const std::vector<Value>& arguments_) const;
+
+    //! \brief memoize the result of the function for the arguments
+    void insert(const IFunction* function_, const std::vector<Value>& arguments_, const Value& result_);
+
+    //! \brief returns the number of memoized results
+    std::size_t size() const
+    {
+        return m_results.size();
+    }
+
+private:
+    struct Entry
+    {
+        const IFunction* function;
+        std::vector<Value> arguments;
+        Value result;
+    };
+
+    //! \brief the entries by the hash of their function and arguments
+    typedef std::unordered_multimap<std::size_t, Entry> Results_t;
+
+    static std::size_t hash(const IFunction* function_, const std::vector<Value>& arguments_);
+
+    Results_t m_results;
+};
+
+} // namespace CalculusPrime
+
+#endif // #ifndef CP_FUNCTIONMEMO_H
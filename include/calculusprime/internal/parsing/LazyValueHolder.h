@@ -16,7 +16,10 @@ limitations under the License.
 #ifndef CP_LAZYVALUEHOLDER_H
 #define CP_LAZYVALUEHOLDER_H 1
 
+#include <future>
 #include <memory>
+#include <mutex>
+#include <thread>
 #include <unordered_map>
 #include <calculusprime/internal/parsing/IValueHolder.h>
 #include <calculusprime/internal/parsing/ValueHolder.h>
@@ -25,14 +28,18 @@ namespace CalculusPrime {
 
 class ParsingContext;
 
-// value holder with lazy evaluation - value is calculated on demand
+// value holder with lazy evaluation - value is calculated on demand.
+// Rating outputs which are calculated concurrently share the value holder. A value is calculated once without holding a lock,
+// threads which need a value while another thread calculates it wait for its result. Formulas with cycles are calculated
+// sequentially (see PreparedTariff::calculate), a formula which the thread calculating it references again is calculated again.
+// The value of an instance invariant formula is calculated once for all instance ids.
 class LazyValueHolder : public IValueHolder
 {
 public:
-    LazyValueHolder(const std::string& variableName_, const std::string& formula_)
-        : m_value(std::make_shared<ValueHolder::ValueMap_t>())
-        , m_variableName(variableName_)
+    LazyValueHolder(const std::string& variableName_, const std::string& formula_, bool instanceInvariant_ = false)
+        : m_variableName(variableName_)
         , m_formula(formula_)
+        , m_instanceInvariant(instanceInvariant_)
     {
     }
 
@@ -48,9 +55,22 @@ public:
     }
 
 private:
-    std::shared_ptr<ValueHolder::ValueMap_t> m_value;
+    //! \brief a value which is being calculated
+    struct Calculation
+    {
+        std::thread::id thread;
+        std::shared_future<Value> result;
+    };
+
+    //! \brief allocated from the heap, the values are calculated by the threads of all rating outputs
+    ValueHolder::ValueMap_t m_value;
     const std::string m_variableName;
     const std::string m_formula;
+    const bool m_instanceInvariant;
+    //! \brief the values which are being calculated by instance id
+    std::unordered_map<std::string, Calculation> m_calculations;
+    //! \brief guards m_value and m_calculations, it is not held while a value is calculated
+    std::mutex m_mutex;
 };
 
 } // namespace CalculusPrime
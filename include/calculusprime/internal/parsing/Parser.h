@@ -22,6 +22,7 @@ limitations under the License.
 
 namespace CalculusPrime {
 
+class CompiledFormula;
 class ParsingContext;
 
 class Parser
@@ -36,7 +37,13 @@ public:
 
     Value parse(const std::string& variableName_, const std::string& formula_);
 
+    //! \brief returns the compiled formula from the parse tree cache, the formula is compiled and cached if not found
+    std::shared_ptr<CompiledFormula> getCompiledFormula(const std::string& variableName_, const std::string& formula_);
+
 private:
+    //! \brief parse the formula and compile its parse tree
+    std::shared_ptr<CompiledFormula> compile(const std::string& variableName_, const std::string& formula_);
+
     const std::shared_ptr<ParsingContext> m_parsingContext;
 };
 
@@ -18,6 +18,7 @@ limitations under the License.
 
 #include <memory>
 #include <unordered_map>
+#include <calculusprime/internal/Arena.h>
 #include <calculusprime/internal/parsing/IValueHolder.h>
 
 namespace CalculusPrime {
@@ -27,7 +28,8 @@ class ParsingContext;
 class ValueHolder : public IValueHolder
 {
 public:
-    typedef std::unordered_map<std::string, Value> ValueMap_t;
+    //! \brief the values by their instance id, allocated from the arena of the calculation (see Arena)
+    typedef std::unordered_map<std::string, Value, std::hash<std::string>, std::equal_to<std::string>, ArenaAllocator<std::pair<const std::string, Value>>> ValueMap_t;
 
     ValueHolder(const std::shared_ptr<ValueMap_t>& value_)
         : m_value(value_)
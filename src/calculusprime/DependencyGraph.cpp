@@ -0,0 +1,192 @@
+/*
+Copyright 2019 Association for the promotion of open - source insurance software and for the establishment of open interface standards in the insurance industry
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http ://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <calculusprime/DependencyGraph.h>
+#include <algorithm>
+#include <iterator>
+#include <boost/algorithm/string/case_conv.hpp>
+
+namespace bal = boost::algorithm;
+
+namespace CalculusPrime {
+
+const std::size_t DependencyGraph::NO_NODE;
+
+DependencyGraph::DependencyGraph()
+{
+}
+
+DependencyGraph::DependencyGraph(const std::vector<Node>& nodes_)
+    : m_nodes(nodes_)
+{
+    for (std::size_t i = 0; i < m_nodes.size(); ++i) {
+        const Node& node = m_nodes[i];
+        m_nodeIndices.emplace(bal::to_lower_copy(node.name), i);
+        if (node.type == NodeType::FORMULA_FUNCTION) {
+            // functions are also found by their name without the arguments
+            m_nodeIndices.emplace(bal::to_lower_copy(node.name.substr(0, node.name.find('('))), i);
+        }
+    }
+    findCycles();
+    computeOutputLevels();
+}
+
+std::size_t DependencyGraph::findNode(const std::string& name_) const
+{
+    std::unordered_map<std::string, std::size_t>::const_iterator it = m_nodeIndices.find(bal::to_lower_copy(name_));
+    return it != m_nodeIndices.end() ? it->second : NO_NODE;
+}
+
+void DependencyGraph::findCycles()
+{
+    // Tarjan's strongly connected components, iterative so deep formula chains do not exhaust the stack
+    const std::size_t numNodes = m_nodes.size();
+    std::vector<std::size_t> index(numNodes, NO_NODE);
+    std::vector<std::size_t> lowLink(numNodes, 0);
+    std::vector<bool> onStack(numNodes, false);
+    std::vector<std::size_t> stack;
+    // the nodes being visited and the next dependency to visit
+    std::vector<std::pair<std::size_t, std::size_t>> callStack;
+    std::size_t nextIndex = 0;
+
+    for (std::size_t root = 0; root < numNodes; ++root) {
+        if (index[root] != NO_NODE) {
+            continue;
+        }
+        callStack.emplace_back(root, 0);
+        while (!callStack.empty()) {
+            const std::size_t node = callStack.back().first;
+            std::size_t& next = callStack.back().second;
+            if (next == 0 && index[node] == NO_NODE) {
+                index[node] = lowLink[node] = nextIndex++;
+                stack.push_back(node);
+                onStack[node] = true;
+            }
+
+            const std::vector<std::size_t>& dependencies = m_nodes[node].dependencies;
+            if (next < dependencies.size()) {
+                const std::size_t dependency = dependencies[next++];
+                if (index[dependency] == NO_NODE) {
+                    callStack.emplace_back(dependency, 0);
+                }
+                else if (onStack[dependency]) {
+                    lowLink[node] = std::min(lowLink[node], index[dependency]);
+                }
+                continue;
+            }
+
+            if (lowLink[node] == index[node]) {
+                std::vector<std::size_t> component;
+                std::size_t member;
+                do {
+                    member = stack.back();
+                    stack.pop_back();
+                    onStack[member] = false;
+                    component.push_back(member);
+                } while (member != node);
+
+                // functions which only call each other are recursive, they may terminate
+                const bool isCycle = std::any_of(component.begin(), component.end(), [this](std::size_t i_) {
+                    return m_nodes[i_].type != NodeType::FORMULA_FUNCTION;
+                }) && (component.size() > 1 || std::binary_search(dependencies.begin(), dependencies.end(), node));
+                if (isCycle) {
+                    std::sort(component.begin(), component.end());
+                    m_cycles.push_back(component);
+                }
+            }
+
+            callStack.pop_back();
+            if (!callStack.empty()) {
+                const std::size_t parent = callStack.back().first;
+                lowLink[parent] = std::min(lowLink[parent], lowLink[node]);
+            }
+        }
+    }
+    std::sort(m_cycles.begin(), m_cycles.end());
+}
+
+void DependencyGraph::computeOutputLevels()
+{
+    std::vector<std::size_t> outputs;
+    // the rating outputs by lower case variable name
+    std::unordered_map<std::string, std::vector<std::size_t>> outputsByName;
+    for (std::size_t i = 0; i < m_nodes.size(); ++i) {
+        if (m_nodes[i].type == NodeType::RATING_OUTPUT) {
+            outputs.push_back(i);
+            outputsByName[bal::to_lower_copy(m_nodes[i].name)].push_back(i);
+        }
+    }
+
+    // the outputs are calculated in node order, an output is above every output before it which it is connected to
+    std::vector<std::size_t> level(m_nodes.size(), 0);
+    std::vector<bool> visited(m_nodes.size());
+    std::vector<std::size_t> pending;
+    std::vector<std::size_t> connectedOutputs;
+    for (std::size_t output : outputs) {
+        // the outputs reachable from this output through formulas
+        std::fill(visited.begin(), visited.end(), false);
+        visited[output] = true;
+        connectedOutputs.clear();
+        pending.assign(m_nodes[output].dependencies.begin(), m_nodes[output].dependencies.end());
+        while (!pending.empty()) {
+            const std::size_t node = pending.back();
+            pending.pop_back();
+            if (visited[node]) {
+                continue;
+            }
+            visited[node] = true;
+            if (m_nodes[node].type == NodeType::RATING_OUTPUT) {
+                connectedOutputs.push_back(node);
+            }
+            else {
+                pending.insert(pending.end(), m_nodes[node].dependencies.begin(), m_nodes[node].dependencies.end());
+            }
+        }
+
+        for (std::size_t connectedOutput : connectedOutputs) {
+            if (connectedOutput < output) {
+                level[output] = std::max(level[output], level[connectedOutput] + 1);
+            }
+        }
+        // the later outputs which must wait for this output:
+        // outputs its formulas refer to, outputs which overwrite a variable it reads and outputs which overwrite its own value
+        std::vector<std::size_t> laterOutputs;
+        for (std::size_t connectedOutput : connectedOutputs) {
+            const std::vector<std::size_t>& sameName = outputsByName[bal::to_lower_copy(m_nodes[connectedOutput].name)];
+            std::copy_if(sameName.begin(), sameName.end(), std::back_inserter(laterOutputs), [output](std::size_t i_) {
+                return i_ > output;
+            });
+        }
+        const std::vector<std::size_t>& sameName = outputsByName[bal::to_lower_copy(m_nodes[output].name)];
+        std::copy_if(sameName.begin(), sameName.end(), std::back_inserter(laterOutputs), [this, output](std::size_t i_) {
+            return i_ > output && m_nodes[i_].instanceId == m_nodes[output].instanceId;
+        });
+        for (std::size_t laterOutput : laterOutputs) {
+            level[laterOutput] = std::max(level[laterOutput], level[output] + 1);
+        }
+    }
+
+    for (std::size_t output : outputs) {
+        if (m_outputLevels.size() <= level[output]) {
+            m_outputLevels.resize(level[output] + 1);
+        }
+        m_outputLevels[level[output]].push_back(output);
+    }
+    for (const std::vector<std::size_t>& outputLevel : m_outputLevels) {
+        m_outputOrder.insert(m_outputOrder.end(), outputLevel.begin(), outputLevel.end());
+    }
+}
+
+} // namespace CalculusPrime
@@ -0,0 +1,52 @@
+/*
+Copyright 2019 Association for the promotion of open - source insurance software and for the establishment of open interface standards in the insurance industry
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http ://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <calculusprime/IRatingEngine.h>
+#include <ostream>
+#include <boost/throw_exception.hpp>
+#include <calculusprime/IPreparedTariff.h>
+#include <calculusprime/RatingEngineException.h>
+
+namespace CalculusPrime {
+
+std::unique_ptr<IPreparedTariff> IRatingEngine::prepare(const std::string&, const RatingFormulaMap_t&, const std::vector<RatingOutput>&)
+{
+    BOOST_THROW_EXCEPTION(RatingEngineException(RatingEngineError::CALLER_SPECIFIC, "prepared tariffs are not supported by this rating engine"));
+}
+
+std::vector<IRatingEngine::BatchResult> IRatingEngine::calculateBatch(const std::string& insuranceRateKey_, const std::vector<Map_t>& inputs_, const RatingFormulaMap_t& ratingFormulas_, const std::vector<RatingOutput>& ratingOutput_)
+{
+    std::vector<BatchResult> results(inputs_.size());
+    for (std::size_t i = 0; i < inputs_.size(); ++i) {
+        try {
+            results[i].output = calculate(insuranceRateKey_, inputs_[i], ratingFormulas_, ratingOutput_);
+        }
+        catch (...) {
+            results[i].error = std::current_exception();
+        }
+    }
+    return results;
+}
+
+DependencyGraph IRatingEngine::analyzeDependencies(const std::string&, const RatingFormulaMap_t&, const std::vector<RatingOutput>&)
+{
+    BOOST_THROW_EXCEPTION(RatingEngineException(RatingEngineError::CALLER_SPECIFIC, "the dependency analysis is not supported by this rating engine"));
+}
+
+void IRatingEngine::evictPreparedTariffs(const std::string&)
+{
+}
+
+} // namespace CalculusPrime
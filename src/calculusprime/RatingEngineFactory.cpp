@@ -20,6 +20,11 @@ limitations under the License.
 namespace CalculusPrime {
 
 std::unique_ptr<IRatingEngine> RatingEngineFactory::createRatingEngine(const std::vector<std::shared_ptr<IFunction>>& functions_, const std::shared_ptr<IFunctionResultCache>& functionResultCache_, const std::shared_ptr<IParseTreeCache>& parseTreeCache_)
+{
+    return createRatingEngine(functions_, functionResultCache_, parseTreeCache_, RatingEngineOptions());
+}
+
+std::unique_ptr<IRatingEngine> RatingEngineFactory::createRatingEngine(const std::vector<std::shared_ptr<IFunction>>& functions_, const std::shared_ptr<IFunctionResultCache>& functionResultCache_, const std::shared_ptr<IParseTreeCache>& parseTreeCache_, const RatingEngineOptions& options_)
 {
     if (!functionResultCache_) {
         BOOST_THROW_EXCEPTION(std::invalid_argument("parameter 'functionResultCache_' is null"));
@@ -28,7 +33,7 @@ std::unique_ptr<IRatingEngine> RatingEngineFactory::createRatingEngine(const std
         BOOST_THROW_EXCEPTION(std::invalid_argument("parameter 'parseTreeCache_' is null"));
     }
 
-    return std::make_unique<RatingEngine>(functions_, functionResultCache_, parseTreeCache_);
+    return std::make_unique<RatingEngine>(functions_, functionResultCache_, parseTreeCache_, options_);
 }
 
 } // namespace CalculusPrime
@@ -0,0 +1,104 @@
+/*
+Copyright 2019 Association for the promotion of open - source insurance software and for the establishment of open interface standards in the insurance industry
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http ://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <calculusprime/Value.h>
+#include <cstring>
+#include <new>
+#include <ostream>
+
+namespace CalculusPrime {
+
+namespace {
+
+class ValueVisitor
+    : public boost::static_visitor<Value>
+{
+public:
+    template <typename T>
+    Value operator()(const T& value_) const
+    {
+        return Value(value_);
+    }
+};
+}
+
+Value::Value(const Variant_t& value_)
+    : Value(boost::apply_visitor(ValueVisitor(), value_))
+{
+}
+
+Value::StringData* Value::createString(boost::string_view value_)
+{
+    if (value_.empty()) {
+        return nullptr;
+    }
+    void* memory = ::operator new(sizeof(StringData) + value_.size());
+    StringData* string = new (memory) StringData;
+    string->refCount.store(1, std::memory_order_relaxed);
+    string->size = value_.size();
+    std::memcpy(reinterpret_cast<char*>(string + 1), value_.data(), value_.size());
+    return string;
+}
+
+void Value::destroyString(StringData* string_)
+{
+    string_->~StringData();
+    ::operator delete(string_);
+}
+
+std::ostream& operator<< (std::ostream& os_, const Value& value_)
+{
+    if (value_.isVoid()) {
+        os_ << "VOID";
+    }
+    else if (value_.isBool()) {
+        os_ << std::boolalpha << value_.asBool();
+    }
+    else if (value_.isDouble()) {
+        // this is a hack to remove .0 from double to String conversion
+        double d = value_.asDouble();
+        long l = (long)d;
+        if (d == l) {
+            os_ << l;
+        }
+        else {
+            os_ << d;
+        }
+    }
+    else if (value_.isString()) {
+        os_ << '\'' << value_.asStringView() << '\'';
+    }
+    return os_;
+}
+
+bool operator <(const Value& lhs_, const Value& rhs_)
+{
+    if (lhs_.isVoid() || rhs_.isVoid()) {
+        BOOST_THROW_EXCEPTION(std::runtime_error("operator < not applicable for empty values"));
+    }
+    if (lhs_.m_type != rhs_.m_type) {
+        return lhs_.m_type < rhs_.m_type;
+    }
+    switch (lhs_.m_type) {
+    case Value::Type::DOUBLE:
+        return lhs_.m_data.number < rhs_.m_data.number;
+    case Value::Type::BOOL:
+        return lhs_.m_data.boolean < rhs_.m_data.boolean;
+    default:
+        return lhs_.asStringView() < rhs_.asStringView();
+    }
+}
+
+} // namespace CalculusPrime
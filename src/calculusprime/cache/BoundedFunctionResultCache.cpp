@@ -0,0 +1,601 @@
+/*
+Copyright 2019 Association for the promotion of open - source insurance software and for the establishment of open interface standards in the insurance industry
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http ://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <calculusprime/cache/BoundedFunctionResultCache.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+#include <boost/functional/hash.hpp>
+#include <boost/intrusive/list.hpp>
+#include <calculusprime/cache/ValidityPeriods.h>
+
+namespace CalculusPrime {
+
+namespace {
+
+namespace bi = boost::intrusive;
+
+// the estimated overhead of a node of an unordered_map with its bucket
+const std::size_t NODE_OVERHEAD = 4 * sizeof(void*);
+
+// the bytes of a value which are not part of its 16 bytes, i.e. the shared string
+std::size_t externalBytes(const Value& value_)
+{
+    if (value_.isVoid() || !value_.isString()) {
+        return 0;
+    }
+    const std::size_t size = value_.asStringView().size();
+    return size > 0 ? size + 2 * sizeof(std::size_t) : 0;
+}
+
+// the bytes of a validity period which is added, see ValidityPeriods::insert
+std::size_t periodBytes(const std::string& validFrom_, const std::string& validTo_, const Value& result_)
+{
+    if (ValidityPeriods::toDayNumber(validFrom_) && ValidityPeriods::toDayNumber(validTo_)) {
+        return sizeof(ValidityPeriods::Period) + sizeof(std::int32_t) + externalBytes(result_);
+    }
+    return sizeof(ValidityPeriods::StringPeriod) + validFrom_.capacity() + validTo_.capacity() + externalBytes(result_);
+}
+
+//! \brief A count-min sketch of 4 bit counters estimating how often keys were requested.
+//! All counters are halved after 10 increments per expected key, so the estimates follow a changing workload.
+class FrequencySketch
+{
+public:
+    explicit FrequencySketch(std::size_t expectedKeys_)
+        : m_table(tableSize(expectedKeys_), 0)
+        , m_mask(m_table.size() - 1)
+        , m_sampleSize(10 * m_table.size())
+        , m_additions(0)
+    {
+    }
+
+    void increment(std::size_t hash_)
+    {
+        bool added = false;
+        for (std::size_t row = 0; row < ROWS; ++row) {
+            const Counter counter = locate(hash_, row);
+            if (((m_table[counter.word] >> counter.shift) & 0xF) < 0xF) {
+                m_table[counter.word] += std::uint64_t(1) << counter.shift;
+                added = true;
+            }
+        }
+        if (added && ++m_additions >= m_sampleSize) {
+            for (std::uint64_t& word : m_table) {
+                word = (word >> 1) & 0x7777777777777777ULL;
+            }
+            m_additions /= 2;
+        }
+    }
+
+    unsigned frequency(std::size_t hash_) const
+    {
+        unsigned result = 0xF;
+        for (std::size_t row = 0; row < ROWS; ++row) {
+            const Counter counter = locate(hash_, row);
+            result = std::min(result, static_cast<unsigned>((m_table[counter.word] >> counter.shift) & 0xF));
+        }
+        return result;
+    }
+
+private:
+    static const std::size_t ROWS = 4;
+
+    struct Counter
+    {
+        std::size_t word;
+        unsigned shift;
+    };
+
+    static std::size_t tableSize(std::size_t expectedKeys_)
+    {
+        std::size_t size = 64;
+        while (size < expectedKeys_ && size < (std::size_t(1) << 24)) {
+            size *= 2;
+        }
+        return size;
+    }
+
+    // every row uses a different hash of the key and its own 16 of the 64 counters of a word
+    Counter locate(std::size_t hash_, std::size_t row_) const
+    {
+        static const std::uint64_t SEEDS[ROWS] = { 0xc3a5c85c97cb3127ULL, 0xb492b66fbe98f273ULL, 0x9ae16a3b2f90404fULL, 0xcbf29ce484222325ULL };
+        std::uint64_t h = (static_cast<std::uint64_t>(hash_) + SEEDS[row_]) * 0x9e3779b97f4a7c15ULL;
+        h ^= h >> 32;
+        Counter counter;
+        counter.word = static_cast<std::size_t>(h) & m_mask;
+        counter.shift = static_cast<unsigned>(((h >> 40) & 3) + 4 * row_) * 4;
+        return counter;
+    }
+
+    std::vector<std::uint64_t> m_table;
+    const std::size_t m_mask;
+    const std::size_t m_sampleSize;
+    std::size_t m_additions;
+};
+}
+
+//! \brief The results of all insurance rate keys. Every result is in the order list of its segment and in the list of its insurance rate key,
+//! both ordered from the most to the least recently used result. With LRU all results are in the protected segment, which is the whole cache then.
+class BoundedFunctionResultCache::Store
+{
+public:
+    Store(std::size_t maxBytes_, EvictionPolicy evictionPolicy_)
+        : m_maxBytes(maxBytes_)
+        , m_evictionPolicy(evictionPolicy_)
+        , m_windowMaxBytes(evictionPolicy_ == EvictionPolicy::W_TINY_LFU ? std::max<std::size_t>(maxBytes_ / 100, 1) : 0)
+        , m_protectedMaxBytes((maxBytes_ - std::min(maxBytes_, m_windowMaxBytes)) / 100 * (evictionPolicy_ == EvictionPolicy::W_TINY_LFU ? 80 : 100))
+        , m_sketch(evictionPolicy_ == EvictionPolicy::W_TINY_LFU ? maxBytes_ / 256 : 0)
+        , m_bytes(0)
+        , m_numberOfResults(0)
+        , m_statistics()
+    {
+        m_segmentBytes.fill(0);
+    }
+
+    ~Store()
+    {
+        for (OrderList_t& list : m_segments) {
+            list.clear();
+        }
+        for (auto& rateKey : m_rateKeys) {
+            rateKey.second->entries.clear();
+        }
+    }
+
+    void put(const std::string& insuranceRateKey_, const std::string& cacheKey_, const Value& result_)
+    {
+        putResult(insuranceRateKey_, cacheKey_, RESULT, std::chrono::system_clock::time_point::max(), result_);
+    }
+
+    void putWithExpiry(const std::string& insuranceRateKey_, const std::string& cacheKey_, std::chrono::system_clock::time_point expiry_, const Value& result_)
+    {
+        putResult(insuranceRateKey_, cacheKey_, EXPIRING_RESULT, expiry_, result_);
+    }
+
+    void putWithValidity(const std::string& insuranceRateKey_, const std::string& cacheKey_, const std::string& validFrom_, const std::string& validTo_, const Value& result_)
+    {
+        RateKeyState& rateKey = getRateKey(insuranceRateKey_);
+        auto inserted = rateKey.datedResults.emplace(cacheKey_, nullptr);
+        Entry* entry = inserted.first->second.get();
+        if (inserted.second) {
+            inserted.first->second.reset(entry = new Entry(rateKey, inserted.first->first, DATED_RESULT));
+            entry->periods.insert(validFrom_, validTo_, result_);
+            add(*entry, entryBytes(cacheKey_) + periodBytes(validFrom_, validTo_, result_));
+        }
+        else {
+            if (boost::optional<Value> replaced = entry->periods.insert(validFrom_, validTo_, result_)) {
+                resize(*entry, entry->bytes - externalBytes(*replaced) + externalBytes(result_));
+            }
+            else {
+                resize(*entry, entry->bytes + periodBytes(validFrom_, validTo_, result_));
+            }
+            touch(*entry);
+        }
+        enforceLimits(rateKey);
+    }
+
+    boost::optional<Value> get(const std::string& insuranceRateKey_, const std::string& cacheKey_)
+    {
+        Entry* entry = find(insuranceRateKey_, cacheKey_, RESULT);
+        if (entry == nullptr) {
+            ++m_statistics.misses;
+            return boost::none;
+        }
+        ++m_statistics.hits;
+        touch(*entry);
+        return entry->result;
+    }
+
+    // an expired result is evicted
+    boost::optional<Value> getWithExpiry(const std::string& insuranceRateKey_, std::chrono::system_clock::time_point now_, const std::string& cacheKey_)
+    {
+        Entry* entry = find(insuranceRateKey_, cacheKey_, EXPIRING_RESULT);
+        if (entry != nullptr && entry->expiry <= now_) {
+            RateKeyState& rateKey = entry->rateKey;
+            evict(*entry);
+            removeIfUnused(rateKey);
+            entry = nullptr;
+        }
+        if (entry == nullptr) {
+            ++m_statistics.misses;
+            return boost::none;
+        }
+        ++m_statistics.hits;
+        touch(*entry);
+        return entry->result;
+    }
+
+    boost::optional<Value> getWithValidity(const std::string& insuranceRateKey_, const std::string& date_, const std::string& cacheKey_)
+    {
+        Entry* entry = find(insuranceRateKey_, cacheKey_, DATED_RESULT);
+        boost::optional<Value> result;
+        if (entry != nullptr) {
+            result = entry->periods.find(date_);
+        }
+        if (!result) {
+            ++m_statistics.misses;
+            return boost::none;
+        }
+        ++m_statistics.hits;
+        touch(*entry);
+        return result;
+    }
+
+    void setQuota(const std::string& insuranceRateKey_, std::size_t maxBytes_)
+    {
+        RateKeyState& rateKey = getRateKey(insuranceRateKey_);
+        rateKey.quota = maxBytes_;
+        enforceLimits(rateKey);
+    }
+
+    std::size_t getBytes() const
+    {
+        return m_bytes;
+    }
+
+    std::size_t getBytes(const std::string& insuranceRateKey_) const
+    {
+        RateKeyMap_t::const_iterator it = m_rateKeys.find(insuranceRateKey_);
+        return it != m_rateKeys.end() ? it->second->bytes : 0;
+    }
+
+    std::size_t getNumberOfResults() const
+    {
+        return m_numberOfResults;
+    }
+
+    const Statistics& getStatistics() const
+    {
+        return m_statistics;
+    }
+
+private:
+    enum Segment { WINDOW, PROBATION, PROTECTED, NUMBER_OF_SEGMENTS };
+
+    //! the kinds of results have their own maps, a cache key may be used by every kind
+    enum Kind { RESULT, DATED_RESULT, EXPIRING_RESULT };
+
+    struct RateKeyState;
+
+    struct Entry
+    {
+        Entry(RateKeyState& rateKey_, const std::string& cacheKey_, Kind kind_)
+            : rateKey(rateKey_)
+            , cacheKey(cacheKey_)
+            , kind(kind_)
+            , segment(PROTECTED)
+            , bytes(0)
+            , hash(std::hash<std::string>()(cacheKey_))
+            , expiry(std::chrono::system_clock::time_point::max())
+        {
+            boost::hash_combine(hash, rateKey_.hash);
+            boost::hash_combine(hash, static_cast<int>(kind_));
+        }
+
+        bi::list_member_hook<> orderHook;
+        bi::list_member_hook<> rateKeyHook;
+        RateKeyState& rateKey;
+        //! the key of the map which owns the entry
+        const std::string& cacheKey;
+        const Kind kind;
+        Segment segment;
+        std::size_t bytes;
+        //! the hash of the insurance rate key and the cache key for the frequency sketch
+        std::size_t hash;
+        //! the result without validity dates
+        Value result;
+        //! the time from which on the result is not used, only for EXPIRING_RESULT
+        std::chrono::system_clock::time_point expiry;
+        //! the results with validity dates
+        ValidityPeriods periods;
+    };
+
+    typedef bi::list<Entry, bi::member_hook<Entry, bi::list_member_hook<>, &Entry::orderHook>> OrderList_t;
+    typedef bi::list<Entry, bi::member_hook<Entry, bi::list_member_hook<>, &Entry::rateKeyHook>> RateKeyList_t;
+    typedef std::unordered_map<std::string, std::unique_ptr<Entry>> EntryMap_t;
+
+    struct RateKeyState
+    {
+        explicit RateKeyState(const std::string& name_)
+            : name(name_)
+            , hash(std::hash<std::string>()(name_))
+            , bytes(0)
+            , quota(0)
+        {
+        }
+
+        //! the key of m_rateKeys
+        const std::string& name;
+        const std::size_t hash;
+        std::size_t bytes;
+        //! the maximum number of bytes, 0 without quota
+        std::size_t quota;
+        EntryMap_t results;
+        EntryMap_t datedResults;
+        EntryMap_t expiringResults;
+        //! from the most to the least recently used result
+        RateKeyList_t entries;
+    };
+
+    typedef std::unordered_map<std::string, std::unique_ptr<RateKeyState>> RateKeyMap_t;
+
+    static std::size_t entryBytes(const std::string& cacheKey_)
+    {
+        return sizeof(Entry) + NODE_OVERHEAD + cacheKey_.capacity();
+    }
+
+    RateKeyState& getRateKey(const std::string& insuranceRateKey_)
+    {
+        auto inserted = m_rateKeys.emplace(insuranceRateKey_, nullptr);
+        if (inserted.second) {
+            inserted.first->second.reset(new RateKeyState(inserted.first->first));
+        }
+        return *inserted.first->second;
+    }
+
+    static EntryMap_t& getEntries(RateKeyState& rateKey_, Kind kind_)
+    {
+        return kind_ == DATED_RESULT ? rateKey_.datedResults : kind_ == EXPIRING_RESULT ? rateKey_.expiringResults : rateKey_.results;
+    }
+
+    Entry* find(const std::string& insuranceRateKey_, const std::string& cacheKey_, Kind kind_) const
+    {
+        RateKeyMap_t::const_iterator rateKey = m_rateKeys.find(insuranceRateKey_);
+        if (rateKey == m_rateKeys.end()) {
+            return nullptr;
+        }
+        const EntryMap_t& entries = getEntries(*rateKey->second, kind_);
+        EntryMap_t::const_iterator it = entries.find(cacheKey_);
+        return it != entries.end() ? it->second.get() : nullptr;
+    }
+
+    // a result without validity dates
+    void putResult(const std::string& insuranceRateKey_, const std::string& cacheKey_, Kind kind_, std::chrono::system_clock::time_point expiry_, const Value& result_)
+    {
+        RateKeyState& rateKey = getRateKey(insuranceRateKey_);
+        auto inserted = getEntries(rateKey, kind_).emplace(cacheKey_, nullptr);
+        Entry* entry = inserted.first->second.get();
+        if (inserted.second) {
+            inserted.first->second.reset(entry = new Entry(rateKey, inserted.first->first, kind_));
+            entry->result = result_;
+            add(*entry, entryBytes(cacheKey_) + externalBytes(result_));
+        }
+        else {
+            resize(*entry, entry->bytes - externalBytes(entry->result) + externalBytes(result_));
+            entry->result = result_;
+            touch(*entry);
+        }
+        entry->expiry = expiry_;
+        enforceLimits(rateKey);
+    }
+
+    // a new result enters the window with W-TinyLFU
+    void add(Entry& entry_, std::size_t bytes_)
+    {
+        entry_.bytes = bytes_;
+        entry_.segment = m_evictionPolicy == EvictionPolicy::W_TINY_LFU ? WINDOW : PROTECTED;
+        m_segments[entry_.segment].push_front(entry_);
+        m_segmentBytes[entry_.segment] += bytes_;
+        entry_.rateKey.entries.push_front(entry_);
+        entry_.rateKey.bytes += bytes_;
+        m_bytes += bytes_;
+        ++m_numberOfResults;
+        ++m_statistics.insertions;
+        if (m_evictionPolicy == EvictionPolicy::W_TINY_LFU) {
+            m_sketch.increment(entry_.hash);
+        }
+    }
+
+    void resize(Entry& entry_, std::size_t bytes_)
+    {
+        m_segmentBytes[entry_.segment] += bytes_ - entry_.bytes;
+        entry_.rateKey.bytes += bytes_ - entry_.bytes;
+        m_bytes += bytes_ - entry_.bytes;
+        entry_.bytes = bytes_;
+    }
+
+    // a result used again in the probation segment is protected
+    void touch(Entry& entry_)
+    {
+        entry_.rateKey.entries.splice(entry_.rateKey.entries.begin(), entry_.rateKey.entries, entry_.rateKey.entries.iterator_to(entry_));
+        if (m_evictionPolicy == EvictionPolicy::W_TINY_LFU) {
+            m_sketch.increment(entry_.hash);
+            if (entry_.segment == PROBATION) {
+                move(entry_, PROTECTED);
+                while (m_segmentBytes[PROTECTED] > m_protectedMaxBytes && &m_segments[PROTECTED].back() != &entry_) {
+                    move(m_segments[PROTECTED].back(), PROBATION);
+                }
+                return;
+            }
+        }
+        OrderList_t& list = m_segments[entry_.segment];
+        list.splice(list.begin(), list, list.iterator_to(entry_));
+    }
+
+    // moves the entry to the front of the segment
+    void move(Entry& entry_, Segment segment_)
+    {
+        m_segments[entry_.segment].erase(m_segments[entry_.segment].iterator_to(entry_));
+        m_segmentBytes[entry_.segment] -= entry_.bytes;
+        entry_.segment = segment_;
+        m_segments[segment_].push_front(entry_);
+        m_segmentBytes[segment_] += entry_.bytes;
+    }
+
+    void evict(Entry& entry_)
+    {
+        RateKeyState& rateKey = entry_.rateKey;
+        m_segments[entry_.segment].erase(m_segments[entry_.segment].iterator_to(entry_));
+        m_segmentBytes[entry_.segment] -= entry_.bytes;
+        rateKey.entries.erase(rateKey.entries.iterator_to(entry_));
+        rateKey.bytes -= entry_.bytes;
+        m_bytes -= entry_.bytes;
+        --m_numberOfResults;
+        ++m_statistics.evictions;
+        m_statistics.evictedBytes += entry_.bytes;
+        // erasing the entry destroys its cache key
+        EntryMap_t& entries = getEntries(rateKey, entry_.kind);
+        entries.erase(entries.find(entry_.cacheKey));
+    }
+
+    // the insurance rate keys without results and without quota are removed
+    void removeIfUnused(RateKeyState& rateKey_)
+    {
+        if (rateKey_.entries.empty() && rateKey_.quota == 0) {
+            m_rateKeys.erase(m_rateKeys.find(rateKey_.name));
+        }
+    }
+
+    // evicts results until the insurance rate key keeps its quota and the cache its maximum size
+    void enforceLimits(RateKeyState& rateKey_)
+    {
+        if (rateKey_.quota != 0) {
+            while (rateKey_.bytes > rateKey_.quota) {
+                ++m_statistics.quotaEvictions;
+                evict(rateKey_.entries.back());
+            }
+        }
+        if (m_evictionPolicy == EvictionPolicy::W_TINY_LFU) {
+            while (m_segmentBytes[WINDOW] > m_windowMaxBytes) {
+                admit(m_segments[WINDOW].back(), rateKey_);
+            }
+        }
+        // with W-TinyLFU this only evicts if a result is larger than the main area
+        while (m_bytes > m_maxBytes) {
+            const Segment segment = !m_segments[PROBATION].empty() ? PROBATION : !m_segments[PROTECTED].empty() ? PROTECTED : WINDOW;
+            evictAndRemoveUnused(m_segments[segment].back(), rateKey_);
+        }
+        removeIfUnused(rateKey_);
+    }
+
+    // the insurance rate key of the caller is removed by the caller
+    void evictAndRemoveUnused(Entry& entry_, const RateKeyState& caller_)
+    {
+        RateKeyState& rateKey = entry_.rateKey;
+        evict(entry_);
+        if (&rateKey != &caller_) {
+            removeIfUnused(rateKey);
+        }
+    }
+
+    // the candidate leaves the window, it replaces the least recently used result of the main area only if it was requested more often
+    void admit(Entry& candidate_, const RateKeyState& caller_)
+    {
+        move(candidate_, PROBATION);
+        const std::size_t mainMaxBytes = m_maxBytes - std::min(m_maxBytes, m_windowMaxBytes);
+        while (m_segmentBytes[PROBATION] + m_segmentBytes[PROTECTED] > mainMaxBytes) {
+            Entry* victim = &m_segments[PROBATION].back();
+            if (victim == &candidate_) {
+                if (m_segments[PROTECTED].empty()) {
+                    break;
+                }
+                victim = &m_segments[PROTECTED].back();
+            }
+            if (m_sketch.frequency(candidate_.hash) > m_sketch.frequency(victim->hash)) {
+                evictAndRemoveUnused(*victim, caller_);
+            }
+            else {
+                ++m_statistics.rejections;
+                evictAndRemoveUnused(candidate_, caller_);
+                break;
+            }
+        }
+    }
+
+    const std::size_t m_maxBytes;
+    const EvictionPolicy m_evictionPolicy;
+    const std::size_t m_windowMaxBytes;
+    const std::size_t m_protectedMaxBytes;
+    FrequencySketch m_sketch;
+    RateKeyMap_t m_rateKeys;
+    std::array<OrderList_t, NUMBER_OF_SEGMENTS> m_segments;
+    std::array<std::size_t, NUMBER_OF_SEGMENTS> m_segmentBytes;
+    std::size_t m_bytes;
+    std::size_t m_numberOfResults;
+    Statistics m_statistics;
+};
+
+BoundedFunctionResultCache::BoundedFunctionResultCache(std::size_t maxBytes_, EvictionPolicy evictionPolicy_)
+    : m_store(new Store(maxBytes_, evictionPolicy_))
+{
+}
+
+BoundedFunctionResultCache::~BoundedFunctionResultCache()
+{
+}
+
+void BoundedFunctionResultCache::putFunctionResult(const std::string& insuranceRateKey_, const std::string& cacheKey_, const Value& result_)
+{
+    m_store->put(insuranceRateKey_, cacheKey_, result_);
+}
+
+void BoundedFunctionResultCache::putFunctionResultWithValidityDate(const std::string& insuranceRateKey_, const std::string& cacheKey_, const std::string& validFrom_,
+                                                                   const std::string& validTo_, const Value& result_)
+{
+    m_store->putWithValidity(insuranceRateKey_, cacheKey_, validFrom_, validTo_, result_);
+}
+
+boost::optional<Value> BoundedFunctionResultCache::getFunctionResult(const std::string& insuranceRateKey_, const std::string& cacheKey_) const
+{
+    return m_store->get(insuranceRateKey_, cacheKey_);
+}
+
+boost::optional<Value> BoundedFunctionResultCache::getFunctionResultWithValidityDate(const std::string& insuranceRateKey_, const std::string& date_, const std::string& cacheKey_) const
+{
+    return m_store->getWithValidity(insuranceRateKey_, date_, cacheKey_);
+}
+
+void BoundedFunctionResultCache::putFunctionResultWithExpiry(const std::string& insuranceRateKey_, const std::string& cacheKey_, std::chrono::system_clock::time_point expiry_,
+                                                             const Value& result_)
+{
+    m_store->putWithExpiry(insuranceRateKey_, cacheKey_, expiry_, result_);
+}
+
+boost::optional<Value> BoundedFunctionResultCache::getFunctionResultWithExpiry(const std::string& insuranceRateKey_, std::chrono::system_clock::time_point now_,
+                                                                               const std::string& cacheKey_) const
+{
+    return m_store->getWithExpiry(insuranceRateKey_, now_, cacheKey_);
+}
+
+void BoundedFunctionResultCache::setQuota(const std::string& insuranceRateKey_, std::size_t maxBytes_)
+{
+    m_store->setQuota(insuranceRateKey_, maxBytes_);
+}
+
+std::size_t BoundedFunctionResultCache::getBytes() const
+{
+    return m_store->getBytes();
+}
+
+std::size_t BoundedFunctionResultCache::getBytes(const std::string& insuranceRateKey_) const
+{
+    return m_store->getBytes(insuranceRateKey_);
+}
+
+std::size_t BoundedFunctionResultCache::getNumberOfResults() const
+{
+    return m_store->getNumberOfResults();
+}
+
+BoundedFunctionResultCache::Statistics BoundedFunctionResultCache::getStatistics() const
+{
+    return m_store->getStatistics();
+}
+
+} // namespace CalculusPrime
@@ -0,0 +1,179 @@
+/*
+Copyright 2019 Association for the promotion of open - source insurance software and for the establishment of open interface standards in the insurance industry
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http ://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <calculusprime/cache/ConcurrentFunctionResultCache.h>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <calculusprime/cache/DefaultFunctionResultCache.h>
+
+namespace CalculusPrime {
+
+namespace {
+std::size_t roundUpToPowerOfTwo(std::size_t value_)
+{
+    std::size_t result = 1;
+    while (result < value_) {
+        result <<= 1;
+    }
+    return result;
+}
+}
+
+//! \brief the results of one shard, two copies with left-right concurrency control
+class ConcurrentFunctionResultCache::Shard
+{
+public:
+    Shard()
+        : m_readIndex(0)
+        , m_readerIndicator(0)
+    {
+        m_readers[0].count = 0;
+        m_readers[1].count = 0;
+    }
+
+    //! \brief call read_ with the copy which is currently read, it must not modify the copy
+    template <typename Read>
+    boost::optional<Value> read(const Read& read_) const
+    {
+        const unsigned indicator = m_readerIndicator.load();
+        ReaderGuard guard(m_readers[indicator].count);
+        return read_(m_copies[m_readIndex.load()]);
+    }
+
+    //! \brief call write_ with both copies, one after another
+    template <typename Write>
+    void write(const Write& write_)
+    {
+        std::lock_guard<std::mutex> lock(m_writeMutex);
+        const unsigned index = m_readIndex.load();
+        write_(m_copies[1 - index]);
+        m_readIndex.store(1 - index);
+
+        // new readers announce themselves in the other counter, so the readers of m_copies[index] finish
+        const unsigned indicator = m_readerIndicator.load();
+        waitForReaders(1 - indicator);
+        m_readerIndicator.store(1 - indicator);
+        waitForReaders(indicator);
+
+        write_(m_copies[index]);
+    }
+
+private:
+    //! \brief a reader counter on its own cache line, so the counters of neighboring shards do not share it
+    struct ReaderCounter
+    {
+        std::atomic<std::size_t> count;
+        char padding[64 - sizeof(std::atomic<std::size_t>)];
+    };
+
+    class ReaderGuard
+    {
+    public:
+        explicit ReaderGuard(std::atomic<std::size_t>& count_)
+            : m_count(count_)
+        {
+            ++m_count;
+        }
+
+        ~ReaderGuard()
+        {
+            --m_count;
+        }
+
+    private:
+        std::atomic<std::size_t>& m_count;
+    };
+
+    void waitForReaders(unsigned indicator_) const
+    {
+        while (m_readers[indicator_].count.load() != 0) {
+            std::this_thread::yield();
+        }
+    }
+
+    mutable ReaderCounter m_readers[2];
+    //! \brief the index of the copy the readers read
+    std::atomic<unsigned> m_readIndex;
+    //! \brief the index of the counter the readers announce themselves in
+    std::atomic<unsigned> m_readerIndicator;
+    DefaultFunctionResultCache m_copies[2];
+    std::mutex m_writeMutex;
+};
+
+const std::size_t ConcurrentFunctionResultCache::DEFAULT_NUMBER_OF_SHARDS;
+
+ConcurrentFunctionResultCache::ConcurrentFunctionResultCache(std::size_t numberOfShards_)
+    : m_shardMask(roundUpToPowerOfTwo(numberOfShards_) - 1)
+    , m_shards(new Shard[m_shardMask + 1])
+{
+}
+
+ConcurrentFunctionResultCache::~ConcurrentFunctionResultCache()
+{
+}
+
+void ConcurrentFunctionResultCache::putFunctionResult(const std::string& insuranceRateKey_, const std::string& cacheKey_, const Value& result_)
+{
+    getShard(cacheKey_).write([&](DefaultFunctionResultCache& copy_) {
+        copy_.putFunctionResult(insuranceRateKey_, cacheKey_, result_);
+    });
+}
+
+void ConcurrentFunctionResultCache::putFunctionResultWithValidityDate(const std::string& insuranceRateKey_, const std::string& cacheKey_, const std::string& validFrom_,
+                                                                      const std::string& validTo_, const Value& result_)
+{
+    getShard(cacheKey_).write([&](DefaultFunctionResultCache& copy_) {
+        copy_.putFunctionResultWithValidityDate(insuranceRateKey_, cacheKey_, validFrom_, validTo_, result_);
+    });
+}
+
+boost::optional<Value> ConcurrentFunctionResultCache::getFunctionResult(const std::string& insuranceRateKey_, const std::string& cacheKey_) const
+{
+    return getShard(cacheKey_).read([&](const DefaultFunctionResultCache& copy_) {
+        return copy_.getFunctionResult(insuranceRateKey_, cacheKey_);
+    });
+}
+
+boost::optional<Value> ConcurrentFunctionResultCache::getFunctionResultWithValidityDate(const std::string& insuranceRateKey_, const std::string& date_, const std::string& cacheKey_) const
+{
+    return getShard(cacheKey_).read([&](const DefaultFunctionResultCache& copy_) {
+        return copy_.getFunctionResultWithValidityDate(insuranceRateKey_, date_, cacheKey_);
+    });
+}
+
+void ConcurrentFunctionResultCache::putFunctionResultWithExpiry(const std::string& insuranceRateKey_, const std::string& cacheKey_, std::chrono::system_clock::time_point expiry_,
+                                                                const Value& result_)
+{
+    getShard(cacheKey_).write([&](DefaultFunctionResultCache& copy_) {
+        copy_.putFunctionResultWithExpiry(insuranceRateKey_, cacheKey_, expiry_, result_);
+    });
+}
+
+boost::optional<Value> ConcurrentFunctionResultCache::getFunctionResultWithExpiry(const std::string& insuranceRateKey_, std::chrono::system_clock::time_point now_,
+                                                                                  const std::string& cacheKey_) const
+{
+    return getShard(cacheKey_).read([&](const DefaultFunctionResultCache& copy_) {
+        return copy_.getFunctionResultWithExpiry(insuranceRateKey_, now_, cacheKey_);
+    });
+}
+
+ConcurrentFunctionResultCache::Shard& ConcurrentFunctionResultCache::getShard(const std::string& cacheKey_) const
+{
+    return m_shards[std::hash<std::string>()(cacheKey_) & m_shardMask];
+}
+
+} // namespace CalculusPrime
@@ -14,36 +14,157 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include <calculusprime/cache/DefaultCacheFactory.h>
-#include <calculusprime/cache/DefaultFunctionResultCache.h>
+#include <array>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <calculusprime/cache/ConcurrentFunctionResultCache.h>
 #include <calculusprime/cache/DefaultParseTreeCache.h>
 
 namespace CalculusPrime {
 
-DefaultCacheFactory::FunctionResultCaches_t DefaultCacheFactory::m_functionResultCaches;
-DefaultCacheFactory::ParseTreeCaches_t DefaultCacheFactory::m_parseTreeCaches;
+//! \brief the caches of all insurance rate keys, distributed over shards by the hash of the insurance rate key
+class DefaultCacheFactory::Registry
+{
+public:
+    //! \brief the caches of an insurance rate key, each created on the first request
+    struct Caches
+    {
+        std::shared_ptr<ConcurrentFunctionResultCache> functionResultCache;
+        std::shared_ptr<DefaultParseTreeCache> parseTreeCache;
+        std::chrono::steady_clock::time_point lastUsed;
+
+        //! \brief returns true if nobody but the registry references the caches
+        bool isUnused() const
+        {
+            return (!functionResultCache || functionResultCache.use_count() == 1) && (!parseTreeCache || parseTreeCache.use_count() == 1);
+        }
+    };
+
+    typedef std::unordered_map<std::string, Caches> CacheMap_t;
+
+    struct Shard
+    {
+        std::mutex mutex;
+        CacheMap_t caches;
+    };
+
+    static const std::size_t NUMBER_OF_SHARDS = 16;
+
+    Shard& getShard(const std::string& insuranceRateKey_)
+    {
+        return m_shards[std::hash<std::string>()(insuranceRateKey_) % NUMBER_OF_SHARDS];
+    }
+
+    std::array<Shard, NUMBER_OF_SHARDS>& getShards()
+    {
+        return m_shards;
+    }
+
+private:
+    std::array<Shard, NUMBER_OF_SHARDS> m_shards;
+};
+
+DefaultCacheFactory::Registry& DefaultCacheFactory::getRegistry()
+{
+    static Registry registry;
+    return registry;
+}
 
 std::shared_ptr<IFunctionResultCache> DefaultCacheFactory::getFunctionResultCache(const std::string& insuranceRateKey_)
 {
-    FunctionResultCaches_t::const_iterator it = m_functionResultCaches.find(insuranceRateKey_);
-    if (it == m_functionResultCaches.end()) {
-        it = m_functionResultCaches.emplace(insuranceRateKey_, std::make_shared<DefaultFunctionResultCache>()).first;
+    Registry::Shard& shard = getRegistry().getShard(insuranceRateKey_);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    Registry::Caches& caches = shard.caches[insuranceRateKey_];
+    if (!caches.functionResultCache) {
+        caches.functionResultCache = std::make_shared<ConcurrentFunctionResultCache>();
     }
-    return it->second;
+    caches.lastUsed = std::chrono::steady_clock::now();
+    return caches.functionResultCache;
 }
 
 std::shared_ptr<IParseTreeCache> DefaultCacheFactory::getParseTreeCache(const std::string& insuranceRateKey_)
 {
-    ParseTreeCaches_t::const_iterator it = m_parseTreeCaches.find(insuranceRateKey_);
-    if (it == m_parseTreeCaches.end()) {
-        it = m_parseTreeCaches.emplace(insuranceRateKey_, std::make_shared<DefaultParseTreeCache>()).first;
+    Registry::Shard& shard = getRegistry().getShard(insuranceRateKey_);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    Registry::Caches& caches = shard.caches[insuranceRateKey_];
+    if (!caches.parseTreeCache) {
+        caches.parseTreeCache = std::make_shared<DefaultParseTreeCache>();
+    }
+    caches.lastUsed = std::chrono::steady_clock::now();
+    return caches.parseTreeCache;
+}
+
+bool DefaultCacheFactory::evict(const std::string& insuranceRateKey_)
+{
+    Registry::Shard& shard = getRegistry().getShard(insuranceRateKey_);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    Registry::CacheMap_t::iterator it = shard.caches.find(insuranceRateKey_);
+    if (it == shard.caches.end() || !it->second.isUnused()) {
+        return false;
+    }
+    shard.caches.erase(it);
+    return true;
+}
+
+void DefaultCacheFactory::invalidate(const std::string& insuranceRateKey_)
+{
+    Registry::Shard& shard = getRegistry().getShard(insuranceRateKey_);
+    Registry::Caches removed;
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        Registry::CacheMap_t::iterator it = shard.caches.find(insuranceRateKey_);
+        if (it == shard.caches.end()) {
+            return;
+        }
+        removed = std::move(it->second);
+        shard.caches.erase(it);
     }
-    return it->second;
+    // the last reference destroys the caches outside of the lock
+}
+
+std::size_t DefaultCacheFactory::expire(std::chrono::steady_clock::duration maxIdleTime_)
+{
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    std::size_t expired = 0;
+    // one shard after another, so the other shards can be used meanwhile
+    for (Registry::Shard& shard : getRegistry().getShards()) {
+        std::vector<Registry::Caches> removed;
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (Registry::CacheMap_t::iterator it = shard.caches.begin(); it != shard.caches.end();) {
+            if (now - it->second.lastUsed >= maxIdleTime_ && it->second.isUnused()) {
+                removed.push_back(std::move(it->second));
+                it = shard.caches.erase(it);
+                ++expired;
+            }
+            else {
+                ++it;
+            }
+        }
+    }
+    return expired;
+}
+
+std::size_t DefaultCacheFactory::getNumberOfInsuranceRateKeys()
+{
+    std::size_t result = 0;
+    for (Registry::Shard& shard : getRegistry().getShards()) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        result += shard.caches.size();
+    }
+    return result;
 }
 
 void DefaultCacheFactory::clear()
 {
-    m_functionResultCaches.clear();
-    m_parseTreeCaches.clear();
+    for (Registry::Shard& shard : getRegistry().getShards()) {
+        Registry::CacheMap_t removed;
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            removed.swap(shard.caches);
+        }
+    }
 }
 
 } // namespace CalculusPrime
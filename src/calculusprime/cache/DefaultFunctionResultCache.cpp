@@ -29,11 +29,7 @@ void DefaultFunctionResultCache::putFunctionResult(const std::string& insuranceR
 void DefaultFunctionResultCache::putFunctionResultWithValidityDate(const std::string& insuranceRateKey_, const std::string& cacheKey_, const std::string& validFrom_,
                                                                    const std::string& validTo_, const Value& result_)
 {
-    FunctionResultWithValidityMap_t::iterator it = m_functionsResultsWithValidity.find(cacheKey_);
-    if (it == m_functionsResultsWithValidity.end()) {
-        it = m_functionsResultsWithValidity.emplace(cacheKey_, std::set<ValueWithValidity_t>()).first;
-    }
-    it->second.emplace(result_, validFrom_, validTo_);
+    m_functionsResultsWithValidity[cacheKey_].insert(validFrom_, validTo_, result_);
 }
 
 boost::optional<Value> DefaultFunctionResultCache::getFunctionResult(const std::string& insuranceRateKey_, const std::string& cacheKey_) const
@@ -48,16 +44,29 @@ boost::optional<Value> DefaultFunctionResultCache::getFunctionResult(const std::
 
 boost::optional<Value> DefaultFunctionResultCache::getFunctionResultWithValidityDate(const std::string& insuranceRateKey_, const std::string& date_, const std::string& cacheKey_) const
 {
-    boost::optional<Value> result;
     FunctionResultWithValidityMap_t::const_iterator it = m_functionsResultsWithValidity.find(cacheKey_);
-    if (it != m_functionsResultsWithValidity.end()) {
-        for (const ValueWithValidity_t& valueWithValidity : it->second) {
-            if (isValidFor(valueWithValidity, date_)) {
-                return std::get<0>(valueWithValidity);
-            }
-        }
+    if (it == m_functionsResultsWithValidity.end()) {
+        return boost::none;
     }
-    return std::move(result);
+    return it->second.find(date_);
+}
+
+void DefaultFunctionResultCache::putFunctionResultWithExpiry(const std::string& insuranceRateKey_, const std::string& cacheKey_, std::chrono::system_clock::time_point expiry_,
+                                                             const Value& result_)
+{
+    ExpiringResult& entry = m_functionResultsWithExpiry[cacheKey_];
+    entry.result = result_;
+    entry.expiry = expiry_;
+}
+
+boost::optional<Value> DefaultFunctionResultCache::getFunctionResultWithExpiry(const std::string& insuranceRateKey_, std::chrono::system_clock::time_point now_,
+                                                                               const std::string& cacheKey_) const
+{
+    FunctionResultWithExpiryMap_t::const_iterator it = m_functionResultsWithExpiry.find(cacheKey_);
+    if (it == m_functionResultsWithExpiry.end() || it->second.expiry <= now_) {
+        return boost::none;
+    }
+    return it->second.result;
 }
 
 } // namespace CalculusPrime
@@ -0,0 +1,100 @@
+/*
+Copyright 2019 Association for the promotion of open - source insurance software and for the establishment of open interface standards in the insurance industry
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http ://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <calculusprime/cache/TwoLevelFunctionResultCache.h>
+#include <calculusprime/internal/ThreadLocalCache.h>
+
+namespace CalculusPrime {
+
+namespace {
+// the date of the results without validity dates in the L1
+const std::string NO_DATE;
+}
+
+TwoLevelFunctionResultCache::TwoLevelFunctionResultCache(const std::shared_ptr<IFunctionResultCache>& sharedCache_, std::size_t numberOfLocalResults_)
+    : m_sharedCache(sharedCache_)
+    , m_localCache(new ThreadLocalCache<Value>(numberOfLocalResults_))
+{
+}
+
+TwoLevelFunctionResultCache::~TwoLevelFunctionResultCache()
+{
+}
+
+void TwoLevelFunctionResultCache::putFunctionResult(const std::string& insuranceRateKey_, const std::string& cacheKey_, const Value& result_)
+{
+    const std::uint64_t generation = m_localCache->getGeneration();
+    m_sharedCache->putFunctionResult(insuranceRateKey_, cacheKey_, result_);
+    m_localCache->put(insuranceRateKey_, cacheKey_, NO_DATE, result_, generation);
+}
+
+void TwoLevelFunctionResultCache::putFunctionResultWithValidityDate(const std::string& insuranceRateKey_, const std::string& cacheKey_, const std::string& validFrom_,
+                                                                    const std::string& validTo_, const Value& result_)
+{
+    // the L1 caches results by date, they are cached when they are read
+    m_sharedCache->putFunctionResultWithValidityDate(insuranceRateKey_, cacheKey_, validFrom_, validTo_, result_);
+}
+
+boost::optional<Value> TwoLevelFunctionResultCache::getFunctionResult(const std::string& insuranceRateKey_, const std::string& cacheKey_) const
+{
+    std::uint64_t generation;
+    const Value* localResult = m_localCache->find(insuranceRateKey_, cacheKey_, NO_DATE, generation);
+    if (localResult != nullptr) {
+        return *localResult;
+    }
+    boost::optional<Value> result = m_sharedCache->getFunctionResult(insuranceRateKey_, cacheKey_);
+    if (result) {
+        m_localCache->put(insuranceRateKey_, cacheKey_, NO_DATE, *result, generation);
+    }
+    return result;
+}
+
+boost::optional<Value> TwoLevelFunctionResultCache::getFunctionResultWithValidityDate(const std::string& insuranceRateKey_, const std::string& date_, const std::string& cacheKey_) const
+{
+    // an empty date is not a valid date, it is not confused with the results without validity dates
+    if (date_.empty()) {
+        return m_sharedCache->getFunctionResultWithValidityDate(insuranceRateKey_, date_, cacheKey_);
+    }
+    std::uint64_t generation;
+    const Value* localResult = m_localCache->find(insuranceRateKey_, cacheKey_, date_, generation);
+    if (localResult != nullptr) {
+        return *localResult;
+    }
+    boost::optional<Value> result = m_sharedCache->getFunctionResultWithValidityDate(insuranceRateKey_, date_, cacheKey_);
+    if (result) {
+        m_localCache->put(insuranceRateKey_, cacheKey_, date_, *result, generation);
+    }
+    return result;
+}
+
+void TwoLevelFunctionResultCache::putFunctionResultWithExpiry(const std::string& insuranceRateKey_, const std::string& cacheKey_, std::chrono::system_clock::time_point expiry_,
+                                                              const Value& result_)
+{
+    m_sharedCache->putFunctionResultWithExpiry(insuranceRateKey_, cacheKey_, expiry_, result_);
+}
+
+boost::optional<Value> TwoLevelFunctionResultCache::getFunctionResultWithExpiry(const std::string& insuranceRateKey_, std::chrono::system_clock::time_point now_,
+                                                                                const std::string& cacheKey_) const
+{
+    // the L1 does not know the expiry times, results with an expiry time are only cached by the shared cache
+    return m_sharedCache->getFunctionResultWithExpiry(insuranceRateKey_, now_, cacheKey_);
+}
+
+void TwoLevelFunctionResultCache::invalidate()
+{
+    m_localCache->invalidate();
+}
+
+} // namespace CalculusPrime
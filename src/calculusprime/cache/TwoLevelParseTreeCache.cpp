@@ -0,0 +1,69 @@
+/*
+Copyright 2019 Association for the promotion of open - source insurance software and for the establishment of open interface standards in the insurance industry
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http ://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <calculusprime/cache/TwoLevelParseTreeCache.h>
+#include <calculusprime/internal/ThreadLocalCache.h>
+
+namespace CalculusPrime {
+
+namespace {
+// parse trees have no validity dates
+const std::string NO_DATE;
+}
+
+TwoLevelParseTreeCache::TwoLevelParseTreeCache(const std::shared_ptr<IParseTreeCache>& sharedCache_, std::size_t numberOfLocalParseTrees_)
+    : m_sharedCache(sharedCache_)
+    , m_localCache(new ThreadLocalCache<std::shared_ptr<void>>(numberOfLocalParseTrees_))
+{
+}
+
+TwoLevelParseTreeCache::~TwoLevelParseTreeCache()
+{
+}
+
+void TwoLevelParseTreeCache::putParseTree(const std::string& insuranceRateKey_, const std::string& cacheKey_, const std::shared_ptr<void>& parseTree_)
+{
+    const std::uint64_t generation = m_localCache->getGeneration();
+    {
+        std::lock_guard<std::mutex> lock(m_sharedCacheMutex);
+        m_sharedCache->putParseTree(insuranceRateKey_, cacheKey_, parseTree_);
+    }
+    m_localCache->put(insuranceRateKey_, cacheKey_, NO_DATE, parseTree_, generation);
+}
+
+std::shared_ptr<void> TwoLevelParseTreeCache::getParseTree(const std::string& insuranceRateKey_, const std::string& cacheKey_) const
+{
+    std::uint64_t generation;
+    const std::shared_ptr<void>* localParseTree = m_localCache->find(insuranceRateKey_, cacheKey_, NO_DATE, generation);
+    if (localParseTree != nullptr) {
+        return *localParseTree;
+    }
+    std::shared_ptr<void> parseTree;
+    {
+        std::lock_guard<std::mutex> lock(m_sharedCacheMutex);
+        parseTree = m_sharedCache->getParseTree(insuranceRateKey_, cacheKey_);
+    }
+    if (parseTree) {
+        m_localCache->put(insuranceRateKey_, cacheKey_, NO_DATE, parseTree, generation);
+    }
+    return parseTree;
+}
+
+void TwoLevelParseTreeCache::invalidate()
+{
+    m_localCache->invalidate();
+}
+
+} // namespace CalculusPrime
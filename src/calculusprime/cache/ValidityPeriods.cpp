@@ -0,0 +1,183 @@
+/*
+Copyright 2019 Association for the promotion of open - source insurance software and for the establishment of open interface standards in the insurance industry
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http ://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <calculusprime/cache/ValidityPeriods.h>
+#include <algorithm>
+#include <cstdio>
+
+namespace CalculusPrime {
+
+namespace {
+// the number of days since 1970-01-01 of a date of the proleptic gregorian calendar
+std::int32_t daysFromCivil(int year_, unsigned month_, unsigned day_)
+{
+    const int year = month_ <= 2 ? year_ - 1 : year_;
+    const int era = (year >= 0 ? year : year - 399) / 400;
+    const unsigned yearOfEra = static_cast<unsigned>(year - era * 400);
+    const unsigned dayOfYear = (153 * (month_ > 2 ? month_ - 3 : month_ + 9) + 2) / 5 + day_ - 1;
+    const unsigned dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + static_cast<std::int32_t>(dayOfEra) - 719468;
+}
+
+// the date in ISO format of a number of days since 1970-01-01
+std::string civilFromDays(std::int32_t days_)
+{
+    const std::int32_t days = days_ + 719468;
+    const int era = (days >= 0 ? days : days - 146096) / 146097;
+    const unsigned dayOfEra = static_cast<unsigned>(days - era * 146097);
+    const unsigned yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    const unsigned dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    const unsigned monthIndex = (5 * dayOfYear + 2) / 153;
+    const unsigned day = dayOfYear - (153 * monthIndex + 2) / 5 + 1;
+    const unsigned month = monthIndex < 10 ? monthIndex + 3 : monthIndex - 9;
+    const int year = static_cast<int>(yearOfEra) + era * 400 + (month <= 2 ? 1 : 0);
+
+    char date[11];
+    std::snprintf(date, sizeof(date), "%04d-%02u-%02u", year, month, day);
+    return date;
+}
+
+bool isLeapYear(unsigned year_)
+{
+    return (year_ % 4 == 0 && year_ % 100 != 0) || year_ % 400 == 0;
+}
+
+unsigned daysOfMonth(unsigned year_, unsigned month_)
+{
+    static const unsigned DAYS[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+    return month_ == 2 && isLeapYear(year_) ? 29 : DAYS[month_ - 1];
+}
+
+bool parseDigits(const std::string& str_, std::size_t pos_, std::size_t count_, unsigned& value_)
+{
+    value_ = 0;
+    for (std::size_t i = pos_; i < pos_ + count_; ++i) {
+        if (str_[i] < '0' || str_[i] > '9') {
+            return false;
+        }
+        value_ = value_ * 10 + static_cast<unsigned>(str_[i] - '0');
+    }
+    return true;
+}
+}
+
+ValidityPeriods::ValidityPeriods()
+{
+}
+
+ValidityPeriods::~ValidityPeriods()
+{
+}
+
+boost::optional<Value> ValidityPeriods::insert(std::int32_t validFrom_, std::int32_t validTo_, const Value& result_)
+{
+    std::vector<Period>::iterator it = std::upper_bound(m_periods.begin(), m_periods.end(), validFrom_, [](std::int32_t value_, const Period& period_) {
+        return value_ < period_.validFrom;
+    });
+    for (std::vector<Period>::iterator equal = it; equal != m_periods.begin() && (equal - 1)->validFrom == validFrom_; --equal) {
+        if ((equal - 1)->validTo == validTo_) {
+            boost::optional<Value> replaced((equal - 1)->result);
+            (equal - 1)->result = result_;
+            return replaced;
+        }
+    }
+
+    const std::size_t index = static_cast<std::size_t>(it - m_periods.begin());
+    Period period = { validFrom_, validTo_, result_ };
+    m_periods.insert(it, std::move(period));
+    m_maxValidTo.resize(m_periods.size());
+    for (std::size_t i = index; i < m_periods.size(); ++i) {
+        m_maxValidTo[i] = i == 0 ? m_periods[i].validTo : std::max(m_maxValidTo[i - 1], m_periods[i].validTo);
+    }
+    return boost::none;
+}
+
+boost::optional<Value> ValidityPeriods::insert(const std::string& validFrom_, const std::string& validTo_, const Value& result_)
+{
+    const boost::optional<std::int32_t> validFrom = toDayNumber(validFrom_);
+    const boost::optional<std::int32_t> validTo = toDayNumber(validTo_);
+    if (validFrom && validTo) {
+        return insert(*validFrom, *validTo, result_);
+    }
+
+    for (StringPeriod& period : m_stringPeriods) {
+        if (period.validFrom == validFrom_ && period.validTo == validTo_) {
+            boost::optional<Value> replaced(period.result);
+            period.result = result_;
+            return replaced;
+        }
+    }
+    StringPeriod period = { validFrom_, validTo_, result_ };
+    m_stringPeriods.push_back(std::move(period));
+    return boost::none;
+}
+
+boost::optional<Value> ValidityPeriods::find(std::int32_t day_) const
+{
+    std::size_t end = static_cast<std::size_t>(std::upper_bound(m_periods.begin(), m_periods.end(), day_, [](std::int32_t value_, const Period& period_) {
+        return value_ < period_.validFrom;
+    }) - m_periods.begin());
+    for (; end != 0 && m_maxValidTo[end - 1] >= day_; --end) {
+        if (m_periods[end - 1].validTo >= day_) {
+            return m_periods[end - 1].result;
+        }
+    }
+    return boost::none;
+}
+
+boost::optional<Value> ValidityPeriods::find(const std::string& date_) const
+{
+    const boost::optional<std::int32_t> day = toDayNumber(date_);
+    if (day) {
+        boost::optional<Value> result = find(*day);
+        if (result || m_stringPeriods.empty()) {
+            return result;
+        }
+    }
+
+    // of overlapping periods the one which starts last, of equal starts the one which was added last
+    const std::string* validFrom = nullptr;
+    const Value* result = nullptr;
+    for (const StringPeriod& period : m_stringPeriods) {
+        if (period.validFrom <= date_ && period.validTo >= date_ && (validFrom == nullptr || period.validFrom >= *validFrom)) {
+            validFrom = &period.validFrom;
+            result = &period.result;
+        }
+    }
+    std::string periodFrom;
+    if (!day) {
+        for (const Period& period : m_periods) {
+            std::string from = civilFromDays(period.validFrom);
+            if (from <= date_ && civilFromDays(period.validTo) >= date_ && (validFrom == nullptr || from >= *validFrom)) {
+                periodFrom = std::move(from);
+                validFrom = &periodFrom;
+                result = &period.result;
+            }
+        }
+    }
+    return result != nullptr ? boost::optional<Value>(*result) : boost::none;
+}
+
+boost::optional<std::int32_t> ValidityPeriods::toDayNumber(const std::string& date_)
+{
+    unsigned year, month, day;
+    if (date_.size() != 10 || date_[4] != '-' || date_[7] != '-' || !parseDigits(date_, 0, 4, year) || !parseDigits(date_, 5, 2, month) || !parseDigits(date_, 8, 2, day)
+        || month < 1 || month > 12 || day < 1 || day > daysOfMonth(year, month)) {
+        return boost::none;
+    }
+    return daysFromCivil(static_cast<int>(year), month, day);
+}
+
+} // namespace CalculusPrime
@@ -0,0 +1,49 @@
+/*
+Copyright 2019 Association for the promotion of open - source insurance software and for the establishment of open interface standards in the insurance industry
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http ://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <calculusprime/internal/Arena.h>
+#include <algorithm>
+
+namespace CalculusPrime {
+
+const std::size_t Arena::INITIAL_CHUNK_SIZE;
+const std::size_t Arena::MAX_CHUNK_SIZE;
+
+Arena::~Arena()
+{
+    while (m_chunks != nullptr) {
+        Chunk* const previous = m_chunks->previous;
+        ::operator delete(m_chunks);
+        m_chunks = previous;
+    }
+}
+
+void* Arena::allocateChunk(std::size_t size_, std::size_t alignment_)
+{
+    // the chunk also holds the header and the padding for the alignment, large allocations get a chunk of their own
+    const std::size_t chunkSize = std::max(m_nextChunkSize, sizeof(Chunk) + alignment_ + size_);
+    Chunk* const chunk = static_cast<Chunk*>(::operator new(chunkSize));
+    chunk->previous = m_chunks;
+    m_chunks = chunk;
+    m_nextChunkSize = std::min(2 * m_nextChunkSize, MAX_CHUNK_SIZE);
+
+    char* const memory = reinterpret_cast<char*>(chunk) + sizeof(Chunk);
+    char* const result = align(memory, alignment_);
+    m_next = result + size_;
+    m_end = memory + (chunkSize - sizeof(Chunk));
+    return result;
+}
+
+} // namespace CalculusPrime
@@ -0,0 +1,151 @@
+/*
+Copyright 2019 Association for the promotion of open - source insurance software and for the establishment of open interface standards in the insurance industry
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http ://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <calculusprime/internal/FunctionResultCaching.h>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <boost/throw_exception.hpp>
+#include <calculusprime/IFunction.h>
+#include <calculusprime/cache/IFunctionResultCache.h>
+#include <calculusprime/internal/ParsingContext.h>
+#include <calculusprime/internal/parsing/FunctionMemo.h>
+
+namespace CalculusPrime {
+
+namespace {
+template <typename T>
+void appendBytes(std::string& key_, const T& value_)
+{
+    char bytes[sizeof(T)];
+    std::memcpy(bytes, &value_, sizeof(T));
+    key_.append(bytes, sizeof(T));
+}
+
+// the binary representation of the value, preceded by its type
+void appendValue(std::string& bytes_, const Value& value_)
+{
+    if (value_.isVoid()) {
+        bytes_.push_back('v');
+    }
+    else if (value_.isDouble()) {
+        // 0.0 and -0.0 are the same value
+        const double number = value_.asDouble();
+        bytes_.push_back('d');
+        appendBytes(bytes_, number == 0.0 ? 0.0 : number);
+    }
+    else if (value_.isBool()) {
+        bytes_.push_back(value_.asBool() ? 't' : 'f');
+    }
+    else {
+        const boost::string_view str = value_.asStringView();
+        bytes_.push_back('s');
+        appendBytes(bytes_, static_cast<std::uint32_t>(str.size()));
+        bytes_.append(str.data(), str.size());
+    }
+}
+
+std::string getValidityDate(const FunctionCachingPolicy& cachingPolicy_, const std::shared_ptr<ParsingContext>& parsingContext_)
+{
+    const Value date = parsingContext_->resolve(cachingPolicy_.getValidityDateVariable());
+    if (date.isVoid() || !date.isString()) {
+        BOOST_THROW_EXCEPTION(std::runtime_error("validity date " + cachingPolicy_.getValidityDateVariable() + " is not a date"));
+    }
+    return date.asString();
+}
+}
+
+Value FunctionResultCaching::execute(IFunction& function_, const std::string& functionId_, const std::vector<Value>& arguments_, const std::shared_ptr<ParsingContext>& parsingContext_)
+{
+    const FunctionCachingPolicy& cachingPolicy = function_.getCachingPolicy();
+    switch (cachingPolicy.getScope()) {
+    case FunctionCachingPolicy::Scope::CALCULATION: {
+        // the validity date is memoized like an additional argument
+        FunctionMemo& memo = parsingContext_->getFunctionMemo();
+        std::vector<Value> memoArguments;
+        const std::vector<Value>* key = &arguments_;
+        if (!cachingPolicy.getValidityDateVariable().empty()) {
+            memoArguments.reserve(arguments_.size() + 1);
+            memoArguments.assign(arguments_.begin(), arguments_.end());
+            memoArguments.emplace_back(getValidityDate(cachingPolicy, parsingContext_));
+            key = &memoArguments;
+        }
+        if (const Value* result = memo.find(&function_, *key)) {
+            return *result;
+        }
+        Value result = function_.execute(arguments_, parsingContext_);
+        memo.insert(&function_, *key, result);
+        return result;
+    }
+
+    case FunctionCachingPolicy::Scope::TARIFF: {
+        const std::shared_ptr<IFunctionResultCache> cache = parsingContext_->getFunctionResultCache();
+        if (!cache) {
+            break;
+        }
+        const std::string& insuranceRateKey = parsingContext_->getInsuranceRateKey();
+        const bool hasValidityDate = !cachingPolicy.getValidityDateVariable().empty();
+        const std::string date = hasValidityDate ? getValidityDate(cachingPolicy, parsingContext_) : std::string();
+
+        // a result with a time to live is cached with its expiry time, the validity date is part of its key like an additional argument
+        const std::chrono::seconds timeToLive = cachingPolicy.getTimeToLive();
+        if (timeToLive.count() > 0) {
+            std::string key = createKey(functionId_, arguments_);
+            if (hasValidityDate) {
+                appendValue(key, Value(date));
+            }
+            const std::chrono::system_clock::time_point now = std::chrono::system_clock::now();
+            if (boost::optional<Value> cached = cache->getFunctionResultWithExpiry(insuranceRateKey, now, key)) {
+                return *cached;
+            }
+            const Value result = function_.execute(arguments_, parsingContext_);
+            cache->putFunctionResultWithExpiry(insuranceRateKey, key, now + timeToLive, result);
+            return result;
+        }
+
+        const std::string key = createKey(functionId_, arguments_);
+        const boost::optional<Value> cached = hasValidityDate ? cache->getFunctionResultWithValidityDate(insuranceRateKey, date, key) : cache->getFunctionResult(insuranceRateKey, key);
+        if (cached) {
+            return *cached;
+        }
+        const Value result = function_.execute(arguments_, parsingContext_);
+        if (hasValidityDate) {
+            cache->putFunctionResultWithValidityDate(insuranceRateKey, key, date, date, result);
+        }
+        else {
+            cache->putFunctionResult(insuranceRateKey, key, result);
+        }
+        return result;
+    }
+
+    default:
+        break;
+    }
+    return function_.execute(arguments_, parsingContext_);
+}
+
+std::string FunctionResultCaching::createKey(const std::string& functionId_, const std::vector<Value>& arguments_)
+{
+    std::string key;
+    key.reserve(functionId_.size() + 1 + arguments_.size() * (1 + sizeof(double)));
+    key.append(functionId_);
+    key.push_back('\0');
+    for (const Value& argument : arguments_) {
+        appendValue(key, argument);
+    }
+    return key;
+}
+
+} // namespace CalculusPrime
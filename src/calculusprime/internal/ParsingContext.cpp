@@ -19,7 +19,8 @@ limitations under the License.
 #include <calculusprime/IFunction.h>
 #include <calculusprime/RatingEngineException.h>
 #include <calculusprime/FunctionIdBuilder.h>
-#include <calculusprime/internal/parsing/ValueHolder.h>
+#include <calculusprime/internal/parsing/IValueHolder.h>
+#include <calculusprime/internal/require.h>
 
 namespace bal = boost::algorithm;
 
@@ -30,36 +31,38 @@ ParsingContext::~ParsingContext()
 {
 }
 
-ParsingContext::ParsingContext(const std::shared_ptr<ParsingContext>& parent_)
+ParsingContext::ParsingContext(const std::shared_ptr<ParsingContext>& parent_, bool shareArgumentStack_)
     : m_parent(parent_)
-    , m_functionResultCache(parent_->getFunctionResultCache())
-    , m_parseTreeCache(parent_->getParseTreeCache())
-    , m_insuranceRateKey(parent_->getInsuranceRateKey())
-    , m_functions(parent_->getFunctions())
-    , m_instanceId(parent_->getInstanceId())
-    , m_logger(parent_->getLogger())
+    , m_root(parent_->m_root)
+    , m_outer(parent_->m_bindsVariables ? parent_.get() : parent_->m_outer)
+    , m_arena(shareArgumentStack_ ? parent_->m_arena : nullptr)
+    , m_bindsVariables(false)
+    , m_instanceScope(parent_->m_instanceScope)
+    , m_instanceOrdinal(parent_->m_instanceOrdinal)
+    , m_variables(ValueHolderMap_t::allocator_type(m_arena))
     , m_functionDurationsMicroSecs(0)
+    , m_evaluationBackend(EvaluationBackend::TREE)
+    , m_shortCircuitEvaluation(false)
+    , m_ownArgumentStack(shareArgumentStack_ ? nullptr : new ArgumentStack())
+    , m_argumentStack(shareArgumentStack_ ? parent_->m_argumentStack : m_ownArgumentStack.get())
+    , m_ownFunctionMemo(shareArgumentStack_ ? nullptr : new FunctionMemo())
+    , m_functionMemo(shareArgumentStack_ ? parent_->m_functionMemo : m_ownFunctionMemo.get())
 {
-    for (const ValueHolderMap_t::value_type& variable : parent_->m_variables) {
-        if (!variable.second->isFunctionArgument()) {
-            m_variables[variable.first] = variable.second;
-        }
-    }
 }
 
 std::shared_ptr<IFunctionResultCache> ParsingContext::getFunctionResultCache() const
 {
-    return m_functionResultCache;
+    return m_root->m_functionResultCache;
 }
 
 std::shared_ptr<IParseTreeCache> ParsingContext::getParseTreeCache() const
 {
-    return m_parseTreeCache;
+    return m_root->m_parseTreeCache;
 }
 
 const std::string& ParsingContext::getInsuranceRateKey() const
 {
-    return m_insuranceRateKey;
+    return m_root->m_insuranceRateKey;
 }
 
 const std::string& ParsingContext::getCurrentRatingoutputVariable() const
@@ -69,50 +72,124 @@ const std::string& ParsingContext::getCurrentRatingoutputVariable() const
 
 const std::string& ParsingContext::getInstanceId() const
 {
-    return m_instanceId;
+    return m_instanceScope->m_instanceId;
 }
 
 void ParsingContext::addFunction(const std::shared_ptr<IFunction>& function_)
 {
-    m_functions[FunctionIdBuilder::createId(function_->getName(), function_->getNumberOfArgs())] = function_;
+    CP_REQUIRE(!m_parent);
+    if (m_functions.use_count() != 1) {
+        // the function map is shared, it must not be changed
+        m_functions = std::make_shared<FunctionMap_t>(*m_functions);
+    }
+    addFunction(*m_functions, function_);
 }
 
-void ParsingContext::assignParam(const std::string& variableName_, const std::shared_ptr<IValueHolder>& valueHolder_)
+void ParsingContext::addFunction(FunctionMap_t& functions_, const std::shared_ptr<IFunction>& function_)
 {
-    // convert var to lower case to support non-case-sensitive lookup
-    m_variables[bal::to_lower_copy(variableName_)] = valueHolder_;
+    functions_[FunctionIdBuilder::createId(function_->getName(), function_->getNumberOfArgs())] = function_;
 }
 
-void ParsingContext::addCalculatedVariable(const std::string& variableName_, const Value& value_)
+void ParsingContext::assignParam(const std::string& variableName_, const std::shared_ptr<IValueHolder>& valueHolder_)
 {
-    const std::string varName(bal::to_lower_copy(variableName_));
-    CalculatedVariableMap_t::iterator it = m_calculatedVariables.find(varName);
-    if (it == m_calculatedVariables.end()) {
-        std::shared_ptr<ValueMap_t> valueMap(std::make_shared<ValueMap_t>());
-        (*valueMap)[getInstanceId()] = value_;
-        m_calculatedVariables[varName] = valueMap;
-        m_variables[varName] = std::make_shared<ValueHolder>(valueMap);
+    const std::shared_ptr<const SymbolTable>& symbolTable = getSymbolTable();
+    const std::uint32_t slot = symbolTable ? symbolTable->findSymbol(variableName_) : SymbolTable::NO_SLOT;
+    if (slot != SymbolTable::NO_SLOT) {
+        assignParam(slot, valueHolder_);
     }
     else {
-        (*(it->second))[getInstanceId()] = value_;
+        // convert var to lower case to support non-case-sensitive lookup
+        m_variables[bal::to_lower_copy(variableName_)] = valueHolder_;
+        m_bindsVariables = m_bindsVariables || !valueHolder_->isFunctionArgument();
+    }
+}
+
+void ParsingContext::assignParam(std::uint32_t slot_, const std::shared_ptr<IValueHolder>& valueHolder_)
+{
+    if (!m_parent) {
+        m_slots[slot_] = valueHolder_;
+        return;
     }
+
+    m_bindsVariables = m_bindsVariables || !valueHolder_->isFunctionArgument();
+    for (SlotBinding_t& binding : m_slotBindings) {
+        if (binding.first == slot_) {
+            binding.second = valueHolder_;
+            return;
+        }
+    }
+    m_slotBindings.emplace_back(slot_, valueHolder_);
 }
 
 Value ParsingContext::resolve(const std::string& variable_)
 {
-    // convert var to lower case to support non-case-sensitive lookup
-    ValueHolderMap_t::const_iterator it = m_variables.find(bal::to_lower_copy(variable_));
-    if (it != m_variables.end()) {
-        // The variable resides in this parsingContext
-        boost::optional<Value> value = it->second->getValue(shared_from_this());
-        if (!value) {
-            BOOST_THROW_EXCEPTION(std::runtime_error("Could not find a value for variable " + variable_ + " with instance-id='" + getInstanceId() + "'"));
+    const std::shared_ptr<const SymbolTable>& symbolTable = getSymbolTable();
+    const std::uint32_t slot = symbolTable ? symbolTable->findSymbol(variable_) : SymbolTable::NO_SLOT;
+    if (slot != SymbolTable::NO_SLOT) {
+        return resolve(slot, variable_);
+    }
+
+    // convert var to lower case to support non-case-sensitive lookup, the function arguments of the enclosing scopes are not visible
+    const std::string lowerCaseName(bal::to_lower_copy(variable_));
+    const std::shared_ptr<IValueHolder>* valueHolder = findVariable(lowerCaseName);
+    for (const ParsingContext* scope = m_outer; valueHolder == nullptr && scope != nullptr; scope = scope->m_outer) {
+        valueHolder = scope->findVariable(lowerCaseName);
+        if (valueHolder != nullptr && (*valueHolder)->isFunctionArgument()) {
+            valueHolder = nullptr;
         }
-        return *value;
     }
-    else {
+    if (valueHolder == nullptr) {
         BOOST_THROW_EXCEPTION(RatingEngineException(RatingEngineError::INPUT_PARAMETER_MISSING, "Parameter " + variable_ + " not defined"));
     }
+    // the value holder is copied, a lazy value holder may replace itself in its scope
+    const std::shared_ptr<IValueHolder> holder = *valueHolder;
+    return getValue(*holder, variable_);
+}
+
+Value ParsingContext::resolve(std::uint32_t slot_, const std::string& variable_)
+{
+    // the function arguments of the enclosing scopes are not visible
+    const std::shared_ptr<IValueHolder>* valueHolder = findSlot(slot_);
+    for (const ParsingContext* scope = m_outer; valueHolder == nullptr && scope != nullptr; scope = scope->m_outer) {
+        valueHolder = scope->findSlot(slot_);
+        if (valueHolder != nullptr && (*valueHolder)->isFunctionArgument()) {
+            valueHolder = nullptr;
+        }
+    }
+    if (valueHolder == nullptr) {
+        BOOST_THROW_EXCEPTION(RatingEngineException(RatingEngineError::INPUT_PARAMETER_MISSING, "Parameter " + variable_ + " not defined"));
+    }
+    // the value holder is copied, a lazy value holder may replace itself in the slot
+    const std::shared_ptr<IValueHolder> holder = *valueHolder;
+    return getValue(*holder, variable_);
+}
+
+const std::shared_ptr<IValueHolder>* ParsingContext::findSlot(std::uint32_t slot_) const
+{
+    if (!m_parent) {
+        return m_slots[slot_] ? &m_slots[slot_] : nullptr;
+    }
+    for (const SlotBinding_t& binding : m_slotBindings) {
+        if (binding.first == slot_) {
+            return &binding.second;
+        }
+    }
+    return nullptr;
+}
+
+const std::shared_ptr<IValueHolder>* ParsingContext::findVariable(const std::string& lowerCaseName_) const
+{
+    ValueHolderMap_t::const_iterator it = m_variables.find(lowerCaseName_);
+    return it != m_variables.end() ? &it->second : nullptr;
+}
+
+Value ParsingContext::getValue(IValueHolder& valueHolder_, const std::string& variable_)
+{
+    boost::optional<Value> value = valueHolder_.getValue(shared_from_this());
+    if (!value) {
+        BOOST_THROW_EXCEPTION(std::runtime_error("Could not find a value for variable " + variable_ + " with instance-id='" + getInstanceId() + "'"));
+    }
+    return *value;
 }
 
 } // namespace CalculusPrime
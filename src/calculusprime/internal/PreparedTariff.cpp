@@ -0,0 +1,865 @@
+/*
+Copyright 2019 Association for the promotion of open - source insurance software and for the establishment of open interface standards in the insurance industry
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http ://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <calculusprime/internal/PreparedTariff.h>
+#include <algorithm>
+#include <chrono>
+#include <unordered_set>
+#include <boost/algorithm/string/case_conv.hpp>
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/algorithm/string/trim.hpp>
+#include <boost/throw_exception.hpp>
+#include <boost/variant/static_visitor.hpp>
+#include <calculusprime/internal/Arena.h>
+#include <calculusprime/internal/compiler/ColumnarEvaluator.h>
+#include <calculusprime/internal/compiler/ShortCircuitAnalysis.h>
+#include <calculusprime/internal/parsing/CalculatedVariables.h>
+#include <calculusprime/internal/parsing/Function.h>
+#include <calculusprime/internal/parsing/Parser.h>
+#include <calculusprime/internal/parsing/ValueHolder.h>
+#include <calculusprime/internal/parsing/LazyValueHolder.h>
+#include <calculusprime/internal/ThreadPool.h>
+#include <calculusprime/internal/require.h>
+
+namespace bal = boost::algorithm;
+
+namespace CalculusPrime {
+
+namespace {
+
+Value getValueFromVariant(const IRatingEngine::Variant_t& variant_)
+{
+    const double* d = boost::get<double>(&variant_);
+    if (d != nullptr) {
+        return Value(*d);
+    }
+    else {
+        const std::string* s = boost::get<std::string>(&variant_);
+        CP_REQUIRE(s != nullptr);
+        return Value(*s);
+    }
+}
+
+void fillVariableValueMap(std::shared_ptr<ValueHolder::ValueMap_t>& valueMap_, const IRatingEngine::Value_t& value_)
+{
+    const IRatingEngine::InstanceVariable_t* instanceVariable = boost::get<IRatingEngine::InstanceVariable_t>(&value_);
+    if (instanceVariable != nullptr) {
+        for (const IRatingEngine::InstanceVariable_t::value_type& instanceValue : *instanceVariable) {
+            IRatingEngine::Variant_t variant = instanceValue.second;
+            valueMap_->emplace(instanceValue.first, getValueFromVariant(instanceValue.second));
+        }
+    }
+    else {
+        const IRatingEngine::Variant_t* variant = boost::get<IRatingEngine::Variant_t>(&value_);
+        CP_REQUIRE(variant != nullptr);
+        valueMap_->emplace(std::string(), getValueFromVariant(*variant));
+    }
+}
+
+inline bool isFunction(const std::string& str_)
+{
+    return str_.find('(') != std::string::npos && bal::ends_with(bal::trim_copy(str_), ")");
+}
+
+template <class ValueType>
+class InsertVisitor
+    : public boost::static_visitor<>
+{
+public:
+    InsertVisitor(const std::string& key_, std::unordered_map<std::string, ValueType>& map_)
+        : m_key(key_)
+        , m_map(map_)
+    {
+    }
+
+    void operator()(const double& d_) const
+    {
+        m_map[m_key] = d_;
+    }
+
+    void operator()(const std::string& str_) const
+    {
+        m_map[m_key] = str_;
+    }
+
+    void operator()(const bool& b_) const
+    {
+        m_map[m_key] = b_ ? "1" : "0";
+    }
+
+private:
+    const std::string m_key;
+    std::unordered_map<std::string, ValueType>& m_map;
+};
+
+void addValueToResult(const Value& value_, IRatingEngine::Map_t& result_, const RatingOutput& output_)
+{
+    const std::string& variableName = output_.getVariableName();
+    const std::string& instanceId = output_.getInstanceId();
+
+    if (instanceId.empty()) {
+        // we have a simple result
+        value_.applyVisitor(InsertVisitor<IRatingEngine::Value_t>(variableName, result_));
+    }
+    else {
+        // we have a result for a specific instance
+        IRatingEngine::Map_t::iterator it = result_.find(variableName);
+        if (it == result_.end()) {
+            IRatingEngine::InstanceVariable_t instanceVariable;
+            value_.applyVisitor(InsertVisitor<IRatingEngine::Variant_t>(instanceId, instanceVariable));
+            result_.emplace(variableName, instanceVariable).first;
+        }
+        else {
+            IRatingEngine::InstanceVariable_t* instanceVariable = boost::get<IRatingEngine::InstanceVariable_t>(&(it->second));
+            if (instanceVariable != nullptr) {
+                value_.applyVisitor(InsertVisitor<IRatingEngine::Variant_t>(instanceId, *instanceVariable));
+            }
+            else {
+                BOOST_THROW_EXCEPTION(std::runtime_error("Inconsistent result type! Expected InstanceVariable"));
+            }
+        }
+    }
+}
+
+// returns the number value of the input parameter like ValueHolder, nullptr if it is not defined or not a number
+const double* findNumber(const std::unordered_map<std::string, const IRatingEngine::Value_t*>& parameters_, const std::string& variableName_, const std::string& instanceId_)
+{
+    std::unordered_map<std::string, const IRatingEngine::Value_t*>::const_iterator it = parameters_.find(variableName_);
+    if (it == parameters_.end()) {
+        return nullptr;
+    }
+
+    const IRatingEngine::InstanceVariable_t* instanceVariable = boost::get<IRatingEngine::InstanceVariable_t>(it->second);
+    if (instanceVariable == nullptr) {
+        return boost::get<double>(boost::get<IRatingEngine::Variant_t>(it->second));
+    }
+    IRatingEngine::InstanceVariable_t::const_iterator instanceValue = instanceVariable->find(instanceId_);
+    if (instanceValue == instanceVariable->end() && !instanceId_.empty()) {
+        instanceValue = instanceVariable->find(std::string());
+    }
+    return instanceValue != instanceVariable->end() ? boost::get<double>(&instanceValue->second) : nullptr;
+}
+}
+
+PreparedTariff::PreparedTariff(const ParsingContext::FunctionMap_t& functions_, const std::shared_ptr<IFunctionResultCache>& functionResultCache_, const std::shared_ptr<IParseTreeCache>& parseTreeCache_,
+                               const RatingEngineOptions& options_, const std::shared_ptr<ThreadPool>& threadPool_, const log4cplus::Logger& logger_,
+                               const std::string& insuranceRateKey_, const IRatingEngine::RatingFormulaMap_t& ratingFormulas_, const std::vector<RatingOutput>& ratingOutput_)
+    : m_insuranceRateKey(insuranceRateKey_)
+    , m_functions(std::make_shared<ParsingContext::FunctionMap_t>(functions_))
+    , m_symbolTable(std::make_shared<SymbolTable>())
+    , m_functionResultCache(functionResultCache_)
+    , m_parseTreeCache(parseTreeCache_)
+    , m_options(options_)
+    , m_threadPool(threadPool_)
+    , m_logger(logger_)
+    , m_ratingOutput(ratingOutput_)
+    , m_numberOfInstances(0)
+{
+    // formula functions are added to the function map, all other formulas are evaluated lazily
+    std::vector<std::shared_ptr<Function>> formulaFunctions;
+    std::vector<std::string> formulaFunctionNames;
+    for (const IRatingEngine::RatingFormulaMap_t::value_type& formula : ratingFormulas_) {
+        if (isFunction(formula.first)) {
+            std::shared_ptr<Function> function(std::make_shared<Function>(formula.first, formula.second));
+            ParsingContext::addFunction(*m_functions, function);
+            formulaFunctions.push_back(function);
+            formulaFunctionNames.push_back(formula.first);
+        }
+        else {
+            LazyFormula lazyFormula = { formula.first, formula.second, m_symbolTable->addSymbol(formula.first), std::vector<std::string>(), false };
+            m_lazyFormulas.push_back(lazyFormula);
+        }
+    }
+
+    // sort rating output by sort order
+    std::sort(m_ratingOutput.begin(), m_ratingOutput.end(), [](const RatingOutput & lhs_, const RatingOutput & rhs_) {
+        return lhs_.getSortOrder() < rhs_.getSortOrder();
+    });
+
+    // compile all formulas and resolve their identifiers to slots
+    std::shared_ptr<ParsingContext> parsingContext(std::make_shared<ParsingContext>(m_functions, std::shared_ptr<const SymbolTable>(), m_functionResultCache, m_parseTreeCache, m_insuranceRateKey, m_logger));
+    for (std::size_t i = 0; i < formulaFunctions.size(); ++i) {
+        bind(parsingContext, formulaFunctionNames[i], formulaFunctions[i]->getFunctionId(), formulaFunctions[i]->getImplementation());
+    }
+    for (const LazyFormula& lazyFormula : m_lazyFormulas) {
+        bind(parsingContext, lazyFormula.variableName, lazyFormula.variableName, lazyFormula.formula);
+    }
+    for (const RatingOutput& output : m_ratingOutput) {
+        bind(parsingContext, output.getVariableName(), output.getVariableName(), output.getFormula());
+    }
+    internRatingOutputs();
+
+    buildDependencyGraph(formulaFunctions, formulaFunctionNames);
+    findPureFunctions(formulaFunctions);
+
+    if (m_options.isColumnarEvaluation()) {
+        findColumnarOutputs();
+        findInstanceGroups();
+    }
+}
+
+void PreparedTariff::bind(const std::shared_ptr<ParsingContext>& parsingContext_, const std::string& name_, const std::string& cacheKey_, const std::string& formula_)
+{
+    if (m_symbolTable->findFormula(cacheKey_) != nullptr) {
+        return;
+    }
+
+    try {
+        Parser parser(parsingContext_);
+        m_symbolTable->bind(cacheKey_, parser.getCompiledFormula(cacheKey_, formula_), *m_functions);
+        m_boundFormulas.emplace_back(name_, cacheKey_);
+    }
+    catch (const std::exception& ex) {
+        // the formula stays unbound, the error is reported when it is calculated
+        LOG4CPLUS_DEBUG(m_logger, "formula " << name_ << " not bound: " << ex.what());
+    }
+}
+
+void PreparedTariff::buildDependencyGraph(const std::vector<std::shared_ptr<Function>>& formulaFunctions_, const std::vector<std::string>& formulaFunctionNames_)
+{
+    typedef DependencyGraph::Node Node_t;
+
+    std::vector<Node_t> nodes;
+    // the parse tree cache key and the function of every node
+    std::vector<std::pair<std::string, const Function*>> nodeFormulas;
+
+    // formula functions and rating formulas sorted by name, followed by the rating outputs in calculation order
+    std::vector<std::size_t> functionOrder(formulaFunctions_.size());
+    for (std::size_t i = 0; i < functionOrder.size(); ++i) {
+        functionOrder[i] = i;
+    }
+    std::sort(functionOrder.begin(), functionOrder.end(), [&](std::size_t lhs_, std::size_t rhs_) {
+        return formulaFunctionNames_[lhs_] < formulaFunctionNames_[rhs_];
+    });
+    std::unordered_map<std::string, std::size_t> functionNodes;
+    for (std::size_t i : functionOrder) {
+        functionNodes.emplace(formulaFunctions_[i]->getFunctionId(), nodes.size());
+        nodes.push_back(Node_t{ DependencyGraph::NodeType::FORMULA_FUNCTION, formulaFunctionNames_[i], std::string(), false });
+        nodeFormulas.emplace_back(formulaFunctions_[i]->getFunctionId(), formulaFunctions_[i].get());
+    }
+
+    std::vector<const LazyFormula*> lazyFormulas;
+    for (const LazyFormula& lazyFormula : m_lazyFormulas) {
+        lazyFormulas.push_back(&lazyFormula);
+    }
+    std::sort(lazyFormulas.begin(), lazyFormulas.end(), [](const LazyFormula* lhs_, const LazyFormula* rhs_) {
+        return lhs_->variableName < rhs_->variableName;
+    });
+    std::unordered_map<std::string, std::size_t> formulaNodes;
+    for (const LazyFormula* lazyFormula : lazyFormulas) {
+        formulaNodes.emplace(bal::to_lower_copy(lazyFormula->variableName), nodes.size());
+        nodes.push_back(Node_t{ DependencyGraph::NodeType::RATING_FORMULA, lazyFormula->variableName, std::string(), false });
+        nodeFormulas.emplace_back(lazyFormula->variableName, nullptr);
+    }
+
+    std::unordered_map<std::string, std::vector<std::size_t>> outputNodes;
+    for (const RatingOutput& output : m_ratingOutput) {
+        outputNodes[bal::to_lower_copy(output.getVariableName())].push_back(nodes.size());
+        nodes.push_back(Node_t{ DependencyGraph::NodeType::RATING_OUTPUT, output.getVariableName(), output.getInstanceId(), false });
+        nodeFormulas.emplace_back(output.getVariableName(), nullptr);
+    }
+
+    std::unordered_set<std::string> seen;
+    for (std::size_t i = 0; i < nodes.size(); ++i) {
+        Node_t& node = nodes[i];
+        const SymbolTable::BoundFormula* boundFormula = m_symbolTable->findFormula(nodeFormulas[i].first);
+        if (boundFormula == nullptr) {
+            continue;
+        }
+        node.compiled = true;
+        const CompiledFormula& compiledFormula = *boundFormula->compiledFormula;
+
+        seen.clear();
+        if (nodeFormulas[i].second != nullptr) {
+            // the arguments of a function are no variables
+            for (const std::string& argument : nodeFormulas[i].second->getArguments()) {
+                seen.insert(bal::to_lower_copy(argument));
+            }
+        }
+        for (std::size_t j = 0; j < compiledFormula.getNumberOfIdentifiers(); ++j) {
+            const std::string& identifier = compiledFormula.getIdentifier(static_cast<std::uint32_t>(j));
+            const std::string name(bal::to_lower_copy(identifier));
+            if (!seen.insert(name).second) {
+                continue;
+            }
+
+            // a rating output reads the outputs calculated before it, all other formulas may read every output
+            std::unordered_map<std::string, std::vector<std::size_t>>::const_iterator outputs = outputNodes.find(name);
+            const bool isOutput = node.type == DependencyGraph::NodeType::RATING_OUTPUT;
+            bool found = false;
+            if (outputs != outputNodes.end()) {
+                for (std::size_t output : outputs->second) {
+                    if (!isOutput || output < i) {
+                        node.dependencies.push_back(output);
+                        found = true;
+                    }
+                }
+            }
+            std::unordered_map<std::string, std::size_t>::const_iterator formula = formulaNodes.find(name);
+            if (formula != formulaNodes.end()) {
+                node.dependencies.push_back(formula->second);
+                found = true;
+            }
+            if (!found) {
+                node.variables.push_back(identifier);
+            }
+        }
+
+        seen.clear();
+        for (std::size_t j = 0; j < compiledFormula.getNumberOfCallSites(); ++j) {
+            const CompiledFormula::CallSite& callSite = compiledFormula.getCallSite(static_cast<std::uint32_t>(j));
+            std::unordered_map<std::string, std::size_t>::const_iterator function = functionNodes.find(callSite.functionId);
+            if (function != functionNodes.end()) {
+                node.dependencies.push_back(function->second);
+            }
+            else if (seen.insert(bal::to_lower_copy(callSite.functionName)).second) {
+                node.functions.push_back(callSite.functionName);
+            }
+        }
+
+        std::sort(node.variables.begin(), node.variables.end());
+        std::sort(node.functions.begin(), node.functions.end());
+        std::sort(node.dependencies.begin(), node.dependencies.end());
+        node.dependencies.erase(std::unique(node.dependencies.begin(), node.dependencies.end()), node.dependencies.end());
+    }
+
+    analyzeInstanceInvariance(nodes);
+    m_dependencyGraph = DependencyGraph(nodes);
+}
+
+void PreparedTariff::analyzeInstanceInvariance(std::vector<DependencyGraph::Node>& nodes_)
+{
+    typedef DependencyGraph::Node Node_t;
+
+    std::unordered_map<std::string, LazyFormula*> lazyFormulas;
+    for (LazyFormula& lazyFormula : m_lazyFormulas) {
+        lazyFormulas.emplace(lazyFormula.variableName, &lazyFormula);
+    }
+
+    // the first rating output which reads each formula, directly or through other formulas. The rating outputs follow
+    // all other nodes in calculation order, so a formula which was read before has been visited with all formulas it reads.
+    std::vector<std::size_t> firstReaders(nodes_.size(), DependencyGraph::NO_NODE);
+    std::vector<std::size_t> stack;
+    for (std::size_t i = 0; i < nodes_.size(); ++i) {
+        if (nodes_[i].type != DependencyGraph::NodeType::RATING_OUTPUT) {
+            continue;
+        }
+        firstReaders[i] = i;
+        stack.assign(1, i);
+        while (!stack.empty()) {
+            const Node_t& node = nodes_[stack.back()];
+            stack.pop_back();
+            for (std::size_t dependency : node.dependencies) {
+                if (nodes_[dependency].type != DependencyGraph::NodeType::RATING_OUTPUT && firstReaders[dependency] == DependencyGraph::NO_NODE) {
+                    firstReaders[dependency] = i;
+                    stack.push_back(dependency);
+                }
+            }
+        }
+    }
+
+    std::vector<std::string> inputNames;
+    // the nodes visited for the current node are marked with its stamp
+    std::vector<std::size_t> visited(nodes_.size(), 0);
+    std::size_t stamp = 0;
+    for (std::size_t i = 0; i < nodes_.size(); ++i) {
+        // visit the node and all formulas it references, the values of rating outputs are stored and not calculated again
+        bool instanceInvariant = true;
+        inputNames.clear();
+        visited[i] = ++stamp;
+        stack.assign(1, i);
+        while (!stack.empty() && instanceInvariant) {
+            const std::size_t current = stack.back();
+            const Node_t& node = nodes_[current];
+            stack.pop_back();
+            if (!node.compiled || !node.functions.empty()) {
+                instanceInvariant = false;
+                break;
+            }
+
+            for (const std::string& variable : node.variables) {
+                inputNames.push_back(bal::to_lower_copy(variable));
+            }
+            for (std::size_t dependency : node.dependencies) {
+                const Node_t& referenced = nodes_[dependency];
+                if (referenced.type == DependencyGraph::NodeType::RATING_OUTPUT) {
+                    // a rating output which is calculated after the formula is first read has different values for the instances
+                    // read before and after it, the variable may still be an input parameter before
+                    instanceInvariant = instanceInvariant && referenced.instanceId.empty() && (firstReaders[current] == DependencyGraph::NO_NODE || dependency < firstReaders[current]);
+                    inputNames.push_back(bal::to_lower_copy(referenced.name));
+                }
+                else if (visited[dependency] != stamp) {
+                    visited[dependency] = stamp;
+                    stack.push_back(dependency);
+                }
+            }
+        }
+        nodes_[i].instanceInvariant = instanceInvariant;
+
+        if (nodes_[i].type == DependencyGraph::NodeType::RATING_FORMULA) {
+            LazyFormula& lazyFormula = *lazyFormulas.at(nodes_[i].name);
+            lazyFormula.instanceInvariant = instanceInvariant;
+            if (instanceInvariant) {
+                std::sort(inputNames.begin(), inputNames.end());
+                inputNames.erase(std::unique(inputNames.begin(), inputNames.end()), inputNames.end());
+                lazyFormula.inputNames = inputNames;
+            }
+        }
+    }
+}
+
+void PreparedTariff::findPureFunctions(const std::vector<std::shared_ptr<Function>>& formulaFunctions_)
+{
+    std::unordered_map<const IFunction*, std::size_t> functionIndexes;
+    std::vector<const SymbolTable::BoundFormula*> boundFormulas(formulaFunctions_.size());
+    std::vector<std::uint8_t> pure(formulaFunctions_.size(), 0);
+    for (std::size_t i = 0; i < formulaFunctions_.size(); ++i) {
+        const Function& function = *formulaFunctions_[i];
+        functionIndexes.emplace(&function, i);
+        boundFormulas[i] = m_symbolTable->findFormula(function.getFunctionId());
+        if (boundFormulas[i] == nullptr) {
+            continue;
+        }
+
+        // every identifier must be an argument
+        const CompiledFormula& compiledFormula = *boundFormulas[i]->compiledFormula;
+        pure[i] = 1;
+        for (std::size_t j = 0; j < compiledFormula.getNumberOfIdentifiers() && pure[i]; ++j) {
+            const std::string& identifier = compiledFormula.getIdentifier(static_cast<std::uint32_t>(j));
+            pure[i] = std::any_of(function.getArguments().begin(), function.getArguments().end(), [&identifier](const std::string& argument_) {
+                return bal::iequals(argument_, identifier);
+            });
+        }
+    }
+
+    // a function which calls an impure formula function or a business function which is not declared pure (see FunctionCachingPolicy::isPure)
+    // is impure, until nothing changes, so functions which call each other recursively stay pure
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (std::size_t i = 0; i < formulaFunctions_.size(); ++i) {
+            if (!pure[i]) {
+                continue;
+            }
+            for (IFunction* called : boundFormulas[i]->functions) {
+                const std::unordered_map<const IFunction*, std::size_t>::const_iterator it = functionIndexes.find(called);
+                const bool calledPure = it != functionIndexes.end() ? pure[it->second] != 0 : called != nullptr && called->getCachingPolicy().isPure();
+                if (!calledPure) {
+                    pure[i] = 0;
+                    changed = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    for (std::size_t i = 0; i < formulaFunctions_.size(); ++i) {
+        formulaFunctions_[i]->setPure(pure[i] != 0, m_options.isSharedFunctionMemoization());
+    }
+}
+
+void PreparedTariff::findColumnarOutputs()
+{
+    // the rating outputs are the last nodes of the dependency graph
+    const std::vector<DependencyGraph::Node>& nodes = m_dependencyGraph.getNodes();
+    const std::size_t firstOutput = nodes.size() - m_ratingOutput.size();
+    for (std::size_t i = 0; i < m_ratingOutput.size(); ++i) {
+        // only rating outputs which do not read other formulas or outputs, so their variables are input parameters
+        const DependencyGraph::Node& node = nodes[firstOutput + i];
+        const SymbolTable::BoundFormula* boundFormula = m_symbolTable->findFormula(m_ratingOutput[i].getVariableName());
+        if (boundFormula == nullptr || !node.dependencies.empty() || !ColumnarEvaluator::isColumnar(*boundFormula->compiledFormula)) {
+            continue;
+        }
+
+        ColumnarOutput columnarOutput = { i, boundFormula->compiledFormula, std::vector<std::string>() };
+        for (std::size_t j = 0; j < boundFormula->compiledFormula->getNumberOfIdentifiers(); ++j) {
+            columnarOutput.identifiers.push_back(bal::to_lower_copy(boundFormula->compiledFormula->getIdentifier(static_cast<std::uint32_t>(j))));
+        }
+        m_columnarOutputs.push_back(columnarOutput);
+    }
+}
+
+void PreparedTariff::findInstanceGroups()
+{
+    const std::vector<DependencyGraph::Node>& nodes = m_dependencyGraph.getNodes();
+    const std::size_t firstOutput = nodes.size() - m_ratingOutput.size();
+    std::unordered_set<std::string> instanceIds;
+    for (std::size_t i = 0; i < m_ratingOutput.size();) {
+        const RatingOutput& output = m_ratingOutput[i];
+        std::size_t end = i + 1;
+        instanceIds.clear();
+        instanceIds.insert(output.getInstanceId());
+        while (end < m_ratingOutput.size() && m_ratingOutput[end].getVariableName() == output.getVariableName() &&
+               m_ratingOutput[end].getFormula() == output.getFormula() && instanceIds.insert(m_ratingOutput[end].getInstanceId()).second) {
+            ++end;
+        }
+
+        // the formula may read input parameters and rating outputs, which are resolved without side effects, but not its own variable.
+        // Rating formulas are not read, they would be calculated for instances whose rating output does not need them
+        const SymbolTable::BoundFormula* boundFormula = m_symbolTable->findFormula(output.getVariableName());
+        bool columnar = end - i > 1 && boundFormula != nullptr && ColumnarEvaluator::isColumnar(*boundFormula->compiledFormula);
+        const std::string variableName(bal::to_lower_copy(output.getVariableName()));
+        for (std::size_t j = i; columnar && j < end; ++j) {
+            for (std::size_t dependency : nodes[firstOutput + j].dependencies) {
+                if (nodes[dependency].type != DependencyGraph::NodeType::RATING_OUTPUT || bal::to_lower_copy(nodes[dependency].name) == variableName) {
+                    columnar = false;
+                    break;
+                }
+            }
+        }
+        if (columnar) {
+            m_instanceGroups.push_back(InstanceGroup{ i, end - i, boundFormula });
+        }
+        i = end;
+    }
+}
+
+void PreparedTariff::internRatingOutputs()
+{
+    // the empty instance id has ordinal 0
+    std::unordered_map<std::string, std::uint32_t> instanceOrdinals;
+    instanceOrdinals.emplace(std::string(), 0);
+    std::unordered_map<std::uint32_t, std::uint32_t> variables;
+    for (const RatingOutput& output : m_ratingOutput) {
+        const std::uint32_t slot = m_symbolTable->addSymbol(output.getVariableName());
+        const std::uint32_t variable = variables.emplace(slot, static_cast<std::uint32_t>(m_calculatedSlots.size())).first->second;
+        if (variable == m_calculatedSlots.size()) {
+            m_calculatedSlots.push_back(slot);
+        }
+        m_outputVariables.push_back(variable);
+        m_outputInstances.push_back(instanceOrdinals.emplace(output.getInstanceId(), static_cast<std::uint32_t>(instanceOrdinals.size())).first->second);
+    }
+    m_numberOfInstances = instanceOrdinals.size();
+}
+
+PreparedTariff::~PreparedTariff()
+{
+}
+
+Value PreparedTariff::calculateOutput(const std::shared_ptr<ParsingContext>& parsingContext_, std::size_t output_) const
+{
+    const RatingOutput& output = m_ratingOutput[output_];
+    const std::string& variableName = output.getVariableName();
+    const std::string& instanceId = output.getInstanceId();
+    parsingContext_->setCurrentRatingoutputVariable(variableName);
+    parsingContext_->setInstanceId(instanceId, m_outputInstances[output_]);
+
+    log4cplus::NDCContextCreator ndc((!instanceId.empty() ? instanceId + ' ' : std::string()) + variableName);
+
+    Parser parser(parsingContext_);
+    Value value = parser.parse(variableName, output.getFormula());
+    LOG4CPLUS_DEBUG(m_logger, "result=" << value);
+    return value;
+}
+
+std::vector<std::string> PreparedTariff::checkShortCircuitEvaluation() const
+{
+    // reading a rating formula may fail if its formula may fail, including the rating formulas it reads.
+    // The failing formulas are marked until no formula is added, so formulas which reference each other terminate.
+    std::vector<bool> failingSlots(m_symbolTable->getNumberOfSymbols(), false);
+    bool added = true;
+    while (added) {
+        added = false;
+        for (const LazyFormula& lazyFormula : m_lazyFormulas) {
+            if (failingSlots[lazyFormula.slot]) {
+                continue;
+            }
+            // a formula which is not bound reports its error when it is calculated
+            const SymbolTable::BoundFormula* formula = m_symbolTable->findFormula(lazyFormula.variableName);
+            if (formula == nullptr || ShortCircuitAnalysis::mayFail(*formula, failingSlots)) {
+                failingSlots[lazyFormula.slot] = true;
+                added = true;
+            }
+        }
+    }
+
+    std::vector<std::string> result;
+    for (const std::pair<std::string, std::string>& boundFormula : m_boundFormulas) {
+        const SymbolTable::BoundFormula* formula = m_symbolTable->findFormula(boundFormula.second);
+        if (formula != nullptr && ShortCircuitAnalysis::mayDiffer(*formula, failingSlots)) {
+            result.push_back(boundFormula.first);
+        }
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+IRatingEngine::Map_t PreparedTariff::calculate(const IRatingEngine::Map_t& input_) const
+{
+    // with formulas which reference each other, whether the calculation terminates may depend on the calculation order
+    return calculate(input_, m_dependencyGraph.hasCycles() ? nullptr : m_threadPool.get(), nullptr);
+}
+
+std::vector<IRatingEngine::BatchResult> PreparedTariff::calculateBatch(const std::vector<IRatingEngine::Map_t>& inputs_) const
+{
+    std::vector<IRatingEngine::BatchResult> results(inputs_.size());
+
+    // the columnar rating outputs are evaluated first, block by block
+    std::vector<PrecalculatedValues_t> precalculated;
+    if (!m_columnarOutputs.empty()) {
+        precalculated.assign(inputs_.size(), PrecalculatedValues_t(m_ratingOutput.size()));
+        const std::size_t numberOfBlocks = (inputs_.size() + ColumnarEvaluator::BLOCK_SIZE - 1) / ColumnarEvaluator::BLOCK_SIZE;
+        auto calculateBlock = [&](std::size_t i_) {
+            calculateColumnar(inputs_, i_ * ColumnarEvaluator::BLOCK_SIZE, std::min(inputs_.size(), (i_ + 1) * ColumnarEvaluator::BLOCK_SIZE), precalculated);
+        };
+
+        if (m_threadPool) {
+            m_threadPool->run(numberOfBlocks, calculateBlock);
+        }
+        else {
+            for (std::size_t i = 0; i < numberOfBlocks; ++i) {
+                calculateBlock(i);
+            }
+        }
+    }
+
+    // the inputs are distributed to the threads, the rating outputs of one input are not distributed again
+    auto calculateInput = [&](std::size_t i_) {
+        try {
+            results[i_].output = calculate(inputs_[i_], nullptr, precalculated.empty() ? nullptr : &precalculated[i_]);
+        }
+        catch (...) {
+            results[i_].error = std::current_exception();
+        }
+    };
+
+    if (m_threadPool) {
+        m_threadPool->run(inputs_.size(), calculateInput);
+    }
+    else {
+        for (std::size_t i = 0; i < inputs_.size(); ++i) {
+            calculateInput(i);
+        }
+    }
+    return results;
+}
+
+void PreparedTariff::calculateColumnar(const std::vector<IRatingEngine::Map_t>& inputs_, std::size_t first_, std::size_t last_, std::vector<PrecalculatedValues_t>& precalculated_) const
+{
+    const std::size_t numberOfLanes = last_ - first_;
+
+    // the input parameters of every lane by their lower case names, the last of equal names wins like in calculate
+    std::vector<std::unordered_map<std::string, const IRatingEngine::Value_t*>> parameters(numberOfLanes);
+    for (std::size_t lane = 0; lane < numberOfLanes; ++lane) {
+        for (const IRatingEngine::Map_t::value_type& variable : inputs_[first_ + lane]) {
+            parameters[lane][bal::to_lower_copy(variable.first)] = &variable.second;
+        }
+    }
+
+    std::vector<std::vector<double>> columns;
+    std::vector<const double*> columnPointers;
+    std::vector<double> results(numberOfLanes);
+    std::vector<std::uint8_t> fallback(numberOfLanes);
+    for (const ColumnarOutput& columnarOutput : m_columnarOutputs) {
+        const std::string& instanceId = m_ratingOutput[columnarOutput.output].getInstanceId();
+
+        // lanes whose variables are not numbers are calculated by calculate
+        columns.resize(columnarOutput.identifiers.size());
+        columnPointers.clear();
+        std::fill(fallback.begin(), fallback.end(), 0);
+        for (std::size_t i = 0; i < columnarOutput.identifiers.size(); ++i) {
+            columns[i].resize(numberOfLanes);
+            columnPointers.push_back(columns[i].data());
+            for (std::size_t lane = 0; lane < numberOfLanes; ++lane) {
+                const double* number = findNumber(parameters[lane], columnarOutput.identifiers[i], instanceId);
+                if (number != nullptr) {
+                    columns[i][lane] = *number;
+                }
+                else {
+                    fallback[lane] = 1;
+                }
+            }
+        }
+
+        ColumnarEvaluator evaluator(*columnarOutput.compiledFormula);
+        evaluator.evaluate(columnPointers.data(), numberOfLanes, results.data(), fallback.data());
+
+        for (std::size_t lane = 0; lane < numberOfLanes; ++lane) {
+            if (fallback[lane] == 0) {
+                precalculated_[first_ + lane][columnarOutput.output] = Value(results[lane]);
+            }
+        }
+    }
+}
+
+void PreparedTariff::calculateInstanceGroup(const std::shared_ptr<ParsingContext>& parsingContext_, const InstanceGroup& group_, const PrecalculatedValues_t* precalculated_, PrecalculatedValues_t& values_) const
+{
+    const CompiledFormula& compiledFormula = *group_.boundFormula->compiledFormula;
+    const std::size_t numberOfLanes = group_.numberOfOutputs;
+
+    // the variables of every instance, lanes whose variables are not defined or not numbers are calculated separately
+    std::vector<std::vector<double>> columns(compiledFormula.getNumberOfIdentifiers(), std::vector<double>(numberOfLanes));
+    std::vector<const double*> columnPointers;
+    for (const std::vector<double>& column : columns) {
+        columnPointers.push_back(column.data());
+    }
+    std::vector<std::uint8_t> fallback(numberOfLanes, 0);
+    for (std::size_t lane = 0; lane < numberOfLanes; ++lane) {
+        if (precalculated_ != nullptr && (*precalculated_)[group_.firstOutput + lane]) {
+            fallback[lane] = 1;
+            continue;
+        }
+
+        parsingContext_->setInstanceId(m_ratingOutput[group_.firstOutput + lane].getInstanceId(), m_outputInstances[group_.firstOutput + lane]);
+        for (std::uint32_t i = 0; i < columns.size(); ++i) {
+            try {
+                const Value value = parsingContext_->resolve(group_.boundFormula->slots[i], compiledFormula.getIdentifier(i));
+                if (value.isVoid() || !value.isDouble()) {
+                    fallback[lane] = 1;
+                    break;
+                }
+                columns[i][lane] = value.asDouble();
+            }
+            catch (const std::exception&) {
+                // the error is reported by the separate calculation
+                fallback[lane] = 1;
+                break;
+            }
+        }
+    }
+
+    std::vector<double> results(numberOfLanes);
+    ColumnarEvaluator evaluator(compiledFormula);
+    evaluator.evaluate(columnPointers.data(), numberOfLanes, results.data(), fallback.data());
+
+    values_.assign(numberOfLanes, boost::none);
+    for (std::size_t lane = 0; lane < numberOfLanes; ++lane) {
+        if (fallback[lane] == 0) {
+            values_[lane] = Value(results[lane]);
+        }
+    }
+}
+
+IRatingEngine::Map_t PreparedTariff::calculate(const IRatingEngine::Map_t& input_, ThreadPool* threadPool_, const PrecalculatedValues_t* precalculated_) const
+{
+    typedef std::chrono::high_resolution_clock Clock_t;
+
+    LOG4CPLUS_DEBUG(m_logger, "start calculate");
+
+    try {
+        // the temporary objects of the calculation are allocated from the arena, it is released after the parsing context
+        Arena arena;
+        const ArenaAllocator<ParsingContext> allocator(&arena);
+
+        // create parsing context
+        std::shared_ptr<ParsingContext> parsingContext(std::allocate_shared<ParsingContext>(allocator, m_functions, m_symbolTable, m_functionResultCache, m_parseTreeCache, m_insuranceRateKey, m_logger));
+        parsingContext->setArena(&arena);
+        parsingContext->setEvaluationBackend(m_options.getEvaluationBackend());
+        parsingContext->setShortCircuitEvaluation(m_options.isShortCircuitEvaluation());
+
+        // fill parsing context with input variables
+        std::unordered_set<std::string> instanceInputs;
+        for (const IRatingEngine::Map_t::value_type& variable : input_) {
+            std::shared_ptr<ValueHolder::ValueMap_t> valueMap(std::allocate_shared<ValueHolder::ValueMap_t>(allocator, allocator));
+            fillVariableValueMap(valueMap, variable.second);
+            if (valueMap->size() > 1 || valueMap->count(std::string()) == 0) {
+                instanceInputs.insert(bal::to_lower_copy(variable.first));
+            }
+            parsingContext->assignParam(variable.first, std::allocate_shared<ValueHolder>(allocator, valueMap));
+        }
+
+        // fill parsing context with formulas which will be evaluated lazily,
+        // the instance invariant formulas which do not read input parameters with instance values are calculated once for all instances
+        for (const LazyFormula& lazyFormula : m_lazyFormulas) {
+            const bool instanceInvariant = lazyFormula.instanceInvariant && std::none_of(lazyFormula.inputNames.begin(), lazyFormula.inputNames.end(), [&](const std::string& inputName_) {
+                return instanceInputs.count(inputName_) != 0;
+            });
+            parsingContext->assignParam(lazyFormula.slot, std::allocate_shared<LazyValueHolder>(allocator, lazyFormula.variableName, lazyFormula.formula, instanceInvariant));
+        }
+
+        // the rating outputs are stored by their calculated variable and instance ordinal,
+        // a variable replaces the input parameter or formula of the same name when its first value is added
+        const std::shared_ptr<CalculatedVariables> calculatedVariables(std::allocate_shared<CalculatedVariables>(allocator, m_calculatedSlots.size(), m_numberOfInstances));
+        std::vector<bool> assignedVariables(m_calculatedSlots.size(), false);
+        auto addCalculatedVariable = [&](std::size_t output_, const Value& value_) {
+            const std::uint32_t variable = m_outputVariables[output_];
+            calculatedVariables->setValue(variable, m_outputInstances[output_], value_);
+            if (!assignedVariables[variable]) {
+                assignedVariables[variable] = true;
+                parsingContext->assignParam(m_calculatedSlots[variable], calculatedVariables->getValueHolder(variable));
+            }
+        };
+
+        IRatingEngine::Map_t result;
+
+        LOG4CPLUS_DEBUG(m_logger, "start parsing");
+        const std::chrono::time_point<Clock_t> startTime = Clock_t::now();
+
+        if (threadPool_ == nullptr) {
+            // calculate every requested output variable
+            std::vector<InstanceGroup>::const_iterator group = m_instanceGroups.begin();
+            std::size_t groupFirst = 0;
+            std::size_t groupEnd = 0;
+            PrecalculatedValues_t groupValues;
+            for (std::size_t i = 0; i < m_ratingOutput.size(); ++i) {
+                const RatingOutput& output = m_ratingOutput[i];
+                if (group != m_instanceGroups.end() && group->firstOutput == i) {
+                    // the rating outputs of the group do not read each other, all instances are evaluated before the first is added
+                    calculateInstanceGroup(parsingContext, *group, precalculated_, groupValues);
+                    groupFirst = i;
+                    groupEnd = i + group->numberOfOutputs;
+                    ++group;
+                }
+
+                Value value;
+                if (precalculated_ != nullptr && (*precalculated_)[i]) {
+                    value = *(*precalculated_)[i];
+                }
+                else if (i < groupEnd && groupValues[i - groupFirst]) {
+                    value = *groupValues[i - groupFirst];
+                }
+                else {
+                    value = calculateOutput(parsingContext, i);
+                }
+
+                // add the calculated value to the parsing context
+                addCalculatedVariable(i, value);
+                // add the calculated value to the result container
+                addValueToResult(value, result, output);
+            }
+        }
+        else {
+            // the rating outputs are the last nodes of the dependency graph
+            const std::size_t firstOutput = m_dependencyGraph.getNodes().size() - m_ratingOutput.size();
+            std::vector<Value> values;
+            for (const std::vector<std::size_t>& level : m_dependencyGraph.getOutputLevels()) {
+                // the rating outputs of a level are independent, every thread calculates in its own child context.
+                // The lazily evaluated formulas are shared, each of them is calculated once. The arena is used by one thread only
+                values.assign(level.size(), Value());
+                threadPool_->run(level.size(), [&](std::size_t i_) {
+                    Arena outputArena;
+                    std::shared_ptr<ParsingContext> outputContext(std::make_shared<ParsingContext>(parsingContext, false));
+                    outputContext->setArena(&outputArena);
+                    values[i_] = calculateOutput(outputContext, level[i_] - firstOutput);
+                });
+
+                // the values are added in calculation order, the next level may reference them
+                for (std::size_t i = 0; i < level.size(); ++i) {
+                    addCalculatedVariable(level[i] - firstOutput, values[i]);
+                    addValueToResult(values[i], result, m_ratingOutput[level[i] - firstOutput]);
+                }
+            }
+        }
+        const std::chrono::time_point<Clock_t> endTime = Clock_t::now();
+        LOG4CPLUS_DEBUG(m_logger, "end parsing/calculate " << std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime).count() << "ms, thereof function durations=" << parsingContext->getFunctionDurationsMicroSecs() / 1000 << "ms");
+
+        return result;
+    }
+    catch (...) {
+        LOG4CPLUS_DEBUG(m_logger, "end calculate");
+        throw;
+    }
+}
+
+} // namespace CalculusPrime
@@ -14,124 +14,72 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include <calculusprime/internal/RatingEngine.h>
-#include <chrono>
-#include <boost/algorithm/string/predicate.hpp>
-#include <boost/algorithm/string/trim.hpp>
-#include <boost/throw_exception.hpp>
-#include <boost/variant/static_visitor.hpp>
-#include <calculusprime/internal/parsing/Function.h>
-#include <calculusprime/internal/parsing/Parser.h>
-#include <calculusprime/internal/parsing/ValueHolder.h>
-#include <calculusprime/internal/parsing/LazyValueHolder.h>
-#include <calculusprime/internal/ParsingContext.h>
+#include <algorithm>
+#include <iterator>
+#include <boost/functional/hash.hpp>
+#include <calculusprime/IFunction.h>
+#include <calculusprime/cache/ConcurrentFunctionResultCache.h>
+#include <calculusprime/cache/TwoLevelFunctionResultCache.h>
+#include <calculusprime/internal/PreparedTariff.h>
+#include <calculusprime/internal/SynchronizedFunctionResultCache.h>
+#include <calculusprime/internal/ThreadPool.h>
 #include <calculusprime/internal/defs.h>
-#include <calculusprime/internal/require.h>
-
-namespace bal = boost::algorithm;
 
 namespace CalculusPrime {
 
-Value getValueFromVariant(const IRatingEngine::Variant_t& variant_)
+namespace {
+// the function result cache is shared by the threads of a calculation, a concurrent cache is already thread safe
+// and a two level cache requires a thread safe shared cache
+std::shared_ptr<IFunctionResultCache> synchronize(const std::shared_ptr<IFunctionResultCache>& functionResultCache_, std::size_t numberOfThreads_)
 {
-    const double* d = boost::get<double>(&variant_);
-    if (d != nullptr) {
-        return Value(*d);
-    }
-    else {
-        const std::string* s = boost::get<std::string>(&variant_);
-        CP_REQUIRE(s != nullptr);
-        return Value(*s);
+    if (numberOfThreads_ <= 1 || std::dynamic_pointer_cast<ConcurrentFunctionResultCache>(functionResultCache_) ||
+        std::dynamic_pointer_cast<TwoLevelFunctionResultCache>(functionResultCache_)) {
+        return functionResultCache_;
     }
+    return std::make_shared<SynchronizedFunctionResultCache>(functionResultCache_);
 }
 
-void fillVariableValueMap(std::shared_ptr<ValueHolder::ValueMap_t>& valueMap_, const IRatingEngine::Value_t& value_)
+// the formulas are added independent of their order in the unordered map, the rating outputs in their order
+std::size_t getFingerprint(const IRatingEngine::RatingFormulaMap_t& ratingFormulas_, const std::vector<RatingOutput>& ratingOutput_)
 {
-    const IRatingEngine::InstanceVariable_t* instanceVariable = boost::get<IRatingEngine::InstanceVariable_t>(&value_);
-    if (instanceVariable != nullptr) {
-        for (const IRatingEngine::InstanceVariable_t::value_type& instanceValue : *instanceVariable) {
-            IRatingEngine::Variant_t variant = instanceValue.second;
-            valueMap_->emplace(instanceValue.first, getValueFromVariant(instanceValue.second));
-        }
+    std::size_t formulas = 0;
+    for (const IRatingEngine::RatingFormulaMap_t::value_type& ratingFormula : ratingFormulas_) {
+        std::size_t hash = std::hash<std::string>()(ratingFormula.first);
+        boost::hash_combine(hash, ratingFormula.second);
+        formulas += hash;
     }
-    else {
-        const IRatingEngine::Variant_t* variant = boost::get<IRatingEngine::Variant_t>(&value_);
-        CP_REQUIRE(variant != nullptr);
-        valueMap_->emplace(std::string(), getValueFromVariant(*variant));
+    std::size_t fingerprint = ratingFormulas_.size();
+    boost::hash_combine(fingerprint, formulas);
+    for (const RatingOutput& ratingOutput : ratingOutput_) {
+        boost::hash_combine(fingerprint, ratingOutput.getSortOrder());
+        boost::hash_combine(fingerprint, ratingOutput.getVariableName());
+        boost::hash_combine(fingerprint, ratingOutput.getInstanceId());
+        boost::hash_combine(fingerprint, ratingOutput.getFormula());
     }
+    return fingerprint;
 }
 
-inline bool isFunction(const std::string& str_)
+bool isSameRatingOutput(const std::vector<RatingOutput>& lhs_, const std::vector<RatingOutput>& rhs_)
 {
-    return str_.find('(') != std::string::npos && bal::ends_with(bal::trim_copy(str_), ")");
+    return lhs_.size() == rhs_.size() && std::equal(lhs_.begin(), lhs_.end(), rhs_.begin(), [](const RatingOutput& left_, const RatingOutput& right_) {
+        return left_.getSortOrder() == right_.getSortOrder() && left_.getVariableName() == right_.getVariableName() &&
+               left_.getInstanceId() == right_.getInstanceId() && left_.getFormula() == right_.getFormula();
+    });
 }
-
-template <class ValueType>
-class InsertVisitor
-    : public boost::static_visitor<>
-{
-public:
-    InsertVisitor(const std::string& key_, std::unordered_map<std::string, ValueType>& map_)
-        : m_key(key_)
-        , m_map(map_)
-    {
-    }
-
-    void operator()(const double& d_) const
-    {
-        m_map[m_key] = d_;
-    }
-
-    void operator()(const std::string& str_) const
-    {
-        m_map[m_key] = str_;
-    }
-
-    void operator()(const bool& b_) const
-    {
-        m_map[m_key] = b_ ? "1" : "0";
-    }
-
-private:
-    const std::string m_key;
-    std::unordered_map<std::string, ValueType>& m_map;
-};
-
-void addValueToResult(const Value& value_, IRatingEngine::Map_t& result_, const RatingOutput& output_)
-{
-    const std::string& variableName = output_.getVariableName();
-    const std::string& instanceId = output_.getInstanceId();
-
-    if (instanceId.empty()) {
-        // we have a simple result
-        value_.applyVisitor(InsertVisitor<RatingEngine::Value_t>(variableName, result_));
-    }
-    else {
-        // we have a result for a specific instance
-        RatingEngine::Map_t::iterator it = result_.find(variableName);
-        if (it == result_.end()) {
-            IRatingEngine::InstanceVariable_t instanceVariable;
-            value_.applyVisitor(InsertVisitor<RatingEngine::Variant_t>(instanceId, instanceVariable));
-            result_.emplace(variableName, instanceVariable).first;
-        }
-        else {
-            IRatingEngine::InstanceVariable_t* instanceVariable = boost::get<IRatingEngine::InstanceVariable_t>(&(it->second));
-            if (instanceVariable != nullptr) {
-                value_.applyVisitor(InsertVisitor<RatingEngine::Variant_t>(instanceId, *instanceVariable));
-            }
-            else {
-                BOOST_THROW_EXCEPTION(std::runtime_error("Inconsistent result type! Expected InstanceVariable"));
-            }
-        }
-    }
 }
 
-
-RatingEngine::RatingEngine(const std::vector<std::shared_ptr<IFunction>>& functions_, const std::shared_ptr<IFunctionResultCache>& functionResultCache_, const std::shared_ptr<IParseTreeCache>& parseTreeCache_)
-    : m_functions(functions_)
-    , m_functionResultCache(functionResultCache_)
+RatingEngine::RatingEngine(const std::vector<std::shared_ptr<IFunction>>& functions_, const std::shared_ptr<IFunctionResultCache>& functionResultCache_, const std::shared_ptr<IParseTreeCache>& parseTreeCache_,
+                           const RatingEngineOptions& options_)
+    : m_functionResultCache(synchronize(functionResultCache_, options_.getNumberOfThreads()))
     , m_parseTreeCache(parseTreeCache_)
+    , m_options(options_)
+    // the calling thread calculates as well
+    , m_threadPool(options_.getNumberOfThreads() > 1 ? std::make_shared<ThreadPool>(options_.getNumberOfThreads() - 1) : nullptr)
     , m_logger(log4cplus::Logger::getInstance(LOGGER_CALCULUSPRIME))
 {
+    for (const std::shared_ptr<IFunction>& function : functions_) {
+        ParsingContext::addFunction(m_functions, function);
+    }
 }
 
 RatingEngine::~RatingEngine()
@@ -140,69 +88,93 @@ RatingEngine::~RatingEngine()
 
 RatingEngine::Map_t RatingEngine::calculate(const std::string& insuranceRateKey_, const Map_t& input_, const RatingFormulaMap_t& ratingFormulas_, const std::vector<RatingOutput>& ratingOutput_)
 {
-    typedef std::chrono::high_resolution_clock Clock_t;
+    return getPreparedTariff(insuranceRateKey_, ratingFormulas_, ratingOutput_)->calculate(input_);
+}
+
+std::unique_ptr<IPreparedTariff> RatingEngine::prepare(const std::string& insuranceRateKey_, const RatingFormulaMap_t& ratingFormulas_, const std::vector<RatingOutput>& ratingOutput_)
+{
+    return std::make_unique<PreparedTariff>(m_functions, m_functionResultCache, m_parseTreeCache, m_options, m_threadPool, m_logger, insuranceRateKey_, ratingFormulas_, ratingOutput_);
+}
 
-    LOG4CPLUS_DEBUG(m_logger, "start calculate");
+std::vector<RatingEngine::BatchResult> RatingEngine::calculateBatch(const std::string& insuranceRateKey_, const std::vector<Map_t>& inputs_, const RatingFormulaMap_t& ratingFormulas_, const std::vector<RatingOutput>& ratingOutput_)
+{
+    return getPreparedTariff(insuranceRateKey_, ratingFormulas_, ratingOutput_)->calculateBatch(inputs_);
+}
 
-    try {
-        // create parsing context
-        std::shared_ptr<ParsingContext> parsingContext(std::make_shared<ParsingContext>(m_functions, m_functionResultCache, m_parseTreeCache, insuranceRateKey_, m_logger));
+DependencyGraph RatingEngine::analyzeDependencies(const std::string& insuranceRateKey_, const RatingFormulaMap_t& ratingFormulas_, const std::vector<RatingOutput>& ratingOutput_)
+{
+    // the prepared tariff compiles all formulas, the graph is built from the compiled formulas
+    return getPreparedTariff(insuranceRateKey_, ratingFormulas_, ratingOutput_)->getDependencyGraph();
+}
 
-        // fill parsing context with input variables
-        for (const Map_t::value_type& variable : input_) {
-            std::shared_ptr<ValueHolder::ValueMap_t> valueMap(std::make_shared<ValueHolder::ValueMap_t>());
-            fillVariableValueMap(valueMap, variable.second);
-            parsingContext->assignParam(variable.first, std::make_shared<ValueHolder>(valueMap));
-        }
+void RatingEngine::evictPreparedTariffs(const std::string& insuranceRateKey_)
+{
+    // the tariffs are destroyed outside of the lock
+    CachedTariffList_t evicted;
+    std::lock_guard<std::mutex> lock(m_cachedTariffsMutex);
+    auto range = m_cachedTariffsByKey.equal_range(insuranceRateKey_);
+    for (auto it = range.first; it != range.second; ++it) {
+        evicted.splice(evicted.end(), m_cachedTariffs, it->second);
+    }
+    m_cachedTariffsByKey.erase(range.first, range.second);
+}
 
-        // fill parsing context with formulas which will be evaluated lazily
-        for (const RatingFormulaMap_t::value_type& formula : ratingFormulas_) {
-            if (isFunction(formula.first)) {
-                parsingContext->addFunction(std::make_shared<Function>(formula.first, formula.second));
-            }
-            else {
-                parsingContext->assignParam(formula.first, std::make_shared<LazyValueHolder>(formula.first, formula.second));
+std::shared_ptr<const PreparedTariff> RatingEngine::getPreparedTariff(const std::string& insuranceRateKey_, const RatingFormulaMap_t& ratingFormulas_, const std::vector<RatingOutput>& ratingOutput_)
+{
+    const std::size_t maxPreparedTariffs = m_options.getMaxPreparedTariffs();
+    const std::size_t fingerprint = maxPreparedTariffs > 0 ? getFingerprint(ratingFormulas_, ratingOutput_) : 0;
+    if (maxPreparedTariffs > 0) {
+        std::shared_ptr<const CachedTariff> cachedTariff;
+        {
+            std::lock_guard<std::mutex> lock(m_cachedTariffsMutex);
+            auto range = m_cachedTariffsByKey.equal_range(insuranceRateKey_);
+            for (auto it = range.first; it != range.second; ++it) {
+                if ((*it->second)->fingerprint == fingerprint) {
+                    m_cachedTariffs.splice(m_cachedTariffs.begin(), m_cachedTariffs, it->second);
+                    cachedTariff = *it->second;
+                    break;
+                }
             }
         }
-
-        // sort rating output by sort order
-        std::vector<RatingOutput> ratingOutput(ratingOutput_);
-        std::sort(ratingOutput.begin(), ratingOutput.end(), [](const RatingOutput & lhs_, const RatingOutput & rhs_) {
-            return lhs_.getSortOrder() < rhs_.getSortOrder();
-        });
-
-        Parser parser(parsingContext);
-        RatingEngine::Map_t result;
-
-        LOG4CPLUS_DEBUG(m_logger, "start parsing");
-        const std::chrono::time_point<Clock_t> startTime = Clock_t::now();
-
-        // calculate every requested output variable
-        for (const RatingOutput& output : ratingOutput) {
-            const std::string& variableName = output.getVariableName();
-            const std::string& instanceId = output.getInstanceId();
-            parsingContext->setCurrentRatingoutputVariable(variableName);
-            parsingContext->setInstanceId(instanceId);
-
-            log4cplus::NDCContextCreator ndc((!instanceId.empty() ? instanceId + ' ' : std::string()) + variableName);
-
-            Value value = parser.parse(variableName, output.getFormula());
-            LOG4CPLUS_DEBUG(m_logger, "result=" << value);
-
-            // add the calculated value to the parsing context
-            parsingContext->addCalculatedVariable(variableName, value);
-            // add the calculated value to the result container
-            addValueToResult(value, result, output);
+        if (cachedTariff && cachedTariff->ratingFormulas == ratingFormulas_ && isSameRatingOutput(cachedTariff->ratingOutput, ratingOutput_)) {
+            return cachedTariff->preparedTariff;
         }
-        const std::chrono::time_point<Clock_t> endTime = Clock_t::now();
-        LOG4CPLUS_DEBUG(m_logger, "end parsing/calculate " << std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime).count() << "ms, thereof function durations=" << parsingContext->getFunctionDurationsMicroSecs() / 1000 << "ms");
+    }
 
-        return std::move(result);
+    // prepared outside of the lock, concurrent calls with the same formulas may prepare the tariff more than once
+    std::shared_ptr<const PreparedTariff> preparedTariff(std::make_shared<PreparedTariff>(m_functions, m_functionResultCache, m_parseTreeCache, m_options, m_threadPool, m_logger,
+                                                                                          insuranceRateKey_, ratingFormulas_, ratingOutput_));
+    if (maxPreparedTariffs == 0) {
+        return preparedTariff;
+    }
+    std::shared_ptr<const CachedTariff> cachedTariff(std::make_shared<CachedTariff>(CachedTariff{ insuranceRateKey_, fingerprint, ratingFormulas_, ratingOutput_, preparedTariff }));
+
+    // the tariffs are destroyed outside of the lock
+    CachedTariffList_t evicted;
+    std::lock_guard<std::mutex> lock(m_cachedTariffsMutex);
+    // a tariff with the same fingerprint is replaced, so a lookup finds at most one
+    auto range = m_cachedTariffsByKey.equal_range(insuranceRateKey_);
+    for (auto it = range.first; it != range.second; ++it) {
+        if ((*it->second)->fingerprint == fingerprint) {
+            evicted.splice(evicted.end(), m_cachedTariffs, it->second);
+            m_cachedTariffsByKey.erase(it);
+            break;
+        }
     }
-    catch (...) {
-        LOG4CPLUS_DEBUG(m_logger, "end calculate");
-        throw;
+    m_cachedTariffs.push_front(cachedTariff);
+    m_cachedTariffsByKey.emplace(insuranceRateKey_, m_cachedTariffs.begin());
+    while (m_cachedTariffs.size() > maxPreparedTariffs) {
+        const CachedTariffList_t::iterator last = std::prev(m_cachedTariffs.end());
+        range = m_cachedTariffsByKey.equal_range((*last)->insuranceRateKey);
+        for (auto it = range.first; it != range.second; ++it) {
+            if (it->second == last) {
+                m_cachedTariffsByKey.erase(it);
+                break;
+            }
+        }
+        evicted.splice(evicted.end(), m_cachedTariffs, last);
     }
+    return preparedTariff;
 }
 
 } // namespace CalculusPrime
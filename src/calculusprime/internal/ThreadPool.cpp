@@ -0,0 +1,117 @@
+/*
+Copyright 2019 Association for the promotion of open - source insurance software and for the establishment of open interface standards in the insurance industry
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http ://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <calculusprime/internal/ThreadPool.h>
+#include <algorithm>
+
+namespace CalculusPrime {
+
+ThreadPool::ThreadPool(std::size_t numberOfWorkers_)
+    : m_stopped(false)
+{
+    for (std::size_t i = 0; i < numberOfWorkers_; ++i) {
+        m_workers.emplace_back([this]() {
+            work();
+        });
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopped = true;
+    }
+    m_batchAvailable.notify_all();
+    for (std::thread& worker : m_workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::run(std::size_t numberOfTasks_, const Task_t& task_)
+{
+    if (numberOfTasks_ == 0) {
+        return;
+    }
+
+    std::shared_ptr<Batch> batch(std::make_shared<Batch>(numberOfTasks_, task_));
+    if (numberOfTasks_ > 1 && !m_workers.empty()) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_batches.push_back(batch);
+        }
+        m_batchAvailable.notify_all();
+    }
+
+    // the calling thread works on its own batch
+    runTasks(*batch);
+
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_batches.erase(std::remove(m_batches.begin(), m_batches.end(), batch), m_batches.end());
+        m_batchCompleted.wait(lock, [&batch]() {
+            return batch->completedTasks == batch->numberOfTasks;
+        });
+    }
+
+    for (const std::exception_ptr& exception : batch->exceptions) {
+        if (exception) {
+            std::rethrow_exception(exception);
+        }
+    }
+}
+
+void ThreadPool::runTasks(Batch& batch_)
+{
+    for (std::size_t i = batch_.nextTask++; i < batch_.numberOfTasks; i = batch_.nextTask++) {
+        try {
+            batch_.task(i);
+        }
+        catch (...) {
+            batch_.exceptions[i] = std::current_exception();
+        }
+
+        if (++batch_.completedTasks == batch_.numberOfTasks) {
+            // the mutex orders the notification after the check of the waiting thread
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_batchCompleted.notify_all();
+        }
+    }
+}
+
+void ThreadPool::work()
+{
+    for (;;) {
+        std::shared_ptr<Batch> batch;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_batchAvailable.wait(lock, [this]() {
+                return m_stopped || !m_batches.empty();
+            });
+            if (m_stopped) {
+                return;
+            }
+            batch = m_batches.front();
+            // a batch without unclaimed tasks is removed, the others are shared with the next free worker
+            if (batch->nextTask >= batch->numberOfTasks) {
+                m_batches.pop_front();
+                continue;
+            }
+        }
+        runTasks(*batch);
+    }
+}
+
+} // namespace CalculusPrime
@@ -0,0 +1,220 @@
+/*
+Copyright 2019 Association for the promotion of open - source insurance software and for the establishment of open interface standards in the insurance industry
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http ://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <calculusprime/internal/compiler/BytecodeCompiler.h>
+#include <algorithm>
+#include <vector>
+#include <calculusprime/internal/compiler/Operations.h>
+
+namespace CalculusPrime {
+
+namespace {
+
+// returns if the node is compiled to a binary instruction (most of them have an unboxed fast path for numbers)
+bool getBinaryOp(OpCode opCode_, BytecodeOp& op_)
+{
+    switch (opCode_) {
+    case OpCode::ADD:
+        op_ = BytecodeOp::ADD;
+        return true;
+    case OpCode::SUBTRACT:
+        op_ = BytecodeOp::SUBTRACT;
+        return true;
+    case OpCode::MULTIPLY:
+        op_ = BytecodeOp::MULTIPLY;
+        return true;
+    case OpCode::DIVIDE:
+        op_ = BytecodeOp::DIVIDE;
+        return true;
+    case OpCode::POWER:
+        op_ = BytecodeOp::POWER;
+        return true;
+    case OpCode::GT_EQ:
+        op_ = BytecodeOp::GT_EQ;
+        return true;
+    case OpCode::LT_EQ:
+        op_ = BytecodeOp::LT_EQ;
+        return true;
+    case OpCode::GT:
+        op_ = BytecodeOp::GT;
+        return true;
+    case OpCode::LT:
+        op_ = BytecodeOp::LT;
+        return true;
+    case OpCode::EQ:
+        op_ = BytecodeOp::EQ;
+        return true;
+    case OpCode::NOT_EQ:
+        op_ = BytecodeOp::NOT_EQ;
+        return true;
+    case OpCode::AND:
+        op_ = BytecodeOp::AND;
+        return true;
+    case OpCode::OR:
+        op_ = BytecodeOp::OR;
+        return true;
+    default:
+        return false;
+    }
+}
+}
+
+std::shared_ptr<const BytecodeProgram> BytecodeCompiler::compile(const CompiledFormula& compiledFormula_)
+{
+    std::shared_ptr<BytecodeProgram> program = std::make_shared<BytecodeProgram>();
+    BytecodeCompiler compiler(compiledFormula_, *program);
+    compiler.compileBlock(compiledFormula_.getRoot());
+    program->addInstruction(BytecodeOp::END, 0, 0, 0, compiledFormula_.getRoot());
+    return program;
+}
+
+std::uint32_t BytecodeCompiler::allocateRegisters(std::uint32_t count_)
+{
+    const std::uint32_t first = m_nextRegister;
+    m_nextRegister += count_;
+    m_program.setNumberOfRegisters(std::max(m_program.getNumberOfRegisters(), m_nextRegister));
+    return first;
+}
+
+void BytecodeCompiler::compileBlock(std::uint32_t node_)
+{
+    const CompiledFormula::Node& node = m_compiledFormula.getNode(node_);
+
+    switch (node.opCode) {
+    case OpCode::RETURN:
+    case OpCode::ERROR_CALL: {
+        const std::uint32_t reg = allocateRegisters(1);
+        compileExpression(m_compiledFormula.getOperand(node, 0), reg);
+        m_program.addInstruction(node.opCode == OpCode::RETURN ? BytecodeOp::RETURN : BytecodeOp::ERROR_CALL, 0, reg, 0, node_);
+        releaseRegisters(1);
+        break;
+    }
+
+    case OpCode::IF: {
+        // jumps to the end of the if statement
+        std::vector<std::uint32_t> endJumps;
+
+        const std::size_t numConditions = (node.numOperands - node.data) / 2;
+        for (std::size_t i = 0; i < numConditions; ++i) {
+            const std::uint32_t reg = allocateRegisters(1);
+            compileExpression(m_compiledFormula.getOperand(node, 2 * i), reg);
+            const std::uint32_t nextCondition = m_program.addInstruction(BytecodeOp::JUMP_IF_FALSE, 0, reg, 0, node_);
+            releaseRegisters(1);
+
+            const std::uint32_t block = m_compiledFormula.getOperand(node, 2 * i + 1);
+            compileBlock(block);
+            // Return and Error do not continue, all other blocks continue after the if statement
+            const OpCode blockOpCode = m_compiledFormula.getNode(block).opCode;
+            if (blockOpCode != OpCode::RETURN && blockOpCode != OpCode::ERROR_CALL) {
+                endJumps.push_back(m_program.addInstruction(BytecodeOp::JUMP, 0, 0, 0, node_));
+            }
+            m_program.setJumpTarget(nextCondition, m_program.getNextAddress());
+        }
+
+        if (node.data != 0) {
+            compileBlock(m_compiledFormula.getOperand(node, node.numOperands - 1));
+        }
+
+        for (std::uint32_t jump : endJumps) {
+            m_program.setJumpTarget(jump, m_program.getNextAddress());
+        }
+        break;
+    }
+
+    default:
+        compileExpression(node_, allocateRegisters(1));
+        releaseRegisters(1);
+        break;
+    }
+}
+
+void BytecodeCompiler::compileExpression(std::uint32_t node_, std::uint32_t dst_)
+{
+    const CompiledFormula::Node& node = m_compiledFormula.getNode(node_);
+    BytecodeOp binaryOp;
+
+    switch (node.opCode) {
+    case OpCode::CONSTANT: {
+        const Value& constant = m_compiledFormula.getConstant(node.data);
+        if (constant.isDouble()) {
+            m_program.addInstruction(BytecodeOp::LOAD_NUMBER, dst_, m_program.addNumber(constant.asDouble()), 0, node_);
+        }
+        else {
+            m_program.addInstruction(BytecodeOp::LOAD_CONSTANT, dst_, node.data, 0, node_);
+        }
+        break;
+    }
+
+    case OpCode::IDENTIFIER:
+        m_program.addInstruction(BytecodeOp::LOAD_VARIABLE, dst_, node.data, 0, node_);
+        break;
+
+    case OpCode::NEGATE:
+        compileExpression(m_compiledFormula.getOperand(node, 0), dst_);
+        m_program.addInstruction(BytecodeOp::NEGATE, dst_, dst_, 0, node_);
+        break;
+
+    case OpCode::CALL: {
+        // an unknown function is reported before the arguments are evaluated
+        m_program.addInstruction(BytecodeOp::FIND_FUNCTION, 0, node.data, 0, node_);
+        const std::uint32_t first = compileOperands(node_);
+        m_program.addInstruction(BytecodeOp::CALL, dst_, first, node.data, node_);
+        releaseRegisters(node.numOperands);
+        break;
+    }
+
+    default:
+        if (getBinaryOp(node.opCode, binaryOp)) {
+            // the left operand is computed in the destination register
+            compileExpression(m_compiledFormula.getOperand(node, 0), dst_);
+            // And and Or skip the right operand at runtime if the engine uses short circuit evaluation,
+            // the left operand is the result then. So the cached bytecode serves both evaluation modes.
+            const bool isLogical = binaryOp == BytecodeOp::AND || binaryOp == BytecodeOp::OR;
+            std::uint32_t shortCircuit = 0;
+            if (isLogical) {
+                shortCircuit = m_program.addInstruction(binaryOp == BytecodeOp::AND ? BytecodeOp::SHORT_CIRCUIT_AND : BytecodeOp::SHORT_CIRCUIT_OR, 0, dst_, 0, node_);
+            }
+            const std::uint32_t rhs = allocateRegisters(1);
+            compileExpression(m_compiledFormula.getOperand(node, 1), rhs);
+            m_program.addInstruction(binaryOp, dst_, dst_, rhs, node_);
+            releaseRegisters(1);
+            if (isLogical) {
+                m_program.setJumpTarget(shortCircuit, m_program.getNextAddress());
+            }
+        }
+        else {
+            const std::uint32_t first = compileOperands(node_);
+            m_program.addInstruction(BytecodeOp::APPLY, dst_, first, 0, node_);
+            releaseRegisters(node.numOperands);
+        }
+        break;
+    }
+}
+
+std::uint32_t BytecodeCompiler::compileOperands(std::uint32_t node_)
+{
+    const CompiledFormula::Node& node = m_compiledFormula.getNode(node_);
+    const bool hasOperandChecks = Operations::hasOperandChecks(node.opCode);
+    const std::uint32_t first = allocateRegisters(node.numOperands);
+    for (std::uint32_t i = 0; i < node.numOperands; ++i) {
+        compileExpression(m_compiledFormula.getOperand(node, i), first + i);
+        if (hasOperandChecks && i + 1 < node.numOperands) {
+            m_program.addInstruction(BytecodeOp::CHECK_OPERAND, 0, first + i, i, node_);
+        }
+    }
+    return first;
+}
+
+} // namespace CalculusPrime
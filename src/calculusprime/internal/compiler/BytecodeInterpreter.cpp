@@ -0,0 +1,392 @@
+/*
+Copyright 2019 Association for the promotion of open - source insurance software and for the establishment of open interface standards in the insurance industry
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http ://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <calculusprime/internal/compiler/BytecodeInterpreter.h>
+#include <cmath>
+#include <vector>
+#include <boost/container/small_vector.hpp>
+#include <boost/throw_exception.hpp>
+#include <calculusprime/RatingEngineException.h>
+#include <calculusprime/internal/ParsingContext.h>
+#include <calculusprime/internal/compiler/Operations.h>
+#include <calculusprime/internal/parsing/EvalException.h>
+
+namespace CalculusPrime {
+
+namespace {
+
+//! \brief a register of the VM, numbers are stored unboxed
+struct Register
+{
+    Register()
+        : isNumber(false)
+        , number(0.0)
+    {
+    }
+
+    void setNumber(double number_)
+    {
+        isNumber = true;
+        number = number_;
+    }
+
+    void setValue(const Value& value_)
+    {
+        if (!value_.isVoid() && value_.isDouble()) {
+            setNumber(value_.asDouble());
+        }
+        else {
+            isNumber = false;
+            value = value_;
+        }
+    }
+
+    Value toValue() const
+    {
+        return isNumber ? Value(number) : value;
+    }
+
+    bool isNumber;
+    double number;
+    Value value;
+};
+
+// the same tolerance as operator== of Value
+inline bool numbersEqual(double lhs_, double rhs_)
+{
+    return std::abs(lhs_ - rhs_) < 0.00000000001;
+}
+
+// the values of numOperands_ consecutive registers
+inline void toValues(const Register* registers_, std::size_t numOperands_, Value* values_)
+{
+    for (std::size_t i = 0; i < numOperands_; ++i) {
+        values_[i] = registers_[i].toValue();
+    }
+}
+}
+
+boost::optional<Value> BytecodeInterpreter::execute()
+{
+    typedef boost::container::small_vector<Register, 16> Registers_t;
+    typedef boost::container::small_vector<IFunction*, 4> Functions_t;
+
+    const BytecodeProgram& program = *m_compiledFormula.getBytecode();
+    const BytecodeProgram::Instruction* const code = program.getInstructions().data();
+    const double* const numbers = program.getNumbers().data();
+    Registers_t registers(program.getNumberOfRegisters());
+    Register* const r = registers.data();
+    // the functions found by FIND_FUNCTION, by call site
+    Functions_t functions(m_compiledFormula.getNumberOfCallSites());
+    const bool shortCircuitEvaluation = m_parsingContext->isShortCircuitEvaluation();
+
+    const BytecodeProgram::Instruction* instruction = code;
+
+    // falls back to Operations for all operands which are not numbers, this also reports the errors
+    auto applyBoxed = [&](std::size_t numOperands_) {
+        Value operands[3];
+        toValues(&r[instruction->a], numOperands_, operands);
+        r[instruction->dst].setValue(Operations::apply(m_compiledFormula, instruction->node, operands));
+    };
+
+    auto binaryBoxed = [&]() {
+        Value operands[2] = { r[instruction->a].toValue(), r[instruction->b].toValue() };
+        r[instruction->dst].setValue(Operations::apply(m_compiledFormula, instruction->node, operands));
+    };
+
+#ifdef CP_BYTECODE_COMPUTED_GOTO
+#define CP_LABEL_ADDRESS(op) &&op_##op,
+    static void* const dispatchTable[] = { CP_BYTECODE_OPS(CP_LABEL_ADDRESS) };
+#undef CP_LABEL_ADDRESS
+#define CP_OP(op) op_##op
+#define CP_NEXT() goto *dispatchTable[static_cast<std::size_t>(instruction->op)]
+    CP_NEXT();
+    {
+#else
+#define CP_OP(op) case BytecodeOp::op
+#define CP_NEXT() continue
+    for (;;) {
+        switch (instruction->op) {
+#endif
+        CP_OP(LOAD_NUMBER): {
+            r[instruction->dst].setNumber(numbers[instruction->a]);
+            ++instruction;
+            CP_NEXT();
+        }
+
+        CP_OP(LOAD_CONSTANT): {
+            r[instruction->dst].setValue(m_compiledFormula.getConstant(instruction->a));
+            ++instruction;
+            CP_NEXT();
+        }
+
+        CP_OP(LOAD_VARIABLE): {
+            const std::string& identifier = m_compiledFormula.getIdentifier(instruction->a);
+            r[instruction->dst].setValue(m_slots != nullptr ? m_parsingContext->resolve(m_slots[instruction->a], identifier) : m_parsingContext->resolve(identifier));
+            ++instruction;
+            CP_NEXT();
+        }
+
+        CP_OP(NEGATE): {
+            if (r[instruction->a].isNumber) {
+                r[instruction->dst].setNumber(-r[instruction->a].number);
+            }
+            else {
+                applyBoxed(1);
+            }
+            ++instruction;
+            CP_NEXT();
+        }
+
+        CP_OP(ADD): {
+            if (r[instruction->a].isNumber && r[instruction->b].isNumber) {
+                r[instruction->dst].setNumber(r[instruction->a].number + r[instruction->b].number);
+            }
+            else {
+                binaryBoxed();
+            }
+            ++instruction;
+            CP_NEXT();
+        }
+
+        CP_OP(SUBTRACT): {
+            if (r[instruction->a].isNumber && r[instruction->b].isNumber) {
+                r[instruction->dst].setNumber(r[instruction->a].number - r[instruction->b].number);
+            }
+            else {
+                binaryBoxed();
+            }
+            ++instruction;
+            CP_NEXT();
+        }
+
+        CP_OP(MULTIPLY): {
+            if (r[instruction->a].isNumber && r[instruction->b].isNumber) {
+                r[instruction->dst].setNumber(r[instruction->a].number * r[instruction->b].number);
+            }
+            else {
+                binaryBoxed();
+            }
+            ++instruction;
+            CP_NEXT();
+        }
+
+        CP_OP(DIVIDE): {
+            if (r[instruction->a].isNumber && r[instruction->b].isNumber) {
+                const double result = r[instruction->a].number / r[instruction->b].number;
+                if (std::isinf(result)) {
+                    BOOST_THROW_EXCEPTION(RatingEngineException(RatingEngineError::DIVISION_BY_ZERO));
+                }
+                r[instruction->dst].setNumber(result);
+            }
+            else {
+                binaryBoxed();
+            }
+            ++instruction;
+            CP_NEXT();
+        }
+
+        CP_OP(POWER): {
+            if (r[instruction->a].isNumber && r[instruction->b].isNumber) {
+                r[instruction->dst].setNumber(std::pow(r[instruction->a].number, r[instruction->b].number));
+            }
+            else {
+                binaryBoxed();
+            }
+            ++instruction;
+            CP_NEXT();
+        }
+
+        CP_OP(GT_EQ): {
+            if (r[instruction->a].isNumber && r[instruction->b].isNumber) {
+                r[instruction->dst].setValue(Value(r[instruction->a].number >= r[instruction->b].number));
+            }
+            else {
+                binaryBoxed();
+            }
+            ++instruction;
+            CP_NEXT();
+        }
+
+        CP_OP(LT_EQ): {
+            if (r[instruction->a].isNumber && r[instruction->b].isNumber) {
+                r[instruction->dst].setValue(Value(r[instruction->a].number <= r[instruction->b].number));
+            }
+            else {
+                binaryBoxed();
+            }
+            ++instruction;
+            CP_NEXT();
+        }
+
+        CP_OP(GT): {
+            if (r[instruction->a].isNumber && r[instruction->b].isNumber) {
+                r[instruction->dst].setValue(Value(r[instruction->a].number > r[instruction->b].number));
+            }
+            else {
+                binaryBoxed();
+            }
+            ++instruction;
+            CP_NEXT();
+        }
+
+        CP_OP(LT): {
+            if (r[instruction->a].isNumber && r[instruction->b].isNumber) {
+                r[instruction->dst].setValue(Value(r[instruction->a].number < r[instruction->b].number));
+            }
+            else {
+                binaryBoxed();
+            }
+            ++instruction;
+            CP_NEXT();
+        }
+
+        CP_OP(EQ): {
+            if (r[instruction->a].isNumber && r[instruction->b].isNumber) {
+                r[instruction->dst].setValue(Value(numbersEqual(r[instruction->a].number, r[instruction->b].number)));
+            }
+            else {
+                binaryBoxed();
+            }
+            ++instruction;
+            CP_NEXT();
+        }
+
+        CP_OP(NOT_EQ): {
+            if (r[instruction->a].isNumber && r[instruction->b].isNumber) {
+                r[instruction->dst].setValue(Value(!numbersEqual(r[instruction->a].number, r[instruction->b].number)));
+            }
+            else {
+                binaryBoxed();
+            }
+            ++instruction;
+            CP_NEXT();
+        }
+
+        CP_OP(AND): {
+            binaryBoxed();
+            ++instruction;
+            CP_NEXT();
+        }
+
+        CP_OP(OR): {
+            binaryBoxed();
+            ++instruction;
+            CP_NEXT();
+        }
+
+        CP_OP(CHECK_OPERAND): {
+            Operations::checkOperand(m_compiledFormula, instruction->node, instruction->b, r[instruction->a].toValue());
+            ++instruction;
+            CP_NEXT();
+        }
+
+        CP_OP(APPLY): {
+            applyBoxed(m_compiledFormula.getNode(instruction->node).numOperands);
+            ++instruction;
+            CP_NEXT();
+        }
+
+        CP_OP(FIND_FUNCTION): {
+            try {
+                functions[instruction->a] = Operations::findFunction(m_parsingContext, m_compiledFormula, instruction->node, m_functions != nullptr ? m_functions[instruction->a] : nullptr);
+            }
+            catch (const std::exception& ex) {
+                BOOST_THROW_EXCEPTION(EvalException(ex.what(), m_compiledFormula, instruction->node));
+            }
+            ++instruction;
+            CP_NEXT();
+        }
+
+        CP_OP(CALL): {
+            try {
+                const CompiledFormula::Node& node = m_compiledFormula.getNode(instruction->node);
+                ArgumentStack::Frame frame(m_parsingContext->getArgumentStack(), node.numOperands);
+                std::vector<Value>& arguments = frame.getArguments();
+                toValues(&r[instruction->a], arguments.size(), arguments.data());
+                r[instruction->dst].setValue(Operations::callFunction(m_parsingContext, m_compiledFormula, instruction->node, *functions[instruction->b], arguments));
+            }
+            catch (const RatingEngineException&) {
+                throw;
+            }
+            catch (const std::exception& ex) {
+                BOOST_THROW_EXCEPTION(EvalException(ex.what(), m_compiledFormula, instruction->node));
+            }
+            ++instruction;
+            CP_NEXT();
+        }
+
+        CP_OP(JUMP): {
+            instruction = code + instruction->a;
+            CP_NEXT();
+        }
+
+        CP_OP(JUMP_IF_FALSE): {
+            // conditions must be bool, asBool() reports all other types
+            const Register& condition = r[instruction->a];
+            if (!(condition.isNumber ? Value(condition.number) : condition.value).asBool()) {
+                instruction = code + instruction->b;
+            }
+            else {
+                ++instruction;
+            }
+            CP_NEXT();
+        }
+
+        CP_OP(SHORT_CIRCUIT_AND): {
+            const Register& lhs = r[instruction->a];
+            if (shortCircuitEvaluation && !lhs.isNumber && !lhs.value.isVoid() && lhs.value.isBool() && !lhs.value.asBool()) {
+                instruction = code + instruction->b;
+            }
+            else {
+                ++instruction;
+            }
+            CP_NEXT();
+        }
+
+        CP_OP(SHORT_CIRCUIT_OR): {
+            const Register& lhs = r[instruction->a];
+            if (shortCircuitEvaluation && !lhs.isNumber && !lhs.value.isVoid() && lhs.value.isBool() && lhs.value.asBool()) {
+                instruction = code + instruction->b;
+            }
+            else {
+                ++instruction;
+            }
+            CP_NEXT();
+        }
+
+        CP_OP(RETURN): {
+            return r[instruction->a].toValue();
+        }
+
+        CP_OP(ERROR_CALL): {
+            applyBoxed(1);
+            ++instruction;
+            CP_NEXT();
+        }
+
+        CP_OP(END): {
+            return boost::none;
+        }
+#ifndef CP_BYTECODE_COMPUTED_GOTO
+        }
+#endif
+    }
+
+#undef CP_OP
+#undef CP_NEXT
+}
+
+} // namespace CalculusPrime
@@ -0,0 +1,428 @@
+/*
+Copyright 2019 Association for the promotion of open - source insurance software and for the establishment of open interface standards in the insurance industry
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http ://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#define NOMINMAX
+#include <calculusprime/internal/compiler/ColumnarEvaluator.h>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace CalculusPrime {
+
+namespace {
+
+inline bool any(const std::uint8_t* mask_, std::size_t n_)
+{
+    return std::find(mask_, mask_ + n_, 1) != mask_ + n_;
+}
+
+// the same rounding as the scalar RND
+inline double roundTo(double value_, double places_)
+{
+    if (places_ >= 0) {
+        int x = 1;
+        for (double d = 0; d < places_; d += 1.0) {
+            x *= 10;
+        }
+        return std::round(value_ * x) / x;
+    }
+    else {
+        int x = 1;
+        for (double d = 0; d > places_; d -= 1.0) {
+            x *= 10;
+        }
+        return std::round(value_ / x) * x;
+    }
+}
+}
+
+const std::size_t ColumnarEvaluator::BLOCK_SIZE;
+
+bool ColumnarEvaluator::isColumnar(const CompiledFormula& compiledFormula_)
+{
+    return compiledFormula_.getNumberOfNodes() != 0 && isColumnarBlock(compiledFormula_, compiledFormula_.getRoot());
+}
+
+bool ColumnarEvaluator::isColumnarBlock(const CompiledFormula& compiledFormula_, std::uint32_t index_)
+{
+    const CompiledFormula::Node& node = compiledFormula_.getNode(index_);
+
+    switch (node.opCode) {
+    case OpCode::RETURN:
+        return getType(compiledFormula_, compiledFormula_.getOperand(node, 0)) == Type::NUMBER;
+
+    case OpCode::IF: {
+        const std::size_t numConditions = (node.numOperands - node.data) / 2;
+        for (std::size_t i = 0; i < numConditions; ++i) {
+            if (getType(compiledFormula_, compiledFormula_.getOperand(node, 2 * i)) != Type::BOOL ||
+                !isColumnarBlock(compiledFormula_, compiledFormula_.getOperand(node, 2 * i + 1))) {
+                return false;
+            }
+        }
+        return node.data == 0 || isColumnarBlock(compiledFormula_, compiledFormula_.getOperand(node, node.numOperands - 1));
+    }
+
+    case OpCode::ERROR_CALL:
+        // the lanes are evaluated by the scalar backend, which cancels the calculation
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+ColumnarEvaluator::Type ColumnarEvaluator::getType(const CompiledFormula& compiledFormula_, std::uint32_t index_)
+{
+    const CompiledFormula::Node& node = compiledFormula_.getNode(index_);
+
+    Type operandType = Type::INVALID;
+    for (std::size_t i = 0; i < node.numOperands; ++i) {
+        const Type type = getType(compiledFormula_, compiledFormula_.getOperand(node, i));
+        if (type == Type::INVALID || (i != 0 && type != operandType)) {
+            return Type::INVALID;
+        }
+        operandType = type;
+    }
+
+    switch (node.opCode) {
+    case OpCode::CONSTANT: {
+        const Value& constant = compiledFormula_.getConstant(node.data);
+        if (constant.isVoid() || constant.isString()) {
+            return Type::INVALID;
+        }
+        return constant.isDouble() ? Type::NUMBER : Type::BOOL;
+    }
+
+    case OpCode::IDENTIFIER:
+        // the caller only passes lanes whose variables are numbers
+        return Type::NUMBER;
+
+    case OpCode::NEGATE:
+    case OpCode::POWER:
+    case OpCode::MULTIPLY:
+    case OpCode::DIVIDE:
+    case OpCode::ADD:
+    case OpCode::SUBTRACT:
+    case OpCode::MODULO:
+    case OpCode::MAX:
+    case OpCode::MIN:
+    case OpCode::ROUND:
+    case OpCode::CEIL:
+    case OpCode::FLOOR:
+    case OpCode::EXP:
+        return operandType == Type::NUMBER ? Type::NUMBER : Type::INVALID;
+
+    case OpCode::GT_EQ:
+    case OpCode::LT_EQ:
+    case OpCode::GT:
+    case OpCode::LT:
+        return operandType == Type::NUMBER ? Type::BOOL : Type::INVALID;
+
+    case OpCode::EQ:
+    case OpCode::NOT_EQ:
+        // numbers or bools, both operands have the same type
+        return Type::BOOL;
+
+    case OpCode::NOT:
+    case OpCode::AND:
+    case OpCode::OR:
+        return operandType == Type::BOOL ? Type::BOOL : Type::INVALID;
+
+    default:
+        // strings, dates and function calls
+        return Type::INVALID;
+    }
+}
+
+void ColumnarEvaluator::evaluate(const double* const* columns_, std::size_t numberOfLanes_, double* results_, std::uint8_t* fallback_)
+{
+    m_variables = columns_;
+    m_results = results_;
+
+    for (std::size_t first = 0; first < numberOfLanes_; first += BLOCK_SIZE) {
+        const std::size_t n = std::min(BLOCK_SIZE, numberOfLanes_ - first);
+        m_firstLane = first;
+        m_numberOfLanes = n;
+
+        std::uint8_t* const active = pushMask();
+        for (std::size_t i = 0; i < n; ++i) {
+            active[i] = fallback_[first + i] == 0 ? 1 : 0;
+        }
+        std::fill(m_returned, m_returned + n, 0);
+        std::fill(m_failed, m_failed + n, 0);
+
+        executeBlock(m_compiledFormula.getRoot(), active);
+        popMask();
+
+        for (std::size_t i = 0; i < n; ++i) {
+            fallback_[first + i] |= m_failed[i] | (m_returned[i] ^ 1);
+        }
+    }
+}
+
+void ColumnarEvaluator::executeBlock(std::uint32_t index_, const std::uint8_t* active_)
+{
+    const CompiledFormula::Node& node = m_compiledFormula.getNode(index_);
+    const std::size_t n = m_numberOfLanes;
+
+    switch (node.opCode) {
+    case OpCode::RETURN: {
+        double* const value = pushColumn();
+        evaluate(m_compiledFormula.getOperand(node, 0), value, active_);
+        double* const results = m_results + m_firstLane;
+        for (std::size_t i = 0; i < n; ++i) {
+            results[i] = active_[i] != 0 ? value[i] : results[i];
+            m_returned[i] |= active_[i];
+        }
+        popColumn();
+        break;
+    }
+
+    case OpCode::IF: {
+        // every lane takes the first branch whose condition is true
+        const std::size_t numConditions = (node.numOperands - node.data) / 2;
+        std::uint8_t* const remaining = pushMask();
+        std::uint8_t* const taken = pushMask();
+        double* const condition = pushColumn();
+        std::copy(active_, active_ + n, remaining);
+
+        for (std::size_t c = 0; c < numConditions && any(remaining, n); ++c) {
+            evaluate(m_compiledFormula.getOperand(node, 2 * c), condition, remaining);
+            for (std::size_t i = 0; i < n; ++i) {
+                taken[i] = remaining[i] & (condition[i] != 0.0 ? 1 : 0);
+                remaining[i] &= taken[i] ^ 1;
+            }
+            if (any(taken, n)) {
+                executeBlock(m_compiledFormula.getOperand(node, 2 * c + 1), taken);
+            }
+        }
+
+        // else ...
+        if (node.data != 0 && any(remaining, n)) {
+            executeBlock(m_compiledFormula.getOperand(node, node.numOperands - 1), remaining);
+        }
+
+        popColumn();
+        popMask();
+        popMask();
+        break;
+    }
+
+    default:
+        // Error(code) cancels the calculation of all active lanes
+        for (std::size_t i = 0; i < n; ++i) {
+            m_failed[i] |= active_[i];
+        }
+        break;
+    }
+}
+
+void ColumnarEvaluator::evaluate(std::uint32_t index_, double* column_, const std::uint8_t* active_)
+{
+    const CompiledFormula::Node& node = m_compiledFormula.getNode(index_);
+    const std::size_t n = m_numberOfLanes;
+    double* const out = column_;
+    std::uint8_t* const failed = m_failed;
+
+    if (node.opCode == OpCode::CONSTANT) {
+        const Value& constant = m_compiledFormula.getConstant(node.data);
+        std::fill(out, out + n, constant.isDouble() ? constant.asDouble() : (constant.asBool() ? 1.0 : 0.0));
+        return;
+    }
+    if (node.opCode == OpCode::IDENTIFIER) {
+        const double* const variable = m_variables[node.data] + m_firstLane;
+        std::copy(variable, variable + n, out);
+        return;
+    }
+
+    // the first operand is evaluated into the result column, the operators work in place
+    evaluate(m_compiledFormula.getOperand(node, 0), out, active_);
+
+    if (node.numOperands == 1) {
+        switch (node.opCode) {
+        case OpCode::NEGATE:
+            for (std::size_t i = 0; i < n; ++i) {
+                out[i] = -1 * out[i];
+            }
+            break;
+
+        case OpCode::NOT:
+            for (std::size_t i = 0; i < n; ++i) {
+                out[i] = out[i] != 0.0 ? 0.0 : 1.0;
+            }
+            break;
+
+        case OpCode::CEIL:
+            for (std::size_t i = 0; i < n; ++i) {
+                out[i] = std::ceil(out[i]);
+            }
+            break;
+
+        case OpCode::FLOOR:
+            for (std::size_t i = 0; i < n; ++i) {
+                out[i] = std::floor(out[i]);
+            }
+            break;
+
+        default: // EXP
+            // overflow and underflow are reported as range errors by the scalar backends
+            for (std::size_t i = 0; i < n; ++i) {
+                const double result = std::exp(out[i]);
+                failed[i] |= active_[i] & (result >= DBL_MIN && result <= DBL_MAX ? 0 : 1);
+                out[i] = result;
+            }
+            break;
+        }
+        return;
+    }
+
+    double* const rhs = pushColumn();
+    evaluate(m_compiledFormula.getOperand(node, 1), rhs, active_);
+
+    switch (node.opCode) {
+    case OpCode::POWER:
+        for (std::size_t i = 0; i < n; ++i) {
+            out[i] = std::pow(out[i], rhs[i]);
+        }
+        break;
+
+    case OpCode::MULTIPLY:
+        for (std::size_t i = 0; i < n; ++i) {
+            out[i] = out[i] * rhs[i];
+        }
+        break;
+
+    case OpCode::DIVIDE:
+        for (std::size_t i = 0; i < n; ++i) {
+            const double result = out[i] / rhs[i];
+            failed[i] |= active_[i] & (std::isinf(result) ? 1 : 0);
+            out[i] = result;
+        }
+        break;
+
+    case OpCode::ADD:
+        for (std::size_t i = 0; i < n; ++i) {
+            out[i] = out[i] + rhs[i];
+        }
+        break;
+
+    case OpCode::SUBTRACT:
+        for (std::size_t i = 0; i < n; ++i) {
+            out[i] = out[i] - rhs[i];
+        }
+        break;
+
+    case OpCode::MODULO:
+        // the scalar backends report the invalid operations as division by zero
+        for (std::size_t i = 0; i < n; ++i) {
+            failed[i] |= active_[i] & (rhs[i] == 0.0 || !std::isfinite(out[i]) || std::isnan(rhs[i]) ? 1 : 0);
+            out[i] = std::fmod(out[i], rhs[i]);
+        }
+        break;
+
+    case OpCode::MAX:
+        for (std::size_t i = 0; i < n; ++i) {
+            out[i] = std::max(out[i], rhs[i]);
+        }
+        break;
+
+    case OpCode::MIN:
+        for (std::size_t i = 0; i < n; ++i) {
+            out[i] = std::min(out[i], rhs[i]);
+        }
+        break;
+
+    case OpCode::ROUND:
+        for (std::size_t i = 0; i < n; ++i) {
+            // the power of ten overflows for more places, these lanes are not rounded at all
+            if (std::abs(rhs[i]) <= 9.0) {
+                out[i] = roundTo(out[i], rhs[i]);
+            }
+            else {
+                failed[i] |= active_[i];
+            }
+        }
+        break;
+
+    case OpCode::GT_EQ:
+        for (std::size_t i = 0; i < n; ++i) {
+            out[i] = out[i] >= rhs[i] ? 1.0 : 0.0;
+        }
+        break;
+
+    case OpCode::LT_EQ:
+        for (std::size_t i = 0; i < n; ++i) {
+            out[i] = out[i] <= rhs[i] ? 1.0 : 0.0;
+        }
+        break;
+
+    case OpCode::GT:
+        for (std::size_t i = 0; i < n; ++i) {
+            out[i] = out[i] > rhs[i] ? 1.0 : 0.0;
+        }
+        break;
+
+    case OpCode::LT:
+        for (std::size_t i = 0; i < n; ++i) {
+            out[i] = out[i] < rhs[i] ? 1.0 : 0.0;
+        }
+        break;
+
+    // the same tolerance as operator== of Value, exact for bools
+    case OpCode::EQ:
+        for (std::size_t i = 0; i < n; ++i) {
+            out[i] = std::abs(out[i] - rhs[i]) < 0.00000000001 ? 1.0 : 0.0;
+        }
+        break;
+
+    case OpCode::NOT_EQ:
+        for (std::size_t i = 0; i < n; ++i) {
+            out[i] = std::abs(out[i] - rhs[i]) < 0.00000000001 ? 0.0 : 1.0;
+        }
+        break;
+
+    case OpCode::AND:
+        for (std::size_t i = 0; i < n; ++i) {
+            out[i] = out[i] != 0.0 && rhs[i] != 0.0 ? 1.0 : 0.0;
+        }
+        break;
+
+    default: // OR
+        for (std::size_t i = 0; i < n; ++i) {
+            out[i] = out[i] != 0.0 || rhs[i] != 0.0 ? 1.0 : 0.0;
+        }
+        break;
+    }
+    popColumn();
+}
+
+double* ColumnarEvaluator::pushColumn()
+{
+    // the columns do not move when the stack grows
+    if (m_numberOfColumns == m_columns.size()) {
+        m_columns.emplace_back(BLOCK_SIZE);
+    }
+    return m_columns[m_numberOfColumns++].data();
+}
+
+std::uint8_t* ColumnarEvaluator::pushMask()
+{
+    if (m_numberOfMasks == m_masks.size()) {
+        m_masks.emplace_back(BLOCK_SIZE);
+    }
+    return m_masks[m_numberOfMasks++].data();
+}
+
+} // namespace CalculusPrime
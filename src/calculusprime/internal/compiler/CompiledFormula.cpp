@@ -0,0 +1,90 @@
+/*
+Copyright 2019 Association for the promotion of open - source insurance software and for the establishment of open interface standards in the insurance industry
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http ://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <calculusprime/internal/compiler/CompiledFormula.h>
+#include <limits>
+#include <boost/throw_exception.hpp>
+#include <calculusprime/FunctionIdBuilder.h>
+
+namespace CalculusPrime {
+
+std::string CompiledFormula::getText(std::uint32_t index_) const
+{
+    const SourceRef& source = m_sources[index_];
+    if (source.startIndex >= m_formula.size() || source.stopIndex < source.startIndex) {
+        return std::string();
+    }
+    return m_formula.substr(source.startIndex, source.stopIndex - source.startIndex + 1);
+}
+
+std::uint32_t CompiledFormula::addNode(OpCode opCode_, const std::vector<std::uint32_t>& operands_, std::uint32_t data_, const SourceRef& source_)
+{
+    if (operands_.size() > std::numeric_limits<std::uint16_t>::max()) {
+        BOOST_THROW_EXCEPTION(std::runtime_error("too many operands in formula expression"));
+    }
+
+    Node node;
+    node.opCode = opCode_;
+    node.numOperands = static_cast<std::uint16_t>(operands_.size());
+    node.firstOperand = static_cast<std::uint32_t>(m_operands.size());
+    node.data = data_;
+
+    m_operands.insert(m_operands.end(), operands_.begin(), operands_.end());
+    m_nodes.push_back(node);
+    m_sources.push_back(source_);
+    return static_cast<std::uint32_t>(m_nodes.size() - 1);
+}
+
+void CompiledFormula::replaceByConstant(std::uint32_t index_, const Value& value_)
+{
+    Node& node = m_nodes[index_];
+    node.opCode = OpCode::CONSTANT;
+    node.numOperands = 0;
+    node.firstOperand = static_cast<std::uint32_t>(m_operands.size());
+    node.data = addConstant(value_);
+}
+
+void CompiledFormula::replaceOperands(std::uint32_t index_, const std::vector<std::uint32_t>& operands_, std::uint32_t data_)
+{
+    // the operands can only shrink, so the count fits
+    Node& node = m_nodes[index_];
+    node.numOperands = static_cast<std::uint16_t>(operands_.size());
+    node.firstOperand = static_cast<std::uint32_t>(m_operands.size());
+    node.data = data_;
+    m_operands.insert(m_operands.end(), operands_.begin(), operands_.end());
+}
+
+std::uint32_t CompiledFormula::addConstant(const Value& value_)
+{
+    m_constants.push_back(value_);
+    return static_cast<std::uint32_t>(m_constants.size() - 1);
+}
+
+std::uint32_t CompiledFormula::addIdentifier(const std::string& identifier_)
+{
+    m_identifiers.push_back(identifier_);
+    return static_cast<std::uint32_t>(m_identifiers.size() - 1);
+}
+
+std::uint32_t CompiledFormula::addCallSite(const std::string& functionName_, std::size_t numberOfArgs_)
+{
+    CallSite callSite;
+    callSite.functionName = functionName_;
+    callSite.functionId = FunctionIdBuilder::createId(functionName_, numberOfArgs_);
+    m_callSites.push_back(callSite);
+    return static_cast<std::uint32_t>(m_callSites.size() - 1);
+}
+
+} // namespace CalculusPrime
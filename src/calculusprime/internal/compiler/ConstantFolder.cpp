@@ -0,0 +1,114 @@
+/*
+Copyright 2019 Association for the promotion of open - source insurance software and for the establishment of open interface standards in the insurance industry
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http ://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <calculusprime/internal/compiler/ConstantFolder.h>
+#include <exception>
+#include <vector>
+#include <calculusprime/internal/compiler/Operations.h>
+
+namespace CalculusPrime {
+
+void ConstantFolder::fold(CompiledFormula& compiledFormula_)
+{
+    // the operands always precede their node, so they are folded first
+    for (std::uint32_t i = 0; i < compiledFormula_.getNumberOfNodes(); ++i) {
+        switch (compiledFormula_.getNode(i).opCode) {
+        case OpCode::RETURN:
+        case OpCode::ERROR_CALL:
+        case OpCode::CONSTANT:
+        case OpCode::IDENTIFIER:
+        case OpCode::CALL:
+            break;
+
+        case OpCode::IF:
+            foldIf(compiledFormula_, i);
+            break;
+
+        default:
+            foldExpression(compiledFormula_, i);
+            break;
+        }
+    }
+}
+
+void ConstantFolder::foldExpression(CompiledFormula& compiledFormula_, std::uint32_t index_)
+{
+    const CompiledFormula::Node& node = compiledFormula_.getNode(index_);
+
+    // operators and built-in functions have at most three operands
+    Value operands[3];
+    for (std::size_t i = 0; i < node.numOperands; ++i) {
+        const std::uint32_t operand = compiledFormula_.getOperand(node, i);
+        if (!isConstant(compiledFormula_, operand)) {
+            return;
+        }
+        operands[i] = compiledFormula_.getConstant(compiledFormula_.getNode(operand).data);
+    }
+
+    Value result;
+    try {
+        result = Operations::apply(compiledFormula_, index_, operands);
+    }
+    catch (const std::exception&) {
+        // the error is reported when the formula is evaluated
+        return;
+    }
+    compiledFormula_.replaceByConstant(index_, result);
+}
+
+void ConstantFolder::foldIf(CompiledFormula& compiledFormula_, std::uint32_t index_)
+{
+    const CompiledFormula::Node& node = compiledFormula_.getNode(index_);
+    const std::size_t numConditions = (node.numOperands - node.data) / 2;
+
+    std::vector<std::uint32_t> operands;
+    bool changed = false;
+    bool alwaysExecuted = false;
+
+    for (std::size_t i = 0; i < numConditions; ++i) {
+        const std::uint32_t condition = compiledFormula_.getOperand(node, 2 * i);
+        const std::uint32_t block = compiledFormula_.getOperand(node, 2 * i + 1);
+        if (isConstant(compiledFormula_, condition)) {
+            // conditions which are not bool are reported when the formula is evaluated
+            const Value& value = compiledFormula_.getConstant(compiledFormula_.getNode(condition).data);
+            if (value.isBool()) {
+                changed = true;
+                if (value.asBool()) {
+                    // the block becomes the else block, the following conditions are never evaluated
+                    operands.push_back(block);
+                    alwaysExecuted = true;
+                    break;
+                }
+                // the block is never executed
+                continue;
+            }
+        }
+        operands.push_back(condition);
+        operands.push_back(block);
+    }
+
+    if (!changed) {
+        return;
+    }
+
+    std::uint32_t hasElse = alwaysExecuted ? 1 : 0;
+    if (!alwaysExecuted && node.data != 0) {
+        operands.push_back(compiledFormula_.getOperand(node, node.numOperands - 1));
+        hasElse = 1;
+    }
+    compiledFormula_.replaceOperands(index_, operands, hasElse);
+}
+
+} // namespace CalculusPrime
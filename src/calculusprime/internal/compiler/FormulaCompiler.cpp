@@ -0,0 +1,368 @@
+/*
+Copyright 2019 Association for the promotion of open - source insurance software and for the establishment of open interface standards in the insurance industry
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http ://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <calculusprime/internal/compiler/FormulaCompiler.h>
+#include <regex>
+#include "RatingEngineParser.h"
+
+namespace {
+
+const std::regex& getRegex()
+{
+    static const std::regex rgx("\\\\(.)");
+    return rgx;
+}
+
+inline bool compareChar(char left_, char right_)
+{
+    return left_ == right_ || std::toupper(left_) == std::toupper(right_);
+}
+
+inline bool equalsIgnCase(const std::string& left_, const std::string& right_)
+{
+    return ((left_.size() == right_.size()) &&
+        std::equal(left_.begin(), left_.end(), right_.begin(), &compareChar));
+}
+}
+
+namespace CalculusPrime {
+
+std::shared_ptr<CompiledFormula> FormulaCompiler::compile(RatingEngineParser::ParseContext* parseTree_, const std::string& formula_)
+{
+    std::shared_ptr<CompiledFormula> compiledFormula = std::make_shared<CompiledFormula>(formula_);
+    FormulaCompiler compiler(compiledFormula);
+    compiledFormula->setRoot(compiler.compileNode(parseTree_));
+    return compiledFormula;
+}
+
+FormulaCompiler::~FormulaCompiler()
+{
+}
+
+std::uint32_t FormulaCompiler::compileNode(antlr4::tree::ParseTree* tree_)
+{
+    return visit(tree_).as<std::uint32_t>();
+}
+
+std::vector<std::uint32_t> FormulaCompiler::compileNodes(const std::vector<RatingEngineParser::ExpressionContext*>& expressions_)
+{
+    std::vector<std::uint32_t> operands;
+    operands.reserve(expressions_.size());
+    for (RatingEngineParser::ExpressionContext* expression : expressions_) {
+        operands.push_back(compileNode(expression));
+    }
+    return operands;
+}
+
+std::uint32_t FormulaCompiler::emit(OpCode opCode_, antlr4::ParserRuleContext* ctx_, const std::vector<std::uint32_t>& operands_, std::uint32_t data_)
+{
+    CompiledFormula::SourceRef source;
+    source.line = static_cast<std::uint32_t>(ctx_->getStart()->getLine());
+    source.startIndex = static_cast<std::uint32_t>(ctx_->getStart()->getStartIndex());
+    source.stopIndex = static_cast<std::uint32_t>(ctx_->getStop() != nullptr ? ctx_->getStop()->getStopIndex() : ctx_->getStart()->getStopIndex());
+    return m_compiledFormula->addNode(opCode_, operands_, data_, source);
+}
+
+antlrcpp::Any FormulaCompiler::visitParse(RatingEngineParser::ParseContext* ctx)
+{
+    // parse
+    // : block EOF
+    // ;
+    return compileNode(ctx->block());
+}
+
+antlrcpp::Any FormulaCompiler::visitBlock(RatingEngineParser::BlockContext* ctx)
+{
+    // block
+    // : ifStatement | (Return expression) | errorFunctionCall
+    // ;
+    RatingEngineParser::IfStatementContext* ifStmt;
+    if ((ifStmt = ctx->ifStatement()) != nullptr) {
+        return compileNode(ifStmt);
+    }
+
+    RatingEngineParser::ExpressionContext* ex;
+    if ((ex = ctx->expression()) != nullptr) {
+        return emit(OpCode::RETURN, ctx, { compileNode(ex) });
+    }
+
+    return compileNode(ctx->errorFunctionCall());
+}
+
+antlrcpp::Any FormulaCompiler::visitErrorFunctionCall(RatingEngineParser::ErrorFunctionCallContext* ctx)
+{
+    // Error '(' expression ')'                #errorFunctionCall
+    return emit(OpCode::ERROR_CALL, ctx, { compileNode(ctx->expression()) });
+}
+
+antlrcpp::Any FormulaCompiler::visitMaxFunctionCall(RatingEngineParser::MaxFunctionCallContext* ctx)
+{
+    // Max '(' expression ',' expression ')'  #maxFunctionCall
+    return emit(OpCode::MAX, ctx, compileNodes(ctx->expression()));
+}
+
+antlrcpp::Any FormulaCompiler::visitMinFunctionCall(RatingEngineParser::MinFunctionCallContext* ctx)
+{
+    // Min '(' expression ',' expression ')'  #minFunctionCall
+    return emit(OpCode::MIN, ctx, compileNodes(ctx->expression()));
+}
+
+antlrcpp::Any FormulaCompiler::visitRoundFunctionCall(RatingEngineParser::RoundFunctionCallContext* ctx)
+{
+    // Rnd '(' expression ',' expression ')'   #roundFunctionCall
+    return emit(OpCode::ROUND, ctx, compileNodes(ctx->expression()));
+}
+
+antlrcpp::Any FormulaCompiler::visitCeilFunctionCall(RatingEngineParser::CeilFunctionCallContext* ctx)
+{
+    // Ceil '(' expression ')'                 #ceilFunctionCall
+    return emit(OpCode::CEIL, ctx, { compileNode(ctx->expression()) });
+}
+
+antlrcpp::Any FormulaCompiler::visitFloorFunctionCall(RatingEngineParser::FloorFunctionCallContext* ctx)
+{
+    // Floor '(' expression ')'                #floorFunctionCall
+    return emit(OpCode::FLOOR, ctx, { compileNode(ctx->expression()) });
+}
+
+antlrcpp::Any FormulaCompiler::visitExpFunctionCall(RatingEngineParser::ExpFunctionCallContext* ctx)
+{
+    // Exp '(' expression ')'                  #expFunctionCall
+    return emit(OpCode::EXP, ctx, { compileNode(ctx->expression()) });
+}
+
+antlrcpp::Any FormulaCompiler::visitDayFunctionCall(RatingEngineParser::DayFunctionCallContext* ctx)
+{
+    // Day '(' expression ')'                  #dayFunctionCall
+    return emit(OpCode::DAY, ctx, { compileNode(ctx->expression()) });
+}
+
+antlrcpp::Any FormulaCompiler::visitMonthFunctionCall(RatingEngineParser::MonthFunctionCallContext* ctx)
+{
+    // Month '(' expression ')'                #monthFunctionCall
+    return emit(OpCode::MONTH, ctx, { compileNode(ctx->expression()) });
+}
+
+antlrcpp::Any FormulaCompiler::visitYearFunctionCall(RatingEngineParser::YearFunctionCallContext* ctx)
+{
+    // Year '(' expression ')'                 #yearFunctionCall
+    return emit(OpCode::YEAR, ctx, { compileNode(ctx->expression()) });
+}
+
+antlrcpp::Any FormulaCompiler::visitSubstrFunctionCall(RatingEngineParser::SubstrFunctionCallContext* ctx)
+{
+    // Substr '(' expression ',' expression ',' expression')'   #substrFunctionCall
+    return emit(OpCode::SUBSTR, ctx, compileNodes(ctx->expression()));
+}
+
+antlrcpp::Any FormulaCompiler::visitAddDaysFunctionCall(RatingEngineParser::AddDaysFunctionCallContext *ctx)
+{
+    return emit(OpCode::ADD_DAYS, ctx, compileNodes(ctx->expression()));
+}
+
+antlrcpp::Any FormulaCompiler::visitGetDiffDaysFunctionCall(RatingEngineParser::GetDiffDaysFunctionCallContext *ctx)
+{
+    return emit(OpCode::GET_DIFF_DAYS, ctx, compileNodes(ctx->expression()));
+}
+
+antlrcpp::Any FormulaCompiler::visitPaddedStringFunctionCall(RatingEngineParser::PaddedStringFunctionCallContext *ctx)
+{
+    return emit(OpCode::PADDED_STRING, ctx, compileNodes(ctx->expression()));
+}
+
+antlrcpp::Any FormulaCompiler::visitDifferenceInMonthsFunctionCall(RatingEngineParser::DifferenceInMonthsFunctionCallContext *ctx)
+{
+    return emit(OpCode::DIFFERENCE_IN_MONTHS, ctx, compileNodes(ctx->expression()));
+}
+
+antlrcpp::Any FormulaCompiler::visitIdentifierFunctionCall(RatingEngineParser::IdentifierFunctionCallContext* ctx)
+{
+    // Identifier '(' exprList? ')' #identifierFunctionCall
+
+    std::vector<std::uint32_t> params;
+    if (ctx->exprList() != nullptr) {
+        params = compileNodes(ctx->exprList()->expression());
+    }
+    const std::uint32_t callSite = m_compiledFormula->addCallSite(ctx->Identifier()->getText(), params.size());
+    return emit(OpCode::CALL, ctx, params, callSite);
+}
+
+antlrcpp::Any FormulaCompiler::visitIfStatement(RatingEngineParser::IfStatementContext* ctx)
+{
+    // ifStatement
+    //  : ifStat elseIfStat* elseStat? End
+    //  ;
+    //
+    // operands: condition/block pairs of the if and the else if branches, followed by the else block (if any)
+
+    std::vector<std::uint32_t> operands;
+    operands.push_back(compileNode(ctx->ifStat()->expression()));
+    operands.push_back(compileNode(ctx->ifStat()->block()));
+
+    for (RatingEngineParser::ElseIfStatContext* elseIfStat : ctx->elseIfStat()) {
+        operands.push_back(compileNode(elseIfStat->expression()));
+        operands.push_back(compileNode(elseIfStat->block()));
+    }
+
+    std::uint32_t hasElse = 0;
+    if (ctx->elseStat() != nullptr) {
+        operands.push_back(compileNode(ctx->elseStat()->block()));
+        hasElse = 1;
+    }
+    return emit(OpCode::IF, ctx, operands, hasElse);
+}
+
+antlrcpp::Any FormulaCompiler::visitLtExpression(RatingEngineParser::LtExpressionContext* ctx)
+{
+    // expression '<' expression                #ltExpression
+    return emit(OpCode::LT, ctx, compileNodes(ctx->expression()));
+}
+
+antlrcpp::Any FormulaCompiler::visitGtExpression(RatingEngineParser::GtExpressionContext* ctx)
+{
+    // expression '>' expression                #gtExpression
+    return emit(OpCode::GT, ctx, compileNodes(ctx->expression()));
+}
+
+antlrcpp::Any FormulaCompiler::visitBoolExpression(RatingEngineParser::BoolExpressionContext* ctx)
+{
+    const std::uint32_t constant = m_compiledFormula->addConstant(Value(equalsIgnCase(ctx->getText(), "true")));
+    return emit(OpCode::CONSTANT, ctx, std::vector<std::uint32_t>(), constant);
+}
+
+antlrcpp::Any FormulaCompiler::visitNotEqExpression(RatingEngineParser::NotEqExpressionContext* ctx)
+{
+    // expression '!=' expression               #notEqExpression
+    return emit(OpCode::NOT_EQ, ctx, compileNodes(ctx->expression()));
+}
+
+antlrcpp::Any FormulaCompiler::visitModuloExpression(RatingEngineParser::ModuloExpressionContext* ctx)
+{
+    // expression '%' expression                #moduloExpression
+    return emit(OpCode::MODULO, ctx, compileNodes(ctx->expression()));
+}
+
+antlrcpp::Any FormulaCompiler::visitNumberExpression(RatingEngineParser::NumberExpressionContext* ctx)
+{
+    // Number                                   #numberExpression
+    const std::uint32_t constant = m_compiledFormula->addConstant(Value(std::stod(ctx->getText())));
+    return emit(OpCode::CONSTANT, ctx, std::vector<std::uint32_t>(), constant);
+}
+
+antlrcpp::Any FormulaCompiler::visitIdentifierExpression(RatingEngineParser::IdentifierExpressionContext* ctx)
+{
+    // Identifier indexes?                      #identifierExpression
+    const std::uint32_t identifier = m_compiledFormula->addIdentifier(ctx->Identifier()->getText());
+    return emit(OpCode::IDENTIFIER, ctx, std::vector<std::uint32_t>(), identifier);
+}
+
+antlrcpp::Any FormulaCompiler::visitNotExpression(RatingEngineParser::NotExpressionContext* ctx)
+{
+    // '!' expression                           #notExpression
+    return emit(OpCode::NOT, ctx, { compileNode(ctx->expression()) });
+}
+
+antlrcpp::Any FormulaCompiler::visitMultiplyExpression(RatingEngineParser::MultiplyExpressionContext* ctx)
+{
+    // expression '*' expression                #multiplyExpression
+    return emit(OpCode::MULTIPLY, ctx, compileNodes(ctx->expression()));
+}
+
+antlrcpp::Any FormulaCompiler::visitGtEqExpression(RatingEngineParser::GtEqExpressionContext* ctx)
+{
+    // expression '>=' expression               #gtEqExpression
+    return emit(OpCode::GT_EQ, ctx, compileNodes(ctx->expression()));
+}
+
+antlrcpp::Any FormulaCompiler::visitDivideExpression(RatingEngineParser::DivideExpressionContext* ctx)
+{
+    // expression '/' expression                #divideExpression
+    return emit(OpCode::DIVIDE, ctx, compileNodes(ctx->expression()));
+}
+
+antlrcpp::Any FormulaCompiler::visitOrExpression(RatingEngineParser::OrExpressionContext* ctx)
+{
+    // expression Or expression               #orExpression
+    return emit(OpCode::OR, ctx, compileNodes(ctx->expression()));
+}
+
+antlrcpp::Any FormulaCompiler::visitUnaryMinusExpression(RatingEngineParser::UnaryMinusExpressionContext* ctx)
+{
+    // '-' expression                           #unaryMinusExpression
+    return emit(OpCode::NEGATE, ctx, { compileNode(ctx->expression()) });
+}
+
+antlrcpp::Any FormulaCompiler::visitPowerExpression(RatingEngineParser::PowerExpressionContext* ctx)
+{
+    // expression '^' expression                #powerExpression
+    return emit(OpCode::POWER, ctx, compileNodes(ctx->expression()));
+}
+
+antlrcpp::Any FormulaCompiler::visitEqExpression(RatingEngineParser::EqExpressionContext* ctx)
+{
+    // expression '==' expression               #eqExpression
+    return emit(OpCode::EQ, ctx, compileNodes(ctx->expression()));
+}
+
+antlrcpp::Any FormulaCompiler::visitAndExpression(RatingEngineParser::AndExpressionContext* ctx)
+{
+    // expression And expression               #andExpression
+    return emit(OpCode::AND, ctx, compileNodes(ctx->expression()));
+}
+
+antlrcpp::Any FormulaCompiler::visitStringExpression(RatingEngineParser::StringExpressionContext* ctx)
+{
+    // String indexes?                          #stringExpression
+
+    std::string text = ctx->getText();
+    // first and last char are '
+    text = std::regex_replace(text.substr(1, text.length() - 2), getRegex(), "$1");
+    const std::uint32_t constant = m_compiledFormula->addConstant(Value(text));
+    return emit(OpCode::CONSTANT, ctx, std::vector<std::uint32_t>(), constant);
+}
+
+antlrcpp::Any FormulaCompiler::visitExpressionExpression(RatingEngineParser::ExpressionExpressionContext* ctx)
+{
+    // '(' expression ')' indexes?              #expressionExpression
+
+    // parentheses only group, they do not need a node
+    return compileNode(ctx->expression());
+}
+
+antlrcpp::Any FormulaCompiler::visitAddExpression(RatingEngineParser::AddExpressionContext* ctx)
+{
+    // expression '+' expression                #addExpression
+    return emit(OpCode::ADD, ctx, compileNodes(ctx->expression()));
+}
+
+antlrcpp::Any FormulaCompiler::visitSubtractExpression(RatingEngineParser::SubtractExpressionContext* ctx)
+{
+    // expression '-' expression                #subtractExpression
+    return emit(OpCode::SUBTRACT, ctx, compileNodes(ctx->expression()));
+}
+
+antlrcpp::Any FormulaCompiler::visitFunctionCallExpression(RatingEngineParser::FunctionCallExpressionContext* ctx)
+{
+    // functionCall indexes?                    #functionCallExpression
+    return compileNode(ctx->functionCall());
+}
+
+antlrcpp::Any FormulaCompiler::visitLtEqExpression(RatingEngineParser::LtEqExpressionContext* ctx)
+{
+    // expression '<=' expression               #ltEqExpression
+    return emit(OpCode::LT_EQ, ctx, compileNodes(ctx->expression()));
+}
+
+} // namespace CalculusPrime
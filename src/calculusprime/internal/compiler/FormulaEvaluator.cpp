@@ -0,0 +1,143 @@
+/*
+Copyright 2019 Association for the promotion of open - source insurance software and for the establishment of open interface standards in the insurance industry
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http ://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <calculusprime/internal/compiler/FormulaEvaluator.h>
+#include <sstream>
+#include <boost/throw_exception.hpp>
+#include <calculusprime/RatingEngineException.h>
+#include <calculusprime/internal/ParsingContext.h>
+#include <calculusprime/internal/compiler/Operations.h>
+#include <calculusprime/internal/parsing/EvalException.h>
+
+namespace CalculusPrime {
+
+boost::optional<Value> FormulaEvaluator::execute()
+{
+    Value result;
+    if (executeBlock(m_compiledFormula.getRoot(), result)) {
+        return result;
+    }
+    return boost::none;
+}
+
+bool FormulaEvaluator::executeBlock(std::uint32_t index_, Value& result_)
+{
+    const CompiledFormula::Node& node = m_compiledFormula.getNode(index_);
+
+    switch (node.opCode) {
+    case OpCode::RETURN:
+        result_ = evaluateOperand(node, 0);
+        return true;
+
+    case OpCode::IF: {
+        // if ... else if ...
+        const std::size_t numConditions = (node.numOperands - node.data) / 2;
+        for (std::size_t i = 0; i < numConditions; ++i) {
+            if (evaluateOperand(node, 2 * i).asBool()) {
+                return executeBlock(m_compiledFormula.getOperand(node, 2 * i + 1), result_);
+            }
+        }
+
+        // else ...
+        if (node.data != 0) {
+            return executeBlock(m_compiledFormula.getOperand(node, node.numOperands - 1), result_);
+        }
+        return false;
+    }
+
+    case OpCode::ERROR_CALL: {
+        // cancels the calculation with a RatingEngineException
+        Value code = evaluateOperand(node, 0);
+        Operations::apply(m_compiledFormula, index_, &code);
+        return false;
+    }
+
+    default:
+        BOOST_THROW_EXCEPTION(EvalException(m_compiledFormula, index_));
+    }
+}
+
+Value FormulaEvaluator::evaluate(std::uint32_t index_)
+{
+    const CompiledFormula::Node& node = m_compiledFormula.getNode(index_);
+
+    switch (node.opCode) {
+    case OpCode::CONSTANT:
+        return m_compiledFormula.getConstant(node.data);
+
+    case OpCode::IDENTIFIER:
+        if (m_slots != nullptr) {
+            return m_parsingContext->resolve(m_slots[node.data], m_compiledFormula.getIdentifier(node.data));
+        }
+        return m_parsingContext->resolve(m_compiledFormula.getIdentifier(node.data));
+
+    case OpCode::CALL:
+        return callFunction(index_, node);
+
+    case OpCode::AND:
+    case OpCode::OR:
+        if (m_parsingContext->isShortCircuitEvaluation()) {
+            // the right operand is skipped if the left operand decides the result,
+            // all other cases (including the type errors) are reported by Operations
+            Value operands[2] = { evaluateOperand(node, 0) };
+            if (!operands[0].isVoid() && operands[0].isBool() && operands[0].asBool() == (node.opCode == OpCode::OR)) {
+                return operands[0];
+            }
+            operands[1] = evaluateOperand(node, 1);
+            return Operations::apply(m_compiledFormula, index_, operands);
+        }
+        // fall through
+
+    default: {
+        // operators and built-in functions have at most three operands,
+        // the built-in functions report a wrong operand type before the next operand is evaluated
+        Value operands[3];
+        const bool hasOperandChecks = Operations::hasOperandChecks(node.opCode);
+        for (std::size_t i = 0; i < node.numOperands; ++i) {
+            operands[i] = evaluateOperand(node, i);
+            if (hasOperandChecks && i + 1 < node.numOperands) {
+                Operations::checkOperand(m_compiledFormula, index_, i, operands[i]);
+            }
+        }
+        return Operations::apply(m_compiledFormula, index_, operands);
+    }
+    }
+}
+
+Value FormulaEvaluator::callFunction(std::uint32_t index_, const CompiledFormula::Node& node_)
+{
+    try {
+        // an unknown function is reported before the parameters are evaluated
+        IFunction& function = *Operations::findFunction(m_parsingContext, m_compiledFormula, index_, m_functions != nullptr ? m_functions[node_.data] : nullptr);
+
+        // evaluate the parameters into a reused buffer
+        ArgumentStack::Frame frame(m_parsingContext->getArgumentStack(), node_.numOperands);
+        std::vector<Value>& paramValues = frame.getArguments();
+
+        for (std::size_t i = 0; i < node_.numOperands; ++i) {
+            paramValues[i] = evaluateOperand(node_, i);
+        }
+
+        return Operations::callFunction(m_parsingContext, m_compiledFormula, index_, function, paramValues);
+    }
+    catch (const RatingEngineException&) {
+        throw;
+    }
+    catch (const std::exception& ex) {
+        BOOST_THROW_EXCEPTION(EvalException(ex.what(), m_compiledFormula, index_));
+    }
+}
+
+} // namespace CalculusPrime
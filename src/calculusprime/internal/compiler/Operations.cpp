@@ -0,0 +1,618 @@
+/*
+Copyright 2019 Association for the promotion of open - source insurance software and for the establishment of open interface standards in the insurance industry
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http ://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#define NOMINMAX
+#include <calculusprime/internal/compiler/Operations.h>
+#include <algorithm>
+#include <cerrno>
+#include <cfenv>
+#include <chrono>
+#include <cmath>
+#include <sstream>
+#include <boost/date_time/gregorian/gregorian.hpp>
+#include <boost/spirit/include/classic.hpp>
+#include <boost/spirit/include/classic_chset.hpp>
+#include <boost/throw_exception.hpp>
+#include <calculusprime/IFunction.h>
+#include <calculusprime/Logging.h>
+#include <calculusprime/RatingEngineException.h>
+#include <calculusprime/internal/FunctionResultCaching.h>
+#include <calculusprime/internal/ParsingContext.h>
+#include <calculusprime/internal/parsing/EvalException.h>
+
+namespace bgr = boost::gregorian;
+namespace bsp = boost::spirit::classic;
+
+namespace {
+const std::string gDefaultDate("0001-01-01");
+
+typedef bsp::uint_parser<unsigned, 10, 4, 4> uint4_parser_t;
+typedef bsp::uint_parser<unsigned, 10, 2, 2> uint2_parser_t;
+
+const uint4_parser_t g_uint4_p = uint4_parser_t();
+const uint2_parser_t g_uint2_p = uint2_parser_t();
+
+// converts the string to date - ISO format is expected (YYYY-MM-DD)
+boost::gregorian::date dateFromString(const std::string& str_)
+{
+    using namespace boost::spirit::classic;
+
+    unsigned year, month, day;
+    parse_info<> info = bsp::parse(str_.c_str(),
+                                   (
+                                       g_uint4_p[assign_a(year)] >> '-' >>
+                                       g_uint2_p[assign_a(month)] >> '-' >>
+                                       g_uint2_p[assign_a(day)]
+                                   ));
+    if (info.full) {
+        return bgr::date(year, month, day);
+    }
+    else {
+        BOOST_THROW_EXCEPTION(std::runtime_error("invalid date format: " + str_));
+    }
+}
+}
+
+namespace CalculusPrime {
+
+namespace {
+
+Value cancelCalculation(const CompiledFormula& formula_, std::uint32_t index_, const Value& code_)
+{
+    if (!code_.isDouble()) {
+        BOOST_THROW_EXCEPTION(EvalException("Illegal argument type for first parameter of function 'ERROR', number expected", formula_, index_));
+    }
+    // cancel the entire calculation
+    std::ostringstream errorCode;
+    errorCode << code_;
+    BOOST_THROW_EXCEPTION(RatingEngineException(RatingEngineError::CALCULATION_CANCELLED, "Calculation was cancelled by a call of the error function with code " + errorCode.str(), errorCode.str()));
+}
+
+Value minMax(const CompiledFormula& formula_, std::uint32_t index_, const Value& left_, const Value& right_)
+{
+    const bool isMax = formula_.getNode(index_).opCode == OpCode::MAX;
+    Operations::checkOperand(formula_, index_, 0, left_);
+    Operations::checkOperand(formula_, index_, 1, right_);
+    return Value(isMax ? std::max(left_.asDouble(), right_.asDouble()) : std::min(left_.asDouble(), right_.asDouble()));
+}
+
+Value ceilFloor(const CompiledFormula& formula_, std::uint32_t index_, const Value& value_)
+{
+    const bool isCeil = formula_.getNode(index_).opCode == OpCode::CEIL;
+    if (!value_.isDouble()) {
+        BOOST_THROW_EXCEPTION(EvalException(std::string("Illegal argument type for first parameter of function '") + (isCeil ? "CEIL" : "FLOOR") + "', number expected", formula_, index_));
+    }
+    return Value(isCeil ? std::ceil(value_.asDouble()) : std::floor(value_.asDouble()));
+}
+
+Value roundTo(const CompiledFormula& formula_, std::uint32_t index_, const Value& value_, const Value& placesValue_)
+{
+    Operations::checkOperand(formula_, index_, 0, value_);
+    Operations::checkOperand(formula_, index_, 1, placesValue_);
+
+    double places = placesValue_.asDouble();
+    if (places >= 0) {
+        int x = 1;
+        for (double d = 0; d < places; d += 1.0) {
+            x *= 10;
+        }
+        return Value(std::round(value_.asDouble() * x) / x);
+    }
+    else {
+        int x = 1;
+        for (double d = 0; d > places; d -= 1.0) {
+            x *= 10;
+        }
+        return Value(std::round(value_.asDouble() / x) * x);
+    }
+}
+
+Value checkedExp(const CompiledFormula& formula_, std::uint32_t index_, const Value& value_)
+{
+    if (!value_.isDouble()) {
+        BOOST_THROW_EXCEPTION(EvalException("Illegal argument type for first parameter of function 'EXP', number expected", formula_, index_));
+    }
+    errno = 0;
+    double result = std::exp(value_.asDouble());
+    if (errno == ERANGE) {
+        std::ostringstream msg;
+        msg << "overflow range error in function 'exp' for value: " << value_.asDouble();
+        BOOST_THROW_EXCEPTION(EvalException(msg.str(), formula_, index_));
+    }
+    return Value(result);
+}
+
+// Day, Month and Year
+Value datePart(const CompiledFormula& formula_, std::uint32_t index_, const Value& parm_)
+{
+    const OpCode opCode = formula_.getNode(index_).opCode;
+    const char* upperName = opCode == OpCode::DAY ? "DAY" : (opCode == OpCode::MONTH ? "MONTH" : "YEAR");
+    const char* lowerName = opCode == OpCode::DAY ? "day" : (opCode == OpCode::MONTH ? "month" : "year");
+
+    if (!parm_.isString()) {
+        BOOST_THROW_EXCEPTION(EvalException(std::string("Illegal argument type for first parameter of function '") + upperName + "', string expected", formula_, index_));
+    }
+
+    const std::string& dateStr = parm_.asString();
+    // the boost datetime lib cannot handle dates < 1400, so make a hardcoded workaround for default date 0001-01-01
+    if (dateStr == gDefaultDate || dateStr.empty()) {
+        return Value(1);
+    }
+
+    try {
+        bgr::date date = dateFromString(dateStr);
+        switch (opCode) {
+        case OpCode::DAY:
+            return Value(double(date.day()));
+        case OpCode::MONTH:
+            return Value(double(date.month()));
+        default:
+            return Value(double(date.year()));
+        }
+    }
+    catch (const std::exception&) {
+        BOOST_THROW_EXCEPTION(EvalException(std::string("Cannot convert first parameter of function '") + lowerName + "' to date: " + parm_.asString(), formula_, index_));
+    }
+}
+
+Value substr(const CompiledFormula& formula_, std::uint32_t index_, const Value& value_, const Value& startParm_, const Value& lengthParm_)
+{
+    Operations::checkOperand(formula_, index_, 0, value_);
+    Operations::checkOperand(formula_, index_, 1, startParm_);
+    Operations::checkOperand(formula_, index_, 2, lengthParm_);
+
+    const boost::string_view str = value_.asStringView();
+    int start = static_cast<int>(startParm_.asDouble() + 0.5);
+    // 1-based start index
+    if (start < 1) {
+        BOOST_THROW_EXCEPTION(EvalException("Second parameter of function 'SUBSTR' must be >= 1", formula_, index_));
+    }
+
+    int length = static_cast<int>(lengthParm_.asDouble() + 0.5);
+    if (length < 1) {
+        BOOST_THROW_EXCEPTION(EvalException("Third parameter of function 'SUBSTR' must be >= 1", formula_, index_));
+    }
+
+    try {
+        return Value(str.substr(start - 1, length));
+    }
+    catch (const std::out_of_range&) {
+        std::ostringstream msg;
+        msg << "String index out of range in function 'SUBSTR('" << str << "', " << start << ", " << length << ")";
+        BOOST_THROW_EXCEPTION(EvalException(msg.str(), formula_, index_));
+    }
+}
+
+Value addDays(const CompiledFormula& formula_, std::uint32_t index_, const Value& dateParm_, const Value& daysParm_)
+{
+    Operations::checkOperand(formula_, index_, 0, dateParm_);
+    Operations::checkOperand(formula_, index_, 1, daysParm_);
+
+    try {
+        bgr::date startDate = dateFromString(dateParm_.asString());
+        bgr::date_duration days(static_cast<int>(daysParm_.asDouble() + 0.5));
+        bgr::date resultDate = startDate + days;
+
+        return Value(bgr::to_iso_extended_string(resultDate));
+    }
+    catch (const std::exception&) {
+        BOOST_THROW_EXCEPTION(EvalException("Cannot convert first parameter of function 'year' to date: " + dateParm_.asString(), formula_, index_));
+    }
+}
+
+// converts both parameters of GetDiffDays and DifferenceInMonths to dates
+void datesFromParms(const CompiledFormula& formula_, std::uint32_t index_, const std::string& functionName_,
+                    const Value& dateLeftParm_, const Value& dateRightParm_, bgr::date& dateLeft_, bgr::date& dateRight_)
+{
+    Operations::checkOperand(formula_, index_, 0, dateLeftParm_);
+    Operations::checkOperand(formula_, index_, 1, dateRightParm_);
+
+    try {
+        dateLeft_ = dateFromString(dateLeftParm_.asString());
+    }
+    catch (const std::exception&) {
+        BOOST_THROW_EXCEPTION(EvalException("Cannot convert first parameter of function '" + functionName_ + "' to date: " + dateLeftParm_.asString(), formula_, index_));
+    }
+
+    try {
+        dateRight_ = dateFromString(dateRightParm_.asString());
+    }
+    catch (const std::exception&) {
+        BOOST_THROW_EXCEPTION(EvalException("Cannot convert second parameter of function '" + functionName_ + "' to date: " + dateRightParm_.asString(), formula_, index_));
+    }
+}
+
+Value getDiffDays(const CompiledFormula& formula_, std::uint32_t index_, const Value& dateLeftParm_, const Value& dateRightParm_)
+{
+    bgr::date dateLeft;
+    bgr::date dateRight;
+    datesFromParms(formula_, index_, "GetDiffDays", dateLeftParm_, dateRightParm_, dateLeft, dateRight);
+
+    try {
+        bgr::days diffDays = dateLeft - dateRight;
+
+        if (diffDays.days() < 0) {
+            BOOST_THROW_EXCEPTION(EvalException("Days is difference is less than zero in function 'GetDiffDays' with first parameter '" +
+                dateLeftParm_.asString() + "' and second parameter '" + dateRightParm_.asString() + "'", formula_, index_));
+        }
+
+        return Value(double(diffDays.days()));
+    }
+    catch (const std::exception&) {
+        BOOST_THROW_EXCEPTION(EvalException("Cannot calculate differnce in days in function 'GetDiffDays' with first parameter '" +
+            dateLeftParm_.asString() + "' and second parameter '" + dateRightParm_.asString() + "'", formula_, index_));
+    }
+}
+
+Value paddedString(const CompiledFormula& formula_, std::uint32_t index_, const Value& stringParm_, const Value& expectedLengthParm_)
+{
+    Operations::checkOperand(formula_, index_, 0, stringParm_);
+    Operations::checkOperand(formula_, index_, 1, expectedLengthParm_);
+
+    std::string stringStr = stringParm_.asString();
+    std::size_t expectedLength = static_cast<std::size_t>(expectedLengthParm_.asDouble());
+    std::size_t actualLength = stringStr.length();
+    std::size_t missingLength = expectedLength - actualLength;
+    if (missingLength > 0) {
+        std::string(missingLength, '0').append(stringStr);
+    }
+
+    return Value(stringStr);
+}
+
+Value differenceInMonths(const CompiledFormula& formula_, std::uint32_t index_, const Value& dateLeftParm_, const Value& dateRightParm_)
+{
+    bgr::date dateLeft;
+    bgr::date dateRight;
+    datesFromParms(formula_, index_, "DifferenceInMonths", dateLeftParm_, dateRightParm_, dateLeft, dateRight);
+
+    try {
+        int months = (dateLeft.year() - dateRight.year()) * 12 + dateLeft.month() - dateRight.month();
+        return Value(double(months));
+    }
+    catch (const std::exception&) {
+        BOOST_THROW_EXCEPTION(EvalException("Cannot calculate differnce in days in function 'DifferenceInMonths' with first parameter '" +
+            dateLeftParm_.asString() + "' and second parameter '" + dateRightParm_.asString() + "'", formula_, index_));
+    }
+}
+
+Value add(const Value& lhs_, const Value& rhs_)
+{
+    // number + number
+    if (lhs_.isDouble() && rhs_.isDouble()) {
+        return Value(lhs_.asDouble() + rhs_.asDouble());
+    }
+
+    // string + string
+    if (lhs_.isString() && rhs_.isString()) {
+        const boost::string_view lhs = lhs_.asStringView();
+        const boost::string_view rhs = rhs_.asStringView();
+        std::string str;
+        str.reserve(lhs.size() + rhs.size());
+        str.append(lhs.data(), lhs.size()).append(rhs.data(), rhs.size());
+        return Value(str);
+    }
+
+    std::ostringstream oss;
+    // string + any
+    if (lhs_.isString()) {
+        oss << lhs_.asStringView() << rhs_;
+        return Value(oss.str());
+    }
+
+    // any + string
+    if (rhs_.isString()) {
+        oss << lhs_ << rhs_.asStringView();
+        return Value(oss.str());
+    }
+    oss << lhs_ << rhs_;
+    return Value(oss.str());
+}
+
+Value multiply(const CompiledFormula& formula_, std::uint32_t index_, const Value& lhs_, const Value& rhs_)
+{
+    // number * number
+    if (lhs_.isDouble() && rhs_.isDouble()) {
+        return Value(lhs_.asDouble() * rhs_.asDouble());
+    }
+
+    // string * number
+    if (lhs_.isString() && rhs_.isDouble()) {
+        const boost::string_view lhs = lhs_.asStringView();
+        std::string str;
+        int amount = static_cast<int>(rhs_.asDouble() + 0.5);
+        for (int i = 0; i < amount; ++i) {
+            str.append(lhs.data(), lhs.size());
+        }
+        return Value(str);
+    }
+    BOOST_THROW_EXCEPTION(EvalException(formula_, index_));
+}
+
+Value compare(const CompiledFormula& formula_, std::uint32_t index_, const Value& lhs_, const Value& rhs_)
+{
+    const OpCode opCode = formula_.getNode(index_).opCode;
+    if (lhs_.isDouble() && rhs_.isDouble()) {
+        const double lhs = lhs_.asDouble();
+        const double rhs = rhs_.asDouble();
+        switch (opCode) {
+        case OpCode::GT_EQ:
+            return Value(lhs >= rhs);
+        case OpCode::LT_EQ:
+            return Value(lhs <= rhs);
+        case OpCode::GT:
+            return Value(lhs > rhs);
+        default:
+            return Value(lhs < rhs);
+        }
+    }
+    if (lhs_.isString() && rhs_.isString()) {
+        const boost::string_view lhs = lhs_.asStringView();
+        const boost::string_view rhs = rhs_.asStringView();
+        switch (opCode) {
+        case OpCode::GT_EQ:
+            return Value(lhs >= rhs);
+        case OpCode::LT_EQ:
+            return Value(lhs <= rhs);
+        case OpCode::GT:
+            return Value(lhs > rhs);
+        default:
+            return Value(lhs < rhs);
+        }
+    }
+    BOOST_THROW_EXCEPTION(EvalException(formula_, index_));
+}
+}
+
+Value Operations::apply(const CompiledFormula& compiledFormula_, std::uint32_t node_, const Value* operands_)
+{
+    switch (compiledFormula_.getNode(node_).opCode) {
+    case OpCode::ERROR_CALL:
+        return cancelCalculation(compiledFormula_, node_, operands_[0]);
+
+    case OpCode::NEGATE:
+        if (!operands_[0].isDouble()) {
+            BOOST_THROW_EXCEPTION(EvalException(compiledFormula_, node_));
+        }
+        return Value(-1 * operands_[0].asDouble());
+
+    case OpCode::NOT:
+        if (!operands_[0].isBool()) {
+            BOOST_THROW_EXCEPTION(EvalException(compiledFormula_, node_));
+        }
+        return Value(!operands_[0].asBool());
+
+    case OpCode::POWER:
+        if (operands_[0].isDouble() && operands_[1].isDouble()) {
+            return Value(std::pow(operands_[0].asDouble(), operands_[1].asDouble()));
+        }
+        BOOST_THROW_EXCEPTION(EvalException(compiledFormula_, node_));
+
+    case OpCode::MULTIPLY:
+        return multiply(compiledFormula_, node_, operands_[0], operands_[1]);
+
+    case OpCode::DIVIDE:
+        if (operands_[0].isDouble() && operands_[1].isDouble()) {
+            double result = operands_[0].asDouble() / operands_[1].asDouble();
+            if (std::isinf(result)) {
+                BOOST_THROW_EXCEPTION(RatingEngineException(RatingEngineError::DIVISION_BY_ZERO));
+            }
+            return Value(result);
+        }
+        BOOST_THROW_EXCEPTION(EvalException(compiledFormula_, node_));
+
+    case OpCode::ADD:
+        return add(operands_[0], operands_[1]);
+
+    case OpCode::SUBTRACT:
+        if (operands_[0].isDouble() && operands_[1].isDouble()) {
+            return Value(operands_[0].asDouble() - operands_[1].asDouble());
+        }
+        BOOST_THROW_EXCEPTION(EvalException(compiledFormula_, node_));
+
+    case OpCode::GT_EQ:
+    case OpCode::LT_EQ:
+    case OpCode::GT:
+    case OpCode::LT:
+        return compare(compiledFormula_, node_, operands_[0], operands_[1]);
+
+    case OpCode::EQ:
+        return Value(operands_[0] == operands_[1]);
+
+    case OpCode::NOT_EQ:
+        return Value(!(operands_[0] == operands_[1]));
+
+    case OpCode::AND:
+        if (!operands_[0].isBool() || !operands_[1].isBool()) {
+            BOOST_THROW_EXCEPTION(EvalException(compiledFormula_, node_));
+        }
+        return Value(operands_[0].asBool() && operands_[1].asBool());
+
+    case OpCode::OR:
+        if (!operands_[0].isBool() || !operands_[1].isBool()) {
+            BOOST_THROW_EXCEPTION(EvalException(compiledFormula_, node_));
+        }
+        return Value(operands_[0].asBool() || operands_[1].asBool());
+
+    case OpCode::MODULO:
+        if (operands_[0].isDouble() && operands_[1].isDouble()) {
+            std::feclearexcept(FE_ALL_EXCEPT);
+            double result = std::fmod(operands_[0].asDouble(), operands_[1].asDouble());
+            if (std::fetestexcept(FE_INVALID)) {
+                BOOST_THROW_EXCEPTION(RatingEngineException(RatingEngineError::DIVISION_BY_ZERO));
+            }
+            return Value(result);
+        }
+        BOOST_THROW_EXCEPTION(EvalException(compiledFormula_, node_));
+
+    case OpCode::MAX:
+    case OpCode::MIN:
+        return minMax(compiledFormula_, node_, operands_[0], operands_[1]);
+
+    case OpCode::ROUND:
+        return roundTo(compiledFormula_, node_, operands_[0], operands_[1]);
+
+    case OpCode::CEIL:
+    case OpCode::FLOOR:
+        return ceilFloor(compiledFormula_, node_, operands_[0]);
+
+    case OpCode::EXP:
+        return checkedExp(compiledFormula_, node_, operands_[0]);
+
+    case OpCode::DAY:
+    case OpCode::MONTH:
+    case OpCode::YEAR:
+        return datePart(compiledFormula_, node_, operands_[0]);
+
+    case OpCode::SUBSTR:
+        return substr(compiledFormula_, node_, operands_[0], operands_[1], operands_[2]);
+
+    case OpCode::ADD_DAYS:
+        return addDays(compiledFormula_, node_, operands_[0], operands_[1]);
+
+    case OpCode::GET_DIFF_DAYS:
+        return getDiffDays(compiledFormula_, node_, operands_[0], operands_[1]);
+
+    case OpCode::PADDED_STRING:
+        return paddedString(compiledFormula_, node_, operands_[0], operands_[1]);
+
+    case OpCode::DIFFERENCE_IN_MONTHS:
+        return differenceInMonths(compiledFormula_, node_, operands_[0], operands_[1]);
+
+    default:
+        BOOST_THROW_EXCEPTION(EvalException(compiledFormula_, node_));
+    }
+}
+
+bool Operations::hasOperandChecks(OpCode opCode_)
+{
+    switch (opCode_) {
+    case OpCode::MAX:
+    case OpCode::MIN:
+    case OpCode::ROUND:
+    case OpCode::SUBSTR:
+    case OpCode::ADD_DAYS:
+    case OpCode::GET_DIFF_DAYS:
+    case OpCode::PADDED_STRING:
+    case OpCode::DIFFERENCE_IN_MONTHS:
+        return true;
+    default:
+        return false;
+    }
+}
+
+void Operations::checkOperand(const CompiledFormula& compiledFormula_, std::uint32_t node_, std::size_t operand_, const Value& value_)
+{
+    static const char* const ordinals[] = { "first", "second", "third" };
+
+    const char* name;
+    bool stringExpected;
+    // the second date of GetDiffDays and DifferenceInMonths has always been reported as "number expected"
+    bool numberReported = false;
+    switch (compiledFormula_.getNode(node_).opCode) {
+    case OpCode::MAX:
+        name = "MAX";
+        stringExpected = false;
+        break;
+    case OpCode::MIN:
+        name = "MIN";
+        stringExpected = false;
+        break;
+    case OpCode::ROUND:
+        name = "RND";
+        stringExpected = false;
+        break;
+    case OpCode::SUBSTR:
+        name = "SUBSTR";
+        stringExpected = operand_ == 0;
+        break;
+    case OpCode::ADD_DAYS:
+        name = "ADDDAYS";
+        stringExpected = operand_ == 0;
+        break;
+    case OpCode::GET_DIFF_DAYS:
+        name = "GetDiffDays";
+        stringExpected = true;
+        numberReported = operand_ != 0;
+        break;
+    case OpCode::DIFFERENCE_IN_MONTHS:
+        name = "DifferenceInMonths";
+        stringExpected = true;
+        numberReported = operand_ != 0;
+        break;
+    case OpCode::PADDED_STRING:
+        name = "PaddedString";
+        stringExpected = operand_ == 0;
+        break;
+    default:
+        return;
+    }
+
+    if (stringExpected ? !value_.isString() : !value_.isDouble()) {
+        BOOST_THROW_EXCEPTION(EvalException(std::string("Illegal argument type for ") + ordinals[operand_] + " parameter of function '" + name + "', " +
+            (stringExpected && !numberReported ? "string" : "number") + " expected", compiledFormula_, node_));
+    }
+}
+
+IFunction* Operations::findFunction(const std::shared_ptr<ParsingContext>& parsingContext_, const CompiledFormula& compiledFormula_, std::uint32_t node_, IFunction* function_)
+{
+    if (function_ != nullptr) {
+        return function_;
+    }
+
+    // the functions of the parsing context live as long as the context
+    const CompiledFormula::Node& node = compiledFormula_.getNode(node_);
+    const CompiledFormula::CallSite& callSite = compiledFormula_.getCallSite(node.data);
+    IFunction* function = parsingContext_->getFunction(callSite.functionId).get();
+
+    // check if function implementation exists
+    if (function == nullptr) {
+        std::ostringstream msg;
+        msg << "function " << callSite.functionName << " with " << node.numOperands << " parameters not defined";
+        BOOST_THROW_EXCEPTION(std::runtime_error(msg.str()));
+    }
+    return function;
+}
+
+Value Operations::callFunction(const std::shared_ptr<ParsingContext>& parsingContext_, const CompiledFormula& compiledFormula_, std::uint32_t node_, IFunction& function_, const std::vector<Value>& arguments_)
+{
+    typedef std::chrono::high_resolution_clock Clock_t;
+
+    const CompiledFormula::CallSite& callSite = compiledFormula_.getCallSite(compiledFormula_.getNode(node_).data);
+
+    // get function result from business logic or from the cache
+    const std::chrono::time_point<Clock_t> startTime = Clock_t::now();
+
+    Value result = FunctionResultCaching::execute(function_, callSite.functionId, arguments_, parsingContext_);
+
+    const std::chrono::time_point<Clock_t> endTime = Clock_t::now();
+    parsingContext_->addFunctionDurationMicroSecs(std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime).count());
+
+    const log4cplus::Logger& logger = parsingContext_->getLogger();
+    if (logger.isEnabledFor(log4cplus::DEBUG_LOG_LEVEL)) {
+        std::ostringstream params;
+        for (std::size_t i = 0; i < arguments_.size(); ++i) {
+            if (i != 0) {
+                params << ',';
+            }
+            params << arguments_[i];
+        }
+        LOG4CPLUS_DEBUG(parsingContext_->getLogger(), callSite.functionName << '(' << params.str() << ") result=" << result);
+    }
+
+    return result;
+}
+
+} // namespace CalculusPrime
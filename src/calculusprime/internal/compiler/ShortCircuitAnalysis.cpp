@@ -0,0 +1,97 @@
+/*
+Copyright 2019 Association for the promotion of open - source insurance software and for the establishment of open interface standards in the insurance industry
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http ://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <calculusprime/internal/compiler/ShortCircuitAnalysis.h>
+
+namespace CalculusPrime {
+
+bool ShortCircuitAnalysis::mayDiffer(const SymbolTable::BoundFormula& boundFormula_, const std::vector<bool>& failingSlots_)
+{
+    const CompiledFormula& compiledFormula = *boundFormula_.compiledFormula;
+    for (std::uint32_t i = 0; i < compiledFormula.getNumberOfNodes(); ++i) {
+        const CompiledFormula::Node& node = compiledFormula.getNode(i);
+        if ((node.opCode == OpCode::AND || node.opCode == OpCode::OR) && mayFail(boundFormula_, compiledFormula.getOperand(node, 1), failingSlots_)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ShortCircuitAnalysis::mayFail(const SymbolTable::BoundFormula& boundFormula_, const std::vector<bool>& failingSlots_)
+{
+    // every node is checked, blocks only fail through their operands and constants only as operands of And, Or and Not
+    const CompiledFormula& compiledFormula = *boundFormula_.compiledFormula;
+    for (std::uint32_t i = 0; i < compiledFormula.getNumberOfNodes(); ++i) {
+        const CompiledFormula::Node& node = compiledFormula.getNode(i);
+        if (node.opCode != OpCode::RETURN && node.opCode != OpCode::IF && node.opCode != OpCode::CONSTANT && mayFail(boundFormula_, i, failingSlots_)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ShortCircuitAnalysis::mayFail(const SymbolTable::BoundFormula& boundFormula_, std::uint32_t index_, const std::vector<bool>& failingSlots_)
+{
+    const CompiledFormula& compiledFormula = *boundFormula_.compiledFormula;
+    const CompiledFormula::Node& node = compiledFormula.getNode(index_);
+
+    switch (node.opCode) {
+    case OpCode::CONSTANT: {
+        // And and Or reject all other types
+        const Value& constant = compiledFormula.getConstant(node.data);
+        return constant.isVoid() || !constant.isBool();
+    }
+
+    case OpCode::IDENTIFIER:
+        return isFailing(boundFormula_, node.data, failingSlots_);
+
+    case OpCode::NOT:
+    case OpCode::AND:
+    case OpCode::OR:
+        for (std::size_t i = 0; i < node.numOperands; ++i) {
+            if (mayFail(boundFormula_, compiledFormula.getOperand(node, i), failingSlots_)) {
+                return true;
+            }
+        }
+        return false;
+
+    case OpCode::GT_EQ:
+    case OpCode::LT_EQ:
+    case OpCode::GT:
+    case OpCode::LT:
+    case OpCode::EQ:
+    case OpCode::NOT_EQ:
+        // constants are compared as they are, whatever their type
+        for (std::size_t i = 0; i < node.numOperands; ++i) {
+            const std::uint32_t operand = compiledFormula.getOperand(node, i);
+            if (compiledFormula.getNode(operand).opCode != OpCode::CONSTANT && mayFail(boundFormula_, operand, failingSlots_)) {
+                return true;
+            }
+        }
+        return false;
+
+    default:
+        // function calls, arithmetic operators and built-in functions
+        return true;
+    }
+}
+
+bool ShortCircuitAnalysis::isFailing(const SymbolTable::BoundFormula& boundFormula_, std::uint32_t identifier_, const std::vector<bool>& failingSlots_)
+{
+    const std::uint32_t slot = identifier_ < boundFormula_.slots.size() ? boundFormula_.slots[identifier_] : SymbolTable::NO_SLOT;
+    return slot < failingSlots_.size() && failingSlots_[slot];
+}
+
+} // namespace CalculusPrime
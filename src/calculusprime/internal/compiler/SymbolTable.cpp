@@ -0,0 +1,57 @@
+/*
+Copyright 2019 Association for the promotion of open - source insurance software and for the establishment of open interface standards in the insurance industry
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http ://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <calculusprime/internal/compiler/SymbolTable.h>
+#include <boost/algorithm/string/case_conv.hpp>
+#include <calculusprime/internal/compiler/CompiledFormula.h>
+
+namespace bal = boost::algorithm;
+
+namespace CalculusPrime {
+
+const std::uint32_t SymbolTable::NO_SLOT;
+
+std::uint32_t SymbolTable::addSymbol(const std::string& variableName_)
+{
+    // variables are not case sensitive
+    return m_symbols.emplace(bal::to_lower_copy(variableName_), static_cast<std::uint32_t>(m_symbols.size())).first->second;
+}
+
+std::uint32_t SymbolTable::findSymbol(const std::string& variableName_) const
+{
+    SymbolMap_t::const_iterator it = m_symbols.find(bal::to_lower_copy(variableName_));
+    return it != m_symbols.end() ? it->second : NO_SLOT;
+}
+
+const SymbolTable::BoundFormula& SymbolTable::bind(const std::string& cacheKey_, const std::shared_ptr<CompiledFormula>& compiledFormula_, const FunctionMap_t& functions_)
+{
+    std::pair<FormulaMap_t::iterator, bool> inserted = m_formulas.emplace(cacheKey_, BoundFormula());
+    BoundFormula& boundFormula = inserted.first->second;
+    if (inserted.second) {
+        boundFormula.compiledFormula = compiledFormula_;
+        boundFormula.slots.reserve(compiledFormula_->getNumberOfIdentifiers());
+        for (std::uint32_t i = 0; i < compiledFormula_->getNumberOfIdentifiers(); ++i) {
+            boundFormula.slots.push_back(addSymbol(compiledFormula_->getIdentifier(i)));
+        }
+        boundFormula.functions.reserve(compiledFormula_->getNumberOfCallSites());
+        for (std::uint32_t i = 0; i < compiledFormula_->getNumberOfCallSites(); ++i) {
+            FunctionMap_t::const_iterator it = functions_.find(compiledFormula_->getCallSite(i).functionId);
+            boundFormula.functions.push_back(it != functions_.end() ? it->second.get() : nullptr);
+        }
+    }
+    return boundFormula;
+}
+
+} // namespace CalculusPrime
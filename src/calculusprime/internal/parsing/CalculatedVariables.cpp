@@ -0,0 +1,40 @@
+/*
+Copyright 2019 Association for the promotion of open - source insurance software and for the establishment of open interface standards in the insurance industry
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http ://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <calculusprime/internal/parsing/CalculatedVariables.h>
+#include <calculusprime/internal/ParsingContext.h>
+
+namespace CalculusPrime {
+
+CalculatedVariables::CalculatedVariables(std::size_t numberOfVariables_, std::size_t numberOfInstances_)
+    : m_numberOfInstances(numberOfInstances_)
+    , m_values(numberOfVariables_ * numberOfInstances_)
+{
+    m_valueHolders.reserve(numberOfVariables_);
+    for (std::size_t i = 0; i < numberOfVariables_; ++i) {
+        m_valueHolders.emplace_back(*this, i);
+    }
+}
+
+CalculatedVariables::~CalculatedVariables()
+{
+}
+
+boost::optional<Value> CalculatedVariables::CalculatedValueHolder::getValue(const std::shared_ptr<ParsingContext>& parsingContext_)
+{
+    return m_calculatedVariables.getValue(m_variable, parsingContext_->getInstanceOrdinal());
+}
+
+} // namespace CalculusPrime
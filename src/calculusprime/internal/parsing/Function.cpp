@@ -25,6 +25,7 @@ limitations under the License.
 #include <calculusprime/Logging.h>
 #include <calculusprime/internal/ParsingContext.h>
 #include <calculusprime/internal/parsing/FunctionArgument.h>
+#include <calculusprime/internal/parsing/FunctionMemo.h>
 #include <calculusprime/internal/parsing/Parser.h>
 
 namespace bal = boost::algorithm;
@@ -39,8 +40,11 @@ const std::regex& getRegex()
 
 namespace CalculusPrime {
 
+const std::size_t Function::MAX_SHARED_RESULTS;
+
 Function::Function(const std::string& header_, const std::string& implementation_)
     : m_implementation(implementation_)
+    , m_pure(false)
 {
     const std::regex& rgx(getRegex());
     std::smatch matches;
@@ -75,15 +79,31 @@ Value Function::execute(const std::vector<Value>& params_, const std::shared_ptr
         BOOST_THROW_EXCEPTION(std::runtime_error(msg.str()));
     }
 
-    // create a copy of parsingContext_
-    std::shared_ptr<ParsingContext> parsingContext(std::make_shared<ParsingContext>(std::static_pointer_cast<ParsingContext>(parsingContext_)));
+    const std::shared_ptr<ParsingContext> parentContext(std::static_pointer_cast<ParsingContext>(parsingContext_));
+    FunctionMemo* const memo = m_pure ? &parentContext->getFunctionMemo() : nullptr;
+    if (memo != nullptr) {
+        if (const Value* result = memo->find(this, params_)) {
+            return *result;
+        }
+        if (m_sharedResults) {
+            const boost::optional<Value> result = findSharedResult(params_);
+            if (result) {
+                memo->insert(this, params_, *result);
+                return *result;
+            }
+        }
+    }
+
+    // create a child scope of parsingContext_ for the arguments, the scope and the arguments are allocated from the arena of the calculation
+    const ArenaAllocator<ParsingContext> allocator(parentContext->getArena());
+    std::shared_ptr<ParsingContext> parsingContext(std::allocate_shared<ParsingContext>(allocator, parentContext));
     Parser parser(parsingContext);
     std::ostringstream oss;
     oss << m_name << '(';
 
     for (std::size_t i = 0; i < m_arguments.size(); ++i) {
         const Value& param = params_[i];
-        parsingContext->assignParam(m_arguments[i], std::make_shared<FunctionArgument>(param));
+        parsingContext->assignParam(m_arguments[i], std::allocate_shared<FunctionArgument>(allocator, param));
         if (i != 0) {
             oss << ',';
         }
@@ -93,7 +113,35 @@ Value Function::execute(const std::vector<Value>& params_, const std::shared_ptr
     log4cplus::NDCContextCreator ndc(oss.str());
 
     Value value = parser.parse(m_functionId, m_implementation);
+    if (memo != nullptr) {
+        // errors are not memoized, they are thrown again by the next call
+        memo->insert(this, params_, value);
+        if (m_sharedResults) {
+            shareResult(params_, value);
+        }
+    }
     return value;
 }
 
+void Function::setPure(bool pure_, bool shareResults_)
+{
+    m_pure = pure_;
+    m_sharedResults.reset(pure_ && shareResults_ ? new FunctionMemo() : nullptr);
+}
+
+boost::optional<Value> Function::findSharedResult(const std::vector<Value>& params_)
+{
+    std::lock_guard<std::mutex> lock(m_sharedResultsMutex);
+    const Value* result = m_sharedResults->find(this, params_);
+    return result != nullptr ? boost::optional<Value>(*result) : boost::none;
+}
+
+void Function::shareResult(const std::vector<Value>& params_, const Value& result_)
+{
+    std::lock_guard<std::mutex> lock(m_sharedResultsMutex);
+    if (m_sharedResults->size() < MAX_SHARED_RESULTS && m_sharedResults->find(this, params_) == nullptr) {
+        m_sharedResults->insert(this, params_, result_);
+    }
+}
+
 } // namespace CalculusPrime
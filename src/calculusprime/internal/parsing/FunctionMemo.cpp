@@ -0,0 +1,99 @@
+/*
+Copyright 2019 Association for the promotion of open - source insurance software and for the establishment of open interface standards in the insurance industry
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http ://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <calculusprime/internal/parsing/FunctionMemo.h>
+#include <functional>
+#include <boost/functional/hash.hpp>
+
+namespace CalculusPrime {
+
+namespace {
+bool identical(const Value& lhs_, const Value& rhs_)
+{
+    if (lhs_.isVoid() || rhs_.isVoid()) {
+        return lhs_.isVoid() && rhs_.isVoid();
+    }
+    if (lhs_.isDouble()) {
+        return rhs_.isDouble() && lhs_.asDouble() == rhs_.asDouble();
+    }
+    if (lhs_.isBool()) {
+        return rhs_.isBool() && lhs_.asBool() == rhs_.asBool();
+    }
+    return rhs_.isString() && lhs_.asStringView() == rhs_.asStringView();
+}
+
+bool identical(const std::vector<Value>& lhs_, const std::vector<Value>& rhs_)
+{
+    if (lhs_.size() != rhs_.size()) {
+        return false;
+    }
+    for (std::size_t i = 0; i < lhs_.size(); ++i) {
+        if (!identical(lhs_[i], rhs_[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+}
+
+FunctionMemo::FunctionMemo()
+{
+}
+
+FunctionMemo::~FunctionMemo()
+{
+}
+
+const Value* FunctionMemo::find(const IFunction* function_, const std::vector<Value>& arguments_) const
+{
+    const std::pair<Results_t::const_iterator, Results_t::const_iterator> range = m_results.equal_range(hash(function_, arguments_));
+    for (Results_t::const_iterator it = range.first; it != range.second; ++it) {
+        if (it->second.function == function_ && identical(it->second.arguments, arguments_)) {
+            return &it->second.result;
+        }
+    }
+    return nullptr;
+}
+
+void FunctionMemo::insert(const IFunction* function_, const std::vector<Value>& arguments_, const Value& result_)
+{
+    Entry entry = { function_, arguments_, result_ };
+    m_results.emplace(hash(function_, arguments_), std::move(entry));
+}
+
+std::size_t FunctionMemo::hash(const IFunction* function_, const std::vector<Value>& arguments_)
+{
+    std::size_t seed = std::hash<const IFunction*>()(function_);
+    for (const Value& argument : arguments_) {
+        if (argument.isVoid()) {
+            boost::hash_combine(seed, 0);
+        }
+        else if (argument.isDouble()) {
+            // 0.0 and -0.0 are identical
+            const double number = argument.asDouble();
+            boost::hash_combine(seed, number == 0.0 ? 0.0 : number);
+        }
+        else if (argument.isBool()) {
+            boost::hash_combine(seed, argument.asBool());
+        }
+        else {
+            const boost::string_view str = argument.asStringView();
+            boost::hash_combine(seed, boost::hash_range(str.begin(), str.end()));
+        }
+    }
+    return seed;
+}
+
+} // namespace CalculusPrime
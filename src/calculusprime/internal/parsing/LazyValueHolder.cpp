@@ -24,28 +24,76 @@ namespace CalculusPrime {
 
 boost::optional<Value> LazyValueHolder::getValue(const std::shared_ptr<ParsingContext>& parsingContext_)
 {
-    const std::string& instanceId = parsingContext_->getInstanceId();
-    ValueHolder::ValueMap_t::const_iterator it = m_value->find(instanceId);
-    if (it == m_value->end()) {
-        // value has not been calculated yet
-        log4cplus::NDCContextCreator ndc(m_variableName);
-        Parser parser(parsingContext_);
-        Value value = parser.parse(m_variableName, m_formula);
-        (*m_value)[instanceId] = value;
+    static const std::string noInstanceId;
+    const std::string& instanceId = m_instanceInvariant ? noInstanceId : parsingContext_->getInstanceId();
+    std::promise<Value> promise;
+    std::shared_future<Value> calculation;
+    bool calculating = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ValueHolder::ValueMap_t::const_iterator it = m_value.find(instanceId);
+        if (it != m_value.end()) {
+            return it->second;
+        }
+        auto inserted = m_calculations.emplace(instanceId, Calculation{ std::this_thread::get_id(), std::shared_future<Value>() });
+        if (inserted.second) {
+            inserted.first->second.result = promise.get_future().share();
+            calculating = true;
+        }
+        else if (inserted.first->second.thread != std::this_thread::get_id()) {
+            calculation = inserted.first->second.result;
+        }
+    }
+    if (calculation.valid()) {
+        // another thread calculates the value, an error is reported to all threads which wait for it
+        return calculation.get();
+    }
 
-        LOG4CPLUS_DEBUG(log4cplus::Logger::getInstance(LOGGER_CALCULUSPRIME), "result=" << value);
+    // value has not been calculated yet. It is calculated outside of the lock, so the threads which calculate other instances
+    // or other formulas are not blocked. A formula which references itself is calculated again, the value added first is used.
+    log4cplus::NDCContextCreator ndc(m_variableName);
+    Value value;
+    std::shared_ptr<ValueHolder::ValueMap_t> values;
+    try {
+        Parser parser(parsingContext_);
+        value = parser.parse(m_variableName, m_formula);
 
+        std::lock_guard<std::mutex> lock(m_mutex);
+        value = m_value.emplace(instanceId, value).first->second;
+        if (calculating) {
+            m_calculations.erase(instanceId);
+        }
         if (instanceId.empty()) {
-            // we put the result as static value into the context,
-            // so it is not lazy any more
-            // this cannot be done when multiple instances exist
-            parsingContext_->assignParam(m_variableName, std::make_shared<ValueHolder>(m_value));
+            // the values are copied to the arena of the parsing context, other parsing contexts may still calculate values of other instances
+            const ArenaAllocator<ValueHolder> allocator(parsingContext_->getArena());
+            values = std::allocate_shared<ValueHolder::ValueMap_t>(allocator, m_value, allocator);
+        }
+    }
+    catch (...) {
+        if (calculating) {
+            // the next reader calculates the value again
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_calculations.erase(instanceId);
+            }
+            promise.set_exception(std::current_exception());
         }
-        return value;
+        throw;
     }
-    else {
-        return it->second;
+    if (calculating) {
+        promise.set_value(value);
+    }
+
+    LOG4CPLUS_DEBUG(log4cplus::Logger::getInstance(LOGGER_CALCULUSPRIME), "result=" << value);
+
+    if (values) {
+        // we put the result as static value into the context,
+        // so it is not lazy any more
+        // this cannot be done when multiple instances exist, unless the formula is instance invariant.
+        const ArenaAllocator<ValueHolder> allocator(parsingContext_->getArena());
+        parsingContext_->assignParam(m_variableName, std::allocate_shared<ValueHolder>(allocator, values));
     }
+    return value;
 }
 
 } // namespace CalculusPrime
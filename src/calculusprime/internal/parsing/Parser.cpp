@@ -20,7 +20,11 @@ limitations under the License.
 #include <boost/throw_exception.hpp>
 #include <calculusprime/Logging.h>
 #include <calculusprime/internal/parsing/ParserHolder.h>
-#include <calculusprime/internal/parsing/EvalVisitor.h>
+#include <calculusprime/internal/compiler/BytecodeCompiler.h>
+#include <calculusprime/internal/compiler/BytecodeInterpreter.h>
+#include <calculusprime/internal/compiler/ConstantFolder.h>
+#include <calculusprime/internal/compiler/FormulaCompiler.h>
+#include <calculusprime/internal/compiler/FormulaEvaluator.h>
 #include <calculusprime/internal/parsing/ParsingException.h>
 #include <calculusprime/internal/ParsingContext.h>
 #include <calculusprime/RatingEngineException.h>
@@ -38,8 +42,6 @@ Value Parser::parse(const std::string& variableName_, const std::string& formula
 {
     typedef std::chrono::high_resolution_clock Clock_t;
 
-    using namespace antlr4;
-
     log4cplus::Logger logger = m_parsingContext->getLogger();
     LOG4CPLUS_TRACE_STR(logger, "start parse " + variableName_ + " " + formula_);
 
@@ -52,59 +54,24 @@ Value Parser::parse(const std::string& variableName_, const std::string& formula
     BOOST_SCOPE_EXIT_END
 
     try {
-        std::shared_ptr<IParseTreeCache> cache = m_parsingContext->getParseTreeCache();
-        const std::string& insuranceRateKey = m_parsingContext->getInsuranceRateKey();
-
-        std::shared_ptr<ParserHolder> parserHolder = std::static_pointer_cast<ParserHolder>(cache->getParseTree(insuranceRateKey, variableName_));
-
-        if (!parserHolder) {
-            std::string formulaForStream(formula_);
-
-            // Make sure the formula ends with a line feed. Otherwise a line comment '//' in the last line
-            // is not recognized
-            if (!bal::ends_with(formulaForStream, "\n")) {
-                formulaForStream.append(1, '\n');
-            }
-
-            parserHolder.reset(new ParserHolder());
-
-            try {
-                parserHolder->parse(formulaForStream);
-            }
-            catch (const ParseCancellationException& ex) {
-                try {
-                    std::rethrow_if_nested(ex);
-                }
-                catch (const RecognitionException& nested) {
-                    Token* token = nested.getOffendingToken();
-                    std::ostringstream msg;
-                    msg << "Error while parsing formula " << variableName_ << ": "
-                        << "Parsing error at line " << token->getLine() << ':' << token->getCharPositionInLine() << ' ' << nested.what()
-                        << " formula=" << formula_;
-                    BOOST_THROW_EXCEPTION(ParsingException(msg.str()));
-                }
-                catch (const std::exception& nested) {
-                    std::ostringstream msg;
-                    msg << "Error while parsing formula " << variableName_ << ": " "ParseCancellationException: " << ex.what() << " nested: " << nested.what() << " formula=" << formula_;
-                    BOOST_THROW_EXCEPTION(ParsingException(msg.str()));
-                }
-                throw;
-            }
-            catch (const std::exception& ex) {
-                const std::vector<std::string>& errors = parserHolder->getErrors();
-                std::ostringstream msg;
-                msg << "Error while parsing formula " << variableName_ << ": " << (!errors.empty() ? errors[0] : std::string()) << ' ' << ex.what() << " formula=" << formula_;
-                BOOST_THROW_EXCEPTION(ParsingException(msg.str()));
-            }
-            cache->putParseTree(insuranceRateKey, variableName_, parserHolder);
-        }
+        // formulas of a prepared tariff are bound to its symbol table, their variables are resolved by slot
+        const SymbolTable* symbolTable = m_parsingContext->getSymbolTable().get();
+        const SymbolTable::BoundFormula* boundFormula = symbolTable != nullptr ? symbolTable->findFormula(variableName_) : nullptr;
 
-        EvalVisitor visitor(m_parsingContext);
-        try {
-            visitor.visit(parserHolder->getParseTree());
+        const std::shared_ptr<CompiledFormula> compiledFormula = boundFormula != nullptr ? boundFormula->compiledFormula : getCompiledFormula(variableName_, formula_);
+
+        boost::optional<Value> result;
+        if (m_parsingContext->getEvaluationBackend() == EvaluationBackend::BYTECODE) {
+            BytecodeInterpreter interpreter(m_parsingContext, *compiledFormula, boundFormula);
+            result = interpreter.execute();
         }
-        catch (const Value& value) {
-            return value;
+        else {
+            FormulaEvaluator evaluator(m_parsingContext, *compiledFormula, boundFormula);
+            result = evaluator.execute();
+        }
+
+        if (result) {
+            return *result;
         }
     }
     catch (const ParsingException&) {
@@ -120,4 +87,69 @@ Value Parser::parse(const std::string& variableName_, const std::string& formula
     BOOST_THROW_EXCEPTION(ParsingException("Calculating formula " + variableName_ + " did not return a result, formula=" + formula_));
 }
 
+std::shared_ptr<CompiledFormula> Parser::getCompiledFormula(const std::string& variableName_, const std::string& formula_)
+{
+    std::shared_ptr<IParseTreeCache> cache = m_parsingContext->getParseTreeCache();
+    const std::string& insuranceRateKey = m_parsingContext->getInsuranceRateKey();
+
+    std::shared_ptr<CompiledFormula> compiledFormula = std::static_pointer_cast<CompiledFormula>(cache->getParseTree(insuranceRateKey, variableName_));
+
+    if (!compiledFormula) {
+        compiledFormula = compile(variableName_, formula_);
+        cache->putParseTree(insuranceRateKey, variableName_, compiledFormula);
+    }
+    return compiledFormula;
+}
+
+std::shared_ptr<CompiledFormula> Parser::compile(const std::string& variableName_, const std::string& formula_)
+{
+    using namespace antlr4;
+
+    std::string formulaForStream(formula_);
+
+    // Make sure the formula ends with a line feed. Otherwise a line comment '//' in the last line
+    // is not recognized
+    if (!bal::ends_with(formulaForStream, "\n")) {
+        formulaForStream.append(1, '\n');
+    }
+
+    // the parse tree is only needed for the compilation
+    ParserHolder parserHolder;
+
+    try {
+        parserHolder.parse(formulaForStream);
+    }
+    catch (const ParseCancellationException& ex) {
+        try {
+            std::rethrow_if_nested(ex);
+        }
+        catch (const RecognitionException& nested) {
+            Token* token = nested.getOffendingToken();
+            std::ostringstream msg;
+            msg << "Error while parsing formula " << variableName_ << ": "
+                << "Parsing error at line " << token->getLine() << ':' << token->getCharPositionInLine() << ' ' << nested.what()
+                << " formula=" << formula_;
+            BOOST_THROW_EXCEPTION(ParsingException(msg.str()));
+        }
+        catch (const std::exception& nested) {
+            std::ostringstream msg;
+            msg << "Error while parsing formula " << variableName_ << ": " "ParseCancellationException: " << ex.what() << " nested: " << nested.what() << " formula=" << formula_;
+            BOOST_THROW_EXCEPTION(ParsingException(msg.str()));
+        }
+        throw;
+    }
+    catch (const std::exception& ex) {
+        const std::vector<std::string>& errors = parserHolder.getErrors();
+        std::ostringstream msg;
+        msg << "Error while parsing formula " << variableName_ << ": " << (!errors.empty() ? errors[0] : std::string()) << ' ' << ex.what() << " formula=" << formula_;
+        BOOST_THROW_EXCEPTION(ParsingException(msg.str()));
+    }
+
+    std::shared_ptr<CompiledFormula> compiledFormula = FormulaCompiler::compile(parserHolder.getParseTree(), formulaForStream);
+    ConstantFolder::fold(*compiledFormula);
+    // the bytecode is always generated, so engines with different backends can share the parse tree cache
+    compiledFormula->setBytecode(BytecodeCompiler::compile(*compiledFormula));
+    return compiledFormula;
+}
+
 } // namespace CalculusPrime
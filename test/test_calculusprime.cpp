@@ -13,23 +13,40 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License.
 */
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <iostream>
 #include <memory>
+#include <thread>
 #include <boost/program_options.hpp>
 #include <boost/test/included/unit_test_framework.hpp>
 #include <boost/test/unit_test.hpp>
 #include <log4cplus/configurator.h>
 #include <log4cplus/logger.h>
+#include <calculusprime/cache/BoundedFunctionResultCache.h>
+#include <calculusprime/cache/ConcurrentFunctionResultCache.h>
 #include <calculusprime/cache/DefaultCacheFactory.h>
 #include <calculusprime/cache/DefaultFunctionResultCache.h>
 #include <calculusprime/cache/DefaultParseTreeCache.h>
+#include <calculusprime/cache/TwoLevelFunctionResultCache.h>
+#include <calculusprime/cache/TwoLevelParseTreeCache.h>
+#include <calculusprime/cache/ValidityPeriods.h>
+#include <calculusprime/internal/Arena.h>
+#include <calculusprime/internal/compiler/CompiledFormula.h>
+#include <calculusprime/internal/compiler/SymbolTable.h>
 #include <calculusprime/internal/defs.h>
 #include <calculusprime/internal/parsing/Function.h>
+#include <calculusprime/internal/parsing/FunctionArgument.h>
+#include <calculusprime/internal/parsing/FunctionMemo.h>
 #include <calculusprime/internal/parsing/Parser.h>
 #include <calculusprime/internal/parsing/ParsingException.h>
 #include <calculusprime/internal/parsing/ValueHolder.h>
 #include <calculusprime/internal/ParsingContext.h>
 #include <calculusprime/internal/RatingEngine.h>
+#include <calculusprime/internal/SynchronizedFunctionResultCache.h>
 #include <calculusprime/RatingEngineException.h>
+#include <calculusprime/RatingEngineOptions.h>
 #include <calculusprime/Value.h>
 
 using boost::unit_test_framework::test_suite;
@@ -40,6 +57,19 @@ static const std::string g_dummy("dummy");
 
 void testCalculation();
 void testInstanceCalculation();
+void testBytecodeCalculation();
+void testPreparedTariff();
+void testShortCircuitEvaluation();
+void testEvaluationOrder();
+void testDependencyGraph();
+void testParallelCalculation();
+void testBatchCalculation();
+void testColumnarEvaluation();
+void testInstanceInvariance();
+void testInstanceGroups();
+void testCalculatedVariables();
+void testFunctionMemoization();
+void testFunctionResultCaching();
 void testCalculationPerformance();
 
 namespace {
@@ -130,6 +160,59 @@ void testInvalidDates(const std::string& functionName_)
     // 2015-02-29 is not a leap year
     testParserExpectException<ParsingException>("return " + functionName_ + "('2015-02-29')");
 }
+
+// a function result cache which runs an action after a result was read, like another thread between the read and the return
+class InterleavingFunctionResultCache : public DefaultFunctionResultCache
+{
+public:
+    virtual boost::optional<Value> getFunctionResult(const std::string& insuranceRateKey_, const std::string& cacheKey_) const override
+    {
+        boost::optional<Value> result = DefaultFunctionResultCache::getFunctionResult(insuranceRateKey_, cacheKey_);
+        std::function<void()> afterRead;
+        afterRead.swap(m_afterRead);
+        if (afterRead) {
+            afterRead();
+        }
+        return result;
+    }
+
+    void setAfterRead(const std::function<void()>& afterRead_)
+    {
+        m_afterRead = afterRead_;
+    }
+
+private:
+    mutable std::function<void()> m_afterRead;
+};
+
+// a function result cache which only implements the methods every cache has to implement
+class MinimalFunctionResultCache : public IFunctionResultCache
+{
+public:
+    virtual void putFunctionResult(const std::string& insuranceRateKey_, const std::string& cacheKey_, const Value& result_) override
+    {
+        m_cache.putFunctionResult(insuranceRateKey_, cacheKey_, result_);
+    }
+
+    virtual void putFunctionResultWithValidityDate(const std::string& insuranceRateKey_, const std::string& cacheKey_, const std::string& validFrom_,
+                                                   const std::string& validTo_, const Value& result_) override
+    {
+        m_cache.putFunctionResultWithValidityDate(insuranceRateKey_, cacheKey_, validFrom_, validTo_, result_);
+    }
+
+    virtual boost::optional<Value> getFunctionResult(const std::string& insuranceRateKey_, const std::string& cacheKey_) const override
+    {
+        return m_cache.getFunctionResult(insuranceRateKey_, cacheKey_);
+    }
+
+    virtual boost::optional<Value> getFunctionResultWithValidityDate(const std::string& insuranceRateKey_, const std::string& date_, const std::string& cacheKey_) const override
+    {
+        return m_cache.getFunctionResultWithValidityDate(insuranceRateKey_, date_, cacheKey_);
+    }
+
+private:
+    DefaultFunctionResultCache m_cache;
+};
 }
 
 void testValue()
@@ -157,6 +240,25 @@ void testValue()
     BOOST_CHECK(!v4.isBool());
     BOOST_CHECK(!v4.isString());
     BOOST_CHECK(v4.isDouble());
+
+    // strings are shared by copies
+    BOOST_CHECK(sizeof(Value) <= 16);
+    Value v5("a string which does not fit into a small string buffer");
+    Value v6(v5);
+    BOOST_CHECK(v5.asStringView().data() == v6.asStringView().data());
+    BOOST_CHECK_EQUAL(v6.asString(), "a string which does not fit into a small string buffer");
+    v5 = v4;
+    BOOST_CHECK(v5.isDouble());
+    BOOST_CHECK_EQUAL(v6, Value(std::string("a string which does not fit into a small string buffer")));
+    BOOST_CHECK(v2.asStringView().empty());
+
+    // conversion from the variant and the order of the variant types
+    BOOST_CHECK_EQUAL(Value(Value::Variant_t(std::string("abc"))), Value("abc"));
+    BOOST_CHECK_EQUAL(Value(Value::Variant_t(1.5)), Value(1.5));
+    BOOST_CHECK_EQUAL(Value(Value::Variant_t(false)), Value(false));
+    BOOST_CHECK(Value("abc") < Value("abd"));
+    BOOST_CHECK(Value("abc") < Value(1.0));
+    BOOST_CHECK(Value(1.0) < Value(false));
 }
 
 /**
@@ -503,6 +605,79 @@ void testRecursiveFunctionCall()
     testParser(parsingContext, "return factorial(5)", Value(120.0));
 }
 
+/**
+* tests that nested function calls only see their own arguments and the variables of the enclosing scopes
+*/
+void testFunctionScope()
+{
+    std::shared_ptr<IFunctionResultCache> functionResultCache(std::make_shared<DefaultFunctionResultCache>());
+    std::shared_ptr<IParseTreeCache> parseTreeCache(std::make_shared<DefaultParseTreeCache>());
+    std::shared_ptr<ParsingContext> parsingContext(std::make_shared<ParsingContext>(std::vector<std::shared_ptr<IFunction>>(), functionResultCache, parseTreeCache, g_dummyVtarKey, log4cplus::Logger::getRoot()));
+
+    assignParamToParsingContext(parsingContext, "faktor", 2.0);
+
+    parsingContext->addFunction(std::make_shared<Function>("inner(x)", "return x*faktor"));
+    parsingContext->addFunction(std::make_shared<Function>("outer(x, y)", "return inner(y)+x"));
+    parsingContext->addFunction(std::make_shared<Function>("sum(n)", "if (n = 0) then return 0 else return inner(n)+sum(n-1) end"));
+
+    testParser(parsingContext, "return outer(1, 10)", Value(21.0));
+    testParser(parsingContext, "return sum(10)", Value(110.0));
+
+    // a child scope only binds its own variables
+    std::shared_ptr<ParsingContext> scope(std::make_shared<ParsingContext>(parsingContext));
+    scope->assignParam("x", std::make_shared<FunctionArgument>(Value(3.0)));
+    std::shared_ptr<ParsingContext> nestedScope(std::make_shared<ParsingContext>(scope));
+    BOOST_CHECK_EQUAL(Value(3.0), scope->resolve("X"));
+    BOOST_CHECK_EQUAL(Value(2.0), nestedScope->resolve("faktor"));
+    BOOST_CHECK_THROW(nestedScope->resolve("x"), RatingEngineException);
+    BOOST_CHECK_THROW(parsingContext->resolve("x"), RatingEngineException);
+}
+
+/**
+* tests the memoized results of pure functions
+*/
+void testFunctionMemo()
+{
+    const std::shared_ptr<Function> twice(std::make_shared<Function>("twice(x)", "return x*2"));
+    const std::shared_ptr<Function> concat(std::make_shared<Function>("concat(a, b)", "return a+b"));
+
+    // arguments are compared exactly
+    FunctionMemo memo;
+    memo.insert(twice.get(), { Value(1.0) }, Value(2.0));
+    memo.insert(concat.get(), { Value("a"), Value("b") }, Value("ab"));
+    memo.insert(twice.get(), { Value(0.0) }, Value(0.0));
+    BOOST_CHECK_EQUAL(3u, memo.size());
+    BOOST_REQUIRE(memo.find(twice.get(), { Value(1.0) }) != nullptr);
+    BOOST_CHECK_EQUAL(Value(2.0), *memo.find(twice.get(), { Value(1.0) }));
+    BOOST_CHECK(memo.find(twice.get(), { Value(1.0 + 1e-13) }) == nullptr);
+    BOOST_CHECK(memo.find(twice.get(), { Value("1") }) == nullptr);
+    BOOST_CHECK(memo.find(concat.get(), { Value(1.0) }) == nullptr);
+    BOOST_CHECK(memo.find(twice.get(), { Value(-0.0) }) != nullptr);
+    BOOST_REQUIRE(memo.find(concat.get(), { Value("a"), Value("b") }) != nullptr);
+    BOOST_CHECK_EQUAL(Value("ab"), *memo.find(concat.get(), { Value("a"), Value("b") }));
+    BOOST_CHECK(memo.find(concat.get(), { Value("ab"), Value("") }) == nullptr);
+
+    std::shared_ptr<IFunctionResultCache> functionResultCache(std::make_shared<DefaultFunctionResultCache>());
+    std::shared_ptr<IParseTreeCache> parseTreeCache(std::make_shared<DefaultParseTreeCache>());
+    for (bool shareResults : { false, true }) {
+        std::shared_ptr<ParsingContext> parsingContext(std::make_shared<ParsingContext>(std::vector<std::shared_ptr<IFunction>>(), functionResultCache, parseTreeCache, g_dummyVtarKey, log4cplus::Logger::getRoot()));
+        const std::shared_ptr<Function> pure(std::make_shared<Function>("pure(x)", "return x*2"));
+        pure->setPure(true, shareResults);
+        parsingContext->addFunction(pure);
+        parsingContext->addFunction(std::make_shared<Function>("impure(x)", "return x*3"));
+
+        // only the results of pure functions are memoized, once per arguments
+        testParser(parsingContext, "return pure(3) + pure(3) + pure(4) + impure(3)", Value(23.0));
+        BOOST_CHECK_EQUAL(2u, parsingContext->getFunctionMemo().size());
+
+        // a context for another thread has its own memo
+        std::shared_ptr<ParsingContext> otherThread(std::make_shared<ParsingContext>(parsingContext, false));
+        testParser(otherThread, "return pure(3)", Value(6.0));
+        BOOST_CHECK_EQUAL(1u, otherThread->getFunctionMemo().size());
+        BOOST_CHECK_EQUAL(2u, parsingContext->getFunctionMemo().size());
+    }
+}
+
 /**
 * tests bool expressions
 */
@@ -577,6 +752,687 @@ void testExpFunction()
     testParserExpectException<ParsingException>("return exp(999999.0)");
 }
 
+/**
+* tests that a cached compiled formula is evaluated with the current parameter values
+*/
+void testCompiledFormulaCache()
+{
+    std::shared_ptr<IFunctionResultCache> functionResultCache(std::make_shared<DefaultFunctionResultCache>());
+    std::shared_ptr<IParseTreeCache> parseTreeCache(std::make_shared<DefaultParseTreeCache>());
+    const std::string formula("if (faktor > 1) then return 'high: ' + faktor * 2 else return faktor * 2 end");
+
+    std::shared_ptr<ParsingContext> parsingContext(std::make_shared<ParsingContext>(std::vector<std::shared_ptr<IFunction>>(), functionResultCache, parseTreeCache, g_dummyVtarKey, log4cplus::Logger::getRoot()));
+    assignParamToParsingContext(parsingContext, "faktor", 0.5);
+    BOOST_CHECK_EQUAL(Value(1.0), Parser(parsingContext).parse("cached", formula));
+    BOOST_CHECK(parseTreeCache->getParseTree(g_dummyVtarKey, "cached"));
+
+    std::shared_ptr<ParsingContext> parsingContext2(std::make_shared<ParsingContext>(std::vector<std::shared_ptr<IFunction>>(), functionResultCache, parseTreeCache, g_dummyVtarKey, log4cplus::Logger::getRoot()));
+    assignParamToParsingContext(parsingContext2, "faktor", 2.0);
+    BOOST_CHECK_EQUAL(Value("high: 4"), Parser(parsingContext2).parse("cached", formula));
+}
+
+/**
+* tests that the bytecode backend calculates the same results as the tree evaluation
+*/
+void testBytecodeBackend()
+{
+    std::shared_ptr<IFunctionResultCache> functionResultCache(std::make_shared<DefaultFunctionResultCache>());
+    std::shared_ptr<IParseTreeCache> parseTreeCache(std::make_shared<DefaultParseTreeCache>());
+    std::vector<std::shared_ptr<IFunction>> functions{ std::make_shared<Function>("twice(x)", "return x * 2") };
+
+    const std::vector<std::pair<std::string, Value>> formulas{
+        { "return faktor * 2 + 1", Value(4.0) },
+        { "return -faktor ^ 2 / 4", Value(0.5625) },
+        { "return (10 mod 7) + max(faktor, 2) + rnd(3.456, 2)", Value(8.46) },
+        { "return 'faktor: ' + faktor", Value("faktor: 1.5") },
+        { "return 'ab' * 2", Value("abab") },
+        { "return substr('abcdef', 2, 3) + year('2016-01-20')", Value("bcd2016") },
+        { "return twice(faktor) = 3 and !(faktor <> 1.5)", Value(true) },
+        { "if (faktor < 1) then return 'A' else if (faktor >= 1.5) then if (faktor > 2) then return 'B' else return 'C' end else return 'D' end", Value("C") }
+    };
+
+    for (const EvaluationBackend backend : { EvaluationBackend::TREE, EvaluationBackend::BYTECODE }) {
+        std::shared_ptr<ParsingContext> parsingContext(std::make_shared<ParsingContext>(functions, functionResultCache, parseTreeCache, g_dummyVtarKey, log4cplus::Logger::getRoot()));
+        parsingContext->setEvaluationBackend(backend);
+        assignParamToParsingContext(parsingContext, "faktor", 1.5);
+
+        // both backends use the same cached compiled formulas
+        for (std::size_t i = 0; i < formulas.size(); ++i) {
+            BOOST_CHECK_EQUAL(formulas[i].second, Parser(parsingContext).parse("bytecode" + std::to_string(i), formulas[i].first));
+        }
+
+        try {
+            Parser(parsingContext).parse("bytecodeDivision", "return faktor / 0");
+            BOOST_ERROR("this code shouldn't have been reached");
+        }
+        catch (const RatingEngineException& ex) {
+            BOOST_CHECK_EQUAL(ex.getErrorType(), RatingEngineError::DIVISION_BY_ZERO);
+        }
+        BOOST_CHECK_THROW(Parser(parsingContext).parse("bytecodeIllegal", "return true - faktor"), ParsingException);
+        BOOST_CHECK_THROW(Parser(parsingContext).parse("bytecodeNoResult", "if (faktor > 2) then return 1 end"), ParsingException);
+    }
+}
+
+/**
+* tests that the formulas bound to a symbol table resolve their variables by slot and their functions by call site
+*/
+void testSymbolTable()
+{
+    std::shared_ptr<IFunctionResultCache> functionResultCache(std::make_shared<DefaultFunctionResultCache>());
+    std::shared_ptr<IParseTreeCache> parseTreeCache(std::make_shared<DefaultParseTreeCache>());
+    std::shared_ptr<ParsingContext::FunctionMap_t> functions(std::make_shared<ParsingContext::FunctionMap_t>());
+    std::shared_ptr<Function> function(std::make_shared<Function>("scaled(x)", "return x * Faktor"));
+    ParsingContext::addFunction(*functions, function);
+
+    const std::string formula("return scaled(faktor) + FAKTOR + summand");
+    const std::string missingFormula("return faktor + undefined");
+
+    // bind the formulas, variables are not case sensitive
+    std::shared_ptr<SymbolTable> symbolTable(std::make_shared<SymbolTable>());
+    {
+        Parser parser(std::make_shared<ParsingContext>(functions, std::shared_ptr<const SymbolTable>(), functionResultCache, parseTreeCache, g_dummyVtarKey, log4cplus::Logger::getRoot()));
+        symbolTable->bind(function->getFunctionId(), parser.getCompiledFormula(function->getFunctionId(), function->getImplementation()), *functions);
+        symbolTable->bind("slots", parser.getCompiledFormula("slots", formula), *functions);
+        symbolTable->bind("slotsMissing", parser.getCompiledFormula("slotsMissing", missingFormula), *functions);
+    }
+    BOOST_CHECK_EQUAL(symbolTable->getNumberOfSymbols(), 4U);
+    BOOST_CHECK_EQUAL(symbolTable->findSymbol("Faktor"), symbolTable->findSymbol("faktor"));
+    BOOST_CHECK_EQUAL(symbolTable->findSymbol("unknown"), SymbolTable::NO_SLOT);
+    const SymbolTable::BoundFormula* boundFormula = symbolTable->findFormula("slots");
+    BOOST_REQUIRE(boundFormula != nullptr);
+    // the call site is resolved to the function
+    BOOST_REQUIRE_EQUAL(boundFormula->functions.size(), 1U);
+    BOOST_CHECK_EQUAL(boundFormula->functions[0], function.get());
+
+    for (const EvaluationBackend backend : { EvaluationBackend::TREE, EvaluationBackend::BYTECODE }) {
+        std::shared_ptr<ParsingContext> parsingContext(std::make_shared<ParsingContext>(functions, symbolTable, functionResultCache, parseTreeCache, g_dummyVtarKey, log4cplus::Logger::getRoot()));
+        parsingContext->setEvaluationBackend(backend);
+        assignParamToParsingContext(parsingContext, "FaKtOr", 2.0);
+        assignParamToParsingContext(parsingContext, "summand", 1.0);
+        // not in the symbol table
+        assignParamToParsingContext(parsingContext, "other", 5.0);
+
+        BOOST_CHECK_EQUAL(Value(7.0), Parser(parsingContext).parse("slots", formula));
+        BOOST_CHECK_EQUAL(Value(5.0), parsingContext->resolve("OTHER"));
+        try {
+            Parser(parsingContext).parse("slotsMissing", missingFormula);
+            BOOST_ERROR("this code shouldn't have been reached");
+        }
+        catch (const RatingEngineException& ex) {
+            BOOST_CHECK_EQUAL(ex.getErrorType(), RatingEngineError::INPUT_PARAMETER_MISSING);
+        }
+    }
+}
+
+/**
+* tests that the temporary objects of a calculation are allocated from the arena
+*/
+void testArena()
+{
+    Arena arena;
+    for (std::size_t i = 0; i < 1000; ++i) {
+        const std::size_t alignment = std::size_t(1) << (i % 5);
+        const std::size_t size = i % 100 == 0 ? 100000 : i % 300;
+        void* memory = arena.allocate(size, alignment);
+        BOOST_CHECK_EQUAL(reinterpret_cast<std::uintptr_t>(memory) % alignment, 0U);
+    }
+
+    std::shared_ptr<IFunctionResultCache> functionResultCache(std::make_shared<DefaultFunctionResultCache>());
+    std::shared_ptr<IParseTreeCache> parseTreeCache(std::make_shared<DefaultParseTreeCache>());
+    {
+        Arena calculationArena;
+        const ArenaAllocator<ParsingContext> allocator(&calculationArena);
+        std::shared_ptr<ParsingContext> parsingContext(std::allocate_shared<ParsingContext>(allocator, std::vector<std::shared_ptr<IFunction>>(), functionResultCache, parseTreeCache, g_dummyVtarKey, log4cplus::Logger::getRoot()));
+        parsingContext->setArena(&calculationArena);
+
+        std::shared_ptr<ValueHolder::ValueMap_t> valueMap(std::allocate_shared<ValueHolder::ValueMap_t>(allocator, allocator));
+        (*valueMap)[std::string()] = Value(0.8);
+        parsingContext->assignParam("faktor", std::allocate_shared<ValueHolder>(allocator, valueMap));
+
+        // the contexts and the arguments of the function calls share the arena
+        parsingContext->addFunction(std::make_shared<Function>("F_Rabatt(input)", "return input*faktor"));
+        parsingContext->addFunction(std::make_shared<Function>("F_Rabatt(input, input2)", "return F_Rabatt(input)*input2+input"));
+        for (int i = 0; i < 100; ++i) {
+            testParser(parsingContext, "return F_Rabatt(2000, 10)", Value(18000.0));
+        }
+    }
+}
+
+/**
+* tests the results with validity dates of the default function result cache
+*/
+void testFunctionResultCacheValidity()
+{
+    // yearly rates, stored in random order
+    DefaultFunctionResultCache cache;
+    for (int i = 0; i < 50; ++i) {
+        const int year = 1970 + (i * 17) % 50;
+        cache.putFunctionResultWithValidityDate(g_dummyVtarKey, "rate", std::to_string(year) + "-01-01", std::to_string(year) + "-12-31", Value(static_cast<double>(year)));
+    }
+    cache.putFunctionResultWithValidityDate(g_dummyVtarKey, "rate", "1990-01-01", "1990-12-31", Value(1990.0));
+    for (int year = 1970; year < 2020; ++year) {
+        const std::string date(std::to_string(year));
+        BOOST_CHECK_EQUAL(Value(static_cast<double>(year)), *cache.getFunctionResultWithValidityDate(g_dummyVtarKey, date + "-01-01", "rate"));
+        BOOST_CHECK_EQUAL(Value(static_cast<double>(year)), *cache.getFunctionResultWithValidityDate(g_dummyVtarKey, date + "-06-15", "rate"));
+        BOOST_CHECK_EQUAL(Value(static_cast<double>(year)), *cache.getFunctionResultWithValidityDate(g_dummyVtarKey, date + "-12-31", "rate"));
+    }
+    BOOST_CHECK(!cache.getFunctionResultWithValidityDate(g_dummyVtarKey, "1969-12-31", "rate"));
+    BOOST_CHECK(!cache.getFunctionResultWithValidityDate(g_dummyVtarKey, "2020-01-01", "rate"));
+    BOOST_CHECK(!cache.getFunctionResultWithValidityDate(g_dummyVtarKey, "2000-06-15", "unknown"));
+
+    // a long period which contains shorter ones, the period which starts last wins
+    cache.putFunctionResultWithValidityDate(g_dummyVtarKey, "overlap", "2000-01-01", "2099-12-31", Value("long"));
+    cache.putFunctionResultWithValidityDate(g_dummyVtarKey, "overlap", "2010-02-28", "2010-03-01", Value("short"));
+    BOOST_CHECK_EQUAL(Value("long"), *cache.getFunctionResultWithValidityDate(g_dummyVtarKey, "2010-02-27", "overlap"));
+    BOOST_CHECK_EQUAL(Value("short"), *cache.getFunctionResultWithValidityDate(g_dummyVtarKey, "2010-03-01", "overlap"));
+    BOOST_CHECK_EQUAL(Value("long"), *cache.getFunctionResultWithValidityDate(g_dummyVtarKey, "2010-03-02", "overlap"));
+    BOOST_CHECK_EQUAL(Value("long"), *cache.getFunctionResultWithValidityDate(g_dummyVtarKey, "2050-01-01", "overlap"));
+
+    // the result of an equal period is replaced, the periods of a cache key are not duplicated
+    cache.putFunctionResultWithValidityDate(g_dummyVtarKey, "replaced", "2010-01-01", "2010-12-31", Value(1.0));
+    cache.putFunctionResultWithValidityDate(g_dummyVtarKey, "replaced", "2010-01-01", "2010-12-31", Value(2.0));
+    BOOST_CHECK_EQUAL(Value(2.0), *cache.getFunctionResultWithValidityDate(g_dummyVtarKey, "2010-06-15", "replaced"));
+    ValidityPeriods periods;
+    BOOST_CHECK(!periods.insert("2010-01-01", "2010-12-31", Value(1.0)));
+    BOOST_CHECK_EQUAL(Value(1.0), *periods.insert("2010-01-01", "2010-12-31", Value(2.0)));
+    BOOST_CHECK(!periods.insert("2010-07-01", "2010-12-31", Value(3.0)));
+    BOOST_CHECK_EQUAL(periods.getPeriods().size(), 2u);
+    BOOST_CHECK(!periods.insert("01.01.2010", "31.12.2010", Value(4.0)));
+    BOOST_CHECK_EQUAL(Value(4.0), *periods.insert("01.01.2010", "31.12.2010", Value(5.0)));
+    BOOST_CHECK_EQUAL(periods.getStringPeriods().size(), 1u);
+    BOOST_CHECK_EQUAL(Value(2.0), *periods.find("2010-06-15"));
+    BOOST_CHECK_EQUAL(Value(3.0), *periods.find("2010-07-01"));
+
+    // dates which are not in ISO format are compared as strings
+    cache.putFunctionResultWithValidityDate(g_dummyVtarKey, "string", "01.01.2000", "31.12.2000", Value(1.0));
+    cache.putFunctionResultWithValidityDate(g_dummyVtarKey, "string", "01.01.2000", "31.12.2000", Value(2.0));
+    BOOST_CHECK_EQUAL(Value(2.0), *cache.getFunctionResultWithValidityDate(g_dummyVtarKey, "15.06.2000", "string"));
+    BOOST_CHECK(!cache.getFunctionResultWithValidityDate(g_dummyVtarKey, "4000-01-01", "string"));
+    BOOST_CHECK_EQUAL(Value("long"), *cache.getFunctionResultWithValidityDate(g_dummyVtarKey, "2010-3-1", "overlap"));
+    BOOST_CHECK_EQUAL(Value("short"), *cache.getFunctionResultWithValidityDate(g_dummyVtarKey, "2010-02-28T12:00", "overlap"));
+    cache.putFunctionResultWithValidityDate(g_dummyVtarKey, "string", "1999-01-01", "9999", Value(3.0));
+    BOOST_CHECK_EQUAL(Value(3.0), *cache.getFunctionResultWithValidityDate(g_dummyVtarKey, "2000-06-15", "string"));
+
+    // the day of a date in ISO format is checked against the length of its month
+    BOOST_CHECK_EQUAL(ValidityPeriods::toDayNumber("1970-01-01").value_or(-1), 0);
+    BOOST_CHECK_EQUAL(ValidityPeriods::toDayNumber("2000-03-01").value_or(-1) - ValidityPeriods::toDayNumber("2000-02-28").value_or(-1), 2);
+    BOOST_CHECK(ValidityPeriods::toDayNumber("2000-02-29"));
+    BOOST_CHECK(ValidityPeriods::toDayNumber("2020-12-31"));
+    BOOST_CHECK(!ValidityPeriods::toDayNumber("1900-02-29"));
+    BOOST_CHECK(!ValidityPeriods::toDayNumber("2021-02-29"));
+    BOOST_CHECK(!ValidityPeriods::toDayNumber("2021-04-31"));
+    BOOST_CHECK(!ValidityPeriods::toDayNumber("2021-13-01"));
+}
+
+void testFunctionResultCacheExpiry()
+{
+    const std::chrono::system_clock::time_point now(std::chrono::system_clock::now());
+    const std::vector<std::shared_ptr<IFunctionResultCache>> caches{
+        std::make_shared<DefaultFunctionResultCache>(),
+        std::make_shared<ConcurrentFunctionResultCache>(),
+        std::make_shared<TwoLevelFunctionResultCache>(std::make_shared<ConcurrentFunctionResultCache>()),
+        std::make_shared<BoundedFunctionResultCache>(1 << 20),
+        std::make_shared<SynchronizedFunctionResultCache>(std::make_shared<DefaultFunctionResultCache>())
+    };
+    for (const std::shared_ptr<IFunctionResultCache>& cache : caches) {
+        cache->putFunctionResultWithExpiry(g_dummyVtarKey, "rate", now + std::chrono::seconds(10), Value(1.0));
+        BOOST_CHECK_EQUAL(Value(1.0), *cache->getFunctionResultWithExpiry(g_dummyVtarKey, now, "rate"));
+        BOOST_CHECK(!cache->getFunctionResultWithExpiry(g_dummyVtarKey, now + std::chrono::seconds(10), "rate"));
+        BOOST_CHECK(!cache->getFunctionResultWithExpiry(g_dummyVtarKey, now, "unknown"));
+
+        // the results with and without expiry time are separate
+        BOOST_CHECK(!cache->getFunctionResult(g_dummyVtarKey, "rate"));
+        cache->putFunctionResult(g_dummyVtarKey, "plain", Value(2.0));
+        BOOST_CHECK(!cache->getFunctionResultWithExpiry(g_dummyVtarKey, now, "plain"));
+        BOOST_CHECK_EQUAL(Value(2.0), *cache->getFunctionResult(g_dummyVtarKey, "plain"));
+
+        // an expired result is replaced
+        cache->putFunctionResultWithExpiry(g_dummyVtarKey, "rate", now + std::chrono::seconds(20), Value(3.0));
+        BOOST_CHECK_EQUAL(Value(3.0), *cache->getFunctionResultWithExpiry(g_dummyVtarKey, now + std::chrono::seconds(10), "rate"));
+    }
+
+    // a cache which does not implement the expiry does not cache the result
+    MinimalFunctionResultCache cache;
+    cache.putFunctionResultWithExpiry(g_dummyVtarKey, "rate", now + std::chrono::seconds(10), Value(1.0));
+    BOOST_CHECK(!cache.getFunctionResultWithExpiry(g_dummyVtarKey, now, "rate"));
+    BOOST_CHECK(!cache.getFunctionResult(g_dummyVtarKey, "rate"));
+
+    // the bytes of an expired result are freed when it is read
+    BoundedFunctionResultCache boundedCache(1 << 20);
+    boundedCache.putFunctionResultWithExpiry(g_dummyVtarKey, "rate", now + std::chrono::seconds(10), Value("expiring"));
+    BOOST_CHECK_EQUAL(boundedCache.getNumberOfResults(), 1u);
+    BOOST_CHECK(!boundedCache.getFunctionResultWithExpiry(g_dummyVtarKey, now + std::chrono::seconds(10), "rate"));
+    BOOST_CHECK_EQUAL(boundedCache.getNumberOfResults(), 0u);
+    BOOST_CHECK_EQUAL(boundedCache.getBytes(), 0u);
+}
+
+/**
+* tests the lifecycle of the caches of the default cache factory
+*/
+void testCacheFactory()
+{
+    const std::string insuranceRateKey("cache factory");
+    std::shared_ptr<IFunctionResultCache> functionResultCache(DefaultCacheFactory::getFunctionResultCache(insuranceRateKey));
+    std::shared_ptr<IParseTreeCache> parseTreeCache(DefaultCacheFactory::getParseTreeCache(insuranceRateKey));
+    BOOST_CHECK_EQUAL(functionResultCache, DefaultCacheFactory::getFunctionResultCache(insuranceRateKey));
+    BOOST_CHECK_EQUAL(parseTreeCache, DefaultCacheFactory::getParseTreeCache(insuranceRateKey));
+
+    // caches which are still referenced are neither evicted nor expired
+    BOOST_CHECK(!DefaultCacheFactory::evict(insuranceRateKey));
+    DefaultCacheFactory::expire(std::chrono::seconds(0));
+    BOOST_CHECK_EQUAL(functionResultCache, DefaultCacheFactory::getFunctionResultCache(insuranceRateKey));
+    parseTreeCache.reset();
+    functionResultCache.reset();
+    BOOST_CHECK(DefaultCacheFactory::evict(insuranceRateKey));
+    BOOST_CHECK(!DefaultCacheFactory::evict(insuranceRateKey));
+
+    // an invalidated cache is replaced, its holders keep using it
+    functionResultCache = DefaultCacheFactory::getFunctionResultCache(insuranceRateKey);
+    functionResultCache->putFunctionResult(insuranceRateKey, "key", Value(1.0));
+    DefaultCacheFactory::invalidate(insuranceRateKey);
+    BOOST_CHECK_EQUAL(Value(1.0), *functionResultCache->getFunctionResult(insuranceRateKey, "key"));
+    BOOST_CHECK(!DefaultCacheFactory::getFunctionResultCache(insuranceRateKey)->getFunctionResult(insuranceRateKey, "key"));
+    functionResultCache.reset();
+
+    // only the caches which were idle long enough expire
+    const std::size_t numberOfInsuranceRateKeys = DefaultCacheFactory::getNumberOfInsuranceRateKeys();
+    BOOST_CHECK_EQUAL(0u, DefaultCacheFactory::expire(std::chrono::hours(1)));
+    BOOST_CHECK(DefaultCacheFactory::expire(std::chrono::seconds(0)) >= 1);
+    BOOST_CHECK(DefaultCacheFactory::getNumberOfInsuranceRateKeys() < numberOfInsuranceRateKeys);
+
+    // threads requesting the caches of the same new tariffs get the same instances
+    const std::size_t numberOfThreads = 4;
+    const int numberOfTariffs = 100;
+    std::vector<std::vector<std::shared_ptr<IFunctionResultCache>>> caches(numberOfThreads);
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < numberOfThreads; ++t) {
+        threads.emplace_back([&caches, t, numberOfTariffs]() {
+            for (int i = 0; i < numberOfTariffs; ++i) {
+                caches[t].push_back(DefaultCacheFactory::getFunctionResultCache("tariff " + std::to_string(i)));
+                DefaultCacheFactory::getParseTreeCache("tariff " + std::to_string(i));
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    for (std::size_t t = 1; t < numberOfThreads; ++t) {
+        BOOST_CHECK(caches[0] == caches[t]);
+    }
+    for (int i = 0; i < numberOfTariffs; ++i) {
+        DefaultCacheFactory::invalidate("tariff " + std::to_string(i));
+    }
+
+    // the threads which share the function result cache of a tariff put and get results concurrently
+    functionResultCache = DefaultCacheFactory::getFunctionResultCache(insuranceRateKey);
+    BOOST_CHECK(std::dynamic_pointer_cast<ConcurrentFunctionResultCache>(functionResultCache));
+    std::vector<std::size_t> misses(numberOfThreads, 0);
+    threads.clear();
+    for (std::size_t t = 0; t < numberOfThreads; ++t) {
+        threads.emplace_back([&functionResultCache, &misses, &insuranceRateKey, t]() {
+            for (int i = 0; i < 1000; ++i) {
+                const std::string key(std::to_string(t) + ' ' + std::to_string(i));
+                functionResultCache->putFunctionResult(insuranceRateKey, key, Value(static_cast<double>(i)));
+                const boost::optional<Value> result = functionResultCache->getFunctionResult(insuranceRateKey, key);
+                if (!result || !(*result == Value(static_cast<double>(i)))) {
+                    ++misses[t];
+                }
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    for (std::size_t t = 0; t < numberOfThreads; ++t) {
+        BOOST_CHECK_EQUAL(misses[t], 0u);
+    }
+    functionResultCache.reset();
+    DefaultCacheFactory::invalidate(insuranceRateKey);
+}
+
+/**
+* tests the eviction, the memory accounting and the quotas of the bounded function result cache
+*/
+void testBoundedFunctionResultCache()
+{
+    // LRU keeps the recently used results within the maximum size
+    BoundedFunctionResultCache lru(20000);
+    for (int i = 0; i < 1000; ++i) {
+        lru.putFunctionResult(g_dummyVtarKey, "key" + std::to_string(i), Value(static_cast<double>(i)));
+        BOOST_CHECK(lru.getFunctionResult(g_dummyVtarKey, "key0"));
+        BOOST_CHECK(lru.getBytes() <= 20000);
+    }
+    BOOST_CHECK(lru.getFunctionResult(g_dummyVtarKey, "key999"));
+    BOOST_CHECK(!lru.getFunctionResult(g_dummyVtarKey, "key1"));
+    BoundedFunctionResultCache::Statistics statistics = lru.getStatistics();
+    BOOST_CHECK_EQUAL(1000u, statistics.insertions);
+    BOOST_CHECK_EQUAL(1000u - lru.getNumberOfResults(), statistics.evictions);
+    BOOST_CHECK_EQUAL(lru.getBytes(), lru.getBytes(g_dummyVtarKey));
+
+    // the validity periods of a cache key are one result, a period which is already cached does not need memory
+    BoundedFunctionResultCache dated(1 << 20);
+    dated.putFunctionResultWithValidityDate(g_dummyVtarKey, "rate", "2020-01-01", "2020-12-31", Value(1.0));
+    dated.putFunctionResultWithValidityDate(g_dummyVtarKey, "rate", "2021-01-01", "2021-12-31", Value(2.0));
+    const std::size_t bytes = dated.getBytes();
+    dated.putFunctionResultWithValidityDate(g_dummyVtarKey, "rate", "2021-01-01", "2021-12-31", Value(2.0));
+    BOOST_CHECK_EQUAL(bytes, dated.getBytes());
+    BOOST_CHECK_EQUAL(1u, dated.getNumberOfResults());
+    BOOST_CHECK_EQUAL(Value(2.0), *dated.getFunctionResultWithValidityDate(g_dummyVtarKey, "2021-05-05", "rate"));
+    BOOST_CHECK(!dated.getFunctionResultWithValidityDate(g_dummyVtarKey, "2022-05-05", "rate"));
+    BOOST_CHECK(!dated.getFunctionResult(g_dummyVtarKey, "rate"));
+    dated.putFunctionResultWithValidityDate(g_dummyVtarKey, "rate", "01.01.2022", "31.12.2022", Value(3.0));
+    BOOST_CHECK_GT(dated.getBytes(), bytes);
+    BOOST_CHECK_EQUAL(Value(3.0), *dated.getFunctionResultWithValidityDate(g_dummyVtarKey, "05.05.2022", "rate"));
+
+    // a tariff with a quota only evicts its own results
+    BoundedFunctionResultCache quota(1 << 20);
+    quota.setQuota("small", 2000);
+    for (int i = 0; i < 200; ++i) {
+        quota.putFunctionResult("small", "key" + std::to_string(i), Value(std::string(50, 'x')));
+        quota.putFunctionResult("large", "key" + std::to_string(i), Value(1.0));
+    }
+    BOOST_CHECK(quota.getBytes("small") > 0 && quota.getBytes("small") <= 2000);
+    BOOST_CHECK(quota.getFunctionResult("large", "key0"));
+    BOOST_CHECK(quota.getStatistics().quotaEvictions > 0);
+    quota.setQuota("small", 1);
+    BOOST_CHECK_EQUAL(0u, quota.getBytes("small"));
+    BOOST_CHECK_EQUAL(quota.getBytes("large"), quota.getBytes());
+
+    // W-TinyLFU keeps frequently used results while many results are used once
+    for (EvictionPolicy evictionPolicy : { EvictionPolicy::LRU, EvictionPolicy::W_TINY_LFU }) {
+        BoundedFunctionResultCache cache(40000, evictionPolicy);
+        std::size_t hits = 0;
+        int scanned = 0;
+        for (int i = 0; i < 20000; ++i) {
+            const std::string frequent("frequent" + std::to_string((i * 7919) % 50));
+            if (cache.getFunctionResult(g_dummyVtarKey, frequent)) {
+                ++hits;
+            }
+            else {
+                cache.putFunctionResult(g_dummyVtarKey, frequent, Value(std::string(30, 'x')));
+            }
+            for (int j = 0; j < 10; ++j) {
+                cache.putFunctionResult(g_dummyVtarKey, "once" + std::to_string(scanned++), Value(1.0));
+            }
+            BOOST_CHECK(cache.getBytes() <= 40000);
+        }
+        std::cout << (evictionPolicy == EvictionPolicy::LRU ? "LRU" : "W-TinyLFU") << ": hit rate of the frequent results " << hits / 200.0 << "%" << std::endl;
+        if (evictionPolicy == EvictionPolicy::W_TINY_LFU) {
+            BOOST_CHECK(hits > 19000);
+            BOOST_CHECK(cache.getStatistics().rejections > 0);
+        }
+    }
+
+    // a result larger than the cache is not cached
+    BoundedFunctionResultCache small(1000, EvictionPolicy::W_TINY_LFU);
+    small.putFunctionResult(g_dummyVtarKey, "large", Value(std::string(5000, 'x')));
+    BOOST_CHECK_EQUAL(0u, small.getBytes());
+    BOOST_CHECK(!small.getFunctionResult(g_dummyVtarKey, "large"));
+}
+
+/**
+* tests the concurrent function result cache
+*/
+void testConcurrentFunctionResultCache()
+{
+    ConcurrentFunctionResultCache cache(5);
+    BOOST_CHECK_EQUAL(8u, cache.getNumberOfShards());
+
+    cache.putFunctionResult(g_dummyVtarKey, "key", Value(1.0));
+    cache.putFunctionResult(g_dummyVtarKey, "key", Value(2.0));
+    cache.putFunctionResultWithValidityDate(g_dummyVtarKey, "dated", "2020-01-01", "2020-12-31", Value("2020"));
+    cache.putFunctionResultWithValidityDate(g_dummyVtarKey, "dated", "2021-01-01", "2021-12-31", Value("2021"));
+    BOOST_CHECK_EQUAL(Value(2.0), *cache.getFunctionResult(g_dummyVtarKey, "key"));
+    BOOST_CHECK(!cache.getFunctionResult(g_dummyVtarKey, "unknown"));
+    BOOST_CHECK_EQUAL(Value("2021"), *cache.getFunctionResultWithValidityDate(g_dummyVtarKey, "2021-06-30", "dated"));
+    BOOST_CHECK(!cache.getFunctionResultWithValidityDate(g_dummyVtarKey, "2019-06-30", "dated"));
+
+    // readers always see either no result or the complete result while other threads write
+    const std::size_t numberOfThreads = 4;
+    const int numberOfKeys = 1000;
+    std::atomic<std::size_t> wrongResults(0);
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < numberOfThreads; ++t) {
+        threads.emplace_back([&cache, &wrongResults, t]() {
+            for (int i = 0; i < numberOfKeys; ++i) {
+                const std::string key(std::to_string(i));
+                if (static_cast<std::size_t>(i) % numberOfThreads == t) {
+                    cache.putFunctionResult(g_dummyVtarKey, key, Value("result " + key));
+                }
+                const boost::optional<Value> result = cache.getFunctionResult(g_dummyVtarKey, std::to_string(numberOfKeys - 1 - i));
+                if (result && result->asString() != "result " + std::to_string(numberOfKeys - 1 - i)) {
+                    ++wrongResults;
+                }
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    BOOST_CHECK_EQUAL(0u, wrongResults.load());
+    for (int i = 0; i < numberOfKeys; ++i) {
+        BOOST_CHECK_EQUAL(Value("result " + std::to_string(i)), *cache.getFunctionResult(g_dummyVtarKey, std::to_string(i)));
+    }
+}
+
+/**
+* tests the two level caches and the invalidation of the thread local caches
+*/
+void testTwoLevelCache()
+{
+    const std::shared_ptr<IFunctionResultCache> sharedCache(std::make_shared<ConcurrentFunctionResultCache>());
+    TwoLevelFunctionResultCache cache(sharedCache, 4);
+    cache.putFunctionResult(g_dummyVtarKey, "key", Value(1.0));
+    BOOST_CHECK_EQUAL(Value(1.0), *sharedCache->getFunctionResult(g_dummyVtarKey, "key"));
+    BOOST_CHECK_EQUAL(Value(1.0), *cache.getFunctionResult(g_dummyVtarKey, "key"));
+    cache.putFunctionResultWithValidityDate(g_dummyVtarKey, "key", "2020-01-01", "2020-12-31", Value(2.0));
+    BOOST_CHECK_EQUAL(Value(2.0), *cache.getFunctionResultWithValidityDate(g_dummyVtarKey, "2020-06-30", "key"));
+    BOOST_CHECK_EQUAL(Value(2.0), *cache.getFunctionResultWithValidityDate(g_dummyVtarKey, "2020-06-30", "key"));
+    BOOST_CHECK(!cache.getFunctionResultWithValidityDate(g_dummyVtarKey, "2021-06-30", "key"));
+    BOOST_CHECK_EQUAL(Value(1.0), *cache.getFunctionResult(g_dummyVtarKey, "key"));
+
+    // more results than local slots are read from the shared cache
+    for (int i = 0; i < 100; ++i) {
+        cache.putFunctionResult(g_dummyVtarKey, "key" + std::to_string(i), Value(static_cast<double>(i)));
+    }
+    for (int i = 0; i < 100; ++i) {
+        BOOST_CHECK_EQUAL(Value(static_cast<double>(i)), *cache.getFunctionResult(g_dummyVtarKey, "key" + std::to_string(i)));
+    }
+
+    // the local results of other threads are dropped after the invalidation
+    std::shared_ptr<IFunctionResultCache> replacedCache(std::make_shared<ConcurrentFunctionResultCache>());
+    TwoLevelFunctionResultCache replaced(replacedCache);
+    replaced.putFunctionResult(g_dummyVtarKey, "key", Value(1.0));
+    std::thread([&replaced]() { BOOST_CHECK_EQUAL(Value(1.0), *replaced.getFunctionResult(g_dummyVtarKey, "key")); }).join();
+    replacedCache->putFunctionResult(g_dummyVtarKey, "key", Value(3.0));
+    replaced.invalidate();
+    BOOST_CHECK_EQUAL(Value(3.0), *replaced.getFunctionResult(g_dummyVtarKey, "key"));
+    std::thread([&replaced]() { BOOST_CHECK_EQUAL(Value(3.0), *replaced.getFunctionResult(g_dummyVtarKey, "key")); }).join();
+
+    // the parse trees of a cleared shared cache are not found any more
+    std::shared_ptr<IParseTreeCache> sharedParseTrees(std::make_shared<DefaultParseTreeCache>());
+    TwoLevelParseTreeCache parseTreeCache(sharedParseTrees);
+    const std::shared_ptr<void> parseTree(std::make_shared<int>(1));
+    parseTreeCache.putParseTree(g_dummyVtarKey, "formula", parseTree);
+    BOOST_CHECK_EQUAL(parseTree, parseTreeCache.getParseTree(g_dummyVtarKey, "formula"));
+    BOOST_CHECK(!parseTreeCache.getParseTree(g_dummyVtarKey, "unknown"));
+    {
+        std::lock_guard<std::mutex> lock(parseTreeCache.getSharedCacheMutex());
+        parseTreeCache.getSharedCache()->putParseTree(g_dummyVtarKey, "formula", nullptr);
+    }
+    parseTreeCache.invalidate();
+    BOOST_CHECK(!parseTreeCache.getParseTree(g_dummyVtarKey, "formula"));
+
+    // a result read from the shared cache before it was replaced and the local results were invalidated is not cached locally
+    const std::shared_ptr<InterleavingFunctionResultCache> interleavingCache(std::make_shared<InterleavingFunctionResultCache>());
+    TwoLevelFunctionResultCache interleaved(interleavingCache);
+    interleavingCache->putFunctionResult(g_dummyVtarKey, "key", Value(1.0));
+    interleavingCache->setAfterRead([&interleavingCache, &interleaved]() {
+        interleavingCache->putFunctionResult(g_dummyVtarKey, "key", Value(2.0));
+        interleaved.invalidate();
+    });
+    BOOST_CHECK_EQUAL(Value(1.0), *interleaved.getFunctionResult(g_dummyVtarKey, "key"));
+    BOOST_CHECK_EQUAL(Value(2.0), *interleaved.getFunctionResult(g_dummyVtarKey, "key"));
+
+    // the local parse trees of a destroyed cache are released on the next access of the thread
+    std::weak_ptr<void> destroyedParseTree;
+    {
+        TwoLevelParseTreeCache destroyed(std::make_shared<DefaultParseTreeCache>());
+        const std::shared_ptr<void> localParseTree(std::make_shared<int>(2));
+        destroyed.putParseTree(g_dummyVtarKey, "formula", localParseTree);
+        destroyedParseTree = localParseTree;
+    }
+    parseTreeCache.getParseTree(g_dummyVtarKey, "formula");
+    BOOST_CHECK(destroyedParseTree.expired());
+}
+
+namespace {
+//! \brief the caches which are compared, by name
+const std::vector<std::pair<std::string, std::function<std::shared_ptr<IFunctionResultCache>()>>>& getConcurrentCaches()
+{
+    static const std::vector<std::pair<std::string, std::function<std::shared_ptr<IFunctionResultCache>()>>> caches{
+        { "synchronized default cache", []() { return std::make_shared<SynchronizedFunctionResultCache>(std::make_shared<DefaultFunctionResultCache>()); } },
+        { "concurrent cache", []() { return std::make_shared<ConcurrentFunctionResultCache>(); } },
+        { "two level cache", []() { return std::make_shared<TwoLevelFunctionResultCache>(std::make_shared<ConcurrentFunctionResultCache>()); } }
+    };
+    return caches;
+}
+
+//! \brief reads and writes (every 64th operation) the results of few hot keys from several threads
+//! \return the number of reads which did not find a result
+std::size_t runConcurrentOperations(IFunctionResultCache& functionResultCache_, std::size_t numberOfThreads_, int operationsPerThread_)
+{
+    const int numberOfKeys = 256;
+    std::vector<std::string> keys;
+    for (int i = 0; i < numberOfKeys; ++i) {
+        keys.push_back("GetSachtarif_1:" + std::to_string(i));
+        functionResultCache_.putFunctionResult(g_dummyVtarKey, keys[i], Value(static_cast<double>(i)));
+    }
+
+    std::atomic<std::size_t> misses(0);
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < numberOfThreads_; ++t) {
+        threads.emplace_back([&functionResultCache_, &keys, &misses, operationsPerThread_, t]() {
+            std::size_t threadMisses = 0;
+            for (int i = 0; i < operationsPerThread_; ++i) {
+                const int key = static_cast<int>((i * 7 + t * 13) % numberOfKeys);
+                if (i % 64 == 0) {
+                    functionResultCache_.putFunctionResult(g_dummyVtarKey, keys[key], Value(static_cast<double>(key)));
+                }
+                else if (!functionResultCache_.getFunctionResult(g_dummyVtarKey, keys[key])) {
+                    ++threadMisses;
+                }
+            }
+            misses += threadMisses;
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    return misses.load();
+}
+}
+
+/**
+* tests that the thread safe function result caches find every cached result while other threads read and write
+*/
+void testFunctionResultCacheConcurrency()
+{
+    for (const auto& cache : getConcurrentCaches()) {
+        const std::shared_ptr<IFunctionResultCache> functionResultCache(cache.second());
+        BOOST_CHECK_MESSAGE(runConcurrentOperations(*functionResultCache, 4, 5000) == 0, cache.first << " missed results");
+    }
+}
+
+/**
+* compares the throughput of the concurrent and the two level function result cache with the synchronized default cache, with mostly reads of few hot keys.
+* It is a benchmark, it only runs with the option --benchmarks.
+*/
+void testFunctionResultCacheContention()
+{
+    typedef std::chrono::high_resolution_clock Clock_t;
+
+    const int operationsPerThread = 200000;
+    const std::size_t maxThreads = std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+    for (const auto& cache : getConcurrentCaches()) {
+        for (std::size_t numberOfThreads = 1; numberOfThreads <= maxThreads; numberOfThreads *= 2) {
+            const std::shared_ptr<IFunctionResultCache> functionResultCache(cache.second());
+            const std::chrono::time_point<Clock_t> startTime = Clock_t::now();
+            const std::size_t misses = runConcurrentOperations(*functionResultCache, numberOfThreads, operationsPerThread);
+            const std::chrono::time_point<Clock_t> endTime = Clock_t::now();
+            BOOST_CHECK_EQUAL(0u, misses);
+
+            const double microSecs = static_cast<double>(std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime).count());
+            std::cout << cache.first << ", " << numberOfThreads << " threads: " << (numberOfThreads * operationsPerThread) / std::max(microSecs, 1.0) << " operations per microsecond\n";
+        }
+    }
+}
+
+/**
+* tests that constant subexpressions are folded at compile time
+*/
+void testConstantFolding()
+{
+    std::shared_ptr<IFunctionResultCache> functionResultCache(std::make_shared<DefaultFunctionResultCache>());
+    std::shared_ptr<IParseTreeCache> parseTreeCache(std::make_shared<DefaultParseTreeCache>());
+    std::shared_ptr<ParsingContext> parsingContext(std::make_shared<ParsingContext>(std::vector<std::shared_ptr<IFunction>>(), functionResultCache, parseTreeCache, g_dummyVtarKey, log4cplus::Logger::getRoot()));
+    assignParamToParsingContext(parsingContext, "faktor", 1.5);
+    Parser parser(parsingContext);
+
+    std::shared_ptr<CompiledFormula> compiledFormula = parser.getCompiledFormula("folded", "return 0.5 * 12 + rnd(100 / 3, 2)");
+    const CompiledFormula::Node& root = compiledFormula->getNode(compiledFormula->getRoot());
+    BOOST_REQUIRE(root.opCode == OpCode::RETURN);
+    const CompiledFormula::Node& expression = compiledFormula->getNode(compiledFormula->getOperand(root, 0));
+    BOOST_REQUIRE(expression.opCode == OpCode::CONSTANT);
+    BOOST_CHECK_EQUAL(compiledFormula->getConstant(expression.data), Value(39.33));
+    BOOST_CHECK_EQUAL(Value(39.33), parser.parse("folded", "return 0.5 * 12 + rnd(100 / 3, 2)"));
+
+    // constant conditions
+    BOOST_CHECK_EQUAL(Value(1.5), parser.parse("foldedIf", "if (1 > 2) then return 'A' else if (faktor > 2) then return 'B' else return faktor end"));
+    BOOST_CHECK_EQUAL(Value("B"), parser.parse("foldedIf2", "if (faktor > 2) then return 'A' else if (2 > 1) then return 'B' else return 'C' end"));
+
+    // failing expressions are reported when they are evaluated
+    try {
+        parser.parse("foldedDivision", "if (faktor > 2) then return 1 else return 1 / 0 end");
+        BOOST_ERROR("this code shouldn't have been reached");
+    }
+    catch (const RatingEngineException& ex) {
+        BOOST_CHECK_EQUAL(ex.getErrorType(), RatingEngineError::DIVISION_BY_ZERO);
+    }
+    BOOST_CHECK_THROW(parser.parse("foldedIllegal", "return true - 1"), ParsingException);
+}
+
+/**
+* measures the evaluation of cached formulas, every evaluation completes with a Return statement
+*/
+void testFormulaEvaluationPerformance()
+{
+    typedef std::chrono::high_resolution_clock Clock_t;
+
+    std::shared_ptr<IFunctionResultCache> functionResultCache(std::make_shared<DefaultFunctionResultCache>());
+    std::shared_ptr<IParseTreeCache> parseTreeCache(std::make_shared<DefaultParseTreeCache>());
+    const std::string formula("if (faktor < 1) then return 1 else if (faktor < 2) then return faktor * 2 + 1 else return 3 end");
+    const std::size_t numberOfEvaluations = 100000;
+
+    for (const EvaluationBackend backend : { EvaluationBackend::TREE, EvaluationBackend::BYTECODE }) {
+        std::shared_ptr<ParsingContext> parsingContext(std::make_shared<ParsingContext>(std::vector<std::shared_ptr<IFunction>>(), functionResultCache, parseTreeCache, g_dummyVtarKey, log4cplus::Logger::getRoot()));
+        parsingContext->setEvaluationBackend(backend);
+        assignParamToParsingContext(parsingContext, "faktor", 1.5);
+        Parser parser(parsingContext);
+
+        const std::chrono::time_point<Clock_t> startTime = Clock_t::now();
+        double sum = 0;
+        for (std::size_t i = 0; i < numberOfEvaluations; ++i) {
+            sum += parser.parse("evaluationPerformance", formula).asDouble();
+        }
+        const std::chrono::time_point<Clock_t> endTime = Clock_t::now();
+
+        BOOST_CHECK_EQUAL(Value(4.0 * numberOfEvaluations), Value(sum));
+        std::cout << (backend == EvaluationBackend::TREE ? "tree" : "bytecode") << " evaluation: "
+                  << std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count() / numberOfEvaluations << " nanoseconds\n";
+    }
+}
+
 
 test_suite* init_unit_test_suite(int argc, char* argv[])
 {
@@ -586,10 +1442,12 @@ test_suite* init_unit_test_suite(int argc, char* argv[])
 
     // Programmparameter
     std::string properties;
+    bool benchmarks = false;
 
     bpo::options_description desc("test_calculusprime options");
     desc.add_options()
     ("properties,p", bpo::value<std::string>(&properties), "properties")
+    ("benchmarks,b", bpo::bool_switch(&benchmarks), "run the benchmarks")
     ;
 
     bpo::variables_map vm;
@@ -609,6 +1467,19 @@ test_suite* init_unit_test_suite(int argc, char* argv[])
     test->add(BOOST_TEST_CASE(&testValue));
     test->add(BOOST_TEST_CASE(&testCalculation));
     test->add(BOOST_TEST_CASE(&testInstanceCalculation));
+    test->add(BOOST_TEST_CASE(&testBytecodeCalculation));
+    test->add(BOOST_TEST_CASE(&testPreparedTariff));
+    test->add(BOOST_TEST_CASE(&testShortCircuitEvaluation));
+    test->add(BOOST_TEST_CASE(&testEvaluationOrder));
+    test->add(BOOST_TEST_CASE(&testDependencyGraph));
+    test->add(BOOST_TEST_CASE(&testParallelCalculation));
+    test->add(BOOST_TEST_CASE(&testBatchCalculation));
+    test->add(BOOST_TEST_CASE(&testColumnarEvaluation));
+    test->add(BOOST_TEST_CASE(&testInstanceInvariance));
+    test->add(BOOST_TEST_CASE(&testInstanceGroups));
+    test->add(BOOST_TEST_CASE(&testCalculatedVariables));
+    test->add(BOOST_TEST_CASE(&testFunctionMemoization));
+    test->add(BOOST_TEST_CASE(&testFunctionResultCaching));
     test->add(BOOST_TEST_CASE(&testCalculationPerformance));
     test->add(BOOST_TEST_CASE(&testIfThenElseExpression));
     test->add(BOOST_TEST_CASE(&testAddExpression));
@@ -637,8 +1508,26 @@ test_suite* init_unit_test_suite(int argc, char* argv[])
     test->add(BOOST_TEST_CASE(&testFunctionCallsOtherFunction));
     test->add(BOOST_TEST_CASE(&testFunctionArgumentScope));
     test->add(BOOST_TEST_CASE(&testRecursiveFunctionCall));
+    test->add(BOOST_TEST_CASE(&testFunctionScope));
+    test->add(BOOST_TEST_CASE(&testFunctionMemo));
     test->add(BOOST_TEST_CASE(&testBoolExpression));
     test->add(BOOST_TEST_CASE(&testStringExpression));
+    test->add(BOOST_TEST_CASE(&testCompiledFormulaCache));
+    test->add(BOOST_TEST_CASE(&testBytecodeBackend));
+    test->add(BOOST_TEST_CASE(&testSymbolTable));
+    test->add(BOOST_TEST_CASE(&testConstantFolding));
+    test->add(BOOST_TEST_CASE(&testArena));
+    test->add(BOOST_TEST_CASE(&testFunctionResultCacheValidity));
+    test->add(BOOST_TEST_CASE(&testFunctionResultCacheExpiry));
+    test->add(BOOST_TEST_CASE(&testCacheFactory));
+    test->add(BOOST_TEST_CASE(&testBoundedFunctionResultCache));
+    test->add(BOOST_TEST_CASE(&testConcurrentFunctionResultCache));
+    test->add(BOOST_TEST_CASE(&testTwoLevelCache));
+    test->add(BOOST_TEST_CASE(&testFunctionResultCacheConcurrency));
+    if (benchmarks) {
+        test->add(BOOST_TEST_CASE(&testFunctionResultCacheContention));
+    }
+    test->add(BOOST_TEST_CASE(&testFormulaEvaluationPerformance));
 
     return test;
 }
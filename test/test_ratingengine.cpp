@@ -13,12 +13,21 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License.
 */
+#include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <iostream>
 #include <memory>
+#include <thread>
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/test/unit_test.hpp>
+#include <calculusprime/cache/BoundedFunctionResultCache.h>
+#include <calculusprime/cache/ConcurrentFunctionResultCache.h>
 #include <calculusprime/cache/DefaultCacheFactory.h>
+#include <calculusprime/cache/DefaultFunctionResultCache.h>
+#include <calculusprime/cache/IParseTreeCache.h>
+#include <calculusprime/FunctionCachingPolicy.h>
+#include <calculusprime/IPreparedTariff.h>
 #include <calculusprime/IRatingEngine.h>
 #include <calculusprime/RatingEngineException.h>
 #include <calculusprime/RatingEngineFactory.h>
@@ -427,6 +436,39 @@ void validateInstanceResults(IRatingEngine::Map_t& results_)
 }
 }
 
+namespace {
+//! \brief a parse tree cache which counts the reads, a tariff reads the parse trees of its formulas when it is prepared
+class CountingParseTreeCache : public IParseTreeCache
+{
+public:
+    explicit CountingParseTreeCache(const std::shared_ptr<IParseTreeCache>& parseTreeCache_)
+        : m_parseTreeCache(parseTreeCache_)
+        , m_reads(0)
+    {
+    }
+
+    virtual void putParseTree(const std::string& insuranceRateKey_, const std::string& variableName_, const std::shared_ptr<void>& parseTree_) override
+    {
+        m_parseTreeCache->putParseTree(insuranceRateKey_, variableName_, parseTree_);
+    }
+
+    virtual std::shared_ptr<void> getParseTree(const std::string& insuranceRateKey_, const std::string& variableName_) const override
+    {
+        ++m_reads;
+        return m_parseTreeCache->getParseTree(insuranceRateKey_, variableName_);
+    }
+
+    std::size_t getReads() const
+    {
+        return m_reads;
+    }
+
+private:
+    const std::shared_ptr<IParseTreeCache> m_parseTreeCache;
+    mutable std::atomic<std::size_t> m_reads;
+};
+}
+
 void testCalculation()
 {
     std::shared_ptr<IFunctionResultCache> functionResultCache(DefaultCacheFactory::getFunctionResultCache(g_dummyVtarKey));
@@ -442,6 +484,674 @@ void testCalculation()
     IRatingEngine::Map_t results = ratingEngine->calculate(g_dummyVtarKey, input, ratingFormulas, ratingOutput);
     dumpResults(results);
     validateResults(results);
+
+    // the tariff is reused while the formulas are the same, other rating outputs prepare another tariff
+    results = ratingEngine->calculate(g_dummyVtarKey, input, ratingFormulas, ratingOutput);
+    validateResults(results);
+    results = ratingEngine->calculate(g_dummyVtarKey, makeInstanceInput(), ratingFormulas, makeInstanceRatingOutput());
+    validateInstanceResults(results);
+
+    // rating outputs used alternately keep their prepared tariffs, up to the maximum number of tariffs
+    for (const std::size_t maxPreparedTariffs : { 0, 1, 16 }) {
+        const std::shared_ptr<CountingParseTreeCache> countingParseTreeCache(std::make_shared<CountingParseTreeCache>(parseTreeCache));
+        std::unique_ptr<IRatingEngine> limitedRatingEngine(
+            RatingEngineFactory::createRatingEngine(functions, functionResultCache, countingParseTreeCache, RatingEngineOptions().setMaxPreparedTariffs(maxPreparedTariffs)));
+        results = limitedRatingEngine->calculate(g_dummyVtarKey, input, ratingFormulas, ratingOutput);
+        validateResults(results);
+        results = limitedRatingEngine->calculate(g_dummyVtarKey, makeInstanceInput(), ratingFormulas, makeInstanceRatingOutput());
+        validateInstanceResults(results);
+        std::size_t reads = countingParseTreeCache->getReads();
+        results = limitedRatingEngine->calculate(g_dummyVtarKey, input, ratingFormulas, ratingOutput);
+        validateResults(results);
+        BOOST_CHECK_EQUAL(countingParseTreeCache->getReads() > reads, maxPreparedTariffs < 2);
+
+        // an evicted tariff is prepared again
+        limitedRatingEngine->evictPreparedTariffs(g_dummyVtarKey);
+        reads = countingParseTreeCache->getReads();
+        results = limitedRatingEngine->calculate(g_dummyVtarKey, input, ratingFormulas, ratingOutput);
+        validateResults(results);
+        BOOST_CHECK_GT(countingParseTreeCache->getReads(), reads);
+    }
+
+    // concurrent calls share the prepared tariffs, the results are checked on this thread
+    std::unique_ptr<IRatingEngine> sharedRatingEngine(RatingEngineFactory::createRatingEngine(functions, std::make_shared<ConcurrentFunctionResultCache>(), parseTreeCache));
+    std::vector<std::vector<IRatingEngine::Map_t>> threadResults(4);
+    std::vector<std::thread> threads;
+    for (std::size_t i = 0; i < threadResults.size(); ++i) {
+        threads.emplace_back([&sharedRatingEngine, &input, &ratingFormulas, &ratingOutput, &threadResults, i]() {
+            for (std::size_t j = 0; j < 10; ++j) {
+                threadResults[i].push_back((i + j) % 2 == 0 ? sharedRatingEngine->calculate(g_dummyVtarKey, input, ratingFormulas, ratingOutput)
+                                                            : sharedRatingEngine->calculate(g_dummyVtarKey, makeInstanceInput(), ratingFormulas, makeInstanceRatingOutput()));
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    for (std::size_t i = 0; i < threadResults.size(); ++i) {
+        BOOST_REQUIRE_EQUAL(threadResults[i].size(), 10u);
+        for (std::size_t j = 0; j < threadResults[i].size(); ++j) {
+            if ((i + j) % 2 == 0) {
+                validateResults(threadResults[i][j]);
+            }
+            else {
+                validateInstanceResults(threadResults[i][j]);
+            }
+        }
+    }
+}
+
+void testBytecodeCalculation()
+{
+    std::shared_ptr<IFunctionResultCache> functionResultCache(DefaultCacheFactory::getFunctionResultCache(g_dummyVtarKey));
+    std::shared_ptr<IParseTreeCache> parseTreeCache(DefaultCacheFactory::getParseTreeCache(g_dummyVtarKey));
+    std::vector<std::shared_ptr<IFunction>> functions{ std::make_shared<GetProdschablFunction>(), std::make_shared<GetSachtarifFunction>(), std::make_shared<GetTarifpraemieFunction>() };
+
+    std::unique_ptr<IRatingEngine> ratingEngine(RatingEngineFactory::createRatingEngine(functions, functionResultCache, parseTreeCache, RatingEngineOptions().setEvaluationBackend(EvaluationBackend::BYTECODE)));
+
+    IRatingEngine::Map_t results = ratingEngine->calculate(g_dummyVtarKey, makeInput(), makeRatingFormulas(), makeRatingOutput());
+    validateResults(results);
+
+    results = ratingEngine->calculate(g_dummyVtarKey, makeInstanceInput(), makeRatingFormulas(), makeInstanceRatingOutput());
+    validateInstanceResults(results);
+}
+
+void testPreparedTariff()
+{
+    std::shared_ptr<IFunctionResultCache> functionResultCache(DefaultCacheFactory::getFunctionResultCache(g_dummyVtarKey));
+    std::shared_ptr<IParseTreeCache> parseTreeCache(DefaultCacheFactory::getParseTreeCache(g_dummyVtarKey));
+    std::vector<std::shared_ptr<IFunction>> functions{ std::make_shared<GetProdschablFunction>(), std::make_shared<GetSachtarifFunction>(), std::make_shared<GetTarifpraemieFunction>() };
+
+    std::unique_ptr<IRatingEngine> ratingEngine(RatingEngineFactory::createRatingEngine(functions, functionResultCache, parseTreeCache));
+    std::unique_ptr<IPreparedTariff> preparedTariff(ratingEngine->prepare(g_dummyVtarKey, makeRatingFormulas(), makeRatingOutput()));
+    std::unique_ptr<IPreparedTariff> preparedInstanceTariff(ratingEngine->prepare(g_dummyVtarKey, makeRatingFormulas(), makeInstanceRatingOutput()));
+
+    BOOST_CHECK_EQUAL(preparedTariff->getInsuranceRateKey(), g_dummyVtarKey);
+    const std::vector<RatingOutput>& ratingOutput = preparedTariff->getRatingOutput();
+    BOOST_CHECK(std::is_sorted(ratingOutput.begin(), ratingOutput.end(), [](const RatingOutput& lhs_, const RatingOutput& rhs_) {
+        return lhs_.getSortOrder() < rhs_.getSortOrder();
+    }));
+
+    // the prepared tariffs are independent of the rating engine and can be calculated repeatedly
+    ratingEngine.reset();
+    for (int i = 0; i < 3; ++i) {
+        IRatingEngine::Map_t results = preparedTariff->calculate(makeInput());
+        validateResults(results);
+
+        results = preparedInstanceTariff->calculate(makeInstanceInput());
+        validateInstanceResults(results);
+    }
+}
+
+void testShortCircuitEvaluation()
+{
+    std::shared_ptr<IFunctionResultCache> functionResultCache(DefaultCacheFactory::getFunctionResultCache(g_dummyVtarKey));
+    std::shared_ptr<IParseTreeCache> parseTreeCache(DefaultCacheFactory::getParseTreeCache(g_dummyVtarKey));
+    std::vector<std::shared_ptr<IFunction>> functions{ std::make_shared<GetTarifpraemieFunction>() };
+
+    // Tarif calls a business function, Umweg divides through Teilquote, Schwelle cannot fail
+    IRatingEngine::RatingFormulaMap_t ratingFormulas{
+        { "Anzahl", "return 0" },
+        { "Quote(anzahl)", "return 100 / anzahl" },
+        { "Tarif", "return GetTarifpraemie('VS_HP_Privat_Sport', 0, 'Variante')" },
+        { "Teilquote", "return 100 / Anzahl" },
+        { "Umweg", "return Teilquote" },
+        { "Schwelle", "return 1" }
+    };
+    std::vector<RatingOutput> ratingOutput{
+        { "Geschuetzt", 0, "return Anzahl > 0 and Quote(Anzahl) > 1", "" },
+        { "Einfach", 1, "return Anzahl = 0 or Anzahl > 1", "" },
+        { "Tarifiert", 2, "return Anzahl > 0 and Tarif > 0", "" },
+        { "Indirekt", 3, "return Anzahl > 0 and Umweg > 1", "" },
+        { "Begrenzt", 4, "return Anzahl = 0 or Anzahl > Schwelle", "" }
+    };
+
+    for (const EvaluationBackend backend : { EvaluationBackend::TREE, EvaluationBackend::BYTECODE }) {
+        // by default the right operand is evaluated and fails
+        std::unique_ptr<IRatingEngine> ratingEngine(RatingEngineFactory::createRatingEngine(functions, functionResultCache, parseTreeCache, RatingEngineOptions().setEvaluationBackend(backend)));
+        std::unique_ptr<IPreparedTariff> preparedTariff(ratingEngine->prepare(g_dummyVtarKey, ratingFormulas, ratingOutput));
+        BOOST_CHECK_THROW(preparedTariff->calculate(IRatingEngine::Map_t()), RatingEngineException);
+
+        // the formulas with a guarded division or function call may differ, also when a rating formula calls it
+        const std::vector<std::string> differingFormulas(preparedTariff->checkShortCircuitEvaluation());
+        BOOST_REQUIRE_EQUAL(differingFormulas.size(), 3u);
+        BOOST_CHECK_EQUAL(differingFormulas[0], "Geschuetzt");
+        BOOST_CHECK_EQUAL(differingFormulas[1], "Indirekt");
+        BOOST_CHECK_EQUAL(differingFormulas[2], "Tarifiert");
+
+        // with short circuit evaluation the division is skipped
+        ratingEngine = RatingEngineFactory::createRatingEngine(functions, functionResultCache, parseTreeCache, RatingEngineOptions().setEvaluationBackend(backend).setShortCircuitEvaluation(true));
+        IRatingEngine::Map_t results = ratingEngine->calculate(g_dummyVtarKey, IRatingEngine::Map_t(), ratingFormulas, ratingOutput);
+        BOOST_CHECK_EQUAL(results["Geschuetzt"], Value_t(std::string("0")));
+        BOOST_CHECK_EQUAL(results["Einfach"], Value_t(std::string("1")));
+        BOOST_CHECK_EQUAL(results["Tarifiert"], Value_t(std::string("0")));
+        BOOST_CHECK_EQUAL(results["Indirekt"], Value_t(std::string("0")));
+        BOOST_CHECK_EQUAL(results["Begrenzt"], Value_t(std::string("1")));
+    }
+}
+
+void testParallelCalculation()
+{
+    std::shared_ptr<IFunctionResultCache> functionResultCache(DefaultCacheFactory::getFunctionResultCache(g_dummyVtarKey));
+    std::shared_ptr<IParseTreeCache> parseTreeCache(DefaultCacheFactory::getParseTreeCache(g_dummyVtarKey));
+    std::vector<std::shared_ptr<IFunction>> functions{ std::make_shared<GetProdschablFunction>(), std::make_shared<GetSachtarifFunction>(), std::make_shared<GetTarifpraemieFunction>() };
+
+    std::unique_ptr<IRatingEngine> ratingEngine(RatingEngineFactory::createRatingEngine(functions, functionResultCache, parseTreeCache, RatingEngineOptions().setNumberOfThreads(4)));
+
+    IRatingEngine::Map_t results = ratingEngine->calculate(g_dummyVtarKey, makeInput(), makeRatingFormulas(), makeRatingOutput());
+    validateResults(results);
+
+    results = ratingEngine->calculate(g_dummyVtarKey, makeInstanceInput(), makeRatingFormulas(), makeInstanceRatingOutput());
+    validateInstanceResults(results);
+
+    // rating outputs which depend on each other keep their order
+    IRatingEngine::RatingFormulaMap_t ratingFormulas{ { "Basis", "return 100" } };
+    std::vector<RatingOutput> ratingOutput{
+        { "Praemie", 0, "return Basis * 2", "" },
+        { "Steuer", 1, "return Praemie * 0.1", "" },
+        { "Praemie", 2, "return Praemie + Steuer", "" },
+        { "Gebuehr", 3, "return Basis + 5", "" }
+    };
+    results = ratingEngine->calculate(g_dummyVtarKey, IRatingEngine::Map_t(), ratingFormulas, ratingOutput);
+    BOOST_CHECK_EQUAL(results["Steuer"], Value_t(20.0));
+    BOOST_CHECK_EQUAL(results["Praemie"], Value_t(220.0));
+    BOOST_CHECK_EQUAL(results["Gebuehr"], Value_t(105.0));
+
+    // formulas which reference each other depending on the instance are calculated sequentially
+    IRatingEngine::RatingFormulaMap_t cyclicFormulas{
+        { "Erstwert", "if (Kreisart = 1) then return Zweitwert + 1 else return 1 end" },
+        { "Zweitwert", "if (Kreisart = 2) then return Erstwert + 1 else return 2 end" }
+    };
+    std::vector<RatingOutput> cyclicOutput{
+        { "Kreissumme", 0, "return Erstwert + Zweitwert", "1" },
+        { "Kreissumme", 1, "return Erstwert + Zweitwert", "2" }
+    };
+    IRatingEngine::Map_t cyclicInput{ { "Kreisart", IRatingEngine::InstanceVariable_t{ { "1", 1.0 }, { "2", 2.0 } } } };
+    results = ratingEngine->calculate(g_dummyVtarKey, cyclicInput, cyclicFormulas, cyclicOutput);
+    BOOST_CHECK_EQUAL(results["Kreissumme"], Value_t(IRatingEngine::InstanceVariable_t{ { "1", 5.0 }, { "2", 3.0 } }));
+}
+
+namespace {
+//! \brief a rating engine which only implements calculate, like the implementations written before prepared tariffs
+class LegacyRatingEngine : public IRatingEngine
+{
+public:
+    explicit LegacyRatingEngine(std::unique_ptr<IRatingEngine> ratingEngine_)
+        : m_ratingEngine(std::move(ratingEngine_))
+    {
+    }
+
+    virtual Map_t calculate(const std::string& insuranceRateKey_, const Map_t& input_, const RatingFormulaMap_t& ratingFormulas_, const std::vector<RatingOutput>& ratingOutput_) override
+    {
+        return m_ratingEngine->calculate(insuranceRateKey_, input_, ratingFormulas_, ratingOutput_);
+    }
+
+private:
+    const std::unique_ptr<IRatingEngine> m_ratingEngine;
+};
+}
+
+void testBatchCalculation()
+{
+    std::shared_ptr<IFunctionResultCache> functionResultCache(DefaultCacheFactory::getFunctionResultCache(g_dummyVtarKey));
+    std::shared_ptr<IParseTreeCache> parseTreeCache(DefaultCacheFactory::getParseTreeCache(g_dummyVtarKey));
+    std::vector<std::shared_ptr<IFunction>> functions{ std::make_shared<GetProdschablFunction>(), std::make_shared<GetSachtarifFunction>(), std::make_shared<GetTarifpraemieFunction>() };
+
+    // the second input lacks all parameters, its calculation fails without cancelling the others
+    std::vector<IRatingEngine::Map_t> inputs{ makeInput(), IRatingEngine::Map_t(), makeInput(), makeInput() };
+
+    for (const std::size_t numberOfThreads : { 1, 4 }) {
+        std::unique_ptr<IRatingEngine> ratingEngine(RatingEngineFactory::createRatingEngine(functions, functionResultCache, parseTreeCache, RatingEngineOptions().setNumberOfThreads(numberOfThreads)));
+        std::vector<IRatingEngine::BatchResult> results = ratingEngine->calculateBatch(g_dummyVtarKey, inputs, makeRatingFormulas(), makeRatingOutput());
+
+        BOOST_REQUIRE_EQUAL(results.size(), inputs.size());
+        for (std::size_t i = 0; i < results.size(); ++i) {
+            if (i == 1) {
+                BOOST_CHECK(results[i].output.empty());
+                BOOST_REQUIRE(results[i].error);
+                BOOST_CHECK_THROW(std::rethrow_exception(results[i].error), RatingEngineException);
+            }
+            else {
+                BOOST_CHECK(!results[i].error);
+                validateResults(results[i].output);
+            }
+        }
+    }
+
+    // the default implementation calculates the inputs one after the other, prepared tariffs are not supported
+    LegacyRatingEngine legacyRatingEngine(RatingEngineFactory::createRatingEngine(functions, functionResultCache, parseTreeCache));
+    std::vector<IRatingEngine::BatchResult> results = legacyRatingEngine.calculateBatch(g_dummyVtarKey, inputs, makeRatingFormulas(), makeRatingOutput());
+    BOOST_REQUIRE_EQUAL(results.size(), inputs.size());
+    BOOST_CHECK(results[1].error);
+    validateResults(results[3].output);
+    BOOST_CHECK_THROW(legacyRatingEngine.prepare(g_dummyVtarKey, makeRatingFormulas(), makeRatingOutput()), RatingEngineException);
+}
+
+void testColumnarEvaluation()
+{
+    std::shared_ptr<IFunctionResultCache> functionResultCache(DefaultCacheFactory::getFunctionResultCache(g_dummyVtarKey));
+    std::shared_ptr<IParseTreeCache> parseTreeCache(DefaultCacheFactory::getParseTreeCache(g_dummyVtarKey));
+    std::vector<std::shared_ptr<IFunction>> functions;
+
+    IRatingEngine::RatingFormulaMap_t ratingFormulas{ { "Grundbeitrag", "return 50" } };
+    std::vector<RatingOutput> ratingOutput{
+        { "Tarifstufe", 0, "if (Alter < 25) then return 3 else if (Alter < 60) then return 2 else return 1 end", "" },
+        { "Jahresbeitrag", 1, "return Rnd(Max(Summe * 0.0012, 40) * (1 + Ceil(Schaeden / 2) / 10), 2)", "" },
+        { "Monatsbeitrag", 2, "return Jahresbeitrag / Monate", "" },
+        { "Beitragsquote", 3, "if (Summe > 0 and !(Monate = 12)) then return Summe / Monate else return 0 end", "" },
+        { "Stufenzuschlag", 4, "return Grundbeitrag * Tarifstufe", "" },
+        { "Faktorbeitrag", 5, "return Summe * Faktor", "1" },
+        { "Faktorbeitrag", 6, "return Summe * Faktor", "2" }
+    };
+
+    // the numeric rating outputs are evaluated column by column, the other ones and all failing inputs one by one
+    std::vector<IRatingEngine::Map_t> inputs;
+    for (int i = 0; i < 600; ++i) {
+        IRatingEngine::Map_t input{
+            { "Alter", double(18 + i % 70) },
+            { "Summe", double(1000 * (i % 250)) },
+            { "Schaeden", double(i % 5) },
+            { "Monate", i % 7 == 0 ? 0.0 : 12.0 },
+            { "Faktor", IRatingEngine::InstanceVariable_t{ { "1", 1.1 }, { "", 0.9 } } }
+        };
+        if (i % 97 == 0) {
+            input["Summe"] = std::string("unbekannt");
+        }
+        if (i % 101 == 0) {
+            input.erase("Schaeden");
+        }
+        inputs.push_back(input);
+    }
+
+    for (const std::size_t numberOfThreads : { 1, 4 }) {
+        std::unique_ptr<IRatingEngine> ratingEngine(RatingEngineFactory::createRatingEngine(functions, functionResultCache, parseTreeCache, RatingEngineOptions().setNumberOfThreads(numberOfThreads)));
+        std::vector<IRatingEngine::BatchResult> expected = ratingEngine->calculateBatch(g_dummyVtarKey, inputs, ratingFormulas, ratingOutput);
+
+        ratingEngine = RatingEngineFactory::createRatingEngine(functions, functionResultCache, parseTreeCache, RatingEngineOptions().setNumberOfThreads(numberOfThreads).setColumnarEvaluation(true));
+        std::vector<IRatingEngine::BatchResult> results = ratingEngine->calculateBatch(g_dummyVtarKey, inputs, ratingFormulas, ratingOutput);
+
+        BOOST_REQUIRE_EQUAL(results.size(), expected.size());
+        std::size_t numberOfErrors = 0;
+        for (std::size_t i = 0; i < results.size(); ++i) {
+            BOOST_CHECK_EQUAL(bool(results[i].error), bool(expected[i].error));
+            BOOST_CHECK(results[i].output == expected[i].output);
+            numberOfErrors += results[i].error ? 1 : 0;
+        }
+        BOOST_CHECK(numberOfErrors > 0 && numberOfErrors < results.size());
+    }
+}
+
+void testDependencyGraph()
+{
+    std::shared_ptr<IFunctionResultCache> functionResultCache(DefaultCacheFactory::getFunctionResultCache(g_dummyVtarKey));
+    std::shared_ptr<IParseTreeCache> parseTreeCache(DefaultCacheFactory::getParseTreeCache(g_dummyVtarKey));
+    std::vector<std::shared_ptr<IFunction>> functions{ std::make_shared<GetSachtarifFunction>() };
+
+    IRatingEngine::RatingFormulaMap_t ratingFormulas{
+        { "Basis", "return Wert * 2" },
+        { "Zuschlag", "return Basis + GetSachtarif('ZUSCHLAG')" },
+        { "Quote(anzahl)", "return Basis / anzahl" },
+        { "Fakultaet(n)", "if (n > 1) then return n * Fakultaet(n - 1) else return 1 end" },
+        { "Zyklus_A", "return Zyklus_B + 1" },
+        { "Zyklus_B", "return Zyklus_A + 1" }
+    };
+    std::vector<RatingOutput> ratingOutput{
+        { "Steuer", 1, "return Praemie * 0.1", "" },
+        { "Praemie", 0, "return Quote(2) + Zuschlag", "" },
+        { "Gebuehr", 2, "return Fakultaet(3)", "" }
+    };
+
+    std::unique_ptr<IRatingEngine> ratingEngine(RatingEngineFactory::createRatingEngine(functions, functionResultCache, parseTreeCache));
+    const DependencyGraph graph(ratingEngine->analyzeDependencies(g_dummyVtarKey, ratingFormulas, ratingOutput));
+    const std::vector<DependencyGraph::Node>& nodes = graph.getNodes();
+    BOOST_REQUIRE_EQUAL(nodes.size(), 9u);
+
+    // references of the formulas, the arguments of functions are no variables
+    const DependencyGraph::Node& basis = nodes[graph.findNode("basis")];
+    BOOST_CHECK(basis.type == DependencyGraph::NodeType::RATING_FORMULA);
+    BOOST_CHECK(basis.compiled);
+    BOOST_CHECK(basis.variables == std::vector<std::string>{ "Wert" });
+    BOOST_CHECK(basis.dependencies.empty());
+
+    const DependencyGraph::Node& zuschlag = nodes[graph.findNode("Zuschlag")];
+    BOOST_CHECK(zuschlag.functions == std::vector<std::string>{ "GetSachtarif" });
+    BOOST_CHECK(zuschlag.dependencies == std::vector<std::size_t>{ graph.findNode("Basis") });
+
+    const DependencyGraph::Node& quote = nodes[graph.findNode("Quote")];
+    BOOST_CHECK(quote.type == DependencyGraph::NodeType::FORMULA_FUNCTION);
+    BOOST_CHECK(quote.variables.empty());
+
+    const DependencyGraph::Node& praemie = nodes[graph.findNode("Praemie")];
+    BOOST_CHECK(praemie.type == DependencyGraph::NodeType::RATING_OUTPUT);
+    BOOST_CHECK_EQUAL(praemie.dependencies.size(), 2u);
+
+    // recursive functions are no cycles, formulas which reference each other are
+    BOOST_REQUIRE_EQUAL(graph.getCycles().size(), 1u);
+    BOOST_CHECK(graph.getCycles()[0] == (std::vector<std::size_t>{ graph.findNode("Zyklus_A"), graph.findNode("Zyklus_B") }));
+
+    // Steuer depends on Praemie, Gebuehr is independent
+    const std::vector<std::vector<std::size_t>>& levels = graph.getOutputLevels();
+    BOOST_REQUIRE_EQUAL(levels.size(), 2u);
+    BOOST_CHECK(levels[0] == (std::vector<std::size_t>{ graph.findNode("Praemie"), graph.findNode("Gebuehr") }));
+    BOOST_CHECK(levels[1] == std::vector<std::size_t>{ graph.findNode("Steuer") });
+    BOOST_CHECK(graph.getOutputOrder() == (std::vector<std::size_t>{ graph.findNode("Praemie"), graph.findNode("Gebuehr"), graph.findNode("Steuer") }));
+}
+
+void testInstanceInvariance()
+{
+    std::shared_ptr<IFunctionResultCache> functionResultCache(DefaultCacheFactory::getFunctionResultCache(g_dummyVtarKey));
+    std::shared_ptr<IParseTreeCache> parseTreeCache(DefaultCacheFactory::getParseTreeCache(g_dummyVtarKey));
+    std::vector<std::shared_ptr<IFunction>> functions{ std::make_shared<GetSachtarifFunction>() };
+    std::unique_ptr<IRatingEngine> ratingEngine(RatingEngineFactory::createRatingEngine(functions, functionResultCache, parseTreeCache));
+
+    IRatingEngine::RatingFormulaMap_t ratingFormulas{
+        { "Grundanteil", "return Grundwert * 2" },
+        { "Wertanteil", "return Wert * 0.1" },
+        { "Anteilsumme", "return Grundanteil + Wertanteil" },
+        { "Tarifwert", "return GetSachtarif('MINVSGU')" },
+        { "Instanzsumme", "return Instanzpraemie * 2" }
+    };
+    std::vector<RatingOutput> ratingOutput{
+        { "Instanzpraemie", 0, "return Anteilsumme + Grundanteil", "1" },
+        { "Instanzpraemie", 1, "return Anteilsumme + Grundanteil", "2" },
+        { "Verdoppelt", 2, "return Instanzsumme", "1" },
+        { "Verdoppelt", 3, "return Instanzsumme", "2" }
+    };
+
+    std::unique_ptr<IPreparedTariff> preparedTariff(ratingEngine->prepare(g_dummyVtarKey, ratingFormulas, ratingOutput));
+    const DependencyGraph& graph = preparedTariff->getDependencyGraph();
+    BOOST_CHECK(graph.getNodes()[graph.findNode("Grundanteil")].instanceInvariant);
+    BOOST_CHECK(graph.getNodes()[graph.findNode("Wertanteil")].instanceInvariant);
+    BOOST_CHECK(graph.getNodes()[graph.findNode("Anteilsumme")].instanceInvariant);
+    // business functions may read the instance id
+    BOOST_CHECK(!graph.getNodes()[graph.findNode("Tarifwert")].instanceInvariant);
+    BOOST_CHECK(!graph.getNodes()[graph.findNode("Instanzsumme")].instanceInvariant);
+
+    // the formulas reading the input parameter with instance values are calculated per instance
+    IRatingEngine::Map_t input{
+        { "Grundwert", 10.0 },
+        { "Wert", IRatingEngine::InstanceVariable_t{ { "1", 100.0 }, { "2", 200.0 } } }
+    };
+    IRatingEngine::Map_t results = preparedTariff->calculate(input);
+    BOOST_CHECK_EQUAL(results["Instanzpraemie"], Value_t(IRatingEngine::InstanceVariable_t{ { "1", 50.0 }, { "2", 60.0 } }));
+    BOOST_CHECK_EQUAL(results["Verdoppelt"], Value_t(IRatingEngine::InstanceVariable_t{ { "1", 100.0 }, { "2", 120.0 } }));
+
+    input["Wert"] = 100.0;
+    results = preparedTariff->calculate(input);
+    BOOST_CHECK_EQUAL(results["Instanzpraemie"], Value_t(IRatingEngine::InstanceVariable_t{ { "1", 50.0 }, { "2", 50.0 } }));
+    BOOST_CHECK_EQUAL(results["Verdoppelt"], Value_t(IRatingEngine::InstanceVariable_t{ { "1", 100.0 }, { "2", 100.0 } }));
+
+    // a formula which reads a rating output calculated between the instances is calculated per instance,
+    // the first instance reads the input parameter
+    IRatingEngine::RatingFormulaMap_t zuschlagFormulas{ { "Zuschlag", "return Zuschlagsatz * 10" } };
+    std::vector<RatingOutput> zuschlagOutput{
+        { "Zuschlagspraemie", 0, "return Zuschlag", "1" },
+        { "Zuschlagsatz", 1, "return 2", "" },
+        { "Zuschlagspraemie", 2, "return Zuschlag", "2" }
+    };
+    preparedTariff = ratingEngine->prepare(g_dummyVtarKey, zuschlagFormulas, zuschlagOutput);
+    BOOST_CHECK(!preparedTariff->getDependencyGraph().getNodes()[preparedTariff->getDependencyGraph().findNode("Zuschlag")].instanceInvariant);
+    results = preparedTariff->calculate(IRatingEngine::Map_t{ { "Zuschlagsatz", 1.0 } });
+    BOOST_CHECK_EQUAL(results["Zuschlagspraemie"], Value_t(IRatingEngine::InstanceVariable_t{ { "1", 10.0 }, { "2", 20.0 } }));
+
+    // calculated before the formula is first read, the rating output is the same for all instances
+    zuschlagOutput[1] = RatingOutput("Zuschlagsatz", -1, "return 2", "");
+    preparedTariff = ratingEngine->prepare(g_dummyVtarKey, zuschlagFormulas, zuschlagOutput);
+    BOOST_CHECK(preparedTariff->getDependencyGraph().getNodes()[preparedTariff->getDependencyGraph().findNode("Zuschlag")].instanceInvariant);
+    results = preparedTariff->calculate(IRatingEngine::Map_t{ { "Zuschlagsatz", 1.0 } });
+    BOOST_CHECK_EQUAL(results["Zuschlagspraemie"], Value_t(IRatingEngine::InstanceVariable_t{ { "1", 20.0 }, { "2", 20.0 } }));
+}
+
+void testInstanceGroups()
+{
+    std::shared_ptr<IFunctionResultCache> functionResultCache(DefaultCacheFactory::getFunctionResultCache(g_dummyVtarKey));
+    std::shared_ptr<IParseTreeCache> parseTreeCache(DefaultCacheFactory::getParseTreeCache(g_dummyVtarKey));
+    std::vector<std::shared_ptr<IFunction>> functions;
+
+    // the premium and the tax of every vehicle are evaluated for all vehicles at once
+    IRatingEngine::RatingFormulaMap_t ratingFormulas{ { "Kfz_Rabatt", "return 0.9" } };
+    std::vector<RatingOutput> ratingOutput{ { "Kfz_Grundpraemie", 0, "return 300", "" } };
+    IRatingEngine::InstanceVariable_t leistung;
+    for (int i = 0; i < 40; ++i) {
+        const std::string instanceId(std::to_string(i));
+        ratingOutput.push_back(RatingOutput("Kfz_Praemie", 1 + i, "if (Leistung > 100) then return Rnd(Kfz_Grundpraemie * Leistung / 100, 2) else return Kfz_Grundpraemie end", instanceId));
+        ratingOutput.push_back(RatingOutput("Kfz_Steuer", 100 + i, "return Kfz_Praemie * 0.19", instanceId));
+        ratingOutput.push_back(RatingOutput("Kfz_Nachlass", 200 + i, "return Kfz_Praemie * Kfz_Rabatt", instanceId));
+        leistung.emplace(instanceId, double(60 + 7 * i));
+    }
+
+    IRatingEngine::Map_t input{ { "Leistung", leistung } };
+    std::unique_ptr<IRatingEngine> ratingEngine(RatingEngineFactory::createRatingEngine(functions, functionResultCache, parseTreeCache));
+    IRatingEngine::Map_t expected = ratingEngine->calculate(g_dummyVtarKey, input, ratingFormulas, ratingOutput);
+
+    ratingEngine = RatingEngineFactory::createRatingEngine(functions, functionResultCache, parseTreeCache, RatingEngineOptions().setColumnarEvaluation(true));
+    std::unique_ptr<IPreparedTariff> preparedTariff(ratingEngine->prepare(g_dummyVtarKey, ratingFormulas, ratingOutput));
+    IRatingEngine::Map_t results = preparedTariff->calculate(input);
+    BOOST_CHECK(results == expected);
+    BOOST_CHECK_EQUAL(boost::get<IRatingEngine::InstanceVariable_t>(results["Kfz_Praemie"]).size(), 40u);
+
+    // an instance which cannot be evaluated column by column reports its error
+    leistung["7"] = std::string("unbekannt");
+    input["Leistung"] = leistung;
+    BOOST_CHECK_THROW(preparedTariff->calculate(input), std::exception);
+}
+
+void testCalculatedVariables()
+{
+    std::shared_ptr<IFunctionResultCache> functionResultCache(DefaultCacheFactory::getFunctionResultCache(g_dummyVtarKey));
+    std::shared_ptr<IParseTreeCache> parseTreeCache(DefaultCacheFactory::getParseTreeCache(g_dummyVtarKey));
+    std::vector<std::shared_ptr<IFunction>> functions;
+
+    // a rating output replaces the input parameter of the same name, a value without instance id is the default of all instances
+    std::vector<RatingOutput> ratingOutput{
+        { "rabatt", 0, "return Rabatt * 2", "" },
+        { "Faktor", 1, "return 1", "" },
+        { "Faktor", 2, "return 3", "2" },
+        { "Praemie", 3, "return Wert * Faktor * Rabatt", "1" },
+        { "Praemie", 4, "return Wert * Faktor * Rabatt", "2" },
+        { "Summe", 5, "return Faktor + Rabatt", "" }
+    };
+    IRatingEngine::Map_t input{
+        { "Rabatt", 0.5 },
+        { "Wert", IRatingEngine::InstanceVariable_t{ { "1", 100.0 }, { "2", 200.0 } } }
+    };
+
+    for (const std::size_t numberOfThreads : { 1, 4 }) {
+        std::unique_ptr<IRatingEngine> ratingEngine(RatingEngineFactory::createRatingEngine(functions, functionResultCache, parseTreeCache, RatingEngineOptions().setNumberOfThreads(numberOfThreads)));
+        std::unique_ptr<IPreparedTariff> preparedTariff(ratingEngine->prepare(g_dummyVtarKey, IRatingEngine::RatingFormulaMap_t(), ratingOutput));
+        for (int i = 0; i < 2; ++i) {
+            IRatingEngine::Map_t results = preparedTariff->calculate(input);
+            BOOST_CHECK_EQUAL(results["rabatt"], Value_t(1.0));
+            BOOST_CHECK_EQUAL(results["Praemie"], Value_t(IRatingEngine::InstanceVariable_t{ { "1", 100.0 }, { "2", 600.0 } }));
+            BOOST_CHECK_EQUAL(results["Summe"], Value_t(2.0));
+        }
+    }
+}
+
+namespace {
+//! \brief returns its argument and counts its calls
+class CountingFunction : public IFunction
+{
+public:
+    explicit CountingFunction(const FunctionCachingPolicy& cachingPolicy_ = FunctionCachingPolicy())
+        : m_name("Zaehler")
+        , m_cachingPolicy(cachingPolicy_)
+        , m_calls(0)
+    {
+    }
+
+    virtual const std::string& getName() const override
+    {
+        return m_name;
+    }
+
+    virtual std::size_t getNumberOfArgs() const override
+    {
+        return 1;
+    }
+
+    virtual Value execute(const std::vector<Value>& params_, const std::shared_ptr<IParsingContext>&) override
+    {
+        ++m_calls;
+        return params_[0];
+    }
+
+    virtual const FunctionCachingPolicy& getCachingPolicy() const override
+    {
+        return m_cachingPolicy;
+    }
+
+    std::size_t getCalls() const
+    {
+        return m_calls;
+    }
+
+private:
+    const std::string m_name;
+    const FunctionCachingPolicy m_cachingPolicy;
+    std::atomic<std::size_t> m_calls;
+};
+}
+
+void testFunctionMemoization()
+{
+    std::shared_ptr<IFunctionResultCache> functionResultCache(DefaultCacheFactory::getFunctionResultCache(g_dummyVtarKey));
+    std::shared_ptr<IParseTreeCache> parseTreeCache(DefaultCacheFactory::getParseTreeCache(g_dummyVtarKey));
+
+    // band and fak only read their arguments, gezaehlt calls a business function and faktor reads an input parameter
+    IRatingEngine::RatingFormulaMap_t ratingFormulas{
+        { "band(x)", "if (x < 100) then return 1.1 else return 1.2 end" },
+        { "fak(n)", "if (n <= 1) then return 1 else return n * fak(n - 1) end" },
+        { "gezaehlt(x)", "return Zaehler(x)" },
+        { "faktor(x)", "return x * Rabatt" }
+    };
+    std::vector<RatingOutput> ratingOutput{
+        { "Band", 0, "return band(Wert) + band(Wert) + band(Wert / 2)", "" },
+        { "Fakultaet", 1, "return fak(5) + fak(4)", "" },
+        { "Gezaehlt", 2, "return gezaehlt(Wert) + gezaehlt(Wert)", "" },
+        { "Faktor", 3, "return faktor(Wert) + faktor(Wert)", "" }
+    };
+
+    for (const std::size_t numberOfThreads : { 1, 4 }) {
+        for (const bool sharedFunctionMemoization : { false, true }) {
+            const std::shared_ptr<CountingFunction> countingFunction(std::make_shared<CountingFunction>());
+            std::vector<std::shared_ptr<IFunction>> functions{ countingFunction };
+            std::unique_ptr<IRatingEngine> ratingEngine(RatingEngineFactory::createRatingEngine(functions, functionResultCache, parseTreeCache,
+                                                                                                 RatingEngineOptions().setNumberOfThreads(numberOfThreads).setSharedFunctionMemoization(sharedFunctionMemoization)));
+            std::unique_ptr<IPreparedTariff> preparedTariff(ratingEngine->prepare(g_dummyVtarKey, ratingFormulas, ratingOutput));
+            for (const double rabatt : { 0.5, 0.25 }) {
+                IRatingEngine::Map_t results = preparedTariff->calculate(IRatingEngine::Map_t{ { "Wert", 150.0 }, { "Rabatt", rabatt } });
+                BOOST_CHECK_EQUAL(results["Band"], Value_t(3.5));
+                BOOST_CHECK_EQUAL(results["Fakultaet"], Value_t(144.0));
+                BOOST_CHECK_EQUAL(results["Gezaehlt"], Value_t(300.0));
+                BOOST_CHECK_EQUAL(results["Faktor"], Value_t(300.0 * rabatt));
+            }
+
+            // functions which call business functions are not memoized
+            BOOST_CHECK_EQUAL(countingFunction->getCalls(), 4u);
+        }
+    }
+
+    // a rating formula which concurrently calculated rating outputs reference is calculated once per calculation,
+    // the threads which need it while it is calculated wait for its value
+    const std::shared_ptr<CountingFunction> countingFunction(std::make_shared<CountingFunction>());
+    std::vector<std::shared_ptr<IFunction>> functions{ countingFunction };
+    std::unique_ptr<IRatingEngine> ratingEngine(RatingEngineFactory::createRatingEngine(functions, functionResultCache, parseTreeCache, RatingEngineOptions().setNumberOfThreads(4)));
+    std::vector<RatingOutput> sharedOutput;
+    for (int i = 0; i < 8; ++i) {
+        sharedOutput.push_back({ "Anteil" + std::to_string(i), i, "return Gemeinsam / " + std::to_string(i + 1), "" });
+    }
+    std::unique_ptr<IPreparedTariff> preparedTariff(ratingEngine->prepare(g_dummyVtarKey, IRatingEngine::RatingFormulaMap_t{ { "Gemeinsam", "return Zaehler(Wert)" } }, sharedOutput));
+    for (std::size_t calculation = 1; calculation <= 20; ++calculation) {
+        IRatingEngine::Map_t results = preparedTariff->calculate(IRatingEngine::Map_t{ { "Wert", 840.0 } });
+        BOOST_CHECK_EQUAL(results["Anteil7"], Value_t(105.0));
+        BOOST_CHECK_EQUAL(countingFunction->getCalls(), calculation);
+    }
+}
+
+void testEvaluationOrder()
+{
+    std::shared_ptr<IFunctionResultCache> functionResultCache(DefaultCacheFactory::getFunctionResultCache(g_dummyVtarKey));
+    std::shared_ptr<IParseTreeCache> parseTreeCache(DefaultCacheFactory::getParseTreeCache(g_dummyVtarKey));
+
+    // a wrong operand type of a built-in function is reported before the next operand is evaluated,
+    // an unknown function before its arguments are evaluated
+    const std::vector<std::pair<std::string, std::string>> formulas{
+        { "return Max('x', Zaehler(1))", "Illegal argument type for first parameter of function 'MAX', number expected" },
+        { "return Substr('abc', 'x', Zaehler(1))", "Illegal argument type for second parameter of function 'SUBSTR', number expected" },
+        { "return Unbekannt(Zaehler(1))", "function Unbekannt with 1 parameters not defined" }
+    };
+
+    for (const EvaluationBackend backend : { EvaluationBackend::TREE, EvaluationBackend::BYTECODE }) {
+        for (const std::pair<std::string, std::string>& formula : formulas) {
+            const std::shared_ptr<CountingFunction> countingFunction(std::make_shared<CountingFunction>());
+            std::vector<std::shared_ptr<IFunction>> functions{ countingFunction };
+            std::unique_ptr<IRatingEngine> ratingEngine(RatingEngineFactory::createRatingEngine(functions, functionResultCache, parseTreeCache, RatingEngineOptions().setEvaluationBackend(backend)));
+            std::vector<RatingOutput> ratingOutput{ { "Ergebnis", 0, formula.first, "" } };
+            std::unique_ptr<IPreparedTariff> preparedTariff(ratingEngine->prepare(g_dummyVtarKey, IRatingEngine::RatingFormulaMap_t(), ratingOutput));
+            try {
+                preparedTariff->calculate(IRatingEngine::Map_t());
+                BOOST_ERROR("no error reported for " << formula.first);
+            }
+            catch (const std::exception& ex) {
+                BOOST_CHECK_MESSAGE(std::string(ex.what()).find(formula.second) != std::string::npos, formula.first << ": " << ex.what());
+            }
+            BOOST_CHECK_EQUAL(countingFunction->getCalls(), 0u);
+        }
+    }
+}
+
+void testFunctionResultCaching()
+{
+    typedef FunctionCachingPolicy::Scope Scope_t;
+
+    std::shared_ptr<IParseTreeCache> parseTreeCache(DefaultCacheFactory::getParseTreeCache(g_dummyVtarKey));
+    std::vector<RatingOutput> ratingOutput{
+        { "Summe", 0, "return Zaehler(Wert) + Zaehler(Wert) + Zaehler(Wert * 2)", "" }
+    };
+
+    // the expected calls of three calculations, on the dates 2020-01-01, 2020-01-01 and 2021-01-01
+    const std::vector<std::pair<FunctionCachingPolicy, std::size_t>> policies{
+        { FunctionCachingPolicy(), 9 },
+        { FunctionCachingPolicy().setScope(Scope_t::CALCULATION), 6 },
+        { FunctionCachingPolicy().setScope(Scope_t::CALCULATION).setValidityDateVariable("Tarifdatum"), 6 },
+        { FunctionCachingPolicy().setScope(Scope_t::TARIFF), 2 },
+        { FunctionCachingPolicy().setScope(Scope_t::TARIFF).setValidityDateVariable("Tarifdatum"), 4 },
+        { FunctionCachingPolicy().setScope(Scope_t::TARIFF).setTimeToLive(std::chrono::hours(24)), 2 }
+    };
+
+    for (const std::pair<FunctionCachingPolicy, std::size_t>& policy : policies) {
+        const std::shared_ptr<CountingFunction> countingFunction(std::make_shared<CountingFunction>(policy.first));
+        std::vector<std::shared_ptr<IFunction>> functions{ countingFunction };
+        std::shared_ptr<IFunctionResultCache> functionResultCache(std::make_shared<DefaultFunctionResultCache>());
+        std::unique_ptr<IRatingEngine> ratingEngine(RatingEngineFactory::createRatingEngine(functions, functionResultCache, parseTreeCache));
+        std::unique_ptr<IPreparedTariff> preparedTariff(ratingEngine->prepare(g_dummyVtarKey, IRatingEngine::RatingFormulaMap_t(), ratingOutput));
+        for (const char* date : { "2020-01-01", "2020-01-01", "2021-01-01" }) {
+            IRatingEngine::Map_t results = preparedTariff->calculate(IRatingEngine::Map_t{ { "Wert", 10.0 }, { "Tarifdatum", date } });
+            BOOST_CHECK_EQUAL(results["Summe"], Value_t(40.0));
+        }
+        BOOST_CHECK_EQUAL(countingFunction->getCalls(), policy.second);
+    }
+
+    // an expired result is calculated again and replaces the cached result, its bytes are freed
+    for (const char* validityDateVariable : { "", "Tarifdatum" }) {
+        const std::shared_ptr<CountingFunction> countingFunction(std::make_shared<CountingFunction>(
+            FunctionCachingPolicy().setScope(Scope_t::TARIFF).setValidityDateVariable(validityDateVariable).setTimeToLive(std::chrono::seconds(1))));
+        std::vector<std::shared_ptr<IFunction>> functions{ countingFunction };
+        std::shared_ptr<BoundedFunctionResultCache> functionResultCache(std::make_shared<BoundedFunctionResultCache>(1 << 20));
+        std::unique_ptr<IRatingEngine> ratingEngine(RatingEngineFactory::createRatingEngine(functions, functionResultCache, parseTreeCache));
+        std::unique_ptr<IPreparedTariff> preparedTariff(ratingEngine->prepare(g_dummyVtarKey, IRatingEngine::RatingFormulaMap_t(), ratingOutput));
+        const IRatingEngine::Map_t input{ { "Wert", 10.0 }, { "Tarifdatum", "2020-01-01" } };
+        BOOST_CHECK_EQUAL(preparedTariff->calculate(input)["Summe"], Value_t(40.0));
+        BOOST_CHECK_EQUAL(preparedTariff->calculate(input)["Summe"], Value_t(40.0));
+        BOOST_CHECK_EQUAL(countingFunction->getCalls(), 2u);
+        const std::size_t bytes = functionResultCache->getBytes();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+        BOOST_CHECK_EQUAL(preparedTariff->calculate(input)["Summe"], Value_t(40.0));
+        BOOST_CHECK_EQUAL(countingFunction->getCalls(), 4u);
+        BOOST_CHECK_EQUAL(functionResultCache->getBytes(), bytes);
+    }
 }
 
 void testInstanceCalculation()